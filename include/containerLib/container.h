@@ -15,14 +15,23 @@
 #include "Container_global.h"
 #include <QObject>
 #include <QVector>
+#include <QVarLengthArray>
+#include <QHash>
 #include <QVariant>
 #include <QDataStream>
+#include <QIODevice>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <functional>
+#include <limits>
+#include <span>
+#include <variant>
 #include "package.h"
 
 namespace ContainerCore{
 
+class ContainerJsonWriter;
+
 /**
 * @class Container
 * @brief Represents a shipping container with package storage and tracking capabilities
@@ -54,7 +63,7 @@ class CONTAINER_EXPORT Container : public QObject
 
     Q_PROPERTY(double leavingTime READ getContainerLeavingTime WRITE setContainerLeavingTime NOTIFY containerLeavingTimeChanged FINAL)
     Q_PROPERTY(ContainerSize containerSize READ getContainerSize WRITE setContainerSize NOTIFY containerSizeChanged FINAL)
-    Q_PROPERTY(QVector<Package*> packages READ getPackages WRITE setPackages NOTIFY packagesChanged FINAL)
+    Q_PROPERTY(QVector<PackageData> packages READ getPackages WRITE setPackages NOTIFY packagesChanged FINAL)
     Q_PROPERTY(QMap<HaulerType, QVariantMap> customVariables READ getCustomVariables WRITE setCustomVariables NOTIFY customVariablesChanged FINAL)
     Q_PROPERTY(QString containerCurrentLocation READ getContainerCurrentLocation WRITE setContainerCurrentLocation NOTIFY containerCurrentLocationChanged FINAL)
     Q_PROPERTY(QVector<QString> containerNextDestinations READ getContainerNextDestinations WRITE setContainerNextDestinations NOTIFY containerNextDestinationsChanged FINAL)
@@ -93,6 +102,85 @@ public:
     };
     Q_ENUM(HaulerType)
 
+   /**
+    * @enum ChangeFlag
+    * @brief Identifies which container property changed
+    *
+    * Used to summarise the changes accumulated while a change batch is
+    * open (see beginChangeBatch()).
+    */
+    enum ChangeFlag {
+        NoChange                = 0x000, /**< Nothing changed */
+        ContainerIDChange       = 0x001, /**< containerID changed */
+        AddedTimeChange         = 0x002, /**< addedTime changed */
+        LeavingTimeChange       = 0x004, /**< leavingTime changed */
+        ContainerSizeChange     = 0x008, /**< containerSize changed */
+        PackagesChange          = 0x010, /**< packages changed */
+        CustomVariablesChange   = 0x020, /**< customVariables changed */
+        CurrentLocationChange   = 0x040, /**< current location changed */
+        NextDestinationsChange  = 0x080, /**< next destinations changed */
+        MovementHistoryChange   = 0x100  /**< movement history changed */
+    };
+    Q_DECLARE_FLAGS(ChangeFlags, ChangeFlag)
+    Q_FLAG(ChangeFlags)
+
+   /**
+    * @brief Value held by a schema-registered custom variable slot
+    *
+    * std::monostate marks an unset slot. Integer slots store qint64 so
+    * that 64-bit IDs and timestamps are not truncated.
+    */
+    using CustomValue = std::variant<std::monostate, bool, qint64, double,
+                                     QString>;
+
+   /**
+    * @brief Controls how a container keeps its movement history
+    */
+    struct MovementHistoryPolicy
+    {
+        /** Keep only the most recent entries; 0 keeps everything */
+        qsizetype maxEntries = 0;
+
+        /** Index the entries in a hash set so duplicate checks are O(1) */
+        bool hashedLookup = false;
+
+        friend bool operator==(const MovementHistoryPolicy &,
+                               const MovementHistoryPolicy &) = default;
+    };
+
+   /**
+    * @class ChangeBatch
+    * @brief RAII guard that batches a container's change notifications
+    *
+    * Works like QSignalBlocker: the constructor opens a change batch on
+    * the container and the destructor closes it, emitting each changed
+    * property's signal once followed by containerChanged().
+    */
+    class ChangeBatch
+    {
+    public:
+        explicit ChangeBatch(Container *container)
+            : m_container(container)
+        {
+            if (m_container) {
+                m_container->beginChangeBatch();
+            }
+        }
+
+        ~ChangeBatch()
+        {
+            if (m_container) {
+                m_container->endChangeBatch();
+            }
+        }
+
+        ChangeBatch(const ChangeBatch &) = delete;
+        ChangeBatch &operator=(const ChangeBatch &) = delete;
+
+    private:
+        Container *m_container;
+    };
+
    /**
     * @brief Default constructor
     * @param parent Optional parent QObject for memory management
@@ -107,6 +195,24 @@ public:
     */
     Container(const QString &id, ContainerSize size, QObject *parent = nullptr);
 
+   /**
+    * @brief Constructor for bulk loading
+    * @param id Unique identifier for the container
+    * @param size Size classification of the container
+    * @param addedTime Time when the container was added
+    * @param leavingTime Time when the container should leave
+    * @param location Current location; an empty location keeps "Unknown"
+    * @param parent Optional parent QObject for memory management
+    *
+    * Sets the fields directly, without logging or change notifications,
+    * so that many containers can be built in parallel. A location is
+    * recorded in the movement history as setContainerCurrentLocation()
+    * does.
+    */
+    Container(const QString &id, ContainerSize size, double addedTime,
+              double leavingTime, const QString &location,
+              QObject *parent = nullptr);
+
    /**
     * @brief Constructor from JSON
     * @param json JSON object containing container data
@@ -134,6 +240,41 @@ public:
     */
     void setIsRunningThroughPython(bool isRunningThroughPython);
 
+   /**
+    * @brief Opens a change batch
+    *
+    * While a batch is open, setters record what changed instead of
+    * emitting their notification signals. Batches may be nested; the
+    * notifications are emitted when the outermost batch is closed.
+    */
+    void beginChangeBatch();
+
+   /**
+    * @brief Closes a change batch opened by beginChangeBatch()
+    *
+    * When the outermost batch closes, every property signal that would
+    * have been emitted during the batch is emitted once, followed by a
+    * single containerChanged() carrying the accumulated flags.
+    */
+    void endChangeBatch();
+
+   /**
+    * @brief Checks whether a change batch is currently open
+    * @return true if notifications are being accumulated
+    */
+    bool isBatchingChanges() const;
+
+   /**
+    * @brief Returns a stamp that changes whenever the container does
+    * @return Revision number, unique across all containers
+    *
+    * Every modification draws a new value from a process-wide counter, so
+    * two revisions compare equal only for the same, unmodified object.
+    * ContainerMap uses this to find the containers changed since a
+    * checkpoint.
+    */
+    quint64 revision() const;
+
    /**
     * @brief Virtual destructor
     */
@@ -198,24 +339,67 @@ public:
 
     /**
     * @brief Gets the list of packages stored in the container
-    * @return Vector of pointers to Package objects
+    * @return Copy of the stored package values
+    * @note Prefer packagesView() on read paths; it does not copy
+    */
+    QVector<PackageData> getPackages() const;
+
+    /**
+    * @brief Gets a non-copying view of the stored packages
+    * @return Span over the container's package values
+    * @note The span is invalidated by any change to the packages
+    */
+    std::span<const PackageData> packagesView() const;
+
+    /**
+    * @brief Gets the number of packages stored in the container
+    * @return Package count
     */
-    QVector<Package*> getPackages() const;
+    qsizetype packageCount() const;
+
+    /**
+    * @brief Replaces the entire package collection
+    * @param packages The new package values
+    * emits packagesChanged()
+    */
+    void setPackages(const QVector<PackageData> &packages);
 
     /**
     * @brief Replaces the entire package collection
     * @param packages Vector of pointers to new Package objects
     * emits packagesChanged()
-    * @note Performs deep copy of provided packages
+    * @note Copies the package data; the caller keeps ownership of the
+    * provided Package objects
     */
     void setPackages(const QVector<Package*> &packages);
 
+    /**
+    * @brief Replaces the package collection and takes ownership of the
+    * given objects
+    * @param packages Vector of pointers to heap-allocated Package objects
+    * emits packagesChanged()
+    * @note The package data is stored by value and the objects are
+    * deleted before this returns, so the caller must not use them
+    * afterwards. When running through Python the objects belong to
+    * Python and are left alone.
+    */
+    void adoptPackages(QVector<Package*> &&packages);
+
     /**
     * @brief Adds a single package to the container
     * @param package Pointer to the Package to add
     * emits packagesChanged()
+    * @note The package's data is copied; the caller keeps ownership of
+    * the Package object
     */
-    void addPackage(Package *package);
+    void addPackage(const Package *package);
+
+    /**
+    * @brief Adds a single package value to the container
+    * @param package The package data to add
+    * emits packagesChanged()
+    */
+    void addPackage(const PackageData &package);
 
     // Getter and Setter for customVariables
 
@@ -225,6 +409,19 @@ public:
     */
     QMap<HaulerType, QVariantMap> getCustomVariables() const;
 
+    /**
+    * @brief Visits every custom variable without building a map
+    * @param visitor Called with the hauler type, key and value of each
+    * variable
+    *
+    * Unlike getCustomVariables() this does not copy the variables or
+    * merge schema slots into a temporary map. The visitor must not modify
+    * the container's custom variables.
+    */
+    void forEachCustomVariable(
+        const std::function<void(HaulerType, const QString &,
+                                 const QVariant &)> &visitor) const;
+
     /**
     * @brief Sets all custom variables for all hauler types
     * @param variables Map of hauler types to their respective variable maps
@@ -264,6 +461,64 @@ public:
     */
     QVariantMap getCustomVariablesForHauler(HaulerType hauler) const;
 
+    /**
+    * @brief Pre-declares a custom variable key for a hauler type
+    * @param hauler The hauler type
+    * @param key The variable key
+    * @param type Storage type: QMetaType::Bool, QMetaType::LongLong (or
+    * QMetaType::Int, widened to 64 bits),
+    * QMetaType::Double or QMetaType::QString
+    * @return Slot index to use with the slot accessors, or -1 if the type
+    * is not supported
+    *
+    * Registered keys are stored in a flat typed array in every container
+    * instead of the QVariant map, giving O(1) access by slot index. The
+    * QVariant API keeps working for registered keys. Registering an
+    * existing key returns its slot. The schema is process-wide and should
+    * be set up before containers are populated.
+    */
+    static int registerCustomVariable(HaulerType hauler, const QString &key,
+                                      QMetaType::Type type);
+
+    /**
+    * @brief Removes a custom variable key from the schema
+    * @param hauler The hauler type
+    * @param key The variable key
+    * @return true if the key was registered
+    *
+    * The slot index is retired rather than reused. Containers that still
+    * hold a value in it keep reporting that value under the key, as if it
+    * were stored in the QVariant map, until the key is written or
+    * removed; JSON output and copies carry the value as an untyped map
+    * entry. New values for the key go to the map from then on.
+    */
+    static bool unregisterCustomVariable(HaulerType hauler, const QString &key);
+
+    /**
+    * @brief Looks up the slot index of a registered custom variable
+    * @param hauler The hauler type
+    * @param key The variable key
+    * @return Slot index, or -1 if the key is not registered
+    */
+    static int customVariableSlotIndex(HaulerType hauler, const QString &key);
+
+    /**
+    * @brief Sets a registered custom variable by slot index
+    * @param slot Slot index returned by registerCustomVariable()
+    * @param value The value; must match the slot's registered type
+    * (std::monostate clears the slot)
+    * emits customVariablesChanged()
+    * @note Values of the wrong type are rejected with a warning
+    */
+    void setCustomVariableSlot(int slot, const CustomValue &value);
+
+    /**
+    * @brief Gets a registered custom variable by slot index
+    * @param slot Slot index returned by registerCustomVariable()
+    * @return The stored value, or std::monostate if unset
+    */
+    const CustomValue &customVariableSlot(int slot) const;
+
     // Getters and Setters for current location
 
     /**
@@ -284,9 +539,10 @@ public:
 
     /**
     * @brief Gets the list of planned destinations
-    * @return Vector of destination strings
+    * @return Vector of destination strings, valid until the destinations
+    * change
     */
-    QVector<QString> getContainerNextDestinations() const;
+    const QVector<QString> &getContainerNextDestinations() const;
 
     /**
     * @brief Sets the list of planned destinations
@@ -295,6 +551,13 @@ public:
     */
     void setContainerNextDestinations(const QVector<QString> &destinations);
 
+    /**
+    * @brief Sets the list of planned destinations, taking over the vector
+    * @param destinations Vector of destination strings
+    * emits containerNextDestinationsChanged()
+    */
+    void setContainerNextDestinations(QVector<QString> &&destinations);
+
     /**
     * @brief Adds a destination to the planned route
     * @param destination The destination to add
@@ -314,9 +577,10 @@ public:
 
     /**
     * @brief Gets the container's movement history
-    * @return Vector of historical location strings
+    * @return Vector of historical location strings, valid until the
+    * history changes
     */
-    QVector<QString> getContainerMovementHistory() const;
+    const QVector<QString> &getContainerMovementHistory() const;
 
     /**
     * @brief Sets the container's movement history
@@ -325,6 +589,13 @@ public:
     */
     void setContainerMovementHistory(const QVector<QString> &history);
 
+    /**
+    * @brief Sets the container's movement history, taking over the vector
+    * @param history Vector of historical location strings
+    * emits containerMovementHistoryChanged()
+    */
+    void setContainerMovementHistory(QVector<QString> &&history);
+
     /**
     * @brief Adds a location to the movement history
     * @param history The location to add
@@ -340,6 +611,48 @@ public:
     */
     bool removeMovementHistory(const QString &history);
 
+    /**
+    * @brief Checks whether a location is in the movement history
+    * @param location The location to look for
+    * @return true if the location is present
+    *
+    * O(1) when the history policy enables hashed lookup, linear otherwise.
+    */
+    bool hasMovementHistory(const QString &location) const;
+
+    /**
+    * @brief Sets how this container keeps its movement history
+    * @param policy The history policy
+    *
+    * When maxEntries is set the history behaves as a ring buffer: adding
+    * an entry to a full history drops the oldest one. Applying a smaller
+    * bound trims the existing history immediately and emits
+    * containerMovementHistoryChanged() if anything was dropped.
+    */
+    void setMovementHistoryPolicy(const MovementHistoryPolicy &policy);
+
+    /**
+    * @brief Gets this container's movement history policy
+    * @return The history policy
+    */
+    MovementHistoryPolicy movementHistoryPolicy() const;
+
+    /**
+    * @brief Sets the policy given to containers created afterwards
+    * @param policy The default history policy
+    *
+    * Existing containers keep their current policy.
+    */
+    static void setDefaultMovementHistoryPolicy(
+        const MovementHistoryPolicy &policy);
+
+    /**
+    * @brief Gets the policy given to newly created containers
+    * @return The default history policy (unbounded, linear lookup unless
+    * changed)
+    */
+    static MovementHistoryPolicy defaultMovementHistoryPolicy();
+
     /**
     * @brief Clears all container data
     * 
@@ -357,6 +670,63 @@ public:
     */
     QJsonObject toJson() const;
 
+    /**
+    * @brief Writes the container as compact JSON to a device
+    * @param device Open, writable device
+    * @return true on success
+    *
+    * Produces the same bytes as serializing toJson() with
+    * QJsonDocument::Compact, without building the JSON object.
+    */
+    bool writeJson(QIODevice *device) const;
+
+    /**
+    * @brief Writes the container as a JSON object through a writer
+    * @param writer Writer positioned where a value may follow
+    */
+    void writeJson(ContainerJsonWriter &writer) const;
+
+    /**
+    * @brief Converts the container to a CBOR map
+    * @return CBOR map with the same keys as toJson()
+    *
+    * Unlike toJson(), unset times stay NaN and custom variables keep
+    * their types; hauler keys are integers.
+    */
+    QCborMap toCbor() const;
+
+    /**
+    * @brief Creates a container from a CBOR map
+    * @param cbor Map produced by toCbor()
+    * @param parent Optional parent QObject for memory management
+    * @return Newly allocated container, or nullptr if 'containerID' or
+    *         'containerSize' is missing (reported with qWarning())
+    */
+    static Container *fromCbor(const QCborMap &cbor, QObject *parent = nullptr);
+
+    /**
+    * @brief Streams the container as a CBOR map
+    * @param writer Destination writer
+    *
+    * Produces the same encoding as toCbor() without building the map.
+    */
+    void writeCbor(QCborStreamWriter &writer) const;
+
+    /**
+    * @brief Replaces the container's data with a streamed CBOR map
+    * @param reader Reader positioned on the map
+    * @return false if the value is not a map, has no 'containerID' or the
+    *         stream is corrupt
+    *
+    * A value that is not a map is skipped, so the reader is always past
+    * it unless the stream is corrupt.
+    *
+    * Decodes straight into the members, so a container can be reused
+    * for many records. No change signals are emitted; the revision is
+    * bumped.
+    */
+    bool readCbor(QCborStreamReader &reader);
+
     /**
     * @brief Creates a deep copy of this container
     * @return Pointer to the new copied container
@@ -370,6 +740,9 @@ public:
     * @param out Output stream
     * @param container Container to serialize
     * @return Reference to output stream
+    *
+    * Writes the versioned format (see DataStream), which covers every
+    * field including the times and the movement history policy.
     */
     friend CONTAINER_EXPORT QDataStream &operator<<(QDataStream &out, const Container &container);
 
@@ -378,6 +751,11 @@ public:
     * @param in Input stream
     * @param container Container to deserialize into
     * @return Reference to input stream
+    *
+    * Decodes straight into the members without emitting change signals,
+    * so a container can be reused for many records and keeps its
+    * allocations. Streams in the legacy, unversioned format are read as
+    * well; their times are NaN.
     */
     friend CONTAINER_EXPORT QDataStream &operator>>(QDataStream &in, Container &container);
 
@@ -459,38 +837,144 @@ signals:
      */
     void containerMovementHistoryChanged();
 
+    /**
+     * @brief Emitted once when the outermost change batch is closed
+     * @param changes Flags of all properties changed during the batch
+     *
+     * Only emitted for batched changes; unbatched setters emit their
+     * individual property signals only.
+     */
+    void containerChanged(ContainerCore::Container::ChangeFlags changes);
+
 private:
 
     /** Container's unique identifier */
     QString m_containerID;
 
-    /** Time when container was added */
-    double m_addedTime;
+    /** Time when container was added, NaN if not set */
+    double m_addedTime = std::numeric_limits<double>::quiet_NaN();
 
-    /** Scheduled departure time */
-    double m_leavingTime;
+    /** Scheduled departure time, NaN if not set */
+    double m_leavingTime = std::numeric_limits<double>::quiet_NaN();
 
     /** Container size classification */
     ContainerSize m_containerSize;
 
+    /** Number of packages stored inline before spilling to the heap */
+    static constexpr qsizetype InlinePackageCapacity = 4;
+
     /** Stored packages */
-    QVector<Package*> m_packages;
+    QVarLengthArray<PackageData, InlinePackageCapacity> m_packages;
 
-    /** Custom variables by hauler type */
+    /** Custom variables by hauler type (keys not in the schema) */
     QMap<HaulerType, QVariantMap> m_customVariables;
 
+    /** Schema-registered custom variables, indexed by slot */
+    QVector<CustomValue> m_customSlots;
+
     /** Current location */
     QString m_containerCurrentLocation;
 
     /** Planned destinations */
     QVector<QString> m_containerNextDestinations;
 
-    /** Location history */
+    /** Location history, oldest first */
     QVector<QString> m_containerMovementHistory;
 
+    /** Bound and lookup strategy for the location history */
+    MovementHistoryPolicy m_historyPolicy = defaultMovementHistoryPolicy();
+
+    /**
+    * Occurrence counts of the m_containerMovementHistory entries when
+    * hashedLookup is on; loaded histories may hold duplicates
+    */
+    QHash<QString, qsizetype> m_movementHistoryIndex;
+
     /** Python binding flag */
     bool m_isRunningThroughPython = false;
 
+    /** Nesting depth of open change batches */
+    int m_changeBatchDepth = 0;
+
+    /** Changes accumulated while a change batch is open */
+    ChangeFlags m_pendingChanges;
+
+    /** Current revision, see revision() */
+    quint64 m_revision = nextRevision();
+
+    /**
+    * @brief Draws a fresh value from the process-wide revision counter
+    */
+    static quint64 nextRevision();
+
+    /**
+    * @brief Emits or records a property change notification
+    * @param change The property that changed
+    *
+    * Emits the property's signal immediately unless a change batch is
+    * open, in which case the change is recorded for endChangeBatch().
+    */
+    void notifyChange(ChangeFlag change);
+
+    /**
+    * @brief Emits the signal associated with a single change flag
+    * @param change The property that changed
+    */
+    void emitChange(ChangeFlag change);
+
+    /**
+    * @brief Appends a location to the history unless already present
+    * @param location The location to add
+    * @return true if the history changed
+    *
+    * Drops the oldest entry when the history is at its bound.
+    */
+    bool appendMovementHistory(const QString &location);
+
+    /**
+    * @brief Trims the history to the policy bound and rebuilds the index
+    * @return true if entries were dropped
+    */
+    bool applyMovementHistoryPolicy();
+
+    /**
+    * @brief Drops one occurrence of a location from the history index
+    * @param location The location removed from the history
+    */
+    void unindexMovementHistory(const QString &location);
+
+    /**
+    * @brief Stores a custom variable in its schema slot if possible
+    * @param hauler The hauler type
+    * @param key The variable key
+    * @param value The variable value
+    * @return true if the key is registered and the value fits its type
+    */
+    bool storeInCustomSlot(HaulerType hauler, const QString &key,
+                           const QVariant &value);
+
+    /**
+    * @brief Merges the set schema slots into a custom variable map
+    * @param variables Map to merge into, keyed by hauler type
+    */
+    void mergeCustomSlots(QMap<HaulerType, QVariantMap> &variables) const;
+
+    /**
+    * @brief Finds a value held in an unregistered slot
+    * @param hauler The hauler type
+    * @param key The variable key
+    * @return Index of the retired slot holding a value for key, or -1
+    */
+    int retiredCustomSlot(HaulerType hauler, const QString &key) const;
+
+    /**
+    * @brief Drops a value held in an unregistered slot
+    * @param hauler The hauler type
+    * @param key The variable key
+    * @return true if a value was dropped
+    */
+    bool clearRetiredCustomSlot(HaulerType hauler, const QString &key);
+
     /**
     * @brief Performs deep copy of container data
     * @param other Source Container to copy from
@@ -498,6 +982,8 @@ private:
     void deepCopy(const Container &other);  // Helper function to perform deep copy
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(Container::ChangeFlags)
+
 } // namespace ContainerCore
 
 // Register Container types with Qt's meta-object system
@@ -0,0 +1,135 @@
+/**
+ * @file containerarrow.h
+ * @brief Apache Arrow IPC (Feather v2) export and import of containers
+ * @author Ahmed Aredah
+ * @date 2024
+ *
+ * Containers are written as one Arrow table with a row per container, so
+ * pandas, polars and other Arrow consumers can memory-map the file
+ * without parsing it. The columns are named after the keys of
+ * Container::toJson():
+ *
+ * @code
+ * containerID                utf8
+ * containerSize              int32
+ * containerCurrentLocation   utf8
+ * addedTime                  float64, NaN if not set
+ * leavingTime                float64, NaN if not set
+ * containerNextDestinations  list<utf8>
+ * containerMovementHistory   list<utf8>
+ * packages                   list<utf8>, the package IDs
+ * @endcode
+ *
+ * Custom variables are not exported; use a binary snapshot to keep them.
+ * The file is written uncompressed so readers can map it as is.
+ *
+ * Arrow support is optional. When the library was built without it,
+ * isAvailable() returns false and writing or reading fails with a
+ * warning.
+ */
+
+#ifndef CONTAINERARROW_H
+#define CONTAINERARROW_H
+
+#include "Container_global.h"
+#include "container.h"
+#include <QIODevice>
+#include <QString>
+#include <memory>
+
+namespace ContainerCore {
+
+/**
+ * @class ContainerArrowWriter
+ * @brief Accumulates containers into Arrow columns and writes a Feather file
+ *
+ * Containers are appended to the column builders as they are added, so
+ * callers can stream containers from a database and delete them right
+ * away.
+ */
+class CONTAINER_EXPORT ContainerArrowWriter
+{
+public:
+    ContainerArrowWriter();
+    ~ContainerArrowWriter();
+
+    ContainerArrowWriter(const ContainerArrowWriter &) = delete;
+    ContainerArrowWriter &operator=(const ContainerArrowWriter &) = delete;
+
+    /**
+    * @brief Checks whether the library was built with Arrow
+    * @return true if Feather files can be written and read
+    */
+    static bool isAvailable();
+
+    /**
+    * @brief Appends a container as a new row
+    * @param container The container to add
+    */
+    void addContainer(const Container &container);
+
+    /**
+    * @brief Returns the number of containers added so far
+    * @return Row count
+    */
+    qsizetype containerCount() const;
+
+    /**
+    * @brief Writes the table as a Feather v2 file to a device
+    * @param device Open, writable device
+    * @return true on success; failures are reported with qWarning()
+    */
+    bool write(QIODevice *device);
+
+private:
+    /** @brief Column builders, defined only when built with Arrow */
+    struct Columns;
+    std::unique_ptr<Columns> m_columns;
+    qsizetype m_count = 0;
+};
+
+/**
+ * @class ContainerArrowReader
+ * @brief Reads containers from a memory-mapped Feather file
+ *
+ * The file is mapped, not copied; column data is read in place until
+ * the reader is destroyed.
+ */
+class CONTAINER_EXPORT ContainerArrowReader
+{
+public:
+    ContainerArrowReader();
+    ~ContainerArrowReader();
+
+    ContainerArrowReader(const ContainerArrowReader &) = delete;
+    ContainerArrowReader &operator=(const ContainerArrowReader &) = delete;
+
+    /**
+    * @brief Maps a Feather file and checks its schema
+    * @param path Feather file path
+    * @return true if the file holds the columns described above
+    */
+    bool open(const QString &path);
+
+    /**
+    * @brief Returns the number of containers in the file
+    * @return Row count
+    */
+    qsizetype containerCount() const;
+
+    /**
+    * @brief Creates a new Container from a row
+    * @param index Row index in [0, containerCount())
+    * @return Newly allocated container; the caller takes ownership
+    */
+    Container *createContainer(qsizetype index) const;
+
+private:
+    /** @brief Mapped table, defined only when built with Arrow */
+    struct Table;
+    std::unique_ptr<Table> m_table;
+};
+
+} // namespace ContainerCore
+
+#endif // CONTAINERARROW_H
@@ -0,0 +1,77 @@
+/**
+ * @file containercbor.h
+ * @brief Helpers for reading the CBOR encoding of packages and containers
+ * @author Ahmed Aredah
+ * @date 2024
+ *
+ * Package, Container and ContainerMap encode to CBOR with the same keys
+ * as their JSON form, but times and custom variables keep their native
+ * types: NaN is stored as a CBOR double instead of null, and hauler keys
+ * of the custom variables are integers.
+ *
+ * The functions below consume one value from a QCborStreamReader and
+ * leave it positioned on the next one, so the streaming readers of
+ * Package, Container and ContainerMap can decode straight into members.
+ */
+
+#ifndef CONTAINERCBOR_H
+#define CONTAINERCBOR_H
+
+#include "Container_global.h"
+#include <QCborStreamReader>
+#include <QCborValue>
+#include <QString>
+#include <QVector>
+
+namespace ContainerCore {
+
+/**
+ * @namespace ContainerCore::Cbor
+ * @brief Value readers shared by the CBOR decoders
+ */
+namespace Cbor {
+
+/**
+ * @brief Reads a text string
+ * @param reader Reader positioned on the value
+ * @return The string; empty if the value is not a text string (the
+ *         value is skipped)
+ */
+CONTAINER_EXPORT QString readString(QCborStreamReader &reader);
+
+/**
+ * @brief Reads a number
+ * @param reader Reader positioned on the value
+ * @return The value as a double; NaN for null or non-numeric values
+ */
+CONTAINER_EXPORT double readDouble(QCborStreamReader &reader);
+
+/**
+ * @brief Reads an integer
+ * @param reader Reader positioned on the value
+ * @param defaultValue Returned if the value is not an integer
+ * @return The integer value
+ */
+CONTAINER_EXPORT qint64 readInteger(QCborStreamReader &reader,
+                                    qint64 defaultValue = 0);
+
+/**
+ * @brief Reads an array of text strings
+ * @param reader Reader positioned on the value
+ * @return The strings; non-string elements are skipped and a value that
+ *         is not an array yields an empty vector
+ */
+CONTAINER_EXPORT QVector<QString> readStringArray(QCborStreamReader &reader);
+
+/**
+ * @brief Converts a decoded value to a time
+ * @param value Integer or double value
+ * @return The value as a double; NaN for null or non-numeric values
+ */
+CONTAINER_EXPORT double toDouble(const QCborValue &value);
+
+} // namespace Cbor
+
+} // namespace ContainerCore
+
+#endif // CONTAINERCBOR_H
@@ -0,0 +1,266 @@
+/**
+ * @file containercompression.h
+ * @brief Block-compressed container for snapshots and JSON exports
+ * @author Ahmed Aredah
+ * @date 2024
+ *
+ * Snapshots and JSON exports are split into fixed-size blocks that are
+ * compressed independently, so any block can be decompressed without
+ * touching the others and large files can be inflated in parallel.
+ *
+ * Layout (all integers little-endian):
+ *
+ * @code
+ * FileHeader              24 bytes, magic "CNTRBLKZ", version, codec
+ * compressed blocks ...   back to back, in order
+ * BlockEntry[blockCount]  block table at Trailer::tableOffset
+ * Trailer                 32 bytes at the end of the file
+ * @endcode
+ *
+ * Zlib is always available (through qCompress()). Zstd and LZ4 are
+ * available when the library was built with them; see
+ * isCodecAvailable().
+ */
+
+#ifndef CONTAINERCOMPRESSION_H
+#define CONTAINERCOMPRESSION_H
+
+#include "Container_global.h"
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QIODevice>
+#include <QVector>
+#include <QtEndian>
+
+namespace ContainerCore {
+
+/**
+ * @namespace ContainerCore::Compression
+ * @brief On-disk structures of the block-compressed format
+ */
+namespace Compression {
+
+/** File signature at the start of every compressed file */
+inline constexpr char Magic[8] = {'C', 'N', 'T', 'R', 'B', 'L', 'K', 'Z'};
+
+/** Current format version */
+inline constexpr quint32 FormatVersion = 1;
+
+/** Default uncompressed block size */
+inline constexpr quint32 DefaultBlockSize = 1 << 20;
+
+/**
+ * @enum Codec
+ * @brief Compression algorithm applied to every block of a file
+ */
+enum Codec : quint32 {
+    NoCompression = 0,  /**< Plain, uncompressed output */
+    Zlib          = 1,  /**< zlib through qCompress(), always available */
+    Zstd          = 2,  /**< Zstandard, if built with it */
+    Lz4           = 3   /**< LZ4, if built with it */
+};
+
+/**
+ * @struct FileHeader
+ * @brief Fixed header at offset 0
+ */
+struct FileHeader {
+    char magic[8];
+    quint32_le version;
+    quint32_le codec;
+    quint32_le blockSize;
+    quint32_le reserved;
+};
+
+/**
+ * @struct BlockEntry
+ * @brief Block table entry
+ */
+struct BlockEntry {
+    quint64_le offset;
+    quint32_le compressedSize;
+    quint32_le uncompressedSize;
+};
+
+/**
+ * @struct Trailer
+ * @brief Fixed trailer at the end of the file
+ */
+struct Trailer {
+    quint64_le tableOffset;
+    quint64_le blockCount;
+    quint64_le uncompressedSize;
+    char magic[8];
+};
+
+static_assert(sizeof(FileHeader) == 24, "Unexpected compressed header size");
+static_assert(sizeof(BlockEntry) == 16, "Unexpected block entry size");
+static_assert(sizeof(Trailer) == 32, "Unexpected compressed trailer size");
+
+/**
+ * @brief Checks whether a codec was compiled in
+ * @param codec The codec to check
+ * @return true if data can be compressed and decompressed with it
+ */
+CONTAINER_EXPORT bool isCodecAvailable(Codec codec);
+
+/**
+ * @brief Returns the fastest available codec
+ * @return Zstd if available, otherwise LZ4, otherwise Zlib
+ */
+CONTAINER_EXPORT Codec bestAvailableCodec();
+
+/**
+ * @brief Checks whether data starts with the compressed-file magic
+ * @param prefix The first bytes of a file or device
+ * @return true if the data is block compressed
+ */
+CONTAINER_EXPORT bool isCompressed(QByteArrayView prefix);
+
+/**
+ * @brief Decompresses a whole block-compressed file held in memory
+ * @param data Pointer to the compressed bytes
+ * @param size Size of the compressed bytes
+ * @param output Receives the uncompressed bytes
+ * @param threadCount Worker threads; 0 uses QThread::idealThreadCount()
+ * @return true on success; failures are reported with qWarning()
+ *
+ * Blocks are independent, so they are inflated in parallel straight
+ * into their place in @p output.
+ */
+CONTAINER_EXPORT bool decompress(const uchar *data, qint64 size,
+                                 QByteArray &output, int threadCount = 0);
+
+} // namespace Compression
+
+/**
+ * @class CompressedBlockWriter
+ * @brief Write-only device that block-compresses into another device
+ *
+ * Data written to this device is collected into blocks of the configured
+ * size; each full block is compressed and written to the target at once,
+ * so memory use is bounded by one block. close() writes the last block,
+ * the block table and the trailer.
+ *
+ * Requesting a codec that is not available falls back to Zlib with a
+ * warning.
+ */
+class CONTAINER_EXPORT CompressedBlockWriter : public QIODevice
+{
+public:
+    /**
+    * @brief Constructs a writer over an open, writable device
+    * @param target Destination device; must outlive the writer
+    * @param codec Compression codec for all blocks
+    * @param blockSize Uncompressed block size
+    */
+    CompressedBlockWriter(QIODevice *target, Compression::Codec codec,
+                          quint32 blockSize = Compression::DefaultBlockSize);
+
+    /**
+    * @brief Closes the device if it is still open
+    */
+    ~CompressedBlockWriter() override;
+
+    /**
+    * @brief Returns the codec actually used
+    * @return The requested codec, or Zlib if it was not available
+    */
+    Compression::Codec codec() const;
+
+    /**
+    * @brief Checks whether writing to the target failed
+    * @return true if any block, the table or the trailer was not written
+    */
+    bool hasError() const;
+
+    /**
+    * @brief Flushes the last block and writes the block table and trailer
+    */
+    void close() override;
+
+    bool isSequential() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 size) override;
+
+private:
+    /**
+    * @brief Compresses the pending block and writes it to the target
+    * @return false if the target rejected the data
+    */
+    bool flushBlock();
+
+    QIODevice *m_target;
+    Compression::Codec m_codec;
+    quint32 m_blockSize;
+    QByteArray m_pending;
+    QVector<Compression::BlockEntry> m_blocks;
+    quint64 m_offset = 0;
+    quint64 m_uncompressedSize = 0;
+    bool m_failed = false;
+};
+
+/**
+ * @class CompressedBlockReader
+ * @brief Read-only device that inflates a block-compressed device
+ *
+ * The source must support random access since the block table is stored
+ * at its end. Blocks are inflated one at a time as they are read, and
+ * readBlock() gives direct access to any block.
+ */
+class CONTAINER_EXPORT CompressedBlockReader : public QIODevice
+{
+public:
+    /**
+    * @brief Constructs a reader over an open, readable device
+    * @param source Compressed device; must outlive the reader
+    */
+    explicit CompressedBlockReader(QIODevice *source);
+
+    /**
+    * @brief Reads the header and block table and opens the device
+    * @param mode Must be QIODevice::ReadOnly
+    * @return false if the source is not a valid compressed file
+    */
+    bool open(OpenMode mode) override;
+
+    /**
+    * @brief Returns the number of blocks
+    * @return Block count
+    */
+    qsizetype blockCount() const;
+
+    /**
+    * @brief Decompresses a single block
+    * @param index Block index in [0, blockCount())
+    * @return The uncompressed bytes, or an empty array on failure
+    */
+    QByteArray readBlock(qsizetype index);
+
+    /**
+    * @brief Returns the total size of the uncompressed data
+    * @return Size in bytes
+    */
+    quint64 uncompressedSize() const;
+
+    bool isSequential() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 size) override;
+
+private:
+    QIODevice *m_source;
+    Compression::Codec m_codec = Compression::NoCompression;
+    QVector<Compression::BlockEntry> m_blocks;
+    quint64 m_uncompressedSize = 0;
+    qsizetype m_nextBlock = 0;
+    QByteArray m_current;
+    qsizetype m_currentPos = 0;
+};
+
+} // namespace ContainerCore
+
+#endif // CONTAINERCOMPRESSION_H
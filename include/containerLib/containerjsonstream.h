@@ -0,0 +1,253 @@
+/**
+ * @file containerjsonstream.h
+ * @brief Incremental reader and writer for large container JSON documents
+ * @author Ahmed Aredah
+ * @date 2024
+ *
+ * This file defines ContainerJsonStreamReader, which walks a JSON document
+ * of the form accepted by ContainerMap::addContainers(const QJsonObject&)
+ * without building a DOM for the whole document. Only one element of the
+ * "containers" array is held in memory at a time, so manifests much larger
+ * than the available RAM can be ingested.
+ *
+ * ContainerJsonWriter is the output counterpart used by
+ * Container::writeJson() and ContainerMap::writeJson(). It emits compact
+ * JSON straight to a device through a reusable buffer.
+ */
+
+#ifndef CONTAINERJSONSTREAM_H
+#define CONTAINERJSONSTREAM_H
+
+#include "Container_global.h"
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QIODevice>
+#include <QJsonValue>
+#include <QString>
+#include <QStringView>
+#include <QVarLengthArray>
+
+namespace ContainerCore {
+
+/**
+ * @class ContainerJsonStreamReader
+ * @brief Splits the "containers" array of a JSON document into elements
+ *
+ * The reader scans the top-level object for the "containers" key and
+ * then returns the raw text of each array element in turn. Other
+ * top-level members are skipped. The element text is a complete JSON
+ * value that can be handed to QJsonDocument::fromJson().
+ *
+ * The scanner only tracks nesting, strings and escapes; it does not
+ * validate the elements themselves, so a malformed element is reported
+ * when it is parsed and does not stop the stream.
+ */
+class CONTAINER_EXPORT ContainerJsonStreamReader
+{
+public:
+    /** Default number of bytes read from the device at a time */
+    static constexpr qint64 DefaultChunkSize = 1 << 16;
+
+    /**
+    * @brief Constructs a reader over an open, readable device
+    * @param device Source device; must outlive the reader
+    * @param chunkSize Number of bytes read from the device at a time
+    */
+    explicit ContainerJsonStreamReader(QIODevice *device,
+                                       qint64 chunkSize = DefaultChunkSize);
+
+    /**
+    * @brief Reads the next element of the "containers" array
+    * @param element Receives the raw JSON text of the element
+    * @return true if an element was read; false at the end of the array
+    *         or on a syntax error (see hasError())
+    */
+    bool readNext(QByteArray &element);
+
+    /**
+    * @brief Checks whether the document could not be split
+    * @return true if a syntax error or read error occurred
+    */
+    bool hasError() const;
+
+    /**
+    * @brief Returns a description of the last error
+    * @return Error message, empty if there was none
+    */
+    QString errorString() const;
+
+    /**
+    * @brief Returns the index of the element last returned by readNext()
+    * @return Zero-based element index, -1 before the first element
+    */
+    qsizetype elementIndex() const;
+
+private:
+    enum State {
+        Start,
+        InArray,
+        Finished
+    };
+
+    /**
+    * @brief Appends the next chunk of the device to the buffer
+    * @return false if the device has no more data
+    */
+    bool fill();
+
+    /**
+    * @brief Skips whitespace and returns the next character
+    * @param c Receives the character; it is not consumed
+    * @return false at the end of the input
+    */
+    bool peek(char &c);
+
+    /**
+    * @brief Finds the end of the JSON value starting at m_pos
+    * @param end Receives the offset one past the value
+    * @return false if the input ends inside the value
+    */
+    bool scanValue(qsizetype &end);
+
+    /**
+    * @brief Positions the reader just inside the "containers" array
+    * @return false if the array cannot be found
+    */
+    bool enterContainersArray();
+
+    /**
+    * @brief Records a syntax error and stops the reader
+    * @param message Error description
+    * @return Always false
+    */
+    bool fail(const QString &message);
+
+    QIODevice *m_device;
+    qint64 m_chunkSize;
+    QByteArray m_buffer;
+    qsizetype m_pos = 0;
+    State m_state = Start;
+    qsizetype m_elementIndex = -1;
+    QString m_error;
+};
+
+/**
+ * @class ContainerJsonWriter
+ * @brief Writes compact JSON to a device without building a DOM
+ *
+ * Output goes through an internal buffer that is handed to the device
+ * whenever it grows past the configured size and reused afterwards.
+ * Members and array elements are separated automatically; callers are
+ * responsible for emitting object members in the order they want them,
+ * which is sorted by key when the output must match
+ * QJsonDocument::toJson(QJsonDocument::Compact).
+ *
+ * Numbers are written the way QJsonDocument writes them; NaN and
+ * infinities become null.
+ */
+class CONTAINER_EXPORT ContainerJsonWriter
+{
+public:
+    /** Default buffer size before data is handed to the device */
+    static constexpr qsizetype DefaultBufferSize = 1 << 16;
+
+    /**
+    * @brief Constructs a writer over an open, writable device
+    * @param device Destination device; must outlive the writer
+    * @param bufferSize Bytes to collect before writing to the device
+    */
+    explicit ContainerJsonWriter(QIODevice *device,
+                                 qsizetype bufferSize = DefaultBufferSize);
+
+    /**
+    * @brief Flushes any buffered output
+    */
+    ~ContainerJsonWriter();
+
+    ContainerJsonWriter(const ContainerJsonWriter &) = delete;
+    ContainerJsonWriter &operator=(const ContainerJsonWriter &) = delete;
+
+    /** @brief Opens an object */
+    void beginObject();
+
+    /** @brief Closes the innermost object */
+    void endObject();
+
+    /** @brief Opens an array */
+    void beginArray();
+
+    /** @brief Closes the innermost array */
+    void endArray();
+
+    /**
+    * @brief Writes an object member name
+    * @param key Member name; the value must follow
+    */
+    void writeKey(QStringView key);
+
+    /** @brief Writes a string value */
+    void writeString(QStringView value);
+
+    /** @brief Writes a number, or null if it is not finite */
+    void writeDouble(double value);
+
+    /** @brief Writes an integer */
+    void writeInteger(qint64 value);
+
+    /** @brief Writes a boolean */
+    void writeBool(bool value);
+
+    /** @brief Writes null */
+    void writeNull();
+
+    /**
+    * @brief Writes any JSON value, including nested objects and arrays
+    * @param value The value to write
+    */
+    void writeValue(const QJsonValue &value);
+
+    /**
+    * @brief Hands the buffered output to the device
+    * @return false if the device rejected the data
+    */
+    bool flush();
+
+    /**
+    * @brief Checks whether writing to the device failed
+    * @return true after a failed write
+    */
+    bool hasError() const;
+
+private:
+    /**
+    * @brief Emits the separator needed before the next value
+    */
+    void beginValue();
+
+    /**
+    * @brief Appends an escaped, quoted string to the buffer
+    * @param value The string to write
+    */
+    void appendString(QStringView value);
+
+    /**
+    * @brief Flushes if the buffer has grown past its limit
+    */
+    void flushIfFull();
+
+    QIODevice *m_device;
+    qsizetype m_bufferSize;
+    QByteArray m_buffer;
+
+    /** Per open container: true until its first element is written */
+    QVarLengthArray<bool, 16> m_first;
+
+    /** Set after a key until its value is written */
+    bool m_afterKey = false;
+
+    bool m_error = false;
+};
+
+} // namespace ContainerCore
+
+#endif // CONTAINERJSONSTREAM_H
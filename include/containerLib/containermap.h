@@ -17,18 +17,26 @@
 #include "Container_global.h"
 #include <QObject>
 #include <QMap>
+#include <QSet>
+#include <QStringList>
 #include <QVariant>
 #include <QDataStream>
 #include <QMutex>
+#include <QHash>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QCache>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QCborMap>
 #include "containercache.h"
+#include "containercompression.h"
 #include "container.h"
 #include <QCoreApplication>
+#include <QIODevice>
+#include <memory>
+#include <functional>
 
 
 namespace ContainerCore {
@@ -52,6 +60,81 @@ class CONTAINER_EXPORT ContainerMap : public QObject
 {
     Q_OBJECT
 public:
+    /**
+     * @class ChangeBatch
+     * @brief RAII guard that batches the map's change notifications
+     *
+     * The constructor calls beginBatch() and the destructor endBatch(),
+     * so every container added or removed inside the guarded scope is
+     * reported through a single containersChanged() and
+     * containersBatchChanged() pair.
+     */
+    class ChangeBatch
+    {
+    public:
+        explicit ChangeBatch(ContainerMap *map)
+            : m_map(map)
+        {
+            if (m_map) {
+                m_map->beginBatch();
+            }
+        }
+
+        ~ChangeBatch()
+        {
+            if (m_map) {
+                m_map->endBatch();
+            }
+        }
+
+        ChangeBatch(const ChangeBatch &) = delete;
+        ChangeBatch &operator=(const ChangeBatch &) = delete;
+
+    private:
+        ContainerMap *m_map;
+    };
+
+    /**
+     * @struct Columns
+     * @brief Scalar container fields gathered column by column
+     *
+     * Entry i of every column belongs to the same container. Unset times
+     * are NaN.
+     */
+    struct Columns
+    {
+        QVector<QString> ids;
+        QVector<qint32> sizes;
+        QVector<double> addedTimes;
+        QVector<double> leavingTimes;
+    };
+
+    /**
+     * @struct PageFilter
+     * @brief Restricts the containers returned by getContainersPage()
+     *
+     * The tests match the corresponding getContainersBy...() queries.
+     */
+    struct PageFilter
+    {
+        /** @brief Property the filter tests */
+        enum Field {
+            NoFilter,       /**< Every container matches */
+            AddedTime,      /**< Added time compared with referenceTime */
+            LeavingTime,    /**< Leaving time compared with referenceTime */
+            NextDestination /**< destination is among the next destinations */
+        };
+
+        Field field = NoFilter;
+
+        /** @brief Comparison operator (">", ">=", "<", "<=", "=", "!=") */
+        QString condition;
+
+        double referenceTime = std::nan("");
+
+        QString destination;
+    };
+
     /**
      * @brief Constructs an empty ContainerMap using in-memory storage
      * @param parent Optional parent QObject for memory management
@@ -96,6 +179,30 @@ public:
      */
     void setIsRunningThroughPython(bool isRunningThroughPython);
 
+    /**
+     * @brief Opens a notification batch
+     *
+     * While a batch is open, adding, removing or dequeuing containers
+     * records the affected container IDs instead of emitting
+     * containersChanged() for every element. Batches may be nested.
+     */
+    void beginBatch();
+
+    /**
+     * @brief Closes a notification batch opened by beginBatch()
+     *
+     * When the outermost batch closes and something changed,
+     * containersChanged() is emitted once followed by
+     * containersBatchChanged() with the IDs of all affected containers.
+     */
+    void endBatch();
+
+    /**
+     * @brief Checks whether a notification batch is currently open
+     * @return true if change notifications are being accumulated
+     */
+    bool isBatching() const;
+
     /**
      * @brief Adds a container to the map
      * @param id Unique identifier for the container
@@ -145,6 +252,48 @@ public:
     */
     void removeContainerByID(const QString &id);
 
+    /**
+    * @brief Sets the current location of many containers at once
+    * @param ids IDs of the containers to update
+    * @param locations New location for each ID, in the same order
+    * @return Number of containers updated; unknown IDs are skipped
+    *
+    * All updates run under a single lock and, for database storage, a
+    * single transaction. If the database cannot store an update the
+    * transaction is rolled back, databaseErrorOccurred() is emitted and
+    * 0 is returned. Each container emits its change signals once
+    * and the map reports all updated IDs through one
+    * containersBatchChanged().
+    */
+    qsizetype setContainersCurrentLocation(const QStringList &ids,
+                                           const QStringList &locations);
+
+    /**
+    * @brief Appends a next destination to many containers at once
+    * @param ids IDs of the containers to update
+    * @param destinations Destination to add for each ID, in the same order
+    * @return Number of containers updated; unknown IDs are skipped
+    *
+    * Batched like setContainersCurrentLocation().
+    */
+    qsizetype addContainersDestination(const QStringList &ids,
+                                       const QStringList &destinations);
+
+    /**
+    * @brief Sets a custom variable on many containers at once
+    * @param ids IDs of the containers to update
+    * @param hauler The hauler type
+    * @param key The variable key
+    * @param values Value for each ID, in the same order
+    * @return Number of containers updated; unknown IDs are skipped
+    *
+    * Batched like setContainersCurrentLocation().
+    */
+    qsizetype addContainersCustomVariable(const QStringList &ids,
+                                          Container::HaulerType hauler,
+                                          const QString &key,
+                                          const QVariantList &values);
+
     /**
     * @brief Retrieves all containers in the map
     * @return Map of container IDs to container pointers
@@ -152,6 +301,41 @@ public:
     */
     QMap<QString, Container*> getAllContainers() const;
 
+    /**
+    * @brief Checks whether a container is in the map without loading it
+    * @param id The container's unique identifier
+    * @return true if a container with this ID is stored
+    */
+    bool containsContainer(const QString &id) const;
+
+    /**
+    * @brief Returns the IDs that sort after an ID, in ascending order
+    * @param afterID Exclusive lower bound; empty to start at the first ID
+    * @param limit Maximum number of IDs to return
+    * @return Up to @p limit IDs
+    *
+    * Pass the last ID of a page as @p afterID to get the next page, so a
+    * map can be walked without loading all of it. Containers added or
+    * removed between calls are seen or skipped according to their ID.
+    */
+    QStringList getContainerIDsPage(const QString &afterID,
+                                    qsizetype limit) const;
+
+    /**
+    * @brief Returns the containers that sort after an ID, in ID order
+    * @param afterID Exclusive lower bound; empty to start at the first ID
+    * @param limit Maximum number of containers to return
+    * @param filter Only containers matching the filter are returned
+    * @return Up to @p limit containers, owned by the map
+    *
+    * Pages through the map like getContainerIDsPage(). For database
+    * storage each page is one query; only its containers are loaded.
+    * Emits databaseErrorOccurred signal on failure.
+    */
+    QVector<Container *> getContainersPage(const QString &afterID,
+                                           qsizetype limit,
+                                           const PageFilter &filter = PageFilter());
+
     /**
     * @brief Retrieves the most recently added containers
     * @return Map of container IDs to container pointers
@@ -181,6 +365,37 @@ public:
     */
     qsizetype size() const;
 
+    /**
+    * @brief Copies the scalar fields of all containers into columns
+    * @return One entry per container in every column
+    *
+    * All columns are filled in one pass under a single lock, so they are
+    * consistent with each other. For database storage only the
+    * Containers table is read (cached containers take precedence); a
+    * snapshot-backed map reads the records without creating containers.
+    * Emits databaseErrorOccurred signal on failure.
+    */
+    Columns columns() const;
+
+    /**
+    * @brief Visits every container under the map lock
+    * @param visit Called once per container
+    * @return false if the containers could not be read from the database
+    *
+    * Database rows that are not cached and snapshot records are passed
+    * as temporaries that only live for the call. The visitor must not
+    * call back into the map.
+    */
+    bool forEachContainer(
+        const std::function<void(const Container &)> &visit) const;
+
+    /**
+    * @brief Checks whether the map stores its containers in a database
+    * @return true if the map was constructed with a database location
+    * and is not serving a snapshot opened with openSnapshot()
+    */
+    bool isDatabaseBacked() const;
+
     /**
     * @brief Converts the ContainerMap to a JSON object
     * @return JSON object containing all container data
@@ -264,6 +479,365 @@ public:
     */
     static QVector<Container*> loadContainersFromJson(const QJsonObject &json);
 
+    /**
+    * @brief Adds containers from a JSON document read incrementally
+    * @param device Open, readable device holding the document
+    * @param addingTime Time when the containers were added (NaN for unspecified)
+    * @param leavingTime Time when the containers should leave (NaN for unspecified)
+    * @return false if the document could not be read to the end
+    *
+    * Accepts the same document as addContainers(const QJsonObject&) but
+    * never holds more than one element of the "containers" array in
+    * memory. Invalid records are skipped with the same warnings as
+    * addContainers(const QJsonObject&); containers read before a syntax
+    * error in the document stay in the map.
+    */
+    bool addContainersFromJsonStream(QIODevice *device,
+                                     double addingTime = std::nan("notDefined"),
+                                     double leavingTime = std::nan("notDefined"));
+
+    /**
+    * @brief Adds containers from a JSON file read incrementally
+    * @param path JSON file path
+    * @param addingTime Time when the containers were added (NaN for unspecified)
+    * @param leavingTime Time when the containers should leave (NaN for unspecified)
+    * @return false if the file could not be opened or read to the end
+    */
+    bool addContainersFromJsonFile(const QString &path,
+                                   double addingTime = std::nan("notDefined"),
+                                   double leavingTime = std::nan("notDefined"));
+
+    /**
+    * @brief Creates containers from a JSON document read incrementally
+    * @param device Open, readable device holding the document
+    * @return Vector of created containers
+    * @note The caller is responsible for memory management of returned containers
+    */
+    static QVector<Container*> loadContainersFromJsonStream(QIODevice *device);
+
+    /**
+    * @brief Adds containers from a CBOR map
+    * @param cbor Map with a "containers" array, as produced by toCbor()
+    * @param addingTime Time when the containers were added
+    * @param leavingTime Time when the containers should leave
+    *
+    * Invalid records are skipped with a warning. All containers are added
+    * under a single lock and reported as one change.
+    */
+    void addContainers(const QCborMap &cbor,
+                       double addingTime = std::nan("notDefined"),
+                       double leavingTime = std::nan("notDefined"));
+
+    /**
+    * @brief Adds containers from a CBOR document read from a device
+    * @param device Open, readable device; may be block compressed
+    * @param addingTime Time when the containers were added
+    * @param leavingTime Time when the containers should leave
+    * @return false if the document is not valid CBOR or has no
+    *         "containers" array
+    *
+    * Containers are decoded one at a time straight from the stream, so
+    * the document is never held in memory as a whole.
+    */
+    bool addContainersFromCborStream(QIODevice *device,
+                                     double addingTime = std::nan("notDefined"),
+                                     double leavingTime = std::nan("notDefined"));
+
+    /**
+    * @brief Adds containers from a JSON object, constructing them in parallel
+    * @param json JSON object containing a "containers" array
+    * @param addingTime Time when the containers were added (NaN for unspecified)
+    * @param leavingTime Time when the containers should leave (NaN for unspecified)
+    * @param threadCount Worker threads to use; 0 uses QThread::idealThreadCount()
+    *
+    * The array is split into chunks that are turned into containers on a
+    * private thread pool. The results are added in array order under a
+    * single lock and, for database storage, a single transaction.
+    * Invalid records are reported as by addContainers(const QJsonObject&).
+    */
+    void addContainersParallel(const QJsonObject &json,
+                               double addingTime = std::nan("notDefined"),
+                               double leavingTime = std::nan("notDefined"),
+                               int threadCount = 0);
+
+    /**
+    * @brief Adds containers from a JSON document, parsing it in parallel
+    * @param device Open, readable device holding the document
+    * @param addingTime Time when the containers were added (NaN for unspecified)
+    * @param leavingTime Time when the containers should leave (NaN for unspecified)
+    * @param threadCount Worker threads to use; 0 uses QThread::idealThreadCount()
+    * @return false if the document could not be read to the end
+    *
+    * The calling thread splits the "containers" array as
+    * addContainersFromJsonStream() does; parsing and construction of
+    * each chunk of elements run on a private thread pool. Only a few
+    * chunks of raw JSON per thread are in flight at any time.
+    */
+    bool addContainersParallel(QIODevice *device,
+                               double addingTime = std::nan("notDefined"),
+                               double leavingTime = std::nan("notDefined"),
+                               int threadCount = 0);
+
+    /**
+    * @brief Creates and adds containers from parallel columns
+    * @param columns Container IDs and, optionally, their sizes and times
+    * @param locations Current location of each container; may be empty
+    * @param threadCount Worker threads to use; 0 uses QThread::idealThreadCount()
+    * @return Number of containers added, 0 if the columns do not line up
+    *         or the database could not store them
+    *
+    * Entry i of every column describes the same container. Columns other
+    * than ids may be empty, in which case the containers are twentyFT,
+    * have no times and no location. Each container keeps its own added
+    * and leaving time. Rows with an empty ID, an unknown size or an ID
+    * that an earlier row already uses are skipped with a warning; an ID
+    * already in the map is replaced as addContainer() does.
+    *
+    * Containers are constructed on a private thread pool and added in
+    * column order under a single lock and, for database storage, a
+    * single transaction.
+    */
+    qsizetype addContainersFromColumns(const Columns &columns,
+                                       const QVector<QString> &locations = QVector<QString>(),
+                                       int threadCount = 0);
+
+    /**
+    * @brief Trims every container's movement history to its newest entries
+    * @param keepLast Number of most recent entries to keep per container
+    * @return Number of history entries moved out of the live history
+    *
+    * For database storage the dropped entries are appended to the
+    * MovementHistoryArchive table, oldest first, and can be read back with
+    * getArchivedMovementHistory(). The archive and the trim are one
+    * transaction, and cached containers are trimmed only after it
+    * commits; on failure nothing changes, 0 is returned and
+    * databaseErrorOccurred is emitted.
+    *
+    * For in-memory storage there is nowhere to archive to: the dropped
+    * entries are discarded for good and getArchivedMovementHistory()
+    * never returns them.
+    */
+    qsizetype compactMovementHistory(qsizetype keepLast);
+
+    /**
+    * @brief Retrieves the movement history archived by compactMovementHistory()
+    * @param id The container's unique identifier
+    * @return Archived locations, oldest first; empty for in-memory storage
+    */
+    QVector<QString> getArchivedMovementHistory(const QString &id) const;
+
+    /**
+    * @brief Writes the map as compact JSON to a device
+    * @param device Open, writable device
+    * @param codec Block compression codec
+    * @return true on success
+    *
+    * Produces the same document as serializing toJson() with
+    * QJsonDocument::Compact, but containers are written one at a time
+    * through a reusable buffer instead of being collected first.
+    * With a codec other than NoCompression the output is block
+    * compressed as described in containercompression.h.
+    */
+    bool writeJson(QIODevice *device,
+                   Compression::Codec codec = Compression::NoCompression) const;
+
+    /**
+    * @brief Converts the map to a CBOR map
+    * @return CBOR map shaped like toJson(), with containers encoded by
+    *         Container::toCbor()
+    */
+    QCborMap toCbor() const;
+
+    /**
+    * @brief Writes the map as CBOR to a device
+    * @param device Open, writable device
+    * @param codec Block compression codec
+    * @return true on success
+    *
+    * Produces the same document as toCbor().toCborValue().toCbor(), except
+    * that the "containers" array has indefinite length. Containers are
+    * encoded one at a time without building the map.
+    */
+    bool writeCbor(QIODevice *device,
+                   Compression::Codec codec = Compression::NoCompression) const;
+
+    /**
+    * @brief Writes all containers to a binary snapshot file
+    * @param path Destination file path
+    * @param codec Block compression codec
+    * @return true on success
+    *
+    * The snapshot format is described in containersnapshot.h. For
+    * database storage the containers are streamed from the database;
+    * cached containers are written as they are in memory.
+    * The file is replaced atomically. Failures are reported with
+    * qWarning().
+    *
+    * With a codec other than NoCompression the snapshot is block
+    * compressed; loadSnapshot(), openSnapshot() and
+    * applyDeltaSnapshot() recognize compressed files and inflate their
+    * blocks in parallel.
+    */
+    bool saveSnapshot(const QString &path,
+                      Compression::Codec codec = Compression::NoCompression) const;
+
+    /**
+    * @brief Writes all containers as a binary snapshot to a device
+    * @param device Open, writable device
+    * @param codec Block compression codec
+    * @return true on success
+    */
+    bool saveSnapshot(QIODevice *device,
+                      Compression::Codec codec = Compression::NoCompression) const;
+
+    /**
+    * @brief Replaces the map's contents with the containers of a snapshot
+    * @param path Snapshot file path
+    * @return true on success; the map is left unchanged on failure
+    *
+    * For database storage the loaded containers are written to the
+    * database in a single transaction. Emits containersChanged() once.
+    */
+    bool loadSnapshot(const QString &path);
+
+    /**
+    * @brief Replaces the map's contents with a snapshot read from a device
+    * @param device Open, readable device
+    * @return true on success; the map is left unchanged on failure
+    */
+    bool loadSnapshot(QIODevice *device);
+
+    /**
+    * @brief Records the current state as the base for delta snapshots
+    *
+    * Call after writing a full snapshot with saveSnapshot().
+    * loadSnapshot(), applyDeltaSnapshot() and saveDeltaSnapshot() move the
+    * checkpoint themselves. Only in-memory storage tracks changes.
+    */
+    void markCheckpoint();
+
+    /**
+    * @brief Checks whether a checkpoint has been recorded
+    * @return true once markCheckpoint() or a snapshot load has run
+    */
+    bool hasCheckpoint() const;
+
+    /**
+    * @brief Writes the changes since the last checkpoint as a delta snapshot
+    * @param path Destination file path
+    * @param codec Block compression codec
+    * @return true on success
+    *
+    * The delta holds the containers added or modified since the
+    * checkpoint and the IDs of the removed ones. Modifications are found
+    * through Container::revision(), so nothing is recorded while the map
+    * is being changed. On success the checkpoint moves to the current
+    * state, so consecutive deltas form a chain on top of the base.
+    * Requires in-memory storage and a checkpoint.
+    */
+    bool saveDeltaSnapshot(const QString &path,
+                           Compression::Codec codec = Compression::NoCompression);
+
+    /**
+    * @brief Writes the changes since the last checkpoint to a device
+    * @param device Open, writable device
+    * @param codec Block compression codec
+    * @return true on success
+    */
+    bool saveDeltaSnapshot(QIODevice *device,
+                           Compression::Codec codec = Compression::NoCompression);
+
+    /**
+    * @brief Applies a delta snapshot on top of the current contents
+    * @param path Delta snapshot file path
+    * @return true on success; the map is left unchanged on failure
+    *
+    * Removed containers are dropped and added or modified ones replace
+    * any container with the same ID. Emits containersChanged() once.
+    */
+    bool applyDeltaSnapshot(const QString &path);
+
+    /**
+    * @brief Applies a delta snapshot read from a device
+    * @param device Open, readable device
+    * @return true on success; the map is left unchanged on failure
+    */
+    bool applyDeltaSnapshot(QIODevice *device);
+
+    /**
+    * @brief Loads a base snapshot and replays deltas on top of it
+    * @param basePath Full snapshot file path
+    * @param deltaPaths Delta snapshot file paths, oldest first
+    * @return false if any file could not be loaded; the map then holds
+    *         the state up to the last file that could
+    */
+    bool loadSnapshotChain(const QString &basePath,
+                           const QStringList &deltaPaths);
+
+    /**
+    * @brief Folds a base snapshot and its deltas into one full snapshot
+    * @param basePath Full snapshot file path
+    * @param deltaPaths Delta snapshot file paths, oldest first
+    * @param outputPath Path of the compacted snapshot; may be basePath
+    * @return true on success
+    */
+    static bool compactSnapshotChain(const QString &basePath,
+                                     const QStringList &deltaPaths,
+                                     const QString &outputPath);
+
+    /**
+    * @brief Serves the map read-only from a memory-mapped snapshot file
+    * @param path Snapshot file path
+    * @return true on success; the map is left unchanged on failure
+    *
+    * The snapshot is not deserialized. getContainerByID(), size() and the
+    * time and destination queries and counts are answered from the
+    * mapped file using the indexes embedded in the snapshot. Container
+    * objects are created on first access and stay valid until
+    * closeSnapshot(). Operations that modify the map are rejected with a
+    * warning while the snapshot is open; clear() and loadSnapshot() close
+    * it. The map's previous contents are released (the database, if any,
+    * is left untouched).
+    */
+    bool openSnapshot(const QString &path);
+
+    /**
+    * @brief Closes a snapshot opened with openSnapshot()
+    *
+    * Deletes the containers materialized from the snapshot unless
+    * running through Python. The map is empty afterwards.
+    */
+    void closeSnapshot();
+
+    /**
+    * @brief Checks whether the map is served from a mapped snapshot
+    * @return true between openSnapshot() and closeSnapshot()
+    */
+    bool isSnapshotBacked() const;
+
+    /**
+    * @brief Writes all containers to an Arrow IPC (Feather v2) file
+    * @param path Destination file path
+    * @return true on success; false as well when the library was built
+    *         without Arrow (see ContainerArrowWriter::isAvailable())
+    *
+    * Produces one row per container with the columns described in
+    * containerarrow.h, so pandas and other Arrow readers can map the
+    * file without parsing it. Custom variables are not exported. The
+    * file is replaced atomically.
+    */
+    bool saveArrow(const QString &path) const;
+
+    /**
+    * @brief Replaces the map's contents with the rows of a Feather file
+    * @param path Feather file path
+    * @return true on success; the map is left unchanged on failure
+    *
+    * Accepts files written by saveArrow() and any Feather v2 file with
+    * the same column names and types. Emits containersChanged() once.
+    */
+    bool loadArrow(const QString &path);
+
 
     /**
     * @brief Serialization operator for ContainerMap
@@ -300,6 +874,15 @@ signals:
      */
     void containersChanged();
 
+    /**
+     * @brief Emitted once when the outermost notification batch closes
+     * @param changedIDs IDs of the containers added, removed or dequeued
+     * during the batch
+     *
+     * Always preceded by a single containersChanged() emission.
+     */
+    void containersBatchChanged(const QStringList &changedIDs);
+
     /**
      * @brief Emitted when a database error occurs
      * @param error Description of the error
@@ -314,6 +897,20 @@ private:
     /** @brief Database connection for persistent storage */
     QSqlDatabase m_db;
 
+    /** @brief Thread that opened m_db */
+    QThread *m_dbThread = nullptr;
+
+    /** @brief Clones of m_db for other threads, see connectionUtil() */
+    struct ThreadConnections;
+
+    /**
+    * @brief Clones by thread, shared with the handlers that close them
+    *
+    * Created on first use. A clone is closed by its own thread when the
+    * thread finishes, which may happen after the map is gone.
+    */
+    mutable std::shared_ptr<ThreadConnections> m_threadConnections;
+
     /** @brief Cache for frequently accessed containers */
     ContainerCore::ContainerCache<Container> m_cache;
 
@@ -326,6 +923,27 @@ private:
     /** @brief Flag indicating whether running through Python bindings */
     bool m_isRunningThroughPython = false;
 
+    /** @brief Nesting depth of open notification batches */
+    int m_batchDepth = 0;
+
+    /** @brief Whether a change happened while the batch was open */
+    bool m_batchHasChanges = false;
+
+    /** @brief IDs of containers changed while the batch was open */
+    QSet<QString> m_batchChangedIDs;
+
+    /** @brief Mapped snapshot state used by openSnapshot() */
+    struct SnapshotBackend;
+
+    /** @brief Open read-only snapshot, if any */
+    std::unique_ptr<SnapshotBackend> m_snapshot;
+
+    /** @brief Container revisions at the last checkpoint, by ID */
+    QHash<QString, quint64> m_checkpointRevisions;
+
+    /** @brief Whether m_checkpointRevisions holds a checkpoint */
+    bool m_hasCheckpoint = false;
+
     /**
      * @brief Performs deep copy of container data
      * @param other Source ContainerMap to copy from
@@ -352,6 +970,7 @@ private:
     * - Containers: Main container information (id, size, location, times)
     * - NextDestinations: Container routing information
     * - MovementHistory: Container location history
+    * - MovementHistoryArchive: History moved out by compactMovementHistory()
     * - Packages: Associated package data 
     * - CustomVariables: Container-specific variable storage
     */
@@ -379,8 +998,9 @@ private:
     * Saves all container properties and related data.
     * Rolls back transaction if any operation fails.
     * Emits databaseErrorOccurred signal on failure.
+    * @return true if every statement succeeded
     */
-    void saveContainerToDB(const Container &container);
+    bool saveContainerToDB(const Container &container);
 
     /**
     * @brief Removes a container and all its related data from the database
@@ -390,10 +1010,11 @@ private:
     * - Associated packages
     * - Custom variables
     * - Next destinations
-    * - Movement history
+    * - Movement history, including archived history
     * Emits databaseErrorOccurred signal on failure.
+    * @return true if every statement succeeded
     */
-    void removeContainerFromDB(const QString &id);
+    bool removeContainerFromDB(const QString &id);
 
     /**
     * @brief Removes all data from all container-related database tables
@@ -404,6 +1025,7 @@ private:
     * - CustomVariables
     * - NextDestinations
     * - MovementHistory
+    * - MovementHistoryArchive
     */
     void clearDatabase();
 
@@ -430,6 +1052,25 @@ private:
     */
     Container* getContainer(const QString &id);
 
+    /**
+    * @brief Returns the database connection for the calling thread
+    * @return m_db on the thread that opened it, a clone otherwise
+    *
+    * Qt connections may only be used on the thread that created them, so
+    * calls made from worker threads get their own connection to the same
+    * file. The clone is closed by its thread when the thread finishes,
+    * even if the map is destroyed first. In-memory
+    * databases cannot be shared between connections; they always use
+    * m_db, which is safe because every access holds m_mutex.
+    */
+    QSqlDatabase connectionUtil() const;
+
+    /**
+    * @brief Moves a container created on a worker thread to the map's thread
+    * @param container The container the map is about to keep
+    */
+    void adoptContainerUtil(Container *container) const;
+
     /**
     * @brief Removes a container from storage
     * @param id The container's unique identifier
@@ -438,8 +1079,9 @@ private:
     * - Removes from map and deletes object
     * For database storage:
     * - Removes from database and cache
+    * @return false if the map is read-only or the database delete failed
     */
-    void removeContainer(const QString &id);
+    bool removeContainer(const QString &id);
 
     /**
     * @brief Utility function for adding a container to storage
@@ -453,9 +1095,16 @@ private:
     * - Adds to cache
     * For in-memory storage:
     * - Adds to container map
+    * A container already stored under the same ID is replaced and
+    * released, so adding doubles as an upsert.
     * Emits containersChanged signal.
+    *
+    * The caller must hold m_mutex. The only exception is a constructor
+    * filling a map that no other thread can see yet.
+    * @return false if the map rejected the container or the database
+    * write failed
     */
-    void addContainerUtil(const QString &id, Container* container, double addingTime = std::nan("notDefined"), double leavingTime = std::nan("notDefined"));
+    bool addContainerUtil(const QString &id, Container* container, double addingTime = std::nan("notDefined"), double leavingTime = std::nan("notDefined"));
     
     /**
     * @brief Utility function for clearing container storage
@@ -471,6 +1120,36 @@ private:
     */
     void clearUtil(bool enableClearDatabase = false, bool enableEmit = true);
 
+    /**
+    * @brief Emits or records a change notification for containers
+    * @param ids IDs of the containers that changed (may be empty if
+    * unknown, e.g. when clearing the database)
+    *
+    * Emits containersChanged() immediately unless a notification batch
+    * is open, in which case the IDs are recorded for endBatch().
+    * Callers must hold m_mutex.
+    */
+    void notifyContainersChanged(const QStringList &ids);
+
+    /**
+    * @brief Convenience overload for a single container
+    * @param id ID of the container that changed
+    */
+    void notifyContainersChanged(const QString &id);
+
+    /**
+    * @brief Opens a notification batch while m_mutex is already held
+    */
+    void beginBatchUtil();
+
+    /**
+    * @brief Closes a batch opened with beginBatchUtil()
+    * @param changedIDs Receives the IDs to report if the outermost batch
+    * closed with pending changes
+    * @return true if the caller must emit the batched notifications
+    */
+    bool endBatchUtil(QStringList &changedIDs);
+
     /**
     * @brief Initializes QCoreApplication if needed for database operations
     * 
@@ -479,6 +1158,119 @@ private:
     * Registers cleanup handler for application exit.
     */
     void initializeQtCoreIfNeeded();
+
+    /**
+    * @brief Replaces the map's contents with the containers of a snapshot
+    * @param data Snapshot bytes (8-byte aligned)
+    * @param size Size of the snapshot in bytes
+    * @return true on success
+    */
+    bool loadSnapshotData(const uchar *data, qint64 size);
+
+    /**
+    * @brief Applies a delta snapshot held in memory
+    * @param data Pointer to the delta bytes (8-byte aligned)
+    * @param size Size of the delta in bytes
+    * @return true on success
+    */
+    bool applyDeltaSnapshotData(const uchar *data, qint64 size);
+
+    /**
+    * @brief Replaces the map's contents under a single lock and batch
+    * @param count Number of containers to add
+    * @param create Returns a new container for an index in [0, count)
+    * @return false if the database transaction could not be completed
+    *
+    * For database storage the old rows are cleared and the containers
+    * written in one transaction, which is rolled back on any failure so
+    * the previous contents survive.
+    */
+    bool replaceContents(qsizetype count,
+                         const std::function<Container *(qsizetype)> &create);
+
+    /**
+    * @brief Visits every container while m_mutex is already held
+    * @param visit Called once per container
+    * @return false if the containers could not be read from the database
+    *
+    * Database rows that are not cached and snapshot records are visited
+    * through temporaries that only live for the call.
+    */
+    bool forEachContainerUtil(
+        const std::function<void(const Container &)> &visit) const;
+
+    /**
+    * @brief Applies an update to many containers under a single lock
+    * @param ids IDs of the containers to update
+    * @param valueCount Number of values supplied; must match ids
+    * @param operation Name of the operation for warnings
+    * @param update Called with each container and the index of its ID
+    * @return Number of containers updated, 0 if the database update failed
+    *
+    * Opens a notification batch, a change batch per container and, for
+    * database storage, one transaction in which every updated container
+    * is saved. The first failed save stops the batch and rolls the
+    * transaction back.
+    */
+    qsizetype updateContainers(
+        const QStringList &ids, qsizetype valueCount, const char *operation,
+        const std::function<void(Container &, qsizetype)> &update);
+
+    /**
+    * @brief Records the checkpoint while m_mutex is already held
+    */
+    void markCheckpointUtil();
+
+    /**
+    * @brief Adds already constructed containers under a single lock
+    * @param containers Containers to add, in order
+    * @param addingTime Time when the containers were added
+    * @param leavingTime Time when the containers should leave
+    * @param keepContainerTimes Keep each container's own times instead
+    *        of addingTime and leavingTime
+    * @return false if the database could not store the containers
+    *
+    * Used by the parallel ingest paths to merge their results. For
+    * database storage the merge is one transaction: if any container
+    * cannot be stored it is rolled back and databaseErrorOccurred() is
+    * emitted. Containers that were not added are deleted.
+    */
+    bool addContainersBulk(const QVector<Container *> &containers,
+                           double addingTime, double leavingTime,
+                           bool keepContainerTimes = false);
+
+    /**
+    * @brief Opens a snapshot while m_mutex is already held
+    * @param path Snapshot file path
+    * @return true on success
+    */
+    bool openSnapshotUtil(const QString &path);
+
+    /**
+    * @brief Closes the open snapshot while m_mutex is already held
+    */
+    void closeSnapshotUtil();
+
+    /**
+    * @brief Returns the container for a snapshot record, creating it once
+    * @param index Record index
+    * @return Container owned by the snapshot backend
+    */
+    Container *snapshotContainer(qsizetype index);
+
+    /**
+    * @brief Materializes a list of snapshot records
+    * @param indexes Record indexes
+    * @return Containers in the same order
+    */
+    QVector<Container *> snapshotContainers(const QVector<qsizetype> &indexes);
+
+    /**
+    * @brief Warns if a write is attempted on a snapshot-backed map
+    * @param operation Name of the rejected operation
+    * @return true if the map is snapshot-backed and the write must stop
+    */
+    bool rejectSnapshotWrite(const char *operation) const;
 };
 }
 
@@ -0,0 +1,500 @@
+/**
+ * @file containersnapshot.h
+ * @brief Versioned binary snapshot format for container collections
+ * @author Ahmed Aredah
+ * @date 2024
+ *
+ * This file defines the on-disk snapshot format used by
+ * ContainerMap::saveSnapshot() and ContainerMap::loadSnapshot(), together
+ * with the writer and reader that produce and parse it.
+ *
+ * Layout (all integers little-endian, all offsets absolute file offsets,
+ * every section starts on an 8-byte boundary):
+ *
+ * @code
+ * FileHeader              48 bytes, magic "CNTRSNAP" + format version
+ * section data ...        see SectionType
+ * SectionEntry[count]     section table at FileHeader::sectionTableOffset
+ * @endcode
+ *
+ * Sections:
+ * - StringTable: quint64 count, quint64 offsets[count + 1] relative to
+ *   the end of the offset array, then the UTF-8 bytes of all strings.
+ *   Every string in the file is stored once and referenced by index.
+ * - Containers: ContainerRecord[containerCount], sorted by the UTF-8
+ *   bytes of the container ID.
+ * - Destinations, MovementHistory, Packages: flat quint32 arrays of
+ *   string indexes. Each record references its slice with a
+ *   (begin, count) pair.
+ * - CustomVariables: CustomVariableRecord array, sliced the same way.
+ * - VariantData: QDataStream-encoded QVariants for custom variable values
+ *   that are not a bool, integer, double or string.
+ * - AddedTimeIndex, LeavingTimeIndex: quint32 record indexes of the
+ *   records whose time is set, sorted by time.
+ * - DestinationIndex: DestinationIndexEntry array sorted by the UTF-8
+ *   bytes of the destination, then by record index.
+ *
+ * - RemovedContainers: string indexes of container IDs removed since
+ *   the base snapshot; only present in delta snapshots.
+ *
+ * The index sections are optional; readers fall back to scanning the
+ * records when they are missing.
+ *
+ * A delta snapshot has the DeltaSnapshot header flag set. Its Containers
+ * section holds the containers added or modified since the previous
+ * checkpoint, which replace any container with the same ID when the
+ * delta is applied on top of the earlier snapshots.
+ *
+ * Readers must reject files with a different magic or a newer major
+ * version and must skip section types they do not know, so new sections
+ * can be added without bumping the version.
+ */
+
+#ifndef CONTAINERSNAPSHOT_H
+#define CONTAINERSNAPSHOT_H
+
+#include "Container_global.h"
+#include "container.h"
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QHash>
+#include <QIODevice>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QtEndian>
+
+namespace ContainerCore {
+
+/**
+ * @namespace ContainerCore::Snapshot
+ * @brief Binary snapshot format definitions
+ */
+namespace Snapshot {
+
+/** File signature at the start of every snapshot */
+inline constexpr char Magic[8] = {'C', 'N', 'T', 'R', 'S', 'N', 'A', 'P'};
+
+/** Current format version */
+inline constexpr quint32 FormatVersion = 1;
+
+/**
+ * @enum FileFlag
+ * @brief Bits of FileHeader::flags
+ */
+enum FileFlag : quint32 {
+    DeltaSnapshot = 0x1  /**< Changes on top of an earlier snapshot */
+};
+
+/**
+ * @enum SectionType
+ * @brief Identifies the contents of a section
+ */
+enum SectionType : quint32 {
+    StringTable     = 1,  /**< Deduplicated UTF-8 strings */
+    Containers      = 2,  /**< ContainerRecord array */
+    Destinations    = 3,  /**< String indexes of next destinations */
+    MovementHistory = 4,  /**< String indexes of history locations */
+    Packages        = 5,  /**< String indexes of package IDs */
+    CustomVariables = 6,  /**< CustomVariableRecord array */
+    VariantData     = 7,  /**< Serialized QVariant payloads */
+    AddedTimeIndex  = 8,  /**< Record indexes sorted by added time */
+    LeavingTimeIndex = 9, /**< Record indexes sorted by leaving time */
+    DestinationIndex = 10, /**< DestinationIndexEntry array */
+    RemovedContainers = 11 /**< String indexes of removed container IDs */
+};
+
+/**
+ * @enum ValueType
+ * @brief Storage type of a custom variable value
+ */
+enum ValueType : quint32 {
+    NullValue    = 0,  /**< Invalid QVariant */
+    BoolValue    = 1,  /**< payload is 0 or 1 */
+    IntValue     = 2,  /**< payload is a qint64 */
+    DoubleValue  = 3,  /**< payload holds the IEEE-754 bits */
+    StringValue  = 4,  /**< payload is a string index */
+    VariantValue = 5   /**< payload is an offset into VariantData, aux the size */
+};
+
+/**
+ * @struct FileHeader
+ * @brief Fixed header at offset 0
+ */
+struct FileHeader {
+    char magic[8];
+    quint32_le version;
+    quint32_le flags;
+    quint64_le containerCount;
+    quint64_le sectionTableOffset;
+    quint32_le sectionCount;
+    quint32_le reserved;
+    quint64_le reserved2;
+};
+
+/**
+ * @struct SectionEntry
+ * @brief Section table entry
+ */
+struct SectionEntry {
+    quint32_le type;
+    quint32_le flags;
+    quint64_le offset;
+    quint64_le size;
+};
+
+/**
+ * @struct ContainerRecord
+ * @brief Fixed-width record describing one container
+ *
+ * Times are stored as the bit pattern of the double so that NaN
+ * ("not set") survives the round trip.
+ */
+struct ContainerRecord {
+    quint32_le id;
+    quint32_le currentLocation;
+    quint64_le addedTime;
+    quint64_le leavingTime;
+    qint32_le size;
+    quint32_le flags;
+    quint32_le destinationsBegin;
+    quint32_le destinationsCount;
+    quint32_le historyBegin;
+    quint32_le historyCount;
+    quint32_le packagesBegin;
+    quint32_le packagesCount;
+    quint32_le customBegin;
+    quint32_le customCount;
+};
+
+/**
+ * @struct CustomVariableRecord
+ * @brief Fixed-width record describing one custom variable
+ */
+struct CustomVariableRecord {
+    quint32_le hauler;
+    quint32_le key;
+    quint32_le type;
+    quint32_le aux;
+    quint64_le payload;
+};
+
+/**
+ * @struct DestinationIndexEntry
+ * @brief Maps a destination string to a record that plans to visit it
+ */
+struct DestinationIndexEntry {
+    quint32_le destination;
+    quint32_le record;
+};
+
+static_assert(sizeof(FileHeader) == 48, "Unexpected snapshot header size");
+static_assert(sizeof(SectionEntry) == 24, "Unexpected section entry size");
+static_assert(sizeof(ContainerRecord) == 64,
+              "Unexpected container record size");
+static_assert(sizeof(CustomVariableRecord) == 24,
+              "Unexpected custom variable record size");
+static_assert(sizeof(DestinationIndexEntry) == 8,
+              "Unexpected destination index entry size");
+
+} // namespace Snapshot
+
+/**
+ * @class ContainerSnapshotWriter
+ * @brief Accumulates containers and writes them as a binary snapshot
+ *
+ * Containers are encoded as they are added, so callers can stream
+ * containers from a database and delete them right away.
+ */
+class CONTAINER_EXPORT ContainerSnapshotWriter
+{
+public:
+    ContainerSnapshotWriter();
+
+    /**
+    * @brief Encodes a container into the snapshot
+    * @param container The container to add
+    */
+    void addContainer(const Container &container);
+
+    /**
+    * @brief Returns the number of containers added so far
+    * @return Container count
+    */
+    qsizetype containerCount() const;
+
+    /**
+    * @brief Marks the snapshot as a delta on top of an earlier one
+    * @param delta true to write a delta snapshot
+    */
+    void setDelta(bool delta);
+
+    /**
+    * @brief Records a container removed since the previous checkpoint
+    * @param id The removed container's ID
+    *
+    * Only written for delta snapshots.
+    */
+    void addRemovedContainer(const QString &id);
+
+    /**
+    * @brief Writes the snapshot to a device
+    * @param device Open, writable device
+    * @return true on success; failures are reported with qWarning()
+    */
+    bool write(QIODevice *device);
+
+private:
+    /**
+    * @brief Returns the index of a string, adding it if needed
+    * @param value The string to intern
+    * @return String table index
+    */
+    quint32 intern(const QString &value);
+
+    /** Strings in table order */
+    QVector<QString> m_strings;
+
+    /** String table lookup */
+    QHash<QString, quint32> m_stringIndexes;
+
+    /** Encoded container records */
+    QVector<Snapshot::ContainerRecord> m_records;
+
+    /** Child arrays */
+    QVector<quint32_le> m_destinations;
+    QVector<quint32_le> m_history;
+    QVector<quint32_le> m_packages;
+    QVector<Snapshot::CustomVariableRecord> m_customVariables;
+
+    /** Serialized QVariant payloads */
+    QByteArray m_variantData;
+
+    /** String indexes of removed container IDs */
+    QVector<quint32_le> m_removed;
+
+    /** Whether a delta snapshot is written */
+    bool m_delta = false;
+};
+
+/**
+ * @class ContainerSnapshotReader
+ * @brief Parses a binary snapshot held in memory
+ *
+ * The reader does not copy the snapshot bytes; the buffer passed to
+ * open() must outlive the reader.
+ */
+class CONTAINER_EXPORT ContainerSnapshotReader
+{
+public:
+    /**
+    * @enum TimeField
+    * @brief Container time a query filters on
+    */
+    enum TimeField {
+        AddedTime,
+        LeavingTime
+    };
+
+    /**
+    * @enum Comparison
+    * @brief Comparison applied between a container time and a reference
+    *
+    * Matches the in-memory ContainerMap queries: unset (NaN) times only
+    * satisfy NotEqual.
+    */
+    enum Comparison {
+        Greater,
+        GreaterEqual,
+        Less,
+        LessEqual,
+        Equal,
+        NotEqual
+    };
+
+    ContainerSnapshotReader();
+
+    /**
+    * @brief Validates a snapshot and locates its sections
+    * @param data Pointer to the snapshot bytes (8-byte aligned)
+    * @param size Size of the snapshot in bytes
+    * @return true if the snapshot is valid; failures are reported with
+    * qWarning()
+    */
+    bool open(const uchar *data, qint64 size);
+
+    /**
+    * @brief Returns the number of containers in the snapshot
+    * @return Container count
+    */
+    qsizetype containerCount() const;
+
+    /**
+    * @brief Checks whether the snapshot is a delta snapshot
+    * @return true if the DeltaSnapshot flag is set
+    */
+    bool isDelta() const;
+
+    /**
+    * @brief Returns the IDs removed by a delta snapshot
+    * @return Removed container IDs; empty for full snapshots
+    */
+    QStringList removedContainers() const;
+
+    /**
+    * @brief Creates a container from its record
+    * @param index Record index in [0, containerCount())
+    * @return Newly allocated container owned by the caller
+    */
+    Container *createContainer(qsizetype index) const;
+
+    /**
+    * @brief Returns the record at an index
+    * @param index Record index in [0, containerCount())
+    * @return Reference into the snapshot bytes
+    */
+    const Snapshot::ContainerRecord &record(qsizetype index) const;
+
+    /**
+    * @brief Decodes a string from the string table
+    * @param index String table index
+    * @return The string, or an empty string if the index is invalid
+    */
+    QString string(quint32 index) const;
+
+    /**
+    * @brief Locates a section by type
+    * @param type Section type
+    * @param size Receives the section size in bytes
+    * @return Pointer to the section data, or nullptr if absent
+    */
+    const uchar *section(quint32 type, qint64 *size = nullptr) const;
+
+    /**
+    * @brief Returns the raw UTF-8 bytes of a string without decoding it
+    * @param index String table index
+    * @return View into the snapshot bytes
+    */
+    QByteArrayView stringView(quint32 index) const;
+
+    /**
+    * @brief Finds a container record by ID
+    * @param id The container ID
+    * @return Record index, or -1 if not found
+    *
+    * Binary search over the sorted records; nothing is decoded.
+    */
+    qsizetype findContainer(const QString &id) const;
+
+    /**
+    * @brief Finds the first record whose ID sorts after an ID
+    * @param id The container ID; need not be in the snapshot
+    * @return Record index, or containerCount() if no ID sorts after it
+    *
+    * IDs are compared by their UTF-8 bytes, like the record order.
+    */
+    qsizetype upperBound(const QString &id) const;
+
+    /**
+    * @brief Finds the records whose time satisfies a comparison
+    * @param field Time to compare
+    * @param comparison Comparison to apply
+    * @param referenceTime Time to compare against
+    * @return Matching record indexes in ascending (ID) order
+    */
+    QVector<qsizetype> findByTime(TimeField field, Comparison comparison,
+                                  double referenceTime) const;
+
+    /**
+    * @brief Counts the records whose time satisfies a comparison
+    * @param field Time to compare
+    * @param comparison Comparison to apply
+    * @param referenceTime Time to compare against
+    * @return Number of matching records
+    */
+    qsizetype countByTime(TimeField field, Comparison comparison,
+                          double referenceTime) const;
+
+    /**
+    * @brief Finds the records that list a destination
+    * @param destination The destination to look for
+    * @return Matching record indexes in ascending (ID) order
+    */
+    QVector<qsizetype> findByDestination(const QString &destination) const;
+
+private:
+    /**
+    * @brief Reads a record's time
+    */
+    double recordTime(qsizetype index, TimeField field) const;
+
+    /**
+    * @brief Checks a single time against a comparison
+    */
+    static bool matches(double time, Comparison comparison,
+                        double referenceTime);
+
+    /**
+    * @brief Locates the index entries equal to the reference time
+    * @return false if the time index section is missing
+    */
+    bool timeRange(TimeField field, double referenceTime,
+                   qint64 &lower, qint64 &upper,
+                   const quint32_le *&index, qint64 &indexSize) const;
+
+    /**
+    * @brief Locates the optional index sections and checks their entries
+    * @return false if an index references a missing record or string
+    */
+    bool openIndexes();
+
+    /**
+    * @brief Checks that a (begin, count) slice lies inside an array
+    */
+    static bool sliceInRange(quint32 begin, quint32 count, qint64 length);
+
+    /**
+    * @brief Decodes a custom variable value
+    */
+    QVariant customValue(const Snapshot::CustomVariableRecord &record) const;
+
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    quint32 m_flags = 0;
+
+    const Snapshot::SectionEntry *m_sections = nullptr;
+    quint32 m_sectionCount = 0;
+
+    const Snapshot::ContainerRecord *m_records = nullptr;
+    qint64 m_recordCount = 0;
+
+    const quint64_le *m_stringOffsets = nullptr;
+    const char *m_stringBytes = nullptr;
+    qint64 m_stringCount = 0;
+    qint64 m_stringBytesSize = 0;
+
+    const quint32_le *m_destinations = nullptr;
+    qint64 m_destinationCount = 0;
+    const quint32_le *m_history = nullptr;
+    qint64 m_historyCount = 0;
+    const quint32_le *m_packages = nullptr;
+    qint64 m_packageCount = 0;
+    const Snapshot::CustomVariableRecord *m_customVariables = nullptr;
+    qint64 m_customVariableCount = 0;
+    const uchar *m_variantData = nullptr;
+    qint64 m_variantDataSize = 0;
+
+    const quint32_le *m_addedTimeIndex = nullptr;
+    qint64 m_addedTimeIndexSize = 0;
+    const quint32_le *m_leavingTimeIndex = nullptr;
+    qint64 m_leavingTimeIndexSize = 0;
+    const Snapshot::DestinationIndexEntry *m_destinationIndex = nullptr;
+    qint64 m_destinationIndexSize = 0;
+
+    const quint32_le *m_removed = nullptr;
+    qint64 m_removedCount = 0;
+};
+
+}
+
+#endif // CONTAINERSNAPSHOT_H
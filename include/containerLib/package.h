@@ -14,11 +14,74 @@
 
 #include "Container_global.h"
 #include <QObject>
+#include <QCborMap>
+#include <QCborStreamReader>
+#include <QCborStreamWriter>
 #include <QDataStream>
 #include <QJsonObject>
 
 namespace ContainerCore {
 
+/**
+ * @struct PackageData
+ * @brief Plain value representation of a package
+ *
+ * Containers store their packages as PackageData values so that the
+ * common case of a handful of packages needs no per-package heap
+ * allocation. Package objects can be created from and converted to
+ * this representation when a QObject is required.
+ */
+struct PackageData
+{
+    /** @brief The package's unique identifier */
+    QString packageID;
+
+    friend bool operator==(const PackageData &,
+                           const PackageData &) = default;
+};
+
+/**
+ * @namespace ContainerCore::DataStream
+ * @brief Header of the versioned QDataStream format of Package and Container
+ *
+ * Every serialized Package and Container starts with a magic number and
+ * a format version. Streams written before the format was versioned
+ * start directly with a string length: a byte count of UTF-16 data,
+ * which is even, or 0xFFFFFFFF for a null string. Both magic numbers
+ * are odd and differ from 0xFFFFFFFF, so the length can never equal
+ * them and the operators still read those streams.
+ */
+namespace DataStream {
+
+/** Magic number of a serialized Package ("CNPK") */
+inline constexpr quint32 PackageMagic = 0x434E504B;
+
+/** Magic number of a serialized Container ("CNTC") */
+inline constexpr quint32 ContainerMagic = 0x434E5443;
+
+/** Current format version */
+inline constexpr quint16 FormatVersion = 1;
+
+/**
+ * @brief Writes the magic number and the current format version
+ * @param out Output stream
+ * @param magic PackageMagic or ContainerMagic
+ */
+CONTAINER_EXPORT void writeHeader(QDataStream &out, quint32 magic);
+
+/**
+ * @brief Consumes the header if the stream starts with it
+ * @param in Input stream
+ * @param magic Expected magic number
+ * @return The format version, or 0 for a legacy record without header
+ *
+ * A version newer than FormatVersion sets the stream status to
+ * QDataStream::ReadCorruptData.
+ */
+CONTAINER_EXPORT quint16 readHeader(QDataStream &in, quint32 magic);
+
+} // namespace DataStream
+
 /**
  * @class Package
  * @brief Represents a package that can be stored in a container
@@ -82,6 +145,13 @@ public:
      */
     Package(const QJsonObject &json, QObject *parent = nullptr);
 
+    /**
+     * @brief Constructor from a package value
+     * @param data Package data to initialize from
+     * @param parent Optional parent QObject for memory management
+     */
+    explicit Package(const PackageData &data, QObject *parent = nullptr);
+
     /**
      * @brief Assignment operator
      * @param other Source Package to copy from
@@ -115,6 +185,57 @@ public:
      */
     QJsonObject toJson() const;
 
+    /**
+     * @brief Converts the package to its plain value representation
+     * @return PackageData holding a copy of the package's fields
+     */
+    PackageData toData() const;
+
+    /**
+     * @brief Converts the package to a CBOR map
+     * @return CBOR map with the same keys as toJson()
+     */
+    QCborMap toCbor() const;
+
+    /**
+     * @brief Creates a package from a CBOR map
+     * @param cbor Map produced by toCbor()
+     * @param parent Optional parent QObject for memory management
+     * @return Newly allocated package; the caller takes ownership
+     */
+    static Package *fromCbor(const QCborMap &cbor, QObject *parent = nullptr);
+
+    /**
+     * @brief Streams the package as a CBOR map
+     * @param writer Destination writer
+     */
+    void writeCbor(QCborStreamWriter &writer) const;
+
+    /**
+     * @brief Reads the package from a CBOR map
+     * @param reader Reader positioned on the map
+     * @return false if the value is not a map or the stream is corrupt
+     */
+    bool readCbor(QCborStreamReader &reader);
+
+    /**
+     * @brief Streams a package value as a CBOR map
+     * @param writer Destination writer
+     * @param package Package value to write
+     *
+     * Used by Container, which stores its packages as values.
+     */
+    static void writeCbor(QCborStreamWriter &writer,
+                          const PackageData &package);
+
+    /**
+     * @brief Reads a package value from a CBOR map
+     * @param reader Reader positioned on the map
+     * @param package Receives the package fields
+     * @return false if the value is not a map or the stream is corrupt
+     */
+    static bool readCbor(QCborStreamReader &reader, PackageData &package);
+
     /**
      * @brief Creates a deep copy of this package
      * @return Pointer to the new copied package
@@ -128,6 +249,8 @@ public:
      * @param out Output stream
      * @param package Package to serialize
      * @return Reference to the output stream
+     *
+     * Writes the versioned format described in DataStream.
      */
     friend CONTAINER_EXPORT QDataStream &operator<<(QDataStream &out, const Package &package);
 
@@ -136,6 +259,9 @@ public:
      * @param in Input stream
      * @param package Package to deserialize into
      * @return Reference to the input stream
+     *
+     * Reads both the versioned and the legacy format. The ID is assigned
+     * directly, without emitting packageIDChanged().
      */
     friend CONTAINER_EXPORT QDataStream &operator>>(QDataStream &in, Package &package);
 
@@ -1,4 +1,5 @@
-from typing import List, Dict
+from typing import Any, Awaitable, Dict, Iterator, List, Optional, Sequence, Tuple, Union
+import numpy as np
 from enum import Enum
 
 class Package:
@@ -307,6 +308,31 @@ class Container:
         """
         ...
 
+    def __getstate__(self) -> bytes:
+        """
+        Encodes the container, including custom variables, in the versioned
+        binary format used by QDataStream.
+
+        Returns:
+            bytes: The encoded container.
+        """
+        ...
+
+    def __setstate__(self, state: bytes) -> None:
+        """
+        Restores a container from the bytes returned by __getstate__.
+
+        Raises:
+            ValueError: If the bytes are not a valid container encoding.
+        """
+        ...
+
+    def __reduce__(self) -> tuple:
+        """
+        Supports pickle, copy and multiprocessing through __getstate__.
+        """
+        ...
+
 
 class ContainerMap:
     """
@@ -327,6 +353,15 @@ class ContainerMap:
         - get_containers_by_next_destination: Retrieves containers heading to a specific destination.
         - dequeue_containers_by_next_destination: Removes containers heading to a specific destination.
         - to_json: Extracts ContainerMap information into a Python dictionary.
+
+    Adding containers, queries, dequeues, clear and to_json release the GIL
+    while the C++ side works, so other Python threads keep running. Input
+    dictionaries are converted before the GIL is released and results are
+    converted after it is reacquired.
+
+    Every query returns the same Container object for the same container,
+    so identity checks (``is``) work across calls. Returned containers keep
+    the map alive for as long as they are referenced.
     """
 
     def __init__(self) -> None:
@@ -408,6 +443,177 @@ class ContainerMap:
         """
         ...
 
+    @staticmethod
+    def from_columns(ids: Sequence[str],
+                     sizes: Optional[Union[Sequence[int], np.ndarray]] = None,
+                     added_times: Optional[Union[Sequence[float], np.ndarray]] = None,
+                     leaving_times: Optional[Union[Sequence[float], np.ndarray]] = None,
+                     locations: Optional[Sequence[str]] = None) -> 'ContainerMap':
+        """
+        Creates an in-memory ContainerMap with one container per row.
+
+        Numeric columns may be NumPy arrays, lists, pandas Series or Arrow
+        arrays; they are copied straight from their buffer. String columns
+        may be lists, NumPy arrays or Arrow arrays (None becomes an empty
+        string). The containers are built in C++ with the GIL released.
+
+        Args:
+            ids (Sequence[str]): The container IDs.
+            sizes (optional): ContainerSize value per row. Defaults to TwentyFT.
+            added_times (optional): Added time per row. Defaults to NaN.
+            leaving_times (optional): Leaving time per row. Defaults to NaN.
+            locations (optional): Current location per row.
+
+        Returns:
+            ContainerMap: The new map. It is empty if a column does not
+            have one entry per ID.
+
+        Example:
+            >>> df = pandas.read_parquet("yard.parquet")
+            >>> yard = ContainerMap.from_columns(df["id"], df["size"],
+            ...                                  df["added"], df["leaving"],
+            ...                                  df["location"])
+        """
+        ...
+
+    def add_containers_from_columns(self, ids: Sequence[str],
+                                    sizes: Optional[Union[Sequence[int], np.ndarray]] = None,
+                                    added_times: Optional[Union[Sequence[float], np.ndarray]] = None,
+                                    leaving_times: Optional[Union[Sequence[float], np.ndarray]] = None,
+                                    locations: Optional[Sequence[str]] = None) -> int:
+        """
+        Adds containers built from columns, as from_columns does.
+
+        Each container keeps its own added and leaving time. All rows are
+        added under one lock and, for database storage, one transaction.
+
+        Returns:
+            int: The number of containers added.
+        """
+        ...
+
+    def set_containers_current_location(self, ids: Sequence[str], locations: Sequence[str]) -> int:
+        """
+        Sets the current location of many containers in one call.
+
+        All updates run under one lock (and one database transaction), and
+        the map reports the changes once. Unknown IDs are skipped.
+
+        Args:
+            ids (Sequence[str]): IDs of the containers to update.
+            locations (Sequence[str]): New location for each ID.
+
+        Returns:
+            int: The number of containers updated; 0 if the lengths differ.
+        """
+        ...
+
+    def add_containers_destination(self, ids: Sequence[str], destinations: Sequence[str]) -> int:
+        """
+        Appends a next destination to many containers in one call.
+
+        Batched like set_containers_current_location.
+
+        Args:
+            ids (Sequence[str]): IDs of the containers to update.
+            destinations (Sequence[str]): Destination to add for each ID.
+
+        Returns:
+            int: The number of containers updated; 0 if the lengths differ.
+        """
+        ...
+
+    def add_containers_custom_variable(self, ids: Sequence[str], hauler: int, key: str,
+                                       values: Union[Sequence[Any], np.ndarray]) -> int:
+        """
+        Sets a custom variable on many containers in one call.
+
+        Float, integer and boolean NumPy arrays are read directly from
+        their buffer; NaN values are stored as null. Batched like
+        set_containers_current_location.
+
+        Args:
+            ids (Sequence[str]): IDs of the containers to update.
+            hauler (int): Represents the hauler type (e.g., truck, train).
+            key (str): The key for the custom variable.
+            values (Sequence | np.ndarray): Value for each ID.
+
+        Returns:
+            int: The number of containers updated; 0 if the lengths differ.
+        """
+        ...
+
+    def __len__(self) -> int:
+        """
+        Returns the number of containers in the map.
+        """
+        ...
+
+    def __contains__(self, id: str) -> bool:
+        """
+        Checks whether a container ID is in the map without loading the
+        container.
+        """
+        ...
+
+    def __getitem__(self, id: str) -> Container:
+        """
+        Retrieves a container by its ID.
+
+        Raises:
+            KeyError: If no container has this ID.
+        """
+        ...
+
+    def __iter__(self) -> Iterator[str]:
+        """
+        Iterates over the container IDs in ascending order.
+
+        The map is read one page at a time, so database-backed maps are never
+        loaded as a whole. Containers added during iteration are visited if
+        their ID sorts after the current position.
+        """
+        ...
+
+    def keys(self) -> Iterator[str]:
+        """
+        Lazily iterates over the container IDs in ascending order.
+        """
+        ...
+
+    def values(self) -> Iterator[Container]:
+        """
+        Lazily iterates over the containers in ID order.
+        """
+        ...
+
+    def items(self) -> Iterator[Tuple[str, Container]]:
+        """
+        Lazily iterates over (id, container) pairs in ID order.
+        """
+        ...
+
+    def iter_containers_by_added_time(self, condition: str, referenceTime: float) -> Iterator[Container]:
+        """
+        Lazy variant of get_containers_by_added_time. Matches are yielded in
+        ID order, one page at a time.
+        """
+        ...
+
+    def iter_containers_by_leaving_time(self, condition: str, referenceTime: float) -> Iterator[Container]:
+        """
+        Lazy variant of get_containers_by_leaving_time. Matches are yielded in
+        ID order, one page at a time.
+        """
+        ...
+
+    def iter_containers_by_next_destination(self, destination: str) -> Iterator[Container]:
+        """
+        Lazy variant of get_containers_by_next_destination. Matches are
+        yielded in ID order, one page at a time.
+        """
+        ...
+
     def get_all_containers(self) -> List[Container]:
         """
         Retrieves all containers from the map. Use with caution, especially with large datasets.
@@ -435,6 +641,58 @@ class ContainerMap:
         """
         ...
 
+    def added_times(self) -> np.ndarray:
+        """
+        Retrieves the added time of every container in one bulk copy.
+
+        Returns:
+            np.ndarray: float64 array, NaN where the time is not set. Entries
+            follow the same order as ids().
+        """
+        ...
+
+    def leaving_times(self) -> np.ndarray:
+        """
+        Retrieves the leaving time of every container in one bulk copy.
+
+        Returns:
+            np.ndarray: float64 array, NaN where the time is not set. Entries
+            follow the same order as ids().
+        """
+        ...
+
+    def sizes(self) -> np.ndarray:
+        """
+        Retrieves the size of every container in one bulk copy.
+
+        Returns:
+            np.ndarray: int32 array of ContainerSize values. Entries follow
+            the same order as ids().
+        """
+        ...
+
+    def ids(self) -> np.ndarray:
+        """
+        Retrieves the ID of every container.
+
+        Returns:
+            np.ndarray: Object array of str.
+        """
+        ...
+
+    def columns(self) -> Dict[str, np.ndarray]:
+        """
+        Retrieves ids, sizes, added_times and leaving_times together.
+
+        The columns are gathered in a single pass under one lock, so they
+        stay aligned even if other threads modify the map.
+
+        Returns:
+            Dict[str, np.ndarray]: The arrays keyed "ids", "sizes",
+            "added_times" and "leaving_times".
+        """
+        ...
+
     def get_containers_by_added_time(self, condition: str, referenceTime: float) -> List[Container]:
         """
         Retrieves containers based on an added time condition.
@@ -580,6 +838,135 @@ class ContainerMap:
             Dict: A dictionary containing the ContainerMap information.
         """
         ...
+
+    def save_snapshot(self, path: str) -> bool:
+        """
+        Writes all containers to a binary snapshot file.
+
+        Returns:
+            bool: False if the file could not be written.
+        """
+        ...
+
+    def load_snapshot(self, path: str) -> bool:
+        """
+        Replaces the contents of the map with a binary snapshot file.
+
+        Returns:
+            bool: False if the file could not be read; the map is then
+            unchanged.
+        """
+        ...
+
+    # Awaitable variants. Each call runs on a C++ thread pool and returns
+    # an asyncio future that resolves on the calling event loop, so
+    # several calls can be in flight while the loop keeps running. They
+    # must be called from a running event loop. Calls on the same map
+    # still take its lock one at a time; a database-backed map gives each
+    # worker thread its own connection. Cancelling the future does not
+    # stop work that has already started. C++ errors surface as
+    # RuntimeError.
+    #
+    # Example:
+    #     ready, late = await asyncio.gather(
+    #         yard.get_containers_by_added_time_async("<=", now),
+    #         yard.count_containers_by_leaving_time_async("<", now))
+
+    def get_containers_by_added_time_async(self, condition: str, referenceTime: float) -> Awaitable[List[Container]]:
+        """Awaitable variant of get_containers_by_added_time."""
+        ...
+
+    def dequeue_containers_by_added_time_async(self, condition: str, referenceTime: float) -> Awaitable[List[Container]]:
+        """Awaitable variant of dequeue_containers_by_added_time. If the future is cancelled, the containers are put back into the map."""
+        ...
+
+    def count_containers_by_added_time_async(self, condition: str, referenceTime: float) -> Awaitable[int]:
+        """Awaitable variant of count_containers_by_added_time."""
+        ...
+
+    def get_containers_by_leaving_time_async(self, condition: str, referenceTime: float) -> Awaitable[List[Container]]:
+        """Awaitable variant of get_containers_by_leaving_time."""
+        ...
+
+    def dequeue_containers_by_leaving_time_async(self, condition: str, referenceTime: float) -> Awaitable[List[Container]]:
+        """Awaitable variant of dequeue_containers_by_leaving_time. If the future is cancelled, the containers are put back into the map."""
+        ...
+
+    def count_containers_by_leaving_time_async(self, condition: str, referenceTime: float) -> Awaitable[int]:
+        """Awaitable variant of count_containers_by_leaving_time."""
+        ...
+
+    def get_containers_by_next_destination_async(self, destination: str) -> Awaitable[List[Container]]:
+        """Awaitable variant of get_containers_by_next_destination."""
+        ...
+
+    def dequeue_containers_by_next_destination_async(self, destination: str) -> Awaitable[List[Container]]:
+        """Awaitable variant of dequeue_containers_by_next_destination. If the future is cancelled, the containers are put back into the map."""
+        ...
+
+    def count_containers_by_next_destination_async(self, destination: str) -> Awaitable[int]:
+        """Awaitable variant of count_containers_by_next_destination."""
+        ...
+
+    def add_containers_async(self, containers: List[Container], addingTime: float = float('nan'),
+                             leavingTime: float = float('nan')) -> Awaitable[int]:
+        """
+        Awaitable variant of add_containers; resolves to the number of
+        containers passed in.
+        """
+        ...
+
+    def add_containers_from_dict_async(self, json_dict: Dict, addingTime: float = float('nan'),
+                                       leavingTime: float = float('nan')) -> Awaitable[int]:
+        """
+        Awaitable variant of add_containers_from_dict. The dictionary is
+        converted before the call returns; resolves to the number of valid
+        containers added.
+        """
+        ...
+
+    def add_containers_from_columns_async(self, ids: Sequence[str],
+                                          sizes: Optional[Union[Sequence[int], np.ndarray]] = None,
+                                          added_times: Optional[Union[Sequence[float], np.ndarray]] = None,
+                                          leaving_times: Optional[Union[Sequence[float], np.ndarray]] = None,
+                                          locations: Optional[Sequence[str]] = None) -> Awaitable[int]:
+        """Awaitable variant of add_containers_from_columns."""
+        ...
+
+    def save_snapshot_async(self, path: str) -> Awaitable[bool]:
+        """Awaitable variant of save_snapshot."""
+        ...
+
+    def load_snapshot_async(self, path: str) -> Awaitable[bool]:
+        """Awaitable variant of load_snapshot."""
+        ...
+
+    def __getstate__(self) -> bytes:
+        """
+        Encodes all containers as a binary snapshot, so a whole yard can be
+        sent between processes as a single bytes object.
+
+        Returns:
+            bytes: The snapshot.
+        """
+        ...
+
+    def __setstate__(self, state: bytes) -> None:
+        """
+        Restores a map from the bytes returned by __getstate__. The restored
+        map always keeps its containers in memory, even if the pickled map
+        was backed by a database.
+
+        Raises:
+            ValueError: If the bytes are not a valid snapshot.
+        """
+        ...
+
+    def __reduce__(self) -> tuple:
+        """
+        Supports pickle, copy and multiprocessing through __getstate__.
+        """
+        ...
         
 class ContainerSize(Enum):
     """
@@ -1,9 +1,142 @@
 #include "containerLib/container.h"
+#include "containerLib/containercbor.h"
+#include "containerLib/containerjsonstream.h"
+#include <QCborArray>
 #include <QDataStream>
 #include <QDebug>
+#include <QHash>
+#include <QReadWriteLock>
+#include <atomic>
 
 namespace ContainerCore {
 
+namespace {
+
+/**
+ * @brief Process-wide registry of pre-declared custom variable keys
+ */
+struct CustomVariableSchema
+{
+    struct Slot {
+        Container::HaulerType hauler;
+        QString key;
+        QMetaType::Type type;
+    };
+
+    QReadWriteLock lock;
+    QHash<std::pair<int, QString>, int> slotIndexes;
+    QVector<Slot> slots;
+
+    /** Lets lookups skip the lock while nothing is registered */
+    std::atomic<int> slotCount{0};
+};
+
+CustomVariableSchema &customVariableSchema()
+{
+    static CustomVariableSchema schema;
+    return schema;
+}
+
+/**
+ * @brief Converts a QVariant to a slot value of the given type
+ * @return true if the variant holds a value compatible with the type
+ */
+bool toCustomValue(const QVariant &value, QMetaType::Type type,
+                   Container::CustomValue &result)
+{
+    const int valueType = value.typeId();
+    const bool isInteger = valueType == QMetaType::Int ||
+                           valueType == QMetaType::UInt ||
+                           valueType == QMetaType::LongLong ||
+                           valueType == QMetaType::ULongLong ||
+                           valueType == QMetaType::Short ||
+                           valueType == QMetaType::UShort;
+
+    switch (type) {
+    case QMetaType::Bool:
+        if (valueType == QMetaType::Bool) {
+            result = value.toBool();
+            return true;
+        }
+        break;
+    case QMetaType::LongLong:
+        if (isInteger) {
+            result = static_cast<qint64>(value.toLongLong());
+            return true;
+        }
+        break;
+    case QMetaType::Double:
+        if (isInteger || valueType == QMetaType::Double ||
+            valueType == QMetaType::Float) {
+            result = value.toDouble();
+            return true;
+        }
+        break;
+    case QMetaType::QString:
+        if (valueType == QMetaType::QString) {
+            result = value.toString();
+            return true;
+        }
+        break;
+    default:
+        break;
+    }
+    return false;
+}
+
+/**
+ * @brief Checks that a slot value holds the alternative for the given type
+ */
+bool customValueMatches(const Container::CustomValue &value,
+                        QMetaType::Type type)
+{
+    switch (type) {
+    case QMetaType::Bool:
+        return std::holds_alternative<bool>(value);
+    case QMetaType::LongLong:
+        return std::holds_alternative<qint64>(value);
+    case QMetaType::Double:
+        return std::holds_alternative<double>(value);
+    case QMetaType::QString:
+        return std::holds_alternative<QString>(value);
+    default:
+        return false;
+    }
+}
+
+QVariant fromCustomValue(const Container::CustomValue &value)
+{
+    if (const bool *b = std::get_if<bool>(&value)) {
+        return QVariant(*b);
+    }
+    if (const qint64 *i = std::get_if<qint64>(&value)) {
+        return QVariant(static_cast<qlonglong>(*i));
+    }
+    if (const double *d = std::get_if<double>(&value)) {
+        return QVariant(*d);
+    }
+    if (const QString *str = std::get_if<QString>(&value)) {
+        return QVariant(*str);
+    }
+    return QVariant();
+}
+
+/**
+ * @brief Policy handed to containers on construction
+ *
+ * Packed into one word so every constructor can read it without a lock:
+ * the top bit holds hashedLookup and the rest holds maxEntries.
+ */
+constexpr quint64 HashedLookupBit = quint64(1) << 63;
+
+std::atomic<quint64> &defaultHistoryPolicy()
+{
+    static std::atomic<quint64> defaults{0};
+    return defaults;
+}
+
+} // namespace
+
 Container::Container(QObject *parent)
     : QObject(parent),
     m_containerSize(twentyFT) {} // Default to a common container size
@@ -16,6 +149,19 @@ Container::Container(const QString &id, ContainerSize size, QObject *parent)
         QStringLiteral("Unknown"); // Default location if not provided
 }
 
+Container::Container(const QString &id, ContainerSize size, double addedTime,
+                     double leavingTime, const QString &location,
+                     QObject *parent)
+    : QObject(parent), m_containerID(id), m_addedTime(addedTime),
+    m_leavingTime(leavingTime), m_containerSize(size) {
+    if (location.isEmpty()) {
+        m_containerCurrentLocation = QStringLiteral("Unknown");
+    } else {
+        m_containerCurrentLocation = location;
+        appendMovementHistory(location);
+    }
+}
+
 Container::Container(const QJsonObject &json, QObject *parent)
     : QObject(parent)
 {
@@ -176,6 +322,7 @@ Container::Container(const QJsonObject &json, QObject *parent)
         {
             QJsonArray movementHistoryArray =
                 json[QStringLiteral("containerMovementHistory")].toArray();
+            m_containerMovementHistory.reserve(movementHistoryArray.size());
             for (const QJsonValue &value : movementHistoryArray)
             {
                 if (value.isString())
@@ -183,6 +330,8 @@ Container::Container(const QJsonObject &json, QObject *parent)
                     m_containerMovementHistory.append(value.toString());
                 }
             }
+            // Stored history is taken as is; only the bound is enforced
+            applyMovementHistoryPolicy();
         }
         else if (json[QStringLiteral("containerMovementHistory")].isNull())
         {
@@ -201,16 +350,9 @@ Container::Container(const QJsonObject &json, QObject *parent)
             {
                 if (value.isObject())
                 {
-                    try
-                    {
-                        Package *package = new Package(value.toObject());
-                        m_packages.append(package);
-                    }
-                    catch (const std::exception &e)
-                    {
-                        qWarning() << "Failed to create package:" << e.what();
-                        // Continue processing other packages
-                    }
+                    m_packages.append(PackageData{
+                        value.toObject()[QStringLiteral("packageID")]
+                            .toString()});
                 }
             }
         }
@@ -238,8 +380,11 @@ Container::Container(const QJsonObject &json, QObject *parent)
                     QVariantMap variables;
                     for (const QString &varKey : haulerObject.keys())
                     {
-                        variables.insert(varKey,
-                                         haulerObject[varKey].toVariant());
+                        QVariant value = haulerObject[varKey].toVariant();
+                        if (!storeInCustomSlot(hauler, varKey, value))
+                        {
+                            variables.insert(varKey, value);
+                        }
                     }
                     m_customVariables[hauler] = variables;
                 }
@@ -265,6 +410,7 @@ Container &Container::operator=(const Container &other)
     if (this != &other) {
         clear();  // Clear existing packages
         deepCopy(other);  // Perform deep copy
+        m_revision = nextRevision();
     }
     return *this;
 }
@@ -274,6 +420,102 @@ void Container::setIsRunningThroughPython(bool isRunningThroughPython)
     m_isRunningThroughPython = isRunningThroughPython;
 }
 
+void Container::beginChangeBatch()
+{
+    ++m_changeBatchDepth;
+}
+
+void Container::endChangeBatch()
+{
+    if (m_changeBatchDepth == 0) {
+        qWarning() << "endChangeBatch() called without a matching "
+                      "beginChangeBatch()";
+        return;
+    }
+    if (--m_changeBatchDepth > 0 || m_pendingChanges == NoChange) {
+        return;
+    }
+
+    // Take the pending changes first so that slots reacting to the
+    // signals below may safely open a new batch
+    ChangeFlags changes = m_pendingChanges;
+    m_pendingChanges = NoChange;
+
+    static const ChangeFlag allChanges[] = {
+        ContainerIDChange, AddedTimeChange, LeavingTimeChange,
+        ContainerSizeChange, PackagesChange, CustomVariablesChange,
+        CurrentLocationChange, NextDestinationsChange, MovementHistoryChange
+    };
+    for (ChangeFlag change : allChanges) {
+        if (changes.testFlag(change)) {
+            emitChange(change);
+        }
+    }
+    emit containerChanged(changes);
+}
+
+bool Container::isBatchingChanges() const
+{
+    return m_changeBatchDepth > 0;
+}
+
+quint64 Container::revision() const
+{
+    return m_revision;
+}
+
+quint64 Container::nextRevision()
+{
+    static std::atomic<quint64> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void Container::notifyChange(ChangeFlag change)
+{
+    // Bumped even inside a batch so change tracking never misses an edit
+    m_revision = nextRevision();
+    if (m_changeBatchDepth > 0) {
+        m_pendingChanges |= change;
+        return;
+    }
+    emitChange(change);
+}
+
+void Container::emitChange(ChangeFlag change)
+{
+    switch (change) {
+    case ContainerIDChange:
+        emit containerIDChanged();
+        break;
+    case AddedTimeChange:
+        emit containerAddedTimeChanged();
+        break;
+    case LeavingTimeChange:
+        emit containerLeavingTimeChanged();
+        break;
+    case ContainerSizeChange:
+        emit containerSizeChanged();
+        break;
+    case PackagesChange:
+        emit packagesChanged();
+        break;
+    case CustomVariablesChange:
+        emit customVariablesChanged();
+        break;
+    case CurrentLocationChange:
+        emit containerCurrentLocationChanged();
+        break;
+    case NextDestinationsChange:
+        emit containerNextDestinationsChanged();
+        break;
+    case MovementHistoryChange:
+        emit containerMovementHistoryChanged();
+        break;
+    case NoChange:
+        break;
+    }
+}
+
 // Destructor
 Container::~Container() {
     clear();
@@ -290,7 +532,7 @@ void Container::setContainerID(const QString &id) {
     }
     if (id != m_containerID) {
         m_containerID = id;
-        emit containerIDChanged();
+        notifyChange(ContainerIDChange);
     }
 }
 
@@ -303,7 +545,7 @@ void Container::setContainerAddedTime(const double &time)
 {
     if (time != m_addedTime) {
         m_addedTime = time;
-        emit containerAddedTimeChanged();
+        notifyChange(AddedTimeChange);
     }
 }
 
@@ -316,7 +558,7 @@ void Container::setContainerLeavingTime(const double &time)
 {
     if (time != m_leavingTime) {
         m_leavingTime = time;
-        emit containerLeavingTimeChanged();
+        notifyChange(LeavingTimeChange);
     }
 }
 
@@ -327,59 +569,349 @@ Container::ContainerSize Container::getContainerSize() const {
 void Container::setContainerSize(ContainerSize size) {
     if (size != m_containerSize) {
         m_containerSize = size;
-        emit containerSizeChanged();
+        notifyChange(ContainerSizeChange);
     }
 }
 
-QVector<Package*> Container::getPackages() const {
-    return m_packages;
+QVector<PackageData> Container::getPackages() const {
+    return QVector<PackageData>(m_packages.cbegin(), m_packages.cend());
+}
+
+std::span<const PackageData> Container::packagesView() const {
+    return std::span<const PackageData>(
+        m_packages.constData(), static_cast<std::size_t>(m_packages.size()));
+}
+
+qsizetype Container::packageCount() const {
+    return m_packages.size();
+}
+
+void Container::setPackages(const QVector<PackageData> &packages) {
+    m_packages.clear();
+    m_packages.append(packages.constData(), packages.size());
+    notifyChange(PackagesChange);
 }
 
 void Container::setPackages(const QVector<Package*> &packages) {
-    clear();
-    for (Package* package : packages) {
-        Package* packageCopy = new Package(*package);  // Deep copy of each package
-        m_packages.append(packageCopy);
+    m_packages.clear();
+    for (const Package* package : packages) {
+        if (package) {
+            m_packages.append(package->toData());
+        }
     }
-    emit packagesChanged();
+    notifyChange(PackagesChange);
 }
 
-void Container::addPackage(Package *package) {
+void Container::adoptPackages(QVector<Package*> &&packages) {
+    setPackages(std::as_const(packages));
+    if (!m_isRunningThroughPython) {  // Python handles the pointers not us
+        qDeleteAll(packages);
+    }
+    packages.clear();
+}
+
+void Container::addPackage(const Package *package) {
+    if (package) {
+        addPackage(package->toData());
+    }
+}
+
+void Container::addPackage(const PackageData &package) {
     m_packages.append(package);
-    emit packagesChanged();
+    notifyChange(PackagesChange);
 }
 
 
 QMap<Container::HaulerType, QVariantMap> Container::getCustomVariables() const {
-    return m_customVariables;
+    if (m_customSlots.isEmpty()) {
+        return m_customVariables;
+    }
+    QMap<HaulerType, QVariantMap> variables = m_customVariables;
+    mergeCustomSlots(variables);
+    return variables;
 }
 
 void Container::setCustomVariables(const QMap<HaulerType, QVariantMap> &variables) {
-    m_customVariables = variables;
-    emit customVariablesChanged();
+    m_customSlots.clear();
+    if (customVariableSchema().slotCount.load(std::memory_order_acquire) == 0) {
+        m_customVariables = variables;
+    } else {
+        // Route registered keys into their slots
+        m_customVariables.clear();
+        for (auto it = variables.constBegin(); it != variables.constEnd(); ++it) {
+            QVariantMap &haulerVariables = m_customVariables[it.key()];
+            for (auto varIt = it.value().constBegin();
+                 varIt != it.value().constEnd(); ++varIt) {
+                if (!storeInCustomSlot(it.key(), varIt.key(), varIt.value())) {
+                    haulerVariables.insert(varIt.key(), varIt.value());
+                }
+            }
+        }
+    }
+    notifyChange(CustomVariablesChange);
 }
 
 void Container::addCustomVariable(HaulerType hauler, const QString &key, const QVariant &value) {
-    m_customVariables[hauler].insert(key, value);
-    emit customVariablesChanged();
+    clearRetiredCustomSlot(hauler, key);
+    if (storeInCustomSlot(hauler, key, value)) {
+        // Drop any stale untyped copy of the same key
+        auto it = m_customVariables.find(hauler);
+        if (it != m_customVariables.end()) {
+            it->remove(key);
+        }
+    } else {
+        m_customVariables[hauler].insert(key, value);
+    }
+    notifyChange(CustomVariablesChange);
 }
 
 void Container::removeCustomVariable(HaulerType hauler, const QString &key) {
-    if (m_customVariables.contains(hauler)) {
-        m_customVariables[hauler].remove(key);
-        emit customVariablesChanged();
+    bool removed = false;
+    int slot = customVariableSlotIndex(hauler, key);
+    if (slot >= 0 && slot < m_customSlots.size() &&
+        !std::holds_alternative<std::monostate>(m_customSlots[slot])) {
+        m_customSlots[slot] = std::monostate();
+        removed = true;
+    }
+    if (clearRetiredCustomSlot(hauler, key)) {
+        removed = true;
+    }
+    auto it = m_customVariables.find(hauler);
+    if (it != m_customVariables.end()) {
+        it->remove(key);
+        removed = true;
+    }
+    if (removed) {
+        notifyChange(CustomVariablesChange);
     }
 }
 
 QVariant Container::getCustomVariable(HaulerType hauler, const QString &key) const {
-    if (m_customVariables.contains(hauler) && m_customVariables[hauler].contains(key)) {
-        return m_customVariables[hauler][key];
+    if (!m_customSlots.isEmpty()) {
+        int slot = customVariableSlotIndex(hauler, key);
+        if (slot >= 0 && !std::holds_alternative<std::monostate>(
+                             customVariableSlot(slot))) {
+            return fromCustomValue(customVariableSlot(slot));
+        }
+    }
+    auto it = m_customVariables.constFind(hauler);
+    if (it != m_customVariables.constEnd() && it->contains(key)) {
+        return it->value(key);
+    }
+    const int retired = retiredCustomSlot(hauler, key);
+    if (retired >= 0) {
+        return fromCustomValue(m_customSlots[retired]);
     }
     return QVariant();
 }
 
+void Container::forEachCustomVariable(
+    const std::function<void(HaulerType, const QString &,
+                             const QVariant &)> &visitor) const
+{
+    for (auto it = m_customVariables.constBegin();
+         it != m_customVariables.constEnd(); ++it) {
+        for (auto varIt = it.value().constBegin();
+             varIt != it.value().constEnd(); ++varIt) {
+            visitor(it.key(), varIt.key(), varIt.value());
+        }
+    }
+
+    if (m_customSlots.isEmpty()) {
+        return;
+    }
+    CustomVariableSchema &schema = customVariableSchema();
+    QReadLocker locker(&schema.lock);
+    for (int slot = 0; slot < m_customSlots.size(); ++slot) {
+        if (std::holds_alternative<std::monostate>(m_customSlots[slot])) {
+            continue;
+        }
+        // Unregistered slots still report the values they hold
+        const CustomVariableSchema::Slot &info = schema.slots[slot];
+        visitor(info.hauler, info.key, fromCustomValue(m_customSlots[slot]));
+    }
+}
+
 QVariantMap Container::getCustomVariablesForHauler(HaulerType hauler) const {
-    return m_customVariables.value(hauler);
+    if (m_customSlots.isEmpty()) {
+        return m_customVariables.value(hauler);
+    }
+    QMap<HaulerType, QVariantMap> variables;
+    variables.insert(hauler, m_customVariables.value(hauler));
+    mergeCustomSlots(variables);
+    return variables.value(hauler);
+}
+
+int Container::registerCustomVariable(HaulerType hauler, const QString &key,
+                                      QMetaType::Type type)
+{
+    if (type == QMetaType::Int) {
+        type = QMetaType::LongLong;
+    }
+    if (type != QMetaType::Bool && type != QMetaType::LongLong &&
+        type != QMetaType::Double && type != QMetaType::QString) {
+        qWarning() << "Unsupported custom variable slot type for key" << key;
+        return -1;
+    }
+
+    CustomVariableSchema &schema = customVariableSchema();
+    QWriteLocker locker(&schema.lock);
+    const std::pair<int, QString> slotKey(static_cast<int>(hauler), key);
+    auto it = schema.slotIndexes.constFind(slotKey);
+    if (it != schema.slotIndexes.constEnd()) {
+        if (schema.slots[it.value()].type != type) {
+            qWarning() << "Custom variable" << key
+                       << "is already registered with a different type";
+        }
+        return it.value();
+    }
+
+    int slot = schema.slots.size();
+    schema.slots.append({hauler, key, type});
+    schema.slotIndexes.insert(slotKey, slot);
+    schema.slotCount.store(schema.slots.size(), std::memory_order_release);
+    return slot;
+}
+
+bool Container::unregisterCustomVariable(HaulerType hauler, const QString &key)
+{
+    CustomVariableSchema &schema = customVariableSchema();
+    QWriteLocker locker(&schema.lock);
+    auto it = schema.slotIndexes.find(
+        std::pair<int, QString>(static_cast<int>(hauler), key));
+    if (it == schema.slotIndexes.end()) {
+        return false;
+    }
+    const int slot = it.value();
+    schema.slotIndexes.erase(it);
+    // Retire the slot; reusing the index would expose stale values
+    schema.slots[slot].type = QMetaType::UnknownType;
+    return true;
+}
+
+int Container::customVariableSlotIndex(HaulerType hauler, const QString &key)
+{
+    CustomVariableSchema &schema = customVariableSchema();
+    if (schema.slotCount.load(std::memory_order_acquire) == 0) {
+        return -1;
+    }
+    QReadLocker locker(&schema.lock);
+    return schema.slotIndexes.value(
+        std::pair<int, QString>(static_cast<int>(hauler), key), -1);
+}
+
+void Container::setCustomVariableSlot(int slot, const CustomValue &value)
+{
+    CustomVariableSchema &schema = customVariableSchema();
+    if (slot < 0 || slot >= schema.slotCount.load(std::memory_order_acquire)) {
+        qWarning() << "Invalid custom variable slot" << slot;
+        return;
+    }
+    if (!std::holds_alternative<std::monostate>(value)) {
+        QReadLocker locker(&schema.lock);
+        if (!customValueMatches(value, schema.slots[slot].type)) {
+            qWarning() << "Value does not match the type of custom variable"
+                       << schema.slots[slot].key;
+            return;
+        }
+    }
+    if (slot >= m_customSlots.size()) {
+        if (std::holds_alternative<std::monostate>(value)) {
+            return;  // Nothing to clear
+        }
+        m_customSlots.resize(slot + 1);
+    }
+    m_customSlots[slot] = value;
+    notifyChange(CustomVariablesChange);
+}
+
+const Container::CustomValue &Container::customVariableSlot(int slot) const
+{
+    static const CustomValue unset;
+    if (slot < 0 || slot >= m_customSlots.size()) {
+        return unset;
+    }
+    return m_customSlots[slot];
+}
+
+bool Container::storeInCustomSlot(HaulerType hauler, const QString &key,
+                                  const QVariant &value)
+{
+    CustomVariableSchema &schema = customVariableSchema();
+    if (schema.slotCount.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+
+    QMetaType::Type type;
+    int slot;
+    {
+        QReadLocker locker(&schema.lock);
+        slot = schema.slotIndexes.value(
+            std::pair<int, QString>(static_cast<int>(hauler), key), -1);
+        if (slot < 0) {
+            return false;
+        }
+        type = schema.slots[slot].type;
+    }
+
+    CustomValue slotValue;
+    if (!toCustomValue(value, type, slotValue)) {
+        // The value falls back to the map; the slot must not shadow it
+        if (slot < m_customSlots.size()) {
+            m_customSlots[slot] = std::monostate();
+        }
+        return false;
+    }
+    if (slot >= m_customSlots.size()) {
+        m_customSlots.resize(slot + 1);
+    }
+    m_customSlots[slot] = std::move(slotValue);
+    return true;
+}
+
+void Container::mergeCustomSlots(QMap<HaulerType, QVariantMap> &variables) const
+{
+    CustomVariableSchema &schema = customVariableSchema();
+    QReadLocker locker(&schema.lock);
+    for (int slot = 0; slot < m_customSlots.size(); ++slot) {
+        if (std::holds_alternative<std::monostate>(m_customSlots[slot])) {
+            continue;
+        }
+        // Unregistered slots still report the values they hold
+        const CustomVariableSchema::Slot &info = schema.slots[slot];
+        variables[info.hauler].insert(info.key,
+                                      fromCustomValue(m_customSlots[slot]));
+    }
+}
+
+int Container::retiredCustomSlot(HaulerType hauler, const QString &key) const
+{
+    if (m_customSlots.isEmpty()) {
+        return -1;
+    }
+    CustomVariableSchema &schema = customVariableSchema();
+    QReadLocker locker(&schema.lock);
+    for (int slot = 0; slot < m_customSlots.size(); ++slot) {
+        const CustomVariableSchema::Slot &info = schema.slots[slot];
+        if (info.type == QMetaType::UnknownType && info.hauler == hauler &&
+            info.key == key &&
+            !std::holds_alternative<std::monostate>(m_customSlots[slot])) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+bool Container::clearRetiredCustomSlot(HaulerType hauler, const QString &key)
+{
+    // Writes clear older copies, so at most one retired slot holds a
+    // value for the key
+    const int slot = retiredCustomSlot(hauler, key);
+    if (slot < 0) {
+        return false;
+    }
+    m_customSlots[slot] = std::monostate();
+    return true;
 }
 
 QString Container::getContainerCurrentLocation() const {
@@ -391,9 +923,8 @@ void Container::setContainerCurrentLocation(const QString &location) {
         m_containerCurrentLocation = location; // Update the current location
 
         // Add the new location to movement history if it's not already present
-        if (!m_containerMovementHistory.contains(location)) {
-            m_containerMovementHistory.append(location);
-            emit containerMovementHistoryChanged();
+        if (appendMovementHistory(location)) {
+            notifyChange(MovementHistoryChange);
         }
 
         // If this location was in the next destinations list, remove it
@@ -401,25 +932,32 @@ void Container::setContainerCurrentLocation(const QString &location) {
         removeDestination(location);
 
         // Emit the location change signal
-        emit containerCurrentLocationChanged();
+        notifyChange(CurrentLocationChange);
     }
 }
 
-QVector<QString> Container::getContainerNextDestinations() const {
+const QVector<QString> &Container::getContainerNextDestinations() const {
     return m_containerNextDestinations;
 }
 
 void Container::setContainerNextDestinations(const QVector<QString> &destinations) {
     if (destinations != m_containerNextDestinations) {
         m_containerNextDestinations = destinations;
-        emit containerNextDestinationsChanged();
+        notifyChange(NextDestinationsChange);
+    }
+}
+
+void Container::setContainerNextDestinations(QVector<QString> &&destinations) {
+    if (destinations != m_containerNextDestinations) {
+        m_containerNextDestinations = std::move(destinations);
+        notifyChange(NextDestinationsChange);
     }
 }
 
 void Container::addDestination(const QString &destination) {
     if (!m_containerNextDestinations.contains(destination)) {
         m_containerNextDestinations.append(destination);
-        emit containerNextDestinationsChanged();
+        notifyChange(NextDestinationsChange);
     }
 }
 
@@ -427,40 +965,140 @@ bool Container::removeDestination(const QString &destination) {
     int index = m_containerNextDestinations.indexOf(destination);
     if (index != -1) {
         m_containerNextDestinations.removeAt(index);
-        emit containerNextDestinationsChanged();
+        notifyChange(NextDestinationsChange);
         return true;
     }
     return false;
 }
 
-QVector<QString> Container::getContainerMovementHistory() const {
+const QVector<QString> &Container::getContainerMovementHistory() const {
     return m_containerMovementHistory;
 }
 
 void Container::setContainerMovementHistory(const QVector<QString> &history) {
     if (history != m_containerMovementHistory) {
         m_containerMovementHistory = history;
-        emit containerMovementHistoryChanged();
+        applyMovementHistoryPolicy();
+        notifyChange(MovementHistoryChange);
+    }
+}
+
+void Container::setContainerMovementHistory(QVector<QString> &&history) {
+    if (history != m_containerMovementHistory) {
+        m_containerMovementHistory = std::move(history);
+        applyMovementHistoryPolicy();
+        notifyChange(MovementHistoryChange);
     }
 }
 
 void Container::addMovementHistory(const QString &history) {
-    if (!m_containerMovementHistory.contains(history)) {
-        m_containerMovementHistory.append(history);
-        emit containerMovementHistoryChanged();
+    if (appendMovementHistory(history)) {
+        notifyChange(MovementHistoryChange);
     }
 }
 
 bool Container::removeMovementHistory(const QString &history) {
+    if (m_historyPolicy.hashedLookup &&
+        !m_movementHistoryIndex.contains(history)) {
+        return false;
+    }
     int index = m_containerMovementHistory.indexOf(history);
     if (index != -1) {
         m_containerMovementHistory.removeAt(index);
-        emit containerMovementHistoryChanged();
+        unindexMovementHistory(history);
+        notifyChange(MovementHistoryChange);
         return true;
     }
     return false;
 }
 
+bool Container::hasMovementHistory(const QString &location) const {
+    if (m_historyPolicy.hashedLookup) {
+        return m_movementHistoryIndex.contains(location);
+    }
+    return m_containerMovementHistory.contains(location);
+}
+
+void Container::setMovementHistoryPolicy(const MovementHistoryPolicy &policy) {
+    if (policy == m_historyPolicy) {
+        return;
+    }
+    m_historyPolicy = policy;
+    if (applyMovementHistoryPolicy()) {
+        notifyChange(MovementHistoryChange);
+    }
+}
+
+Container::MovementHistoryPolicy Container::movementHistoryPolicy() const {
+    return m_historyPolicy;
+}
+
+void Container::setDefaultMovementHistoryPolicy(
+    const MovementHistoryPolicy &policy)
+{
+    const quint64 maxEntries =
+        quint64(qMax<qsizetype>(policy.maxEntries, 0)) & ~HashedLookupBit;
+    defaultHistoryPolicy().store(
+        maxEntries | (policy.hashedLookup ? HashedLookupBit : 0),
+        std::memory_order_relaxed);
+}
+
+Container::MovementHistoryPolicy Container::defaultMovementHistoryPolicy()
+{
+    const quint64 packed =
+        defaultHistoryPolicy().load(std::memory_order_relaxed);
+    MovementHistoryPolicy policy;
+    policy.maxEntries = qsizetype(packed & ~HashedLookupBit);
+    policy.hashedLookup = (packed & HashedLookupBit) != 0;
+    return policy;
+}
+
+bool Container::appendMovementHistory(const QString &location) {
+    if (m_historyPolicy.hashedLookup) {
+        if (m_movementHistoryIndex.contains(location)) {
+            return false;
+        }
+        m_movementHistoryIndex.insert(location, 1);
+    } else if (m_containerMovementHistory.contains(location)) {
+        return false;
+    }
+
+    // QList reserves room at the front after removeFirst(), so evicting
+    // the oldest entry is O(1) and the vector works as a ring buffer
+    if (m_historyPolicy.maxEntries > 0 &&
+        m_containerMovementHistory.size() >= m_historyPolicy.maxEntries) {
+        unindexMovementHistory(m_containerMovementHistory.takeFirst());
+    }
+    m_containerMovementHistory.append(location);
+    return true;
+}
+
+bool Container::applyMovementHistoryPolicy() {
+    bool trimmed = false;
+    if (m_historyPolicy.maxEntries > 0 &&
+        m_containerMovementHistory.size() > m_historyPolicy.maxEntries) {
+        m_containerMovementHistory.remove(
+            0, m_containerMovementHistory.size() - m_historyPolicy.maxEntries);
+        trimmed = true;
+    }
+
+    m_movementHistoryIndex.clear();
+    if (m_historyPolicy.hashedLookup) {
+        m_movementHistoryIndex.reserve(m_containerMovementHistory.size());
+        for (const QString &location : std::as_const(m_containerMovementHistory)) {
+            ++m_movementHistoryIndex[location];
+        }
+    }
+    return trimmed;
+}
+
+void Container::unindexMovementHistory(const QString &location) {
+    auto it = m_movementHistoryIndex.find(location);
+    if (it != m_movementHistoryIndex.end() && --it.value() == 0) {
+        m_movementHistoryIndex.erase(it);
+    }
+}
+
 // Helper function to perform deep copy
 void Container::deepCopy(const Container &other)
 {
@@ -469,18 +1107,17 @@ void Container::deepCopy(const Container &other)
     m_containerCurrentLocation = other.m_containerCurrentLocation;
     m_containerNextDestinations = other.m_containerNextDestinations;
     m_containerMovementHistory = other.m_containerMovementHistory;
+    m_addedTime = other.m_addedTime;
+    m_leavingTime = other.m_leavingTime;
+    m_historyPolicy = other.m_historyPolicy;
+    m_movementHistoryIndex = other.m_movementHistoryIndex;
 
-    // Delete existing packages before copying new ones
-    qDeleteAll(m_packages);
-    m_packages.clear();
-    for (Package* package : other.m_packages) {
-        Package* packageCopy =
-            new Package(*package);  // Deep copy of each package
-        m_packages.append(packageCopy);
-    }
+    // Packages are stored by value, so copying the array is a deep copy
+    m_packages = other.m_packages;
 
     m_customVariables =
         other.m_customVariables; // Deep copy of custom variables
+    m_customSlots = other.m_customSlots;
 }
 
 ContainerCore::Container* Container::copy() const {
@@ -494,30 +1131,29 @@ ContainerCore::Container* Container::copy() const {
     newContainer->setContainerLeavingTime(m_leavingTime);
 
     // Copy destinations and history
+    newContainer->setMovementHistoryPolicy(m_historyPolicy);
     newContainer->setContainerNextDestinations(m_containerNextDestinations);
     newContainer->setContainerMovementHistory(m_containerMovementHistory);
 
     // Deep copy packages
-    for (Package* package : m_packages) {
-        Package* packageCopy = new Package(*package);  // Using Package copy constructor
-        newContainer->addPackage(packageCopy);
+    for (const PackageData &package : m_packages) {
+        newContainer->addPackage(package);
     }
 
     // Copy custom variables
-    newContainer->setCustomVariables(m_customVariables);
+    newContainer->setCustomVariables(getCustomVariables());
 
     return newContainer;
 }
 
 // Clear the package list and delete all packages
 void Container::clear() {
-    if (!m_isRunningThroughPython) {  // Python handles the pointers not us
-        qDeleteAll(m_packages);
-    }
     m_packages.clear();
     m_customVariables.clear();
+    m_customSlots.clear();
     m_containerNextDestinations.clear();
     m_containerMovementHistory.clear();
+    m_movementHistoryIndex.clear();
 }
 
 QJsonObject Container::toJson() const
@@ -569,19 +1205,19 @@ QJsonObject Container::toJson() const
 
     // Convert packages to QJsonArray
     QJsonArray packagesArray;
-    for (const Package* package : m_packages)
+    for (const PackageData &package : m_packages)
     {
-        if (package)
-        {
-            packagesArray.append(package->toJson());
-        }
+        QJsonObject packageObject;
+        packageObject[QStringLiteral("packageID")] = package.packageID;
+        packagesArray.append(packageObject);
     }
     jsonObject[QStringLiteral("packages")] = packagesArray;
 
     // Convert customVariables to QJsonObject
     QJsonObject customVariablesObject;
-    for (auto it = m_customVariables.constBegin();
-         it != m_customVariables.constEnd(); ++it)
+    const QMap<HaulerType, QVariantMap> customVariables = getCustomVariables();
+    for (auto it = customVariables.constBegin();
+         it != customVariables.constEnd(); ++it)
     {
         QJsonObject haulerObject;
         for (auto varIt = it.value().constBegin();
@@ -607,24 +1243,373 @@ QJsonObject Container::toJson() const
     return jsonObject;
 }
 
+bool Container::writeJson(QIODevice *device) const
+{
+    ContainerJsonWriter writer(device);
+    writeJson(writer);
+    return writer.flush();
+}
+
+void Container::writeJson(ContainerJsonWriter &writer) const
+{
+    // Members in key order, matching QJsonObject serialization
+    writer.beginObject();
+
+    writer.writeKey(u"addedTime");
+    writer.writeDouble(m_addedTime); // NaN is written as null
+
+    writer.writeKey(u"containerCurrentLocation");
+    writer.writeString(m_containerCurrentLocation);
+
+    writer.writeKey(u"containerID");
+    writer.writeString(m_containerID);
+
+    writer.writeKey(u"containerMovementHistory");
+    writer.beginArray();
+    for (const QString &history : m_containerMovementHistory) {
+        writer.writeString(history);
+    }
+    writer.endArray();
+
+    writer.writeKey(u"containerNextDestinations");
+    writer.beginArray();
+    for (const QString &destination : m_containerNextDestinations) {
+        writer.writeString(destination);
+    }
+    writer.endArray();
+
+    writer.writeKey(u"containerSize");
+    writer.writeInteger(static_cast<int>(m_containerSize));
+
+    writer.writeKey(u"customVariables");
+    writer.beginObject();
+    const QMap<HaulerType, QVariantMap> customVariables = getCustomVariables();
+    for (auto it = customVariables.constBegin();
+         it != customVariables.constEnd(); ++it) {
+        // Hauler keys are single digits, so enum order is key order
+        writer.writeKey(QString::number(static_cast<int>(it.key())));
+        writer.beginObject();
+        for (auto varIt = it.value().constBegin();
+             varIt != it.value().constEnd(); ++varIt) {
+            writer.writeKey(varIt.key());
+            const QVariant &value = varIt.value();
+            if (value.typeId() == QMetaType::Double) {
+                writer.writeDouble(value.toDouble());
+            } else {
+                writer.writeValue(QJsonValue::fromVariant(value));
+            }
+        }
+        writer.endObject();
+    }
+    writer.endObject();
+
+    writer.writeKey(u"leavingTime");
+    writer.writeDouble(m_leavingTime);
+
+    writer.writeKey(u"packages");
+    writer.beginArray();
+    for (const PackageData &package : m_packages) {
+        writer.beginObject();
+        writer.writeKey(u"packageID");
+        writer.writeString(package.packageID);
+        writer.endObject();
+    }
+    writer.endArray();
+
+    writer.endObject();
+}
+
+QCborMap Container::toCbor() const
+{
+    QCborMap cborMap;
+    cborMap.insert(QLatin1String("containerID"), m_containerID);
+    cborMap.insert(QLatin1String("containerSize"),
+                   static_cast<int>(m_containerSize));
+    cborMap.insert(QLatin1String("containerCurrentLocation"),
+                   m_containerCurrentLocation);
+    cborMap.insert(QLatin1String("addedTime"), m_addedTime);
+    cborMap.insert(QLatin1String("leavingTime"), m_leavingTime);
+
+    QCborArray nextDestinations;
+    for (const QString &destination : m_containerNextDestinations) {
+        nextDestinations.append(destination);
+    }
+    cborMap.insert(QLatin1String("containerNextDestinations"),
+                   nextDestinations);
+
+    QCborArray movementHistory;
+    for (const QString &history : m_containerMovementHistory) {
+        movementHistory.append(history);
+    }
+    cborMap.insert(QLatin1String("containerMovementHistory"),
+                   movementHistory);
+
+    QCborArray packages;
+    for (const PackageData &package : m_packages) {
+        QCborMap packageMap;
+        packageMap.insert(QLatin1String("packageID"), package.packageID);
+        packages.append(packageMap);
+    }
+    cborMap.insert(QLatin1String("packages"), packages);
+
+    QCborMap customVariablesMap;
+    const QMap<HaulerType, QVariantMap> customVariables = getCustomVariables();
+    for (auto it = customVariables.constBegin();
+         it != customVariables.constEnd(); ++it) {
+        customVariablesMap.insert(static_cast<qint64>(it.key()),
+                                  QCborMap::fromVariantMap(it.value()));
+    }
+    cborMap.insert(QLatin1String("customVariables"), customVariablesMap);
+
+    return cborMap;
+}
+
+Container *Container::fromCbor(const QCborMap &cbor, QObject *parent)
+{
+    const QCborValue id = cbor.value(QLatin1String("containerID"));
+    const QCborValue size = cbor.value(QLatin1String("containerSize"));
+    if (!id.isString() || !size.isInteger()) {
+        qWarning() << "Invalid container CBOR: 'containerID' or "
+                      "'containerSize' missing";
+        return nullptr;
+    }
+
+    Container *container = new Container(parent);
+    container->m_containerID = id.toString();
+    container->m_containerSize = static_cast<ContainerSize>(size.toInteger());
+    container->m_containerCurrentLocation =
+        cbor.value(QLatin1String("containerCurrentLocation"))
+            .toString(QStringLiteral("Unknown"));
+    container->m_addedTime =
+        Cbor::toDouble(cbor.value(QLatin1String("addedTime")));
+    container->m_leavingTime =
+        Cbor::toDouble(cbor.value(QLatin1String("leavingTime")));
+
+    const QCborArray nextDestinations =
+        cbor.value(QLatin1String("containerNextDestinations")).toArray();
+    for (const QCborValue &value : nextDestinations) {
+        if (value.isString()) {
+            container->m_containerNextDestinations.append(value.toString());
+        }
+    }
+
+    const QCborArray movementHistory =
+        cbor.value(QLatin1String("containerMovementHistory")).toArray();
+    container->m_containerMovementHistory.reserve(movementHistory.size());
+    for (const QCborValue &value : movementHistory) {
+        if (value.isString()) {
+            container->m_containerMovementHistory.append(value.toString());
+        }
+    }
+    container->applyMovementHistoryPolicy();
+
+    const QCborArray packages =
+        cbor.value(QLatin1String("packages")).toArray();
+    for (const QCborValue &value : packages) {
+        if (value.isMap()) {
+            container->m_packages.append(PackageData{
+                value.toMap().value(QLatin1String("packageID")).toString()});
+        }
+    }
+
+    const QCborMap customVariables =
+        cbor.value(QLatin1String("customVariables")).toMap();
+    for (auto it = customVariables.constBegin();
+         it != customVariables.constEnd(); ++it) {
+        const QCborValue haulerKey = it.key();
+        const HaulerType hauler = static_cast<HaulerType>(
+            haulerKey.isInteger() ? haulerKey.toInteger()
+                                  : haulerKey.toString().toInt());
+        const QCborMap haulerMap = it.value().toMap();
+        QVariantMap variables;
+        for (auto varIt = haulerMap.constBegin();
+             varIt != haulerMap.constEnd(); ++varIt) {
+            const QString key = varIt.key().toString();
+            const QVariant value = varIt.value().toVariant();
+            if (!container->storeInCustomSlot(hauler, key, value)) {
+                variables.insert(key, value);
+            }
+        }
+        container->m_customVariables[hauler] = variables;
+    }
+
+    return container;
+}
+
+void Container::writeCbor(QCborStreamWriter &writer) const
+{
+    writer.startMap(9);
+
+    writer.append(QLatin1String("containerID"));
+    writer.append(m_containerID);
+
+    writer.append(QLatin1String("containerSize"));
+    writer.append(static_cast<qint64>(m_containerSize));
+
+    writer.append(QLatin1String("containerCurrentLocation"));
+    writer.append(m_containerCurrentLocation);
+
+    writer.append(QLatin1String("addedTime"));
+    writer.append(m_addedTime); // NaN is a valid CBOR double
+
+    writer.append(QLatin1String("leavingTime"));
+    writer.append(m_leavingTime);
+
+    writer.append(QLatin1String("containerNextDestinations"));
+    writer.startArray(quint64(m_containerNextDestinations.size()));
+    for (const QString &destination : m_containerNextDestinations) {
+        writer.append(destination);
+    }
+    writer.endArray();
+
+    writer.append(QLatin1String("containerMovementHistory"));
+    writer.startArray(quint64(m_containerMovementHistory.size()));
+    for (const QString &history : m_containerMovementHistory) {
+        writer.append(history);
+    }
+    writer.endArray();
+
+    writer.append(QLatin1String("packages"));
+    writer.startArray(quint64(m_packages.size()));
+    for (const PackageData &package : m_packages) {
+        Package::writeCbor(writer, package);
+    }
+    writer.endArray();
+
+    writer.append(QLatin1String("customVariables"));
+    const QMap<HaulerType, QVariantMap> customVariables = getCustomVariables();
+    writer.startMap(quint64(customVariables.size()));
+    for (auto it = customVariables.constBegin();
+         it != customVariables.constEnd(); ++it) {
+        writer.append(static_cast<qint64>(it.key()));
+        writer.startMap(quint64(it.value().size()));
+        for (auto varIt = it.value().constBegin();
+             varIt != it.value().constEnd(); ++varIt) {
+            writer.append(varIt.key());
+            QCborValue::fromVariant(varIt.value()).toCbor(writer);
+        }
+        writer.endMap();
+    }
+    writer.endMap();
+
+    writer.endMap();
+}
+
+bool Container::readCbor(QCborStreamReader &reader)
+{
+    if (!reader.isMap()) {
+        reader.next(); // Skip the value so callers can move on
+        return false;
+    }
+    if (!reader.enterContainer()) {
+        return false;
+    }
+
+    clear();
+    m_containerID.clear();
+    m_containerSize = twentyFT;
+    m_containerCurrentLocation = QStringLiteral("Unknown");
+    m_addedTime = std::numeric_limits<double>::quiet_NaN();
+    m_leavingTime = std::numeric_limits<double>::quiet_NaN();
+    m_revision = nextRevision();
+
+    bool hasID = false;
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        const QString key = Cbor::readString(reader);
+
+        if (key == QLatin1String("containerID")) {
+            hasID = reader.isString();
+            m_containerID = Cbor::readString(reader);
+        } else if (key == QLatin1String("containerSize")) {
+            m_containerSize = static_cast<ContainerSize>(
+                Cbor::readInteger(reader, twentyFT));
+        } else if (key == QLatin1String("containerCurrentLocation")) {
+            if (reader.isString()) {
+                m_containerCurrentLocation = Cbor::readString(reader);
+            } else {
+                reader.next();
+            }
+        } else if (key == QLatin1String("addedTime")) {
+            m_addedTime = Cbor::readDouble(reader);
+        } else if (key == QLatin1String("leavingTime")) {
+            m_leavingTime = Cbor::readDouble(reader);
+        } else if (key == QLatin1String("containerNextDestinations")) {
+            m_containerNextDestinations = Cbor::readStringArray(reader);
+        } else if (key == QLatin1String("containerMovementHistory")) {
+            m_containerMovementHistory = Cbor::readStringArray(reader);
+            applyMovementHistoryPolicy();
+        } else if (key == QLatin1String("packages") && reader.isArray() &&
+                   reader.enterContainer()) {
+            while (reader.lastError() == QCborError::NoError &&
+                   reader.hasNext()) {
+                PackageData package;
+                if (reader.isMap()) {
+                    if (Package::readCbor(reader, package)) {
+                        m_packages.append(std::move(package));
+                    }
+                } else {
+                    reader.next();
+                }
+            }
+            reader.leaveContainer();
+        } else if (key == QLatin1String("customVariables") &&
+                   reader.isMap() && reader.enterContainer()) {
+            while (reader.lastError() == QCborError::NoError &&
+                   reader.hasNext()) {
+                const HaulerType hauler = static_cast<HaulerType>(
+                    reader.isInteger() ? Cbor::readInteger(reader)
+                                       : Cbor::readString(reader).toInt());
+                if (!reader.isMap() || !reader.enterContainer()) {
+                    reader.next();
+                    continue;
+                }
+                QVariantMap variables;
+                while (reader.lastError() == QCborError::NoError &&
+                       reader.hasNext()) {
+                    const QString varKey = Cbor::readString(reader);
+                    const QVariant value =
+                        QCborValue::fromCbor(reader).toVariant();
+                    if (!storeInCustomSlot(hauler, varKey, value)) {
+                        variables.insert(varKey, value);
+                    }
+                }
+                reader.leaveContainer();
+                m_customVariables[hauler] = variables;
+            }
+            reader.leaveContainer();
+        } else {
+            reader.next(); // Unknown member or unexpected type
+        }
+    }
+
+    return reader.leaveContainer() && hasID;
+}
+
 // Serialization
 QDataStream &operator<<(QDataStream &out, const Container &container) {
+    DataStream::writeHeader(out, DataStream::ContainerMagic);
+
     out << container.m_containerID;
-    out << static_cast<int>(container.m_containerSize);
+    out << static_cast<qint32>(container.m_containerSize);
     out << container.m_containerCurrentLocation;
+    out << container.m_addedTime << container.m_leavingTime;
+    out << static_cast<qint64>(container.m_historyPolicy.maxEntries)
+        << container.m_historyPolicy.hashedLookup;
     out << container.m_containerNextDestinations;
     out << container.m_containerMovementHistory;
 
-    out << container.m_packages.size();
-    for (auto package : container.m_packages) {
-        out << *package;
+    out << static_cast<quint32>(container.m_packages.size());
+    for (const PackageData &package : container.m_packages) {
+        out << package.packageID;
     }
 
-    // Serialize custom variables
-    out << container.m_customVariables.size();
-    for (auto it = container.m_customVariables.cbegin();
-         it != container.m_customVariables.cend(); ++it) {
-        out << static_cast<int>(it.key()); // Serialize HaulerType
+    // Serialize custom variables, including the schema slots
+    const QMap<Container::HaulerType, QVariantMap> customVariables =
+        container.getCustomVariables();
+    out << static_cast<quint32>(customVariables.size());
+    for (auto it = customVariables.cbegin();
+         it != customVariables.cend(); ++it) {
+        out << static_cast<qint32>(it.key()); // Serialize HaulerType
         out << it.value();  // Serialize the QVariantMap
     }
 
@@ -633,42 +1618,97 @@ QDataStream &operator<<(QDataStream &out, const Container &container) {
 
 // Deserialization
 QDataStream &operator>>(QDataStream &in, Container &container) {
-    QString id, currentLocation;
-    QVector<QString> nextDestinations, movementHistory;
-    int size;
-    in >> id >> size >> currentLocation >> nextDestinations >> movementHistory;
-    container.setContainerID(id);
-    container.setContainerSize(static_cast<Container::ContainerSize>(size));
-    container.setContainerCurrentLocation(currentLocation);
-    container.setContainerNextDestinations(nextDestinations);
-    container.setContainerMovementHistory(movementHistory);
-
-    int packageCount;
-    in >> packageCount;
-    QVector<Package*> packages;
-    for (int i = 0; i < packageCount; ++i) {
-        Package* package = new Package();
-        in >> *package;
-        packages.append(package);
-    }
-    container.setPackages(packages);
-
-    // Deserialize custom variables
-    int customVarCount;
-    in >> customVarCount;
+    const quint16 version =
+        DataStream::readHeader(in, DataStream::ContainerMagic);
+    if (in.status() != QDataStream::Ok) {
+        return in;
+    }
+
+    // Decode straight into the members; clearing keeps the allocations
+    // of a recycled container
+    container.m_packages.clear();
+    container.m_customVariables.clear();
+    container.m_customSlots.clear();
+
+    qint32 size = 0;
     QMap<Container::HaulerType, QVariantMap> customVariables;
-    for (int i = 0; i < customVarCount; ++i) {
-        int haulerTypeInt;
-        in >> haulerTypeInt;
-        Container::HaulerType haulerType =
-            static_cast<Container::HaulerType>(haulerTypeInt);
 
-        QVariantMap variables;
-        in >> variables;
-        customVariables[haulerType] = variables;
+    if (version == 0) {
+        // Written before the format was versioned: no times or history
+        // policy, and the counts were written as qsizetype
+        in >> container.m_containerID >> size
+            >> container.m_containerCurrentLocation
+            >> container.m_containerNextDestinations
+            >> container.m_containerMovementHistory;
+        container.m_addedTime = std::numeric_limits<double>::quiet_NaN();
+        container.m_leavingTime = std::numeric_limits<double>::quiet_NaN();
+        // A recycled container must not keep its previous policy
+        container.m_historyPolicy =
+            Container::defaultMovementHistoryPolicy();
+    } else {
+        qint64 maxEntries = 0;
+        bool hashedLookup = false;
+        in >> container.m_containerID >> size
+            >> container.m_containerCurrentLocation
+            >> container.m_addedTime >> container.m_leavingTime
+            >> maxEntries >> hashedLookup
+            >> container.m_containerNextDestinations
+            >> container.m_containerMovementHistory;
+        container.m_historyPolicy.maxEntries = qsizetype(maxEntries);
+        container.m_historyPolicy.hashedLookup = hashedLookup;
+    }
+
+    auto readCount = [&in, version]() -> qint64 {
+        if (version == 0) {
+            qint64 count = 0;
+            in >> count;
+            return count;
+        }
+        quint32 count = 0;
+        in >> count;
+        return count;
+    };
+
+    // Packages are moved in one by one, so a corrupt count cannot
+    // trigger a huge allocation
+    const qint64 packageCount = readCount();
+    for (qint64 i = 0; i < packageCount && in.status() == QDataStream::Ok;
+         ++i) {
+        PackageData package;
+        in >> package.packageID;
+        container.m_packages.append(std::move(package));
+    }
+
+    const qint64 haulerCount = readCount();
+    for (qint64 i = 0; i < haulerCount && in.status() == QDataStream::Ok;
+         ++i) {
+        qint32 hauler = 0;
+        QVariantMap haulerVariables;
+        in >> hauler >> haulerVariables;
+        customVariables[static_cast<Container::HaulerType>(hauler)] =
+            std::move(haulerVariables);
+    }
+    container.m_containerSize = static_cast<Container::ContainerSize>(size);
+
+    // Route registered keys to their slots, as setCustomVariables() does
+    if (customVariableSchema().slotCount.load(std::memory_order_acquire) == 0) {
+        container.m_customVariables = std::move(customVariables);
+    } else {
+        for (auto it = customVariables.cbegin(); it != customVariables.cend();
+             ++it) {
+            QVariantMap &variables = container.m_customVariables[it.key()];
+            for (auto varIt = it.value().cbegin();
+                 varIt != it.value().cend(); ++varIt) {
+                if (!container.storeInCustomSlot(it.key(), varIt.key(),
+                                                 varIt.value())) {
+                    variables.insert(varIt.key(), varIt.value());
+                }
+            }
+        }
     }
-    container.setCustomVariables(customVariables);
 
+    container.applyMovementHistoryPolicy();
+    container.m_revision = Container::nextRevision();
     return in;
 }
 
@@ -0,0 +1,416 @@
+#include "containerLib/containerarrow.h"
+#include <QDebug>
+#include <QFile>
+#include <cmath>
+
+#ifdef CONTAINER_HAVE_ARROW
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/io/interfaces.h>
+#include <arrow/ipc/feather.h>
+#include <string_view>
+#endif
+
+namespace ContainerCore {
+
+#ifdef CONTAINER_HAVE_ARROW
+
+namespace {
+
+/**
+ * @brief Arrow output stream that forwards to a QIODevice
+ */
+class DeviceOutputStream : public arrow::io::OutputStream
+{
+public:
+    explicit DeviceOutputStream(QIODevice *device) : m_device(device) {}
+
+    arrow::Status Close() override
+    {
+        m_closed = true;
+        return arrow::Status::OK();
+    }
+
+    bool closed() const override { return m_closed; }
+
+    arrow::Result<int64_t> Tell() const override { return m_position; }
+
+    arrow::Status Write(const void *data, int64_t nbytes) override
+    {
+        if (m_device->write(static_cast<const char *>(data), nbytes) !=
+            nbytes) {
+            return arrow::Status::IOError(
+                m_device->errorString().toStdString());
+        }
+        m_position += nbytes;
+        return arrow::Status::OK();
+    }
+
+    using arrow::io::OutputStream::Write;
+
+private:
+    QIODevice *m_device;
+    int64_t m_position = 0;
+    bool m_closed = false;
+};
+
+std::string_view utf8View(const QByteArray &utf8)
+{
+    return std::string_view(utf8.constData(), size_t(utf8.size()));
+}
+
+arrow::Status appendStrings(arrow::ListBuilder &builder,
+                            const QVector<QString> &values)
+{
+    ARROW_RETURN_NOT_OK(builder.Append());
+    auto *strings =
+        static_cast<arrow::StringBuilder *>(builder.value_builder());
+    for (const QString &value : values) {
+        ARROW_RETURN_NOT_OK(strings->Append(utf8View(value.toUtf8())));
+    }
+    return arrow::Status::OK();
+}
+
+QString toQString(const arrow::StringArray &array, int64_t index)
+{
+    if (array.IsNull(index)) {
+        return QString();
+    }
+    const std::string_view value = array.GetView(index);
+    return QString::fromUtf8(value.data(), qsizetype(value.size()));
+}
+
+QVector<QString> toStringVector(const arrow::ListArray &array, int64_t index)
+{
+    QVector<QString> values;
+    if (array.IsNull(index)) {
+        return values;
+    }
+    const auto &strings =
+        static_cast<const arrow::StringArray &>(*array.values());
+    const int64_t begin = array.value_offset(index);
+    const int64_t end = begin + array.value_length(index);
+    values.reserve(end - begin);
+    for (int64_t i = begin; i < end; ++i) {
+        values.append(toQString(strings, i));
+    }
+    return values;
+}
+
+double toDouble(const arrow::DoubleArray &array, int64_t index)
+{
+    return array.IsNull(index) ? std::nan("") : array.Value(index);
+}
+
+/**
+ * @brief Looks up a column and checks its type
+ * @param table The table read from the file
+ * @param name Column name
+ * @param type Expected type id
+ * @return The column's single chunk
+ *
+ * List columns must hold utf8 values.
+ */
+template <typename ArrayType>
+arrow::Result<std::shared_ptr<ArrayType>>
+column(const arrow::Table &table, const std::string &name,
+       arrow::Type::type type)
+{
+    const std::shared_ptr<arrow::ChunkedArray> chunked =
+        table.GetColumnByName(name);
+    if (!chunked) {
+        return arrow::Status::Invalid("missing column '", name, "'");
+    }
+    bool matches = chunked->type()->id() == type;
+    if (matches && type == arrow::Type::LIST) {
+        matches = static_cast<const arrow::ListType &>(*chunked->type())
+                      .value_type()->id() == arrow::Type::STRING;
+    }
+    if (!matches) {
+        return arrow::Status::TypeError("column '", name, "' has type ",
+                                        chunked->type()->ToString());
+    }
+    if (chunked->num_chunks() == 0) {
+        ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Array> empty,
+                              arrow::MakeEmptyArray(chunked->type()));
+        return std::static_pointer_cast<ArrayType>(empty);
+    }
+    return std::static_pointer_cast<ArrayType>(chunked->chunk(0));
+}
+
+} // namespace
+
+struct ContainerArrowWriter::Columns {
+    arrow::StringBuilder id;
+    arrow::Int32Builder size;
+    arrow::StringBuilder location;
+    arrow::DoubleBuilder addedTime;
+    arrow::DoubleBuilder leavingTime;
+    arrow::ListBuilder destinations{arrow::default_memory_pool(),
+                                    std::make_shared<arrow::StringBuilder>()};
+    arrow::ListBuilder history{arrow::default_memory_pool(),
+                               std::make_shared<arrow::StringBuilder>()};
+    arrow::ListBuilder packages{arrow::default_memory_pool(),
+                                std::make_shared<arrow::StringBuilder>()};
+
+    /** First error raised by a builder; later rows are dropped */
+    arrow::Status status;
+
+    arrow::Status append(const Container &container)
+    {
+        ARROW_RETURN_NOT_OK(
+            id.Append(utf8View(container.getContainerID().toUtf8())));
+        ARROW_RETURN_NOT_OK(
+            size.Append(static_cast<int32_t>(container.getContainerSize())));
+        ARROW_RETURN_NOT_OK(location.Append(
+            utf8View(container.getContainerCurrentLocation().toUtf8())));
+        ARROW_RETURN_NOT_OK(
+            addedTime.Append(container.getContainerAddedTime()));
+        ARROW_RETURN_NOT_OK(
+            leavingTime.Append(container.getContainerLeavingTime()));
+        ARROW_RETURN_NOT_OK(appendStrings(
+            destinations, container.getContainerNextDestinations()));
+        ARROW_RETURN_NOT_OK(
+            appendStrings(history, container.getContainerMovementHistory()));
+
+        ARROW_RETURN_NOT_OK(packages.Append());
+        auto *packageIDs =
+            static_cast<arrow::StringBuilder *>(packages.value_builder());
+        for (const PackageData &package : container.packagesView()) {
+            ARROW_RETURN_NOT_OK(
+                packageIDs->Append(utf8View(package.packageID.toUtf8())));
+        }
+        return arrow::Status::OK();
+    }
+
+    arrow::Result<std::shared_ptr<arrow::Table>> finish()
+    {
+        ARROW_RETURN_NOT_OK(status);
+
+        const auto stringList = arrow::list(arrow::utf8());
+        const auto schema = arrow::schema({
+            arrow::field("containerID", arrow::utf8()),
+            arrow::field("containerSize", arrow::int32()),
+            arrow::field("containerCurrentLocation", arrow::utf8()),
+            arrow::field("addedTime", arrow::float64()),
+            arrow::field("leavingTime", arrow::float64()),
+            arrow::field("containerNextDestinations", stringList),
+            arrow::field("containerMovementHistory", stringList),
+            arrow::field("packages", stringList),
+        });
+
+        std::vector<std::shared_ptr<arrow::Array>> arrays(8);
+        ARROW_ASSIGN_OR_RAISE(arrays[0], id.Finish());
+        ARROW_ASSIGN_OR_RAISE(arrays[1], size.Finish());
+        ARROW_ASSIGN_OR_RAISE(arrays[2], location.Finish());
+        ARROW_ASSIGN_OR_RAISE(arrays[3], addedTime.Finish());
+        ARROW_ASSIGN_OR_RAISE(arrays[4], leavingTime.Finish());
+        ARROW_ASSIGN_OR_RAISE(arrays[5], destinations.Finish());
+        ARROW_ASSIGN_OR_RAISE(arrays[6], history.Finish());
+        ARROW_ASSIGN_OR_RAISE(arrays[7], packages.Finish());
+        return arrow::Table::Make(schema, arrays);
+    }
+};
+
+struct ContainerArrowReader::Table {
+    std::shared_ptr<arrow::io::MemoryMappedFile> file;
+    std::shared_ptr<arrow::Table> table;
+    std::shared_ptr<arrow::StringArray> id;
+    std::shared_ptr<arrow::Int32Array> size;
+    std::shared_ptr<arrow::StringArray> location;
+    std::shared_ptr<arrow::DoubleArray> addedTime;
+    std::shared_ptr<arrow::DoubleArray> leavingTime;
+    std::shared_ptr<arrow::ListArray> destinations;
+    std::shared_ptr<arrow::ListArray> history;
+    std::shared_ptr<arrow::ListArray> packages;
+
+    arrow::Status open(const QString &path)
+    {
+        ARROW_ASSIGN_OR_RAISE(
+            file, arrow::io::MemoryMappedFile::Open(
+                      QFile::encodeName(path).toStdString(),
+                      arrow::io::FileMode::READ));
+        ARROW_ASSIGN_OR_RAISE(auto reader,
+                              arrow::ipc::feather::Reader::Open(file));
+        ARROW_RETURN_NOT_OK(reader->Read(&table));
+
+        // Files from other writers may be split into several record
+        // batches; ours are written as one, so this does not copy
+        ARROW_ASSIGN_OR_RAISE(table, table->CombineChunks());
+
+        ARROW_ASSIGN_OR_RAISE(id, column<arrow::StringArray>(
+                                      *table, "containerID",
+                                      arrow::Type::STRING));
+        ARROW_ASSIGN_OR_RAISE(size, column<arrow::Int32Array>(
+                                        *table, "containerSize",
+                                        arrow::Type::INT32));
+        ARROW_ASSIGN_OR_RAISE(location, column<arrow::StringArray>(
+                                            *table, "containerCurrentLocation",
+                                            arrow::Type::STRING));
+        ARROW_ASSIGN_OR_RAISE(addedTime, column<arrow::DoubleArray>(
+                                             *table, "addedTime",
+                                             arrow::Type::DOUBLE));
+        ARROW_ASSIGN_OR_RAISE(leavingTime, column<arrow::DoubleArray>(
+                                               *table, "leavingTime",
+                                               arrow::Type::DOUBLE));
+        ARROW_ASSIGN_OR_RAISE(destinations, column<arrow::ListArray>(
+                                                *table,
+                                                "containerNextDestinations",
+                                                arrow::Type::LIST));
+        ARROW_ASSIGN_OR_RAISE(history, column<arrow::ListArray>(
+                                           *table, "containerMovementHistory",
+                                           arrow::Type::LIST));
+        ARROW_ASSIGN_OR_RAISE(packages, column<arrow::ListArray>(
+                                            *table, "packages",
+                                            arrow::Type::LIST));
+        return arrow::Status::OK();
+    }
+};
+
+#else
+
+struct ContainerArrowWriter::Columns {};
+struct ContainerArrowReader::Table {};
+
+#endif // CONTAINER_HAVE_ARROW
+
+ContainerArrowWriter::ContainerArrowWriter()
+#ifdef CONTAINER_HAVE_ARROW
+    : m_columns(std::make_unique<Columns>())
+#endif
+{
+}
+
+ContainerArrowWriter::~ContainerArrowWriter() = default;
+
+bool ContainerArrowWriter::isAvailable()
+{
+#ifdef CONTAINER_HAVE_ARROW
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ContainerArrowWriter::addContainer(const Container &container)
+{
+#ifdef CONTAINER_HAVE_ARROW
+    if (m_columns->status.ok()) {
+        m_columns->status = m_columns->append(container);
+    }
+#else
+    Q_UNUSED(container);
+#endif
+    ++m_count;
+}
+
+qsizetype ContainerArrowWriter::containerCount() const
+{
+    return m_count;
+}
+
+bool ContainerArrowWriter::write(QIODevice *device)
+{
+#ifdef CONTAINER_HAVE_ARROW
+    if (!device || !device->isWritable()) {
+        qWarning() << "Cannot write Arrow file: device is not writable";
+        return false;
+    }
+
+    const arrow::Result<std::shared_ptr<arrow::Table>> table =
+        m_columns->finish();
+    if (!table.ok()) {
+        qWarning() << "Failed to build Arrow table:"
+                   << QString::fromStdString(table.status().ToString());
+        return false;
+    }
+
+    // Uncompressed and in a single record batch so readers can map the
+    // columns without copying them
+    arrow::ipc::feather::WriteProperties properties =
+        arrow::ipc::feather::WriteProperties::Defaults();
+    properties.version = arrow::ipc::feather::kFeatherV2Version;
+    properties.compression = arrow::Compression::UNCOMPRESSED;
+    properties.chunksize = qMax<int64_t>((*table)->num_rows(), 1);
+
+    DeviceOutputStream stream(device);
+    const arrow::Status status =
+        arrow::ipc::feather::WriteTable(**table, &stream, properties);
+    if (!status.ok()) {
+        qWarning() << "Failed to write Arrow file:"
+                   << QString::fromStdString(status.ToString());
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(device);
+    qWarning() << "Cannot write Arrow file: library built without Arrow "
+                  "support";
+    return false;
+#endif
+}
+
+ContainerArrowReader::ContainerArrowReader() = default;
+
+ContainerArrowReader::~ContainerArrowReader() = default;
+
+bool ContainerArrowReader::open(const QString &path)
+{
+#ifdef CONTAINER_HAVE_ARROW
+    auto table = std::make_unique<Table>();
+    const arrow::Status status = table->open(path);
+    if (!status.ok()) {
+        qWarning() << "Failed to open Arrow file:" << path
+                   << QString::fromStdString(status.ToString());
+        return false;
+    }
+    m_table = std::move(table);
+    return true;
+#else
+    qWarning() << "Cannot open Arrow file:" << path
+               << "library built without Arrow support";
+    return false;
+#endif
+}
+
+qsizetype ContainerArrowReader::containerCount() const
+{
+#ifdef CONTAINER_HAVE_ARROW
+    return m_table ? qsizetype(m_table->table->num_rows()) : 0;
+#else
+    return 0;
+#endif
+}
+
+Container *ContainerArrowReader::createContainer(qsizetype index) const
+{
+    Container *container = new Container();
+#ifdef CONTAINER_HAVE_ARROW
+    const Table &t = *m_table;
+    const int64_t row = index;
+
+    container->setContainerID(toQString(*t.id, row));
+    if (!t.size->IsNull(row)) {
+        container->setContainerSize(
+            static_cast<Container::ContainerSize>(t.size->Value(row)));
+    }
+    container->setContainerAddedTime(toDouble(*t.addedTime, row));
+    container->setContainerLeavingTime(toDouble(*t.leavingTime, row));
+
+    // Setting the location first lets the stored history and destinations
+    // overwrite the bookkeeping setContainerCurrentLocation() does
+    container->setContainerCurrentLocation(toQString(*t.location, row));
+    container->setContainerNextDestinations(
+        toStringVector(*t.destinations, row));
+    container->setContainerMovementHistory(toStringVector(*t.history, row));
+
+    for (const QString &packageID : toStringVector(*t.packages, row)) {
+        container->addPackage(PackageData{packageID});
+    }
+#else
+    Q_UNUSED(index);
+#endif
+    return container;
+}
+
+} // namespace ContainerCore
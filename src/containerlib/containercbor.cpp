@@ -0,0 +1,86 @@
+#include "containerLib/containercbor.h"
+#include <cmath>
+
+namespace ContainerCore {
+
+namespace Cbor {
+
+QString readString(QCborStreamReader &reader)
+{
+    if (!reader.isString()) {
+        reader.next();
+        return QString();
+    }
+
+    // Strings may arrive in several chunks
+    QString result;
+    auto chunk = reader.readString();
+    while (chunk.status == QCborStreamReader::Ok) {
+        result += chunk.data;
+        chunk = reader.readString();
+    }
+    if (chunk.status == QCborStreamReader::Error) {
+        return QString();
+    }
+    return result;
+}
+
+double readDouble(QCborStreamReader &reader)
+{
+    double value = std::nan("");
+    if (reader.isDouble()) {
+        value = reader.toDouble();
+    } else if (reader.isFloat()) {
+        value = reader.toFloat();
+    } else if (reader.isFloat16()) {
+        value = reader.toFloat16();
+    } else if (reader.isInteger()) {
+        value = double(reader.toInteger());
+    }
+    reader.next();
+    return value;
+}
+
+qint64 readInteger(QCborStreamReader &reader, qint64 defaultValue)
+{
+    qint64 value = defaultValue;
+    if (reader.isInteger()) {
+        value = reader.toInteger();
+    }
+    reader.next();
+    return value;
+}
+
+QVector<QString> readStringArray(QCborStreamReader &reader)
+{
+    QVector<QString> values;
+    if (!reader.isArray()) {
+        reader.next();
+        return values;
+    }
+    if (reader.isLengthKnown()) {
+        // The length comes from the input; do not trust it blindly
+        values.reserve(qsizetype(qMin<quint64>(reader.length(), 1024)));
+    }
+    if (!reader.enterContainer()) {
+        return values;
+    }
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        if (reader.isString()) {
+            values.append(readString(reader));
+        } else {
+            reader.next();
+        }
+    }
+    reader.leaveContainer();
+    return values;
+}
+
+double toDouble(const QCborValue &value)
+{
+    return value.toDouble(std::nan(""));
+}
+
+} // namespace Cbor
+
+} // namespace ContainerCore
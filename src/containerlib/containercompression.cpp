@@ -0,0 +1,536 @@
+#include "containerLib/containercompression.h"
+#include <QDebug>
+#include <QThread>
+#include <QThreadPool>
+#include <atomic>
+#include <cstring>
+
+#ifdef CONTAINER_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef CONTAINER_HAVE_LZ4
+#include <lz4.h>
+#endif
+
+namespace ContainerCore {
+
+namespace {
+
+/** zstd level: close to LZ4 speed with a much better ratio */
+constexpr int ZstdLevel = 3;
+
+QByteArray compressBlock(Compression::Codec codec, const char *data,
+                         qsizetype size)
+{
+    switch (codec) {
+    case Compression::NoCompression:
+        return QByteArray(data, size);
+    case Compression::Zlib:
+        return qCompress(reinterpret_cast<const uchar *>(data), size);
+#ifdef CONTAINER_HAVE_ZSTD
+    case Compression::Zstd: {
+        QByteArray out(qsizetype(ZSTD_compressBound(size_t(size))),
+                       Qt::Uninitialized);
+        const size_t written = ZSTD_compress(out.data(), size_t(out.size()),
+                                             data, size_t(size), ZstdLevel);
+        if (ZSTD_isError(written)) {
+            return QByteArray();
+        }
+        out.resize(qsizetype(written));
+        return out;
+    }
+#endif
+#ifdef CONTAINER_HAVE_LZ4
+    case Compression::Lz4: {
+        QByteArray out(LZ4_compressBound(int(size)), Qt::Uninitialized);
+        const int written =
+            LZ4_compress_default(data, out.data(), int(size), int(out.size()));
+        if (written <= 0) {
+            return QByteArray();
+        }
+        out.resize(written);
+        return out;
+    }
+#endif
+    default:
+        return QByteArray();
+    }
+}
+
+bool decompressBlock(Compression::Codec codec, const char *data,
+                     qsizetype size, char *output, qsizetype outputSize)
+{
+    switch (codec) {
+    case Compression::NoCompression:
+        if (size != outputSize) {
+            return false;
+        }
+        std::memcpy(output, data, size_t(size));
+        return true;
+    case Compression::Zlib: {
+        const QByteArray out =
+            qUncompress(reinterpret_cast<const uchar *>(data), size);
+        if (out.size() != outputSize) {
+            return false;
+        }
+        std::memcpy(output, out.constData(), size_t(outputSize));
+        return true;
+    }
+#ifdef CONTAINER_HAVE_ZSTD
+    case Compression::Zstd: {
+        const size_t read = ZSTD_decompress(output, size_t(outputSize),
+                                            data, size_t(size));
+        return !ZSTD_isError(read) && read == size_t(outputSize);
+    }
+#endif
+#ifdef CONTAINER_HAVE_LZ4
+    case Compression::Lz4:
+        return LZ4_decompress_safe(data, output, int(size),
+                                   int(outputSize)) == int(outputSize);
+#endif
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Validates the header, trailer and block table of a file
+ * @param header First bytes of the file
+ * @param trailer Last bytes of the file
+ * @param fileSize Size of the file
+ * @return false if the file is not a valid compressed file
+ */
+bool checkFraming(const Compression::FileHeader &header,
+                  const Compression::Trailer &trailer, quint64 fileSize)
+{
+    if (std::memcmp(header.magic, Compression::Magic, sizeof(header.magic)) ||
+        std::memcmp(trailer.magic, Compression::Magic, sizeof(trailer.magic))) {
+        qWarning() << "Invalid compressed file: bad magic";
+        return false;
+    }
+    if (header.version > Compression::FormatVersion) {
+        qWarning() << "Unsupported compressed file version"
+                   << quint32(header.version);
+        return false;
+    }
+    if (!Compression::isCodecAvailable(Compression::Codec(quint32(header.codec)))) {
+        qWarning() << "Compressed file uses unavailable codec"
+                   << quint32(header.codec);
+        return false;
+    }
+    const quint64 tableEnd = fileSize - sizeof(Compression::Trailer);
+    const quint64 tableOffset = trailer.tableOffset;
+    if (tableOffset < sizeof(Compression::FileHeader) ||
+        tableOffset > tableEnd ||
+        quint64(trailer.blockCount) !=
+            (tableEnd - tableOffset) / sizeof(Compression::BlockEntry)) {
+        qWarning() << "Invalid compressed file: block table out of range";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks that the blocks lie before the table and add up
+ */
+bool checkBlocks(const Compression::BlockEntry *blocks, quint64 blockCount,
+                 quint64 tableOffset, quint64 uncompressedSize)
+{
+    quint64 total = 0;
+    for (quint64 i = 0; i < blockCount; ++i) {
+        const quint64 offset = blocks[i].offset;
+        const quint64 size = blocks[i].compressedSize;
+        if (offset < sizeof(Compression::FileHeader) || offset > tableOffset ||
+            size > tableOffset - offset) {
+            qWarning() << "Invalid compressed file: block" << i
+                       << "out of range";
+            return false;
+        }
+        total += blocks[i].uncompressedSize;
+    }
+    if (total != uncompressedSize) {
+        qWarning() << "Invalid compressed file: size mismatch";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+namespace Compression {
+
+bool isCodecAvailable(Codec codec)
+{
+    switch (codec) {
+    case NoCompression:
+    case Zlib:
+        return true;
+    case Zstd:
+#ifdef CONTAINER_HAVE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    case Lz4:
+#ifdef CONTAINER_HAVE_LZ4
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+Codec bestAvailableCodec()
+{
+    if (isCodecAvailable(Zstd)) {
+        return Zstd;
+    }
+    if (isCodecAvailable(Lz4)) {
+        return Lz4;
+    }
+    return Zlib;
+}
+
+bool isCompressed(QByteArrayView prefix)
+{
+    return prefix.size() >= qsizetype(sizeof(Magic)) &&
+           std::memcmp(prefix.data(), Magic, sizeof(Magic)) == 0;
+}
+
+bool decompress(const uchar *data, qint64 size, QByteArray &output,
+                int threadCount)
+{
+    if (!data ||
+        size < qint64(sizeof(FileHeader) + sizeof(Trailer))) {
+        qWarning() << "Invalid compressed file: file is too small";
+        return false;
+    }
+
+    FileHeader header;
+    Trailer trailer;
+    std::memcpy(&header, data, sizeof(header));
+    std::memcpy(&trailer, data + size - sizeof(trailer), sizeof(trailer));
+    if (!checkFraming(header, trailer, quint64(size))) {
+        return false;
+    }
+
+    const quint64 blockCount = trailer.blockCount;
+    QVector<BlockEntry> blocks(qsizetype(blockCount));
+    std::memcpy(blocks.data(), data + quint64(trailer.tableOffset),
+                blockCount * sizeof(BlockEntry));
+    if (!checkBlocks(blocks.constData(), blockCount, trailer.tableOffset,
+                     trailer.uncompressedSize)) {
+        return false;
+    }
+
+    output = QByteArray(qsizetype(quint64(trailer.uncompressedSize)),
+                        Qt::Uninitialized);
+    const Codec codec = Codec(quint32(header.codec));
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount > 0 ? threadCount
+                                           : QThread::idealThreadCount());
+    std::atomic<bool> ok{true};
+    char *target = output.data();
+    quint64 outputOffset = 0;
+    for (const BlockEntry &block : std::as_const(blocks)) {
+        const char *source =
+            reinterpret_cast<const char *>(data + quint64(block.offset));
+        const qsizetype compressedSize = qsizetype(quint32(block.compressedSize));
+        const qsizetype uncompressedSize =
+            qsizetype(quint32(block.uncompressedSize));
+        char *destination = target + outputOffset;
+        pool.start([codec, source, compressedSize, destination,
+                    uncompressedSize, &ok]() {
+            if (!decompressBlock(codec, source, compressedSize, destination,
+                                 uncompressedSize)) {
+                ok = false;
+            }
+        });
+        outputOffset += quint64(uncompressedSize);
+    }
+    pool.waitForDone();
+
+    if (!ok) {
+        qWarning() << "Invalid compressed file: corrupt block";
+        output.clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace Compression
+
+CompressedBlockWriter::CompressedBlockWriter(QIODevice *target,
+                                             Compression::Codec codec,
+                                             quint32 blockSize)
+    : m_target(target), m_codec(codec), m_blockSize(qMax(blockSize, 1u))
+{
+    if (!Compression::isCodecAvailable(m_codec)) {
+        qWarning() << "Compression codec" << quint32(codec)
+                   << "is not available, using zlib";
+        m_codec = Compression::Zlib;
+    }
+    m_pending.reserve(m_blockSize);
+
+    if (!m_target || !m_target->isWritable()) {
+        qWarning() << "Cannot compress: target device is not writable";
+        return;
+    }
+
+    Compression::FileHeader header{};
+    std::memcpy(header.magic, Compression::Magic, sizeof(header.magic));
+    header.version = Compression::FormatVersion;
+    header.codec = m_codec;
+    header.blockSize = m_blockSize;
+    if (m_target->write(reinterpret_cast<const char *>(&header),
+                        sizeof(header)) != qint64(sizeof(header))) {
+        qWarning() << "Failed to write compressed header:"
+                   << m_target->errorString();
+        return;
+    }
+    m_offset = sizeof(header);
+    QIODevice::open(QIODevice::WriteOnly);
+}
+
+CompressedBlockWriter::~CompressedBlockWriter()
+{
+    if (isOpen()) {
+        close();
+    }
+}
+
+Compression::Codec CompressedBlockWriter::codec() const
+{
+    return m_codec;
+}
+
+bool CompressedBlockWriter::hasError() const
+{
+    return m_failed || !m_target;
+}
+
+void CompressedBlockWriter::close()
+{
+    if (!isOpen()) {
+        return;
+    }
+    if (!m_pending.isEmpty()) {
+        flushBlock();
+    }
+
+    if (!m_failed) {
+        Compression::Trailer trailer{};
+        trailer.tableOffset = m_offset;
+        trailer.blockCount = quint64(m_blocks.size());
+        trailer.uncompressedSize = m_uncompressedSize;
+        std::memcpy(trailer.magic, Compression::Magic, sizeof(trailer.magic));
+
+        const qint64 tableSize =
+            m_blocks.size() * qint64(sizeof(Compression::BlockEntry));
+        if (m_target->write(reinterpret_cast<const char *>(m_blocks.constData()),
+                            tableSize) != tableSize ||
+            m_target->write(reinterpret_cast<const char *>(&trailer),
+                            sizeof(trailer)) != qint64(sizeof(trailer))) {
+            qWarning() << "Failed to write compressed block table:"
+                       << m_target->errorString();
+            m_failed = true;
+        }
+    }
+    QIODevice::close();
+}
+
+bool CompressedBlockWriter::isSequential() const
+{
+    return true;
+}
+
+qint64 CompressedBlockWriter::readData(char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+qint64 CompressedBlockWriter::writeData(const char *data, qint64 size)
+{
+    if (m_failed) {
+        return -1;
+    }
+    qint64 written = 0;
+    while (written < size) {
+        const qint64 room = qint64(m_blockSize) - m_pending.size();
+        const qint64 chunk = qMin(room, size - written);
+        m_pending.append(data + written, qsizetype(chunk));
+        written += chunk;
+        if (m_pending.size() == qsizetype(m_blockSize) && !flushBlock()) {
+            return -1;
+        }
+    }
+    return written;
+}
+
+bool CompressedBlockWriter::flushBlock()
+{
+    const QByteArray compressed =
+        compressBlock(m_codec, m_pending.constData(), m_pending.size());
+    if (compressed.isEmpty() ||
+        m_target->write(compressed) != compressed.size()) {
+        qWarning() << "Failed to write compressed block:"
+                   << m_target->errorString();
+        m_failed = true;
+        setErrorString(QStringLiteral("Failed to write compressed block"));
+        return false;
+    }
+
+    Compression::BlockEntry entry{};
+    entry.offset = m_offset;
+    entry.compressedSize = quint32(compressed.size());
+    entry.uncompressedSize = quint32(m_pending.size());
+    m_blocks.append(entry);
+
+    m_offset += quint64(compressed.size());
+    m_uncompressedSize += quint64(m_pending.size());
+
+    // Keep the allocation for the next block
+    m_pending.resize(0);
+    return true;
+}
+
+CompressedBlockReader::CompressedBlockReader(QIODevice *source)
+    : m_source(source)
+{
+}
+
+bool CompressedBlockReader::open(OpenMode mode)
+{
+    if (mode != QIODevice::ReadOnly) {
+        qWarning() << "CompressedBlockReader only supports ReadOnly";
+        return false;
+    }
+    if (!m_source || !m_source->isReadable() || m_source->isSequential()) {
+        qWarning() << "Cannot decompress: source must be a readable, "
+                      "random-access device";
+        return false;
+    }
+
+    const qint64 fileSize = m_source->size();
+    if (fileSize < qint64(sizeof(Compression::FileHeader) +
+                          sizeof(Compression::Trailer))) {
+        qWarning() << "Invalid compressed file: file is too small";
+        return false;
+    }
+
+    Compression::FileHeader header;
+    Compression::Trailer trailer;
+    if (!m_source->seek(0) ||
+        m_source->read(reinterpret_cast<char *>(&header), sizeof(header)) !=
+            qint64(sizeof(header)) ||
+        !m_source->seek(fileSize - qint64(sizeof(trailer))) ||
+        m_source->read(reinterpret_cast<char *>(&trailer), sizeof(trailer)) !=
+            qint64(sizeof(trailer))) {
+        qWarning() << "Failed to read compressed file:"
+                   << m_source->errorString();
+        return false;
+    }
+    if (!checkFraming(header, trailer, quint64(fileSize))) {
+        return false;
+    }
+
+    m_blocks.resize(qsizetype(quint64(trailer.blockCount)));
+    const qint64 tableSize =
+        m_blocks.size() * qint64(sizeof(Compression::BlockEntry));
+    if (!m_source->seek(qint64(quint64(trailer.tableOffset))) ||
+        m_source->read(reinterpret_cast<char *>(m_blocks.data()),
+                       tableSize) != tableSize) {
+        qWarning() << "Failed to read compressed block table:"
+                   << m_source->errorString();
+        return false;
+    }
+    if (!checkBlocks(m_blocks.constData(), quint64(m_blocks.size()),
+                     trailer.tableOffset, trailer.uncompressedSize)) {
+        return false;
+    }
+
+    m_codec = Compression::Codec(quint32(header.codec));
+    m_uncompressedSize = trailer.uncompressedSize;
+    m_nextBlock = 0;
+    m_current.clear();
+    m_currentPos = 0;
+    return QIODevice::open(mode);
+}
+
+qsizetype CompressedBlockReader::blockCount() const
+{
+    return m_blocks.size();
+}
+
+QByteArray CompressedBlockReader::readBlock(qsizetype index)
+{
+    if (index < 0 || index >= m_blocks.size()) {
+        return QByteArray();
+    }
+    const Compression::BlockEntry &block = m_blocks[index];
+    if (!m_source->seek(qint64(quint64(block.offset)))) {
+        return QByteArray();
+    }
+    const QByteArray compressed =
+        m_source->read(qint64(quint32(block.compressedSize)));
+    if (compressed.size() != qsizetype(quint32(block.compressedSize))) {
+        return QByteArray();
+    }
+
+    QByteArray output(qsizetype(quint32(block.uncompressedSize)),
+                      Qt::Uninitialized);
+    if (!decompressBlock(m_codec, compressed.constData(), compressed.size(),
+                         output.data(), output.size())) {
+        qWarning() << "Invalid compressed file: corrupt block" << index;
+        return QByteArray();
+    }
+    return output;
+}
+
+quint64 CompressedBlockReader::uncompressedSize() const
+{
+    return m_uncompressedSize;
+}
+
+bool CompressedBlockReader::isSequential() const
+{
+    return true;
+}
+
+qint64 CompressedBlockReader::readData(char *data, qint64 maxSize)
+{
+    qint64 read = 0;
+    while (read < maxSize) {
+        if (m_currentPos == m_current.size()) {
+            if (m_nextBlock == m_blocks.size()) {
+                break;
+            }
+            m_current = readBlock(m_nextBlock++);
+            m_currentPos = 0;
+            if (m_current.isEmpty()) {
+                setErrorString(QStringLiteral("Corrupt compressed block"));
+                return read > 0 ? read : -1;
+            }
+        }
+        const qint64 chunk =
+            qMin(maxSize - read, qint64(m_current.size() - m_currentPos));
+        std::memcpy(data + read, m_current.constData() + m_currentPos,
+                    size_t(chunk));
+        read += chunk;
+        m_currentPos += qsizetype(chunk);
+    }
+    return read > 0 || m_nextBlock < m_blocks.size() ? read : -1;
+}
+
+qint64 CompressedBlockReader::writeData(const char *data, qint64 size)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(size);
+    return -1;
+}
+
+} // namespace ContainerCore
@@ -0,0 +1,491 @@
+#include "containerLib/containerjsonstream.h"
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QLocale>
+#include <QtGlobal>
+#include <cmath>
+
+namespace ContainerCore {
+
+namespace {
+
+bool isJsonWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+char hexDigit(uint value)
+{
+    return value < 10 ? char('0' + value) : char('a' + value - 10);
+}
+
+} // namespace
+
+ContainerJsonStreamReader::ContainerJsonStreamReader(QIODevice *device,
+                                                     qint64 chunkSize)
+    : m_device(device), m_chunkSize(qMax<qint64>(chunkSize, 1))
+{
+}
+
+bool ContainerJsonStreamReader::readNext(QByteArray &element)
+{
+    element.clear();
+
+    if (m_state == Finished) {
+        return false;
+    }
+    if (m_state == Start) {
+        if (!enterContainersArray()) {
+            return false;
+        }
+        m_state = InArray;
+
+        char c;
+        if (!peek(c)) {
+            return fail(QStringLiteral("Unexpected end of input in "
+                                       "'containers' array"));
+        }
+        if (c == ']') {
+            m_state = Finished;
+            return false;
+        }
+    } else {
+        // Consume the separator left after the previous element
+        char c;
+        if (!peek(c)) {
+            return fail(QStringLiteral("Unexpected end of input in "
+                                       "'containers' array"));
+        }
+        if (c == ']') {
+            m_state = Finished;
+            return false;
+        }
+        if (c != ',') {
+            return fail(QStringLiteral("Expected ',' or ']' after element %1")
+                            .arg(m_elementIndex));
+        }
+        ++m_pos;
+    }
+
+    // Drop the consumed part so the buffer only holds the current element
+    if (m_pos > 0) {
+        m_buffer.remove(0, m_pos);
+        m_pos = 0;
+    }
+
+    char c;
+    if (!peek(c)) {
+        return fail(QStringLiteral("Unexpected end of input in "
+                                   "'containers' array"));
+    }
+    qsizetype end = 0;
+    if (!scanValue(end)) {
+        return fail(QStringLiteral("Unexpected end of input in element %1")
+                        .arg(m_elementIndex + 1));
+    }
+
+    element = m_buffer.mid(m_pos, end - m_pos);
+    m_pos = end;
+    ++m_elementIndex;
+    return true;
+}
+
+bool ContainerJsonStreamReader::hasError() const
+{
+    return !m_error.isEmpty();
+}
+
+QString ContainerJsonStreamReader::errorString() const
+{
+    return m_error;
+}
+
+qsizetype ContainerJsonStreamReader::elementIndex() const
+{
+    return m_elementIndex;
+}
+
+bool ContainerJsonStreamReader::fill()
+{
+    if (!m_device || !m_device->isReadable()) {
+        return false;
+    }
+    const QByteArray chunk = m_device->read(m_chunkSize);
+    if (chunk.isEmpty()) {
+        return false;
+    }
+    m_buffer.append(chunk);
+    return true;
+}
+
+bool ContainerJsonStreamReader::peek(char &c)
+{
+    while (true) {
+        while (m_pos < m_buffer.size()) {
+            if (!isJsonWhitespace(m_buffer.at(m_pos))) {
+                c = m_buffer.at(m_pos);
+                return true;
+            }
+            ++m_pos;
+        }
+        // Whitespace is never needed again
+        m_buffer.clear();
+        m_pos = 0;
+        if (!fill()) {
+            return false;
+        }
+    }
+}
+
+bool ContainerJsonStreamReader::scanValue(qsizetype &end)
+{
+    int depth = 0;
+    bool inString = false;
+    bool escaped = false;
+    qsizetype i = m_pos;
+
+    while (true) {
+        for (; i < m_buffer.size(); ++i) {
+            const char c = m_buffer.at(i);
+            if (inString) {
+                if (escaped) {
+                    escaped = false;
+                } else if (c == '\\') {
+                    escaped = true;
+                } else if (c == '"') {
+                    inString = false;
+                    if (depth == 0) {
+                        end = i + 1;
+                        return true;
+                    }
+                }
+                continue;
+            }
+
+            switch (c) {
+            case '"':
+                inString = true;
+                break;
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+            case ']':
+                if (depth == 0) {
+                    // End of a scalar that runs up to the closing bracket
+                    end = i;
+                    return i > m_pos;
+                }
+                if (--depth == 0) {
+                    end = i + 1;
+                    return true;
+                }
+                break;
+            case ',':
+                if (depth == 0) {
+                    end = i;
+                    return i > m_pos;
+                }
+                break;
+            default:
+                if (depth == 0 && isJsonWhitespace(c)) {
+                    end = i;
+                    return i > m_pos;
+                }
+                break;
+            }
+        }
+        if (!fill()) {
+            // A bare scalar may end the input
+            end = i;
+            return depth == 0 && !inString && i > m_pos;
+        }
+    }
+}
+
+bool ContainerJsonStreamReader::enterContainersArray()
+{
+    char c;
+    if (!peek(c) || c != '{') {
+        return fail(QStringLiteral("Document is not a JSON object"));
+    }
+    ++m_pos;
+
+    while (true) {
+        if (!peek(c)) {
+            return fail(QStringLiteral("Unexpected end of input"));
+        }
+        if (c == '}') {
+            return fail(QStringLiteral("'containers' key missing"));
+        }
+        if (c != '"') {
+            return fail(QStringLiteral("Expected an object key"));
+        }
+
+        qsizetype end = 0;
+        if (!scanValue(end)) {
+            return fail(QStringLiteral("Unexpected end of input"));
+        }
+        const bool isContainers =
+            QByteArrayView(m_buffer).sliced(m_pos, end - m_pos) ==
+            QByteArrayView("\"containers\"");
+        m_pos = end;
+
+        if (!peek(c) || c != ':') {
+            return fail(QStringLiteral("Expected ':' after object key"));
+        }
+        ++m_pos;
+        if (!peek(c)) {
+            return fail(QStringLiteral("Unexpected end of input"));
+        }
+
+        if (isContainers) {
+            if (c != '[') {
+                return fail(QStringLiteral("'containers' is not an array"));
+            }
+            ++m_pos;
+            return true;
+        }
+
+        // Skip the value of any other member
+        if (!scanValue(end)) {
+            return fail(QStringLiteral("Unexpected end of input"));
+        }
+        m_pos = end;
+        if (!peek(c)) {
+            return fail(QStringLiteral("Unexpected end of input"));
+        }
+        if (c == ',') {
+            ++m_pos;
+        } else if (c != '}') {
+            return fail(QStringLiteral("Expected ',' or '}' after member"));
+        }
+    }
+}
+
+bool ContainerJsonStreamReader::fail(const QString &message)
+{
+    m_error = message;
+    m_state = Finished;
+    return false;
+}
+
+ContainerJsonWriter::ContainerJsonWriter(QIODevice *device,
+                                         qsizetype bufferSize)
+    : m_device(device), m_bufferSize(qMax<qsizetype>(bufferSize, 1))
+{
+    m_buffer.reserve(m_bufferSize + 256);
+}
+
+ContainerJsonWriter::~ContainerJsonWriter()
+{
+    flush();
+}
+
+void ContainerJsonWriter::beginObject()
+{
+    beginValue();
+    m_buffer.append('{');
+    m_first.append(true);
+}
+
+void ContainerJsonWriter::endObject()
+{
+    m_buffer.append('}');
+    m_first.removeLast();
+    flushIfFull();
+}
+
+void ContainerJsonWriter::beginArray()
+{
+    beginValue();
+    m_buffer.append('[');
+    m_first.append(true);
+}
+
+void ContainerJsonWriter::endArray()
+{
+    m_buffer.append(']');
+    m_first.removeLast();
+    flushIfFull();
+}
+
+void ContainerJsonWriter::writeKey(QStringView key)
+{
+    beginValue();
+    appendString(key);
+    m_buffer.append(':');
+    m_afterKey = true;
+}
+
+void ContainerJsonWriter::writeString(QStringView value)
+{
+    beginValue();
+    appendString(value);
+    flushIfFull();
+}
+
+void ContainerJsonWriter::writeDouble(double value)
+{
+    if (!std::isfinite(value)) {
+        writeNull();
+        return;
+    }
+
+    // Integral values print like integers, as in QJsonDocument
+    constexpr double MaxExactInteger = 9007199254740992.0; // 2^53
+    if (value == std::trunc(value) && std::abs(value) <= MaxExactInteger) {
+        writeInteger(static_cast<qint64>(value));
+        return;
+    }
+    beginValue();
+    m_buffer.append(
+        QByteArray::number(value, 'g', QLocale::FloatingPointShortest));
+}
+
+void ContainerJsonWriter::writeInteger(qint64 value)
+{
+    beginValue();
+    m_buffer.append(QByteArray::number(value));
+}
+
+void ContainerJsonWriter::writeBool(bool value)
+{
+    beginValue();
+    m_buffer.append(value ? "true" : "false");
+}
+
+void ContainerJsonWriter::writeNull()
+{
+    beginValue();
+    m_buffer.append("null");
+}
+
+void ContainerJsonWriter::writeValue(const QJsonValue &value)
+{
+    switch (value.type()) {
+    case QJsonValue::Bool:
+        writeBool(value.toBool());
+        break;
+    case QJsonValue::Double:
+        writeDouble(value.toDouble());
+        break;
+    case QJsonValue::String:
+        writeString(value.toString());
+        break;
+    case QJsonValue::Array: {
+        beginArray();
+        const QJsonArray array = value.toArray();
+        for (const QJsonValue &element : array) {
+            writeValue(element);
+        }
+        endArray();
+        break;
+    }
+    case QJsonValue::Object: {
+        // QJsonObject iterates in key order already
+        beginObject();
+        const QJsonObject object = value.toObject();
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+            writeKey(it.key());
+            writeValue(it.value());
+        }
+        endObject();
+        break;
+    }
+    case QJsonValue::Null:
+    case QJsonValue::Undefined:
+        writeNull();
+        break;
+    }
+}
+
+bool ContainerJsonWriter::flush()
+{
+    if (m_buffer.isEmpty() || m_error) {
+        return !m_error;
+    }
+    if (!m_device ||
+        m_device->write(m_buffer) != m_buffer.size()) {
+        qWarning() << "Failed to write JSON:"
+                   << (m_device ? m_device->errorString()
+                                : QStringLiteral("no device"));
+        m_error = true;
+    }
+    // clear() would drop the allocation; keep it for the next batch
+    m_buffer.resize(0);
+    return !m_error;
+}
+
+bool ContainerJsonWriter::hasError() const
+{
+    return m_error;
+}
+
+void ContainerJsonWriter::beginValue()
+{
+    if (m_afterKey) {
+        m_afterKey = false;
+        return;
+    }
+    if (!m_first.isEmpty()) {
+        if (m_first.last()) {
+            m_first.last() = false;
+        } else {
+            m_buffer.append(',');
+        }
+    }
+}
+
+void ContainerJsonWriter::appendString(QStringView value)
+{
+    const QByteArray utf8 = value.toUtf8();
+    m_buffer.append('"');
+    for (const char byte : utf8) {
+        const uchar c = static_cast<uchar>(byte);
+        switch (c) {
+        case '"':
+            m_buffer.append("\\\"");
+            break;
+        case '\\':
+            m_buffer.append("\\\\");
+            break;
+        case '\b':
+            m_buffer.append("\\b");
+            break;
+        case '\f':
+            m_buffer.append("\\f");
+            break;
+        case '\n':
+            m_buffer.append("\\n");
+            break;
+        case '\r':
+            m_buffer.append("\\r");
+            break;
+        case '\t':
+            m_buffer.append("\\t");
+            break;
+        default:
+            if (c < 0x20) {
+                m_buffer.append("\\u00");
+                m_buffer.append(hexDigit(c >> 4));
+                m_buffer.append(hexDigit(c & 0xf));
+            } else {
+                m_buffer.append(byte);
+            }
+            break;
+        }
+    }
+    m_buffer.append('"');
+}
+
+void ContainerJsonWriter::flushIfFull()
+{
+    if (m_buffer.size() >= m_bufferSize) {
+        flush();
+    }
+}
+
+} // namespace ContainerCore
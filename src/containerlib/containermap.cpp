@@ -1,4 +1,17 @@
 #include "containerLib/containermap.h"
+#include "containerLib/containerarrow.h"
+#include "containerLib/containercbor.h"
+#include "containerLib/containerjsonstream.h"
+#include "containerLib/containersnapshot.h"
+#include <QBuffer>
+#include <QCborArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QSemaphore>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <vector>
 #include <QSqlQuery>
 #include <QSqlRecord>
 #include <QSqlError>
@@ -7,11 +20,246 @@
 #include <QFile>
 #include <iostream>
 #include <QCryptographicHash>
+#include <algorithm>
+#include <atomic>
+#include <bit>
 
 namespace ContainerCore {
 
 #define CONTAINER_CORE_CACHE_SIZE 200
 
+/**
+ * @brief Connections of worker threads, see ContainerMap::connectionUtil()
+ */
+struct ContainerMap::ThreadConnections
+{
+    QMutex mutex;
+    QHash<QThread *, QSqlDatabase> connections;
+};
+
+/**
+ * @brief Memory-mapped snapshot served by ContainerMap::openSnapshot()
+ */
+struct ContainerMap::SnapshotBackend
+{
+    QString path;
+    QFile file;
+
+    /** File mapping; null for compressed snapshots */
+    uchar *mapped = nullptr;
+
+    /** Inflated bytes of a compressed snapshot */
+    QByteArray inflated;
+
+    /** Snapshot bytes served to the reader */
+    const uchar *data = nullptr;
+    qint64 size = 0;
+
+    ContainerSnapshotReader reader;
+
+    /** Containers created from records so far, by record index */
+    QHash<qsizetype, Container *> materialized;
+};
+
+namespace {
+
+/**
+ * @brief Maps a normalized query condition to a snapshot comparison
+ */
+ContainerSnapshotReader::Comparison toComparison(const QString &condition)
+{
+    if (condition == QStringLiteral(">")) {
+        return ContainerSnapshotReader::Greater;
+    } else if (condition == QStringLiteral(">=")) {
+        return ContainerSnapshotReader::GreaterEqual;
+    } else if (condition == QStringLiteral("<")) {
+        return ContainerSnapshotReader::Less;
+    } else if (condition == QStringLiteral("<=")) {
+        return ContainerSnapshotReader::LessEqual;
+    } else if (condition == QStringLiteral("=")) {
+        return ContainerSnapshotReader::Equal;
+    }
+    return ContainerSnapshotReader::NotEqual;
+}
+
+/**
+ * @brief Applies a normalized query condition to a time
+ *
+ * Same semantics as the in-memory queries: NaN only satisfies "!=".
+ */
+bool timeMatches(double time, const QString &condition, double referenceTime)
+{
+    if (condition == QStringLiteral(">")) {
+        return time > referenceTime;
+    } else if (condition == QStringLiteral(">=")) {
+        return time >= referenceTime;
+    } else if (condition == QStringLiteral("<")) {
+        return time < referenceTime;
+    } else if (condition == QStringLiteral("<=")) {
+        return time <= referenceTime;
+    } else if (condition == QStringLiteral("=")) {
+        return time == referenceTime;
+    }
+    return time != referenceTime;
+}
+
+/**
+ * @brief Checks whether a normalized condition is one the queries accept
+ */
+bool isValidCondition(const QString &condition)
+{
+    return condition == QStringLiteral(">") ||
+           condition == QStringLiteral(">=") ||
+           condition == QStringLiteral("<") ||
+           condition == QStringLiteral("<=") ||
+           condition == QStringLiteral("=") ||
+           condition == QStringLiteral("!=");
+}
+
+/**
+ * @brief Creates a container from one element of a "containers" array
+ * @return The container, or nullptr after reporting why it was rejected
+ */
+Container *createContainerFromJson(const QJsonObject &containerObj)
+{
+    try {
+        // Use the existing JSON constructor to create a Container
+        return new Container(containerObj);
+    } catch (const std::invalid_argument &e) {
+        // Handle any exceptions thrown by the Container constructor
+        qWarning() << "Failed to add container with ID: "
+                   << containerObj[QStringLiteral("containerID")].toString()
+                   << ". Error: " << e.what();
+    } catch (const std::exception &e) {
+        // Catch all other exceptions
+        qWarning() << "Unexpected error while adding container with ID: "
+                   << containerObj[QStringLiteral("containerID")].toString()
+                   << ". Error: " << e.what();
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Parses one element produced by ContainerJsonStreamReader
+ * @return The container, or nullptr after reporting why it was rejected
+ */
+Container *createContainerFromJson(const QByteArray &element,
+                                   qsizetype elementIndex)
+{
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(element, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qWarning() << "Failed to add container: item" << elementIndex
+                   << "is not valid JSON:" << error.errorString();
+        return nullptr;
+    }
+    if (!document.isObject()) {
+        qWarning() << "Failed to add container: item is not a JSON object";
+        return nullptr;
+    }
+    return createContainerFromJson(document.object());
+}
+
+/**
+ * @brief Replaces block-compressed snapshot bytes with their inflated form
+ * @param data Snapshot bytes; redirected to @p storage if compressed
+ * @param size Snapshot size; updated if compressed
+ * @param storage Receives the inflated bytes
+ * @return false if the data is compressed but corrupt
+ */
+bool inflateIfCompressed(const uchar *&data, qint64 &size,
+                         QByteArray &storage)
+{
+    const QByteArrayView prefix(
+        data, qMin<qint64>(size, sizeof(Compression::Magic)));
+    if (!data || !Compression::isCompressed(prefix)) {
+        return true;
+    }
+    if (!Compression::decompress(data, size, storage)) {
+        return false;
+    }
+    data = reinterpret_cast<const uchar *>(storage.constData());
+    size = storage.size();
+    return true;
+}
+
+/**
+ * @brief Returns a device that yields the uncompressed bytes of a device
+ * @param device Source device, compressed or not
+ * @param decompressor Holds the decompressing reader if one is needed
+ * @return The device to read from, or nullptr on error
+ */
+QIODevice *openPlainSource(QIODevice *device,
+                          std::unique_ptr<CompressedBlockReader> &decompressor)
+{
+    if (!Compression::isCompressed(
+            device->peek(sizeof(Compression::Magic)))) {
+        return device;
+    }
+    decompressor = std::make_unique<CompressedBlockReader>(device);
+    if (!decompressor->open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+    return decompressor.get();
+}
+
+/**
+ * @brief Runs a writer through a block compressor if a codec is set
+ * @param device Destination device
+ * @param codec Block compression codec
+ * @param write Writes the plain output to the device it is given
+ * @return true if both the output and the compression succeeded
+ */
+bool writeMaybeCompressed(QIODevice *device, Compression::Codec codec,
+                          const std::function<bool(QIODevice *)> &write)
+{
+    if (codec == Compression::NoCompression) {
+        return write(device);
+    }
+    CompressedBlockWriter compressor(device, codec);
+    if (!compressor.isOpen()) {
+        return false;
+    }
+    const bool written = write(&compressor);
+    compressor.close();
+    return written && !compressor.hasError();
+}
+
+/** Encoded CBOR bytes collected before they are written to the device */
+constexpr qsizetype CborWriteBufferSize = 1 << 16;
+
+/** Array elements handed to one parallel ingest task */
+constexpr qsizetype ParallelIngestChunkSize = 512;
+
+/**
+ * @brief Sets up a thread pool for one parallel ingest call
+ */
+void configureIngestPool(QThreadPool &pool, int threadCount)
+{
+    pool.setMaxThreadCount(threadCount > 0 ? threadCount
+                                           : QThread::idealThreadCount());
+}
+
+/**
+ * @brief Concatenates per-chunk results in chunk order
+ */
+QVector<Container *>
+flattenChunks(const std::vector<std::unique_ptr<QVector<Container *>>> &chunks)
+{
+    qsizetype total = 0;
+    for (const auto &chunk : chunks) {
+        total += chunk->size();
+    }
+    QVector<Container *> containers;
+    containers.reserve(total);
+    for (const auto &chunk : chunks) {
+        containers.append(*chunk);
+    }
+    return containers;
+}
+
+} // namespace
+
 static QCoreApplication* coreAppInstance = nullptr;
 
 void deleteCoreAppInstance() {
@@ -75,6 +323,7 @@ ContainerMap::ContainerMap(const QJsonObject &json, QObject *parent)
             json[QStringLiteral("containers")].isArray()) {
             QJsonArray containersArray =
                 json[QStringLiteral("containers")].toArray();
+            ChangeBatch batch(this);
             for (const QJsonValue &value : containersArray) {
                 if (value.isObject()) {
                     try {
@@ -98,6 +347,19 @@ ContainerMap::~ContainerMap()
 {
     clearUtil(false, false);
     if (m_useDatabase) {
+        if (m_threadConnections) {
+            // Only the clone of this thread can be closed here; the others
+            // are closed by their threads when they finish
+            QMutexLocker locker(&m_threadConnections->mutex);
+            QSqlDatabase clone = m_threadConnections->connections.take(
+                QThread::currentThread());
+            const QString cloneName = clone.connectionName();
+            clone.close();
+            clone = QSqlDatabase();
+            if (!cloneName.isEmpty()) {
+                QSqlDatabase::removeDatabase(cloneName);
+            }
+        }
         QString connectionName = m_db.connectionName();
         m_db.close();
         m_db = QSqlDatabase();
@@ -131,19 +393,106 @@ void ContainerMap::setIsRunningThroughPython(bool isRunningThroughPython)
     m_cache.setDeleteWhileDestructing(!isRunningThroughPython);
 }
 
-void ContainerMap::addContainerUtil(const QString &id, Container* container,
+void ContainerMap::beginBatch()
+{
+    QMutexLocker locker(&m_mutex);
+    beginBatchUtil();
+}
+
+void ContainerMap::endBatch()
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList changedIDs;
+    if (!endBatchUtil(changedIDs)) {
+        return;
+    }
+
+    // Emit outside the lock so that listeners may query the map
+    locker.unlock();
+    emit containersChanged();
+    emit containersBatchChanged(changedIDs);
+}
+
+bool ContainerMap::isBatching() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_batchDepth > 0;
+}
+
+void ContainerMap::beginBatchUtil()
+{
+    ++m_batchDepth;
+}
+
+bool ContainerMap::endBatchUtil(QStringList &changedIDs)
+{
+    if (m_batchDepth == 0) {
+        qWarning() << "endBatch() called without a matching beginBatch()";
+        return false;
+    }
+    if (--m_batchDepth > 0 || !m_batchHasChanges) {
+        return false;
+    }
+
+    changedIDs = QStringList(m_batchChangedIDs.cbegin(),
+                             m_batchChangedIDs.cend());
+    m_batchChangedIDs.clear();
+    m_batchHasChanges = false;
+    return true;
+}
+
+void ContainerMap::notifyContainersChanged(const QStringList &ids)
+{
+    if (m_batchDepth > 0) {
+        for (const QString &id : ids) {
+            m_batchChangedIDs.insert(id);
+        }
+        m_batchHasChanges = true;
+        return;
+    }
+    emit containersChanged();
+}
+
+void ContainerMap::notifyContainersChanged(const QString &id)
+{
+    if (m_batchDepth > 0) {
+        m_batchChangedIDs.insert(id);
+        m_batchHasChanges = true;
+        return;
+    }
+    emit containersChanged();
+}
+
+bool ContainerMap::addContainerUtil(const QString &id, Container* container,
                                     double addingTime, double leavingTime)
 {
+    if (rejectSnapshotWrite("addContainer")) {
+        if (!m_isRunningThroughPython) {
+            delete container;
+        }
+        return false;
+    }
+    adoptContainerUtil(container);
+    bool stored = true;
     if (m_useDatabase) {
         container->setContainerAddedTime(addingTime);
         container->setContainerLeavingTime(leavingTime);
+        if (std::as_const(m_cache).object(id) != container) {
+            // Release a cached container this one replaces
+            m_cache.remove(id, !m_isRunningThroughPython);
+        }
         m_cache.insert(id, container);
-        saveContainerToDB(*container);
+        stored = saveContainerToDB(*container);
     } else {
         container->setContainerAddedTime(addingTime);
+        Container *previous = m_containers.value(id, nullptr);
         m_containers.insert(id, container);
+        if (previous && previous != container && !m_isRunningThroughPython) {
+            delete previous;
+        }
     }
-    emit containersChanged();
+    notifyContainersChanged(id);
+    return stored;
 }
 
 void ContainerMap::addContainer(const QString &id, Container* container,
@@ -157,6 +506,8 @@ void ContainerMap::addContainer(const QString &id, Container* container,
 void ContainerMap::addContainers(const QVector<Container*> &containers,
                                  double addingTime, double leavingTime)
 {
+    ChangeBatch batch(this);
+    QMutexLocker locker(&m_mutex);
     for (Container* container : containers) {
         if (container) {
             addContainerUtil(container->getContainerID(), container,
@@ -179,6 +530,9 @@ void ContainerMap::addContainers(const QJsonObject &json, double addingTime,
     // Retrieve the array of containers from the JSON object
     QJsonArray containersArray = json[QStringLiteral("containers")].toArray();
 
+    // Report the whole array as a single change
+    ChangeBatch batch(this);
+
     // Loop over each item in the array
     for (const QJsonValue &containerValue : containersArray) {
         if (!containerValue.isObject()) {
@@ -186,32 +540,402 @@ void ContainerMap::addContainers(const QJsonObject &json, double addingTime,
             continue; // Skip if the container is not a JSON object
         }
 
-        QJsonObject containerObj = containerValue.toObject();
+        Container *container =
+            createContainerFromJson(containerValue.toObject());
+        if (container) {
+            // Lock per record; parsing stays outside the lock
+            QMutexLocker locker(&m_mutex);
+            addContainerUtil(container->getContainerID(), container,
+                             addingTime, leavingTime);
+        }
+    }
+}
 
-        try {
-            // Use the existing JSON constructor to create a Container
-            Container *container = new Container(containerObj);
+bool ContainerMap::addContainersFromJsonStream(QIODevice *device,
+                                               double addingTime,
+                                               double leavingTime)
+{
+    if (!device || !device->isReadable()) {
+        qWarning() << "Failed to add containers: device is not readable";
+        return false;
+    }
 
-            // Add the container to the ContainerMap
-            this->addContainerUtil(container->getContainerID(), container,
-                                   addingTime, leavingTime);
-        } catch (const std::invalid_argument &e) {
-            // Handle any exceptions thrown by the Container constructor
-            qWarning() << "Failed to add container with ID: "
-                       << containerObj[QStringLiteral("containerID")].toString()
-                       << ". Error: " << e.what();
-        } catch (const std::exception &e) {
-            // Catch all other exceptions
-            qWarning() << "Unexpected error while adding container with ID: "
-                       << containerObj[QStringLiteral("containerID")].toString()
-                       << ". Error: " << e.what();
+    std::unique_ptr<CompressedBlockReader> decompressor;
+    QIODevice *source = openPlainSource(device, decompressor);
+    if (!source) {
+        return false;
+    }
+
+    // Report the whole stream as a single change
+    ChangeBatch batch(this);
+
+    ContainerJsonStreamReader reader(source);
+    QByteArray element;
+    while (reader.readNext(element)) {
+        Container *container =
+            createContainerFromJson(element, reader.elementIndex());
+        if (!container) {
+            continue;
+        }
+
+        // Lock per record so readers are not blocked for the whole file
+        QMutexLocker locker(&m_mutex);
+        addContainerUtil(container->getContainerID(), container,
+                         addingTime, leavingTime);
+    }
+
+    if (reader.hasError()) {
+        qWarning() << "Failed to add containers:" << reader.errorString();
+        return false;
+    }
+    return true;
+}
+
+void ContainerMap::addContainers(const QCborMap &cbor, double addingTime,
+                                 double leavingTime)
+{
+    const QCborValue containersValue = cbor.value(QLatin1String("containers"));
+    if (!containersValue.isArray()) {
+        qWarning() << "Failed to add containers: 'containers' "
+                      "key missing or not an array";
+        return;
+    }
+
+    const QCborArray containersArray = containersValue.toArray();
+    QVector<Container *> containers;
+    containers.reserve(containersArray.size());
+    for (const QCborValue &containerValue : containersArray) {
+        if (!containerValue.isMap()) {
+            qWarning() << "Failed to add container: item is not a CBOR map";
+            continue;
+        }
+        if (Container *container =
+                Container::fromCbor(containerValue.toMap())) {
+            containers.append(container);
+        }
+    }
+    addContainersBulk(containers, addingTime, leavingTime);
+}
+
+bool ContainerMap::addContainersFromCborStream(QIODevice *device,
+                                               double addingTime,
+                                               double leavingTime)
+{
+    if (!device || !device->isReadable()) {
+        qWarning() << "Failed to add containers: device is not readable";
+        return false;
+    }
+
+    std::unique_ptr<CompressedBlockReader> decompressor;
+    QIODevice *source = openPlainSource(device, decompressor);
+    if (!source) {
+        return false;
+    }
+
+    QCborStreamReader reader(source);
+    if (!reader.isMap() || !reader.enterContainer()) {
+        qWarning() << "Failed to add containers: document is not a CBOR map";
+        return false;
+    }
+
+    // Report the whole stream as a single change
+    ChangeBatch batch(this);
+
+    bool foundContainers = false;
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        const QString key = Cbor::readString(reader);
+        if (key != QLatin1String("containers") || !reader.isArray()) {
+            reader.next();
+            continue;
+        }
+        foundContainers = true;
+        reader.enterContainer();
+
+        qsizetype index = 0;
+        while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+            auto container = std::make_unique<Container>();
+            if (!container->readCbor(reader)) {
+                if (reader.lastError() == QCborError::NoError) {
+                    qWarning() << "Failed to add container: item" << index
+                               << "is not a valid container map";
+                }
+                ++index;
+                continue;
+            }
+            ++index;
+
+            // Lock per record so readers are not blocked for the whole file
+            QMutexLocker locker(&m_mutex);
+            const QString id = container->getContainerID();
+            addContainerUtil(id, container.release(), addingTime, leavingTime);
+        }
+        reader.leaveContainer();
+    }
+
+    if (reader.lastError() != QCborError::NoError) {
+        qWarning() << "Failed to add containers:"
+                   << reader.lastError().toString();
+        return false;
+    }
+    if (!foundContainers) {
+        qWarning() << "Failed to add containers: 'containers' "
+                      "key missing or not an array";
+        return false;
+    }
+    return true;
+}
+
+void ContainerMap::addContainersParallel(const QJsonObject &json,
+                                         double addingTime,
+                                         double leavingTime, int threadCount)
+{
+    if (!json.contains(QStringLiteral("containers")) ||
+        !json[QStringLiteral("containers")].isArray()) {
+        qWarning() << "Failed to add containers: 'containers' "
+                      "key missing or not an array";
+        return;
+    }
+
+    const QJsonArray containersArray =
+        json[QStringLiteral("containers")].toArray();
+    QThread *targetThread = thread();
+
+    QThreadPool pool;
+    configureIngestPool(pool, threadCount);
+
+    std::vector<std::unique_ptr<QVector<Container *>>> chunks;
+    for (qsizetype begin = 0; begin < containersArray.size();
+         begin += ParallelIngestChunkSize) {
+        const qsizetype end = qMin(begin + ParallelIngestChunkSize,
+                                   containersArray.size());
+        chunks.push_back(std::make_unique<QVector<Container *>>());
+        QVector<Container *> *output = chunks.back().get();
+
+        pool.start([containersArray, begin, end, output, targetThread]() {
+            output->reserve(end - begin);
+            for (qsizetype i = begin; i < end; ++i) {
+                const QJsonValue containerValue = containersArray.at(i);
+                if (!containerValue.isObject()) {
+                    qWarning() << "Failed to add container: item is not "
+                                  "a JSON object";
+                    continue;
+                }
+                Container *container =
+                    createContainerFromJson(containerValue.toObject());
+                if (container) {
+                    // Hand the object over to the map's thread
+                    container->moveToThread(targetThread);
+                    output->append(container);
+                }
+            }
+        });
+    }
+    pool.waitForDone();
+
+    addContainersBulk(flattenChunks(chunks), addingTime, leavingTime);
+}
+
+bool ContainerMap::addContainersParallel(QIODevice *device,
+                                         double addingTime,
+                                         double leavingTime, int threadCount)
+{
+    if (!device || !device->isReadable()) {
+        qWarning() << "Failed to add containers: device is not readable";
+        return false;
+    }
+
+    QThread *targetThread = thread();
+
+    QThreadPool pool;
+    configureIngestPool(pool, threadCount);
+
+    // Bound the raw JSON waiting for a worker
+    QSemaphore pendingChunks(pool.maxThreadCount() * 2);
+
+    std::unique_ptr<CompressedBlockReader> decompressor;
+    QIODevice *source = openPlainSource(device, decompressor);
+    if (!source) {
+        return false;
+    }
+
+    std::vector<std::unique_ptr<QVector<Container *>>> chunks;
+    ContainerJsonStreamReader reader(source);
+    QVector<QByteArray> elements;
+    qsizetype firstIndex = 0;
+
+    auto dispatch = [&]() {
+        if (elements.isEmpty()) {
+            return;
+        }
+        chunks.push_back(std::make_unique<QVector<Container *>>());
+        QVector<Container *> *output = chunks.back().get();
+
+        pendingChunks.acquire();
+        pool.start([elements = std::move(elements), firstIndex, output,
+                    targetThread, &pendingChunks]() {
+            output->reserve(elements.size());
+            for (qsizetype i = 0; i < elements.size(); ++i) {
+                Container *container =
+                    createContainerFromJson(elements[i], firstIndex + i);
+                if (container) {
+                    // Hand the object over to the map's thread
+                    container->moveToThread(targetThread);
+                    output->append(container);
+                }
+            }
+            pendingChunks.release();
+        });
+        elements = QVector<QByteArray>();
+        elements.reserve(ParallelIngestChunkSize);
+    };
+
+    elements.reserve(ParallelIngestChunkSize);
+    QByteArray element;
+    while (reader.readNext(element)) {
+        if (elements.isEmpty()) {
+            firstIndex = reader.elementIndex();
+        }
+        elements.append(std::move(element));
+        if (elements.size() == ParallelIngestChunkSize) {
+            dispatch();
+        }
+    }
+    dispatch();
+    pool.waitForDone();
+
+    // Containers read before a syntax error are kept, as in the serial path
+    if (!addContainersBulk(flattenChunks(chunks), addingTime, leavingTime)) {
+        return false;
+    }
+
+    if (reader.hasError()) {
+        qWarning() << "Failed to add containers:" << reader.errorString();
+        return false;
+    }
+    return true;
+}
+
+qsizetype ContainerMap::addContainersFromColumns(
+    const Columns &columns, const QVector<QString> &locations, int threadCount)
+{
+    const qsizetype count = columns.ids.size();
+    auto linesUp = [count](qsizetype size) {
+        return size == 0 || size == count;
+    };
+    if (!linesUp(columns.sizes.size()) ||
+        !linesUp(columns.addedTimes.size()) ||
+        !linesUp(columns.leavingTimes.size()) || !linesUp(locations.size())) {
+        qWarning() << "Failed to add containers: columns must be empty or "
+                      "have one entry per ID";
+        return 0;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        if (rejectSnapshotWrite("addContainersFromColumns")) {
+            return 0;
+        }
+    }
+
+    // Only the first row of an ID is built; a later one would replace it
+    QVector<bool> duplicate(count, false);
+    {
+        QSet<QString> seen;
+        seen.reserve(count);
+        for (qsizetype i = 0; i < count; ++i) {
+            const QString &id = columns.ids[i];
+            if (id.isEmpty()) {
+                continue;
+            }
+            if (seen.contains(id)) {
+                qWarning() << "Failed to add container: row" << i
+                           << "repeats ID" << id;
+                duplicate[i] = true;
+            } else {
+                seen.insert(id);
+            }
         }
     }
+
+    QThread *targetThread = thread();
+
+    QThreadPool pool;
+    configureIngestPool(pool, threadCount);
+
+    std::vector<std::unique_ptr<QVector<Container *>>> chunks;
+    for (qsizetype begin = 0; begin < count;
+         begin += ParallelIngestChunkSize) {
+        const qsizetype end = qMin(begin + ParallelIngestChunkSize, count);
+        chunks.push_back(std::make_unique<QVector<Container *>>());
+        QVector<Container *> *output = chunks.back().get();
+
+        pool.start([&columns, &locations, &duplicate, begin, end, output,
+                    targetThread]() {
+            output->reserve(end - begin);
+            for (qsizetype i = begin; i < end; ++i) {
+                if (duplicate[i]) {
+                    continue;
+                }
+                const QString &id = columns.ids[i];
+                if (id.isEmpty()) {
+                    qWarning() << "Failed to add container: row" << i
+                               << "has no ID";
+                    continue;
+                }
+                const qint32 size = columns.sizes.isEmpty()
+                                        ? qint32(Container::twentyFT)
+                                        : columns.sizes[i];
+                if (size < Container::twentyFT || size > Container::sixtyFT) {
+                    qWarning() << "Failed to add container with ID:" << id
+                               << ". Error: unknown container size" << size;
+                    continue;
+                }
+
+                // The bulk constructor neither logs nor notifies
+                auto *container = new Container(
+                    id, static_cast<Container::ContainerSize>(size),
+                    columns.addedTimes.isEmpty() ? std::nan("")
+                                                 : columns.addedTimes[i],
+                    columns.leavingTimes.isEmpty() ? std::nan("")
+                                                   : columns.leavingTimes[i],
+                    locations.isEmpty() ? QString() : locations[i]);
+                // Hand the object over to the map's thread
+                container->moveToThread(targetThread);
+                output->append(container);
+            }
+        });
+    }
+    pool.waitForDone();
+
+    const QVector<Container *> containers = flattenChunks(chunks);
+    if (!addContainersBulk(containers, std::nan(""), std::nan(""), true)) {
+        return 0;
+    }
+    return containers.size();
+}
+
+bool ContainerMap::addContainersFromJsonFile(const QString &path,
+                                             double addingTime,
+                                             double leavingTime)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to open JSON file:" << path
+                   << file.errorString();
+        return false;
+    }
+    return addContainersFromJsonStream(&file, addingTime, leavingTime);
 }
 
 
 Container* ContainerMap::getContainer(const QString &id)
 {
+    if (m_snapshot) {
+        qsizetype index = m_snapshot->reader.findContainer(id);
+        return index < 0 ? nullptr : snapshotContainer(index);
+    }
     if (m_useDatabase) {
         if (!m_cache.contains(id)) {
             loadContainerFromDB(id);
@@ -229,10 +953,14 @@ Container* ContainerMap::getContainerByID(const QString &id)
     return getContainer(id);
 }
 
-void ContainerMap::removeContainer(const QString &id)
+bool ContainerMap::removeContainer(const QString &id)
 {
+    if (rejectSnapshotWrite("removeContainer")) {
+        return false;
+    }
+    bool removed = true;
     if (m_useDatabase) {
-        removeContainerFromDB(id);
+        removed = removeContainerFromDB(id);
         m_cache.remove(id);
     } else {
         auto containerPtr = m_containers.take(id);
@@ -240,7 +968,8 @@ void ContainerMap::removeContainer(const QString &id)
             delete containerPtr;
         }
     }
-    emit containersChanged();
+    notifyContainersChanged(id);
+    return removed;
 }
 
 void ContainerMap::removeContainerByID(const QString &id)
@@ -250,17 +979,127 @@ void ContainerMap::removeContainerByID(const QString &id)
     removeContainer(id);
 }
 
-QMap<QString, Container*> ContainerMap::getAllContainers() const
+qsizetype ContainerMap::setContainersCurrentLocation(
+    const QStringList &ids, const QStringList &locations)
 {
-    QMutexLocker locker(&m_mutex);
-    QMap<QString, Container*> result;
+    return updateContainers(
+        ids, locations.size(), "setContainersCurrentLocation",
+        [&locations](Container &container, qsizetype index) {
+            container.setContainerCurrentLocation(locations[index]);
+        });
+}
 
-    if (m_useDatabase) {
-        // Query the database to retrieve all containers
-        QSqlQuery query(QStringLiteral("SELECT id, size, currentLocation, "
-                                      "addedTime, leavingTime FROM "
-                                      "Containers"), m_db);
-        while (query.next()) {
+qsizetype ContainerMap::addContainersDestination(
+    const QStringList &ids, const QStringList &destinations)
+{
+    return updateContainers(
+        ids, destinations.size(), "addContainersDestination",
+        [&destinations](Container &container, qsizetype index) {
+            container.addDestination(destinations[index]);
+        });
+}
+
+qsizetype ContainerMap::addContainersCustomVariable(
+    const QStringList &ids, Container::HaulerType hauler, const QString &key,
+    const QVariantList &values)
+{
+    return updateContainers(
+        ids, values.size(), "addContainersCustomVariable",
+        [hauler, &key, &values](Container &container, qsizetype index) {
+            container.addCustomVariable(hauler, key, values[index]);
+        });
+}
+
+qsizetype ContainerMap::updateContainers(
+    const QStringList &ids, qsizetype valueCount, const char *operation,
+    const std::function<void(Container &, qsizetype)> &update)
+{
+    if (ids.size() != valueCount) {
+        qWarning() << operation << "expects one value per ID, got"
+                   << valueCount << "values for" << ids.size() << "IDs";
+        return 0;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (rejectSnapshotWrite(operation)) {
+        return 0;
+    }
+
+    if (m_useDatabase && !connectionUtil().transaction()) {
+        qWarning() << "Failed to start transaction for container updates:"
+                   << connectionUtil().lastError().text();
+        emit databaseErrorOccurred(
+            QStringLiteral("Failed to store container updates in database."));
+        return 0;
+    }
+
+    beginBatchUtil();
+
+    bool stored = true;
+    qsizetype updated = 0;
+    for (qsizetype i = 0; i < ids.size() && stored; ++i) {
+        Container *container = getContainer(ids[i]);
+        if (!container) {
+            continue;
+        }
+        {
+            Container::ChangeBatch batch(container);
+            update(*container, i);
+        }
+        if (m_useDatabase) {
+            stored = saveContainerToDB(*container);
+        }
+        notifyContainersChanged(ids[i]);
+        ++updated;
+    }
+
+    if (m_useDatabase) {
+        if (stored && !connectionUtil().commit()) {
+            qWarning() << "Failed to commit container updates to database:"
+                       << connectionUtil().lastError().text();
+            stored = false;
+        }
+        if (!stored) {
+            // The cache holds updates the rollback discards
+            connectionUtil().rollback();
+            m_cache.clear(!m_isRunningThroughPython);
+            updated = 0;
+            emit databaseErrorOccurred(QStringLiteral(
+                "Failed to store container updates in database."));
+        }
+    }
+
+    QStringList changedIDs;
+    if (endBatchUtil(changedIDs)) {
+        locker.unlock();
+        emit containersChanged();
+        emit containersBatchChanged(changedIDs);
+    }
+    return updated;
+}
+
+QMap<QString, Container*> ContainerMap::getAllContainers() const
+{
+    QMutexLocker locker(&m_mutex);
+    QMap<QString, Container*> result;
+
+    if (m_snapshot) {
+        // Materializing is logically const: the snapshot content is fixed
+        ContainerMap *self = const_cast<ContainerMap *>(this);
+        const qsizetype count = m_snapshot->reader.containerCount();
+        for (qsizetype i = 0; i < count; ++i) {
+            Container *container = self->snapshotContainer(i);
+            result.insert(container->getContainerID(), container);
+        }
+        return result;
+    }
+
+    if (m_useDatabase) {
+        // Query the database to retrieve all containers
+        QSqlQuery query(QStringLiteral("SELECT id, size, currentLocation, "
+                                      "addedTime, leavingTime FROM "
+                                      "Containers"), connectionUtil());
+        while (query.next()) {
             QString id = query.value("id").toString();
             int size = query.value("size").toInt();
             QString currentLocation =
@@ -304,10 +1143,205 @@ QMap<QString, Container*> ContainerMap::getAllContainers() const
     return result;
 }
 
+bool ContainerMap::containsContainer(const QString &id) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_snapshot) {
+        return m_snapshot->reader.findContainer(id) >= 0;
+    }
+    if (!m_useDatabase) {
+        return m_containers.contains(id);
+    }
+    if (m_cache.contains(id)) {
+        return true;
+    }
+
+    QSqlQuery query(connectionUtil());
+    query.prepare(QStringLiteral("SELECT 1 FROM Containers WHERE id = :id"));
+    query.bindValue(QStringLiteral(":id"), id);
+    if (!query.exec()) {
+        emit databaseErrorOccurred(
+            QStringLiteral("Failed to look up container."));
+        return false;
+    }
+    return query.next();
+}
+
+QStringList ContainerMap::getContainerIDsPage(const QString &afterID,
+                                              qsizetype limit) const
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList ids;
+    if (limit <= 0) {
+        return ids;
+    }
+
+    if (m_snapshot) {
+        const ContainerSnapshotReader &reader = m_snapshot->reader;
+        const qsizetype count = reader.containerCount();
+        for (qsizetype i = afterID.isEmpty() ? 0 : reader.upperBound(afterID);
+             i < count && ids.size() < limit; ++i) {
+            ids.append(reader.string(reader.record(i).id));
+        }
+        return ids;
+    }
+
+    if (!m_useDatabase) {
+        auto it = afterID.isEmpty() ? m_containers.constBegin()
+                                    : m_containers.upperBound(afterID);
+        for (; it != m_containers.constEnd() && ids.size() < limit; ++it) {
+            ids.append(it.key());
+        }
+        return ids;
+    }
+
+    QSqlQuery query(connectionUtil());
+    query.setForwardOnly(true);
+    query.prepare(QStringLiteral("SELECT id FROM Containers WHERE id > :after "
+                                 "ORDER BY id LIMIT :limit"));
+    query.bindValue(QStringLiteral(":after"), afterID);
+    query.bindValue(QStringLiteral(":limit"), qint64(limit));
+    if (!query.exec()) {
+        emit databaseErrorOccurred(
+            QStringLiteral("Failed to query a page of container IDs."));
+        return ids;
+    }
+    while (query.next()) {
+        ids.append(query.value(0).toString());
+    }
+    return ids;
+}
+
+QVector<Container *> ContainerMap::getContainersPage(const QString &afterID,
+                                                     qsizetype limit,
+                                                     const PageFilter &filter)
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<Container *> result;
+
+    const QString condition = filter.condition.trimmed().toLower();
+    const bool timeFilter = filter.field == PageFilter::AddedTime ||
+                            filter.field == PageFilter::LeavingTime;
+    if (timeFilter && !isValidCondition(condition)) {
+        qDebug() << "Invalid condition: must be one of '>', '>=', '<', "
+                    "'<=', '=', or '!='.";
+        return result;
+    }
+    if (limit <= 0) {
+        return result;
+    }
+
+    const auto matches = [&](const Container &container) {
+        switch (filter.field) {
+        case PageFilter::AddedTime:
+            return timeMatches(container.getContainerAddedTime(), condition,
+                               filter.referenceTime);
+        case PageFilter::LeavingTime:
+            return timeMatches(container.getContainerLeavingTime(), condition,
+                               filter.referenceTime);
+        case PageFilter::NextDestination:
+            return container.getContainerNextDestinations().contains(
+                filter.destination);
+        case PageFilter::NoFilter:
+            break;
+        }
+        return true;
+    };
+
+    if (m_snapshot) {
+        const ContainerSnapshotReader &reader = m_snapshot->reader;
+        const qsizetype start =
+            afterID.isEmpty() ? 0 : reader.upperBound(afterID);
+
+        if (filter.field == PageFilter::NextDestination) {
+            // The destination index is sorted by record
+            const QVector<qsizetype> indexes =
+                reader.findByDestination(filter.destination);
+            auto it = std::lower_bound(indexes.cbegin(), indexes.cend(), start);
+            for (; it != indexes.cend() && result.size() < limit; ++it) {
+                result.append(snapshotContainer(*it));
+            }
+            return result;
+        }
+
+        const qsizetype count = reader.containerCount();
+        for (qsizetype i = start; i < count && result.size() < limit; ++i) {
+            const Snapshot::ContainerRecord &rec = reader.record(i);
+            if (timeFilter &&
+                !timeMatches(std::bit_cast<double>(quint64(
+                                 filter.field == PageFilter::AddedTime
+                                     ? rec.addedTime : rec.leavingTime)),
+                             condition, filter.referenceTime)) {
+                continue;
+            }
+            result.append(snapshotContainer(i));
+        }
+        return result;
+    }
+
+    if (!m_useDatabase) {
+        auto it = afterID.isEmpty() ? m_containers.constBegin()
+                                    : m_containers.upperBound(afterID);
+        for (; it != m_containers.constEnd() && result.size() < limit; ++it) {
+            if (it.value() && matches(*it.value())) {
+                result.append(it.value());
+            }
+        }
+        return result;
+    }
+
+    // Loaded containers live in the cache; a page larger than the cache
+    // would evict and delete its own first containers
+    limit = qMin<qsizetype>(limit, CONTAINER_CORE_CACHE_SIZE);
+
+    QString where = QStringLiteral("id > :after");
+    if (timeFilter) {
+        where += QStringLiteral(" AND %1 %2 :referenceTime")
+                     .arg(filter.field == PageFilter::AddedTime
+                              ? QStringLiteral("addedTime")
+                              : QStringLiteral("leavingTime"),
+                          condition);
+    } else if (filter.field == PageFilter::NextDestination) {
+        where += QStringLiteral(" AND id IN (SELECT container_id FROM "
+                                "NextDestinations WHERE destination = "
+                                ":destination)");
+    }
+
+    QSqlQuery query(connectionUtil());
+    query.setForwardOnly(true);
+    query.prepare(QStringLiteral("SELECT id FROM Containers WHERE %1 "
+                                 "ORDER BY id LIMIT :limit").arg(where));
+    query.bindValue(QStringLiteral(":after"), afterID);
+    query.bindValue(QStringLiteral(":limit"), qint64(limit));
+    if (timeFilter) {
+        query.bindValue(QStringLiteral(":referenceTime"),
+                        filter.referenceTime);
+    } else if (filter.field == PageFilter::NextDestination) {
+        query.bindValue(QStringLiteral(":destination"), filter.destination);
+    }
+    if (!query.exec()) {
+        emit databaseErrorOccurred(
+            QStringLiteral("Failed to query a page of containers."));
+        return result;
+    }
+
+    QStringList ids;
+    while (query.next()) {
+        ids.append(query.value(0).toString());
+    }
+    for (const QString &id : std::as_const(ids)) {
+        if (Container *container = getContainer(id)) {
+            result.append(container);
+        }
+    }
+    return result;
+}
+
 void ContainerMap::loadAdditionalContainerData(Container &container) const
 {
     // Load packages
-    QSqlQuery packageQuery(m_db);
+    QSqlQuery packageQuery(connectionUtil());
     packageQuery.prepare(QStringLiteral("SELECT id FROM Packages WHERE "
                                        "container_id = :container_id"));
     packageQuery.bindValue(QStringLiteral(":container_id"),
@@ -316,13 +1350,11 @@ void ContainerMap::loadAdditionalContainerData(Container &container) const
 
     while (packageQuery.next()) {
         QString packageID = packageQuery.value("id").toString();
-        // Assume you have a way to create or retrieve the package by ID
-        Package *package = new Package(packageID);
-        container.addPackage(package);
+        container.addPackage(PackageData{packageID});
     }
 
     // Load custom variables
-    QSqlQuery customVarQuery(m_db);
+    QSqlQuery customVarQuery(connectionUtil());
     customVarQuery.prepare(QStringLiteral("SELECT hauler_type, key, value "
                                          "FROM CustomVariables WHERE "
                                          "container_id = :container_id"));
@@ -339,7 +1371,7 @@ void ContainerMap::loadAdditionalContainerData(Container &container) const
     }
 
     // Load next destinations
-    QSqlQuery nextDestQuery(m_db);
+    QSqlQuery nextDestQuery(connectionUtil());
     nextDestQuery.prepare(QStringLiteral("SELECT destination FROM "
                                         "NextDestinations WHERE "
                                         "container_id = :container_id"));
@@ -353,7 +1385,7 @@ void ContainerMap::loadAdditionalContainerData(Container &container) const
     }
 
     // Load movement history
-    QSqlQuery movementHistoryQuery(m_db);
+    QSqlQuery movementHistoryQuery(connectionUtil());
     movementHistoryQuery.prepare(QStringLiteral("SELECT history FROM "
                                                "MovementHistory WHERE "
                                                "container_id = :container_id"));
@@ -371,6 +1403,16 @@ QMap<QString, Container *> ContainerMap::getLatestContainers()
 {
     QMutexLocker locker(&m_mutex);
 
+    if (m_snapshot) {
+        // Only the containers materialized so far
+        QMap<QString, Container*> result;
+        for (Container *container :
+             std::as_const(m_snapshot->materialized)) {
+            result.insert(container->getContainerID(), container);
+        }
+        return result;
+    }
+
     if (m_useDatabase) {
         QMap<QString, Container*> result;
         for (auto &id : m_cache.keys()) {
@@ -384,6 +1426,15 @@ QMap<QString, Container *> ContainerMap::getLatestContainers()
 
 void ContainerMap::clearUtil(bool enableClearDatabase, bool enableEmit)
 {
+    // Only collect the cleared IDs when a batch will report them
+    QStringList clearedIDs;
+    if (enableEmit && m_batchDepth > 0 && !m_snapshot) {
+        clearedIDs = m_useDatabase ? m_cache.keys() : m_containers.keys();
+    }
+
+    // Clearing ends read-only snapshot mode
+    closeSnapshotUtil();
+
     if (m_useDatabase) {
         if (enableClearDatabase) {
             clearDatabase();
@@ -396,7 +1447,7 @@ void ContainerMap::clearUtil(bool enableClearDatabase, bool enableEmit)
         m_containers.clear();
     }
     if (enableEmit) {
-        emit containersChanged();
+        notifyContainersChanged(clearedIDs);
     }
 }
 
@@ -410,10 +1461,23 @@ void ContainerMap::copyFrom(ContainerMap &other)
     QMutexLocker locker(&m_mutex);
     QMutexLocker otherLocker(&other.m_mutex);
 
-    if (other.m_useDatabase) {
+    if (rejectSnapshotWrite("copyFrom")) {
+        return;
+    }
+
+    if (other.m_snapshot) {
+        const qsizetype count = other.m_snapshot->reader.containerCount();
+        for (qsizetype i = 0; i < count; ++i) {
+            // Copy straight from the record so the source stays unexpanded
+            Container *container = other.m_snapshot->reader.createContainer(i);
+            addContainerUtil(container->getContainerID(), container,
+                             container->getContainerAddedTime(),
+                             container->getContainerLeavingTime());
+        }
+    } else if (other.m_useDatabase) {
         // If the source ContainerMap is using a database,
         // iterate over all container IDs in the database
-        QSqlQuery query(other.m_db);
+        QSqlQuery query(other.connectionUtil());
         query.prepare(QStringLiteral("SELECT id FROM Containers"));
 
         if (query.exec()) {
@@ -450,9 +1514,11 @@ qsizetype ContainerMap::size() const
     QMutexLocker locker(&m_mutex);
     qsizetype count = 0;
 
-    if (m_useDatabase) {
+    if (m_snapshot) {
+        count = m_snapshot->reader.containerCount();
+    } else if (m_useDatabase) {
         // Query the database to count the number of containers
-        QSqlQuery query(m_db);
+        QSqlQuery query(connectionUtil());
         query.prepare(QStringLiteral("SELECT COUNT(*) FROM Containers"));
 
         if (query.exec() && query.next()) {
@@ -470,12 +1536,104 @@ qsizetype ContainerMap::size() const
     return count;
 }
 
+ContainerMap::Columns ContainerMap::columns() const
+{
+    QMutexLocker locker(&m_mutex);
+    Columns columns;
+    const auto append = [&columns](const QString &id, qint32 size,
+                                   double addedTime, double leavingTime) {
+        columns.ids.append(id);
+        columns.sizes.append(size);
+        columns.addedTimes.append(addedTime);
+        columns.leavingTimes.append(leavingTime);
+    };
+    const auto reserve = [&columns](qsizetype count) {
+        columns.ids.reserve(count);
+        columns.sizes.reserve(count);
+        columns.addedTimes.reserve(count);
+        columns.leavingTimes.reserve(count);
+    };
+
+    if (m_snapshot) {
+        const ContainerSnapshotReader &reader = m_snapshot->reader;
+        const qsizetype count = reader.containerCount();
+        reserve(count);
+        for (qsizetype i = 0; i < count; ++i) {
+            const Snapshot::ContainerRecord &rec = reader.record(i);
+            append(reader.string(rec.id), rec.size,
+                   std::bit_cast<double>(quint64(rec.addedTime)),
+                   std::bit_cast<double>(quint64(rec.leavingTime)));
+        }
+        return columns;
+    }
+
+    if (!m_useDatabase) {
+        reserve(m_containers.size());
+        for (const Container *container : m_containers) {
+            if (container) {
+                append(container->getContainerID(),
+                       qint32(container->getContainerSize()),
+                       container->getContainerAddedTime(),
+                       container->getContainerLeavingTime());
+            }
+        }
+        return columns;
+    }
+
+    QSqlQuery query(connectionUtil());
+    query.setForwardOnly(true);
+    if (!query.exec(QStringLiteral("SELECT id, size, addedTime, leavingTime "
+                                   "FROM Containers"))) {
+        emit databaseErrorOccurred(
+            QStringLiteral("Failed to query container columns."));
+        return columns;
+    }
+    while (query.next()) {
+        const QString id = query.value(0).toString();
+        if (const Container *cached = m_cache.object(id)) {
+            append(id, qint32(cached->getContainerSize()),
+                   cached->getContainerAddedTime(),
+                   cached->getContainerLeavingTime());
+            continue;
+        }
+        append(id, query.value(1).toInt(),
+               query.value(2).isNull() ? std::nan("")
+                                       : query.value(2).toDouble(),
+               query.value(3).isNull() ? std::nan("")
+                                       : query.value(3).toDouble());
+    }
+    return columns;
+}
+
+bool ContainerMap::forEachContainer(
+    const std::function<void(const Container &)> &visit) const
+{
+    QMutexLocker locker(&m_mutex);
+    return forEachContainerUtil(visit);
+}
+
+bool ContainerMap::isDatabaseBacked() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_useDatabase && !m_snapshot;
+}
+
 QJsonObject ContainerMap::toJson() const
 {
     QMutexLocker locker(&m_mutex);
     QJsonObject jsonObject;
 
-    if (m_useDatabase) {
+    if (m_snapshot) {
+        // Build the objects from the records without keeping them around
+        QJsonArray containerArray;
+        const qsizetype count = m_snapshot->reader.containerCount();
+        for (qsizetype i = 0; i < count; ++i) {
+            std::unique_ptr<Container> container(
+                m_snapshot->reader.createContainer(i));
+            containerArray.append(container->toJson());
+        }
+        jsonObject[QStringLiteral("containers")] = containerArray;
+    } else if (m_useDatabase) {
         // Add the database location to the JSON object
         jsonObject[QStringLiteral("databaseLocation")] = m_db.databaseName();
     } else {
@@ -497,6 +1655,119 @@ QJsonObject ContainerMap::toJson() const
     return jsonObject;
 }
 
+bool ContainerMap::writeJson(QIODevice *device,
+                             Compression::Codec codec) const
+{
+    if (codec != Compression::NoCompression) {
+        return writeMaybeCompressed(device, codec, [this](QIODevice *target) {
+            return writeJson(target, Compression::NoCompression);
+        });
+    }
+
+    QMutexLocker locker(&m_mutex);
+    ContainerJsonWriter writer(device);
+
+    writer.beginObject();
+    if (m_snapshot) {
+        writer.writeKey(u"containers");
+        writer.beginArray();
+        const qsizetype count = m_snapshot->reader.containerCount();
+        for (qsizetype i = 0; i < count && !writer.hasError(); ++i) {
+            std::unique_ptr<Container> container(
+                m_snapshot->reader.createContainer(i));
+            container->writeJson(writer);
+        }
+        writer.endArray();
+    } else if (m_useDatabase) {
+        writer.writeKey(u"databaseLocation");
+        writer.writeString(m_db.databaseName());
+    } else {
+        writer.writeKey(u"containers");
+        writer.beginArray();
+        for (auto it = m_containers.constBegin();
+             it != m_containers.constEnd() && !writer.hasError(); ++it) {
+            if (it.value()) {
+                it.value()->writeJson(writer);
+            }
+        }
+        writer.endArray();
+    }
+    writer.endObject();
+
+    return writer.flush();
+}
+
+QCborMap ContainerMap::toCbor() const
+{
+    QMutexLocker locker(&m_mutex);
+    QCborMap cborMap;
+
+    if (m_useDatabase && !m_snapshot) {
+        cborMap.insert(QLatin1String("databaseLocation"), m_db.databaseName());
+        return cborMap;
+    }
+
+    QCborArray containerArray;
+    forEachContainerUtil([&containerArray](const Container &container) {
+        containerArray.append(container.toCbor());
+    });
+    cborMap.insert(QLatin1String("containers"), containerArray);
+    return cborMap;
+}
+
+bool ContainerMap::writeCbor(QIODevice *device,
+                             Compression::Codec codec) const
+{
+    if (codec != Compression::NoCompression) {
+        return writeMaybeCompressed(device, codec, [this](QIODevice *target) {
+            return writeCbor(target, Compression::NoCompression);
+        });
+    }
+    if (!device || !device->isWritable()) {
+        qWarning() << "Failed to write CBOR: device is not writable";
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    // QCborStreamWriter does not report device errors, so encode into a
+    // buffer and hand it to the device in batches
+    QByteArray pending;
+    QBuffer buffer(&pending);
+    buffer.open(QIODevice::WriteOnly);
+    QCborStreamWriter writer(&buffer);
+    bool failed = false;
+    auto drain = [&]() {
+        if (!failed && device->write(pending) != pending.size()) {
+            qWarning() << "Failed to write CBOR:" << device->errorString();
+            failed = true;
+        }
+        pending.resize(0);
+        buffer.seek(0);
+    };
+
+    writer.startMap(1);
+    if (m_useDatabase && !m_snapshot) {
+        writer.append(QLatin1String("databaseLocation"));
+        writer.append(m_db.databaseName());
+    } else {
+        // Indefinite length, since null entries are skipped
+        writer.append(QLatin1String("containers"));
+        writer.startArray();
+        forEachContainerUtil([&](const Container &container) {
+            container.writeCbor(writer);
+            if (pending.size() >= CborWriteBufferSize) {
+                drain();
+            }
+        });
+        writer.endArray();
+    }
+    writer.endMap();
+    drain();
+
+    return !failed;
+}
+
 QVector<Container *> ContainerMap::getContainersByAddedTime(
     const QString &condition, double referenceTime)
 {
@@ -518,9 +1789,15 @@ QVector<Container *> ContainerMap::getContainersByAddedTime(
         return result;
     }
 
+    if (m_snapshot) {
+        return snapshotContainers(m_snapshot->reader.findByTime(
+            ContainerSnapshotReader::AddedTime,
+            toComparison(normalizedCondition), referenceTime));
+    }
+
     if (m_useDatabase) {
         // If using a database, query based on addedTime
-        QSqlQuery query(m_db);
+        QSqlQuery query(connectionUtil());
         QString queryString;
 
         // Prepare query string based on condition
@@ -621,9 +1898,16 @@ QVector<Container *> ContainerMap::dequeueContainersByAddedTime(const QString &c
         return matchingContainers;
     }
 
+    if (rejectSnapshotWrite("dequeueContainersByAddedTime")) {
+        return matchingContainers;
+    }
+
+    // Report all dequeued containers as a single change
+    beginBatchUtil();
+
     if (m_useDatabase) {
         // Retrieve containers from the database based on addedTime
-        QSqlQuery query(m_db);
+        QSqlQuery query(connectionUtil());
         QString queryString;
 
         // Prepare query string based on condition
@@ -696,6 +1980,7 @@ QVector<Container *> ContainerMap::dequeueContainersByAddedTime(const QString &c
 
                 if (conditionMet) {
                     matchingContainers.append(container);
+                    notifyContainersChanged(it.key());
                     it = m_containers.erase(it);
                 } else {
                     ++it;
@@ -706,7 +1991,11 @@ QVector<Container *> ContainerMap::dequeueContainersByAddedTime(const QString &c
         }
     }
 
-    emit containersChanged();
+    QStringList changedIDs;
+    if (endBatchUtil(changedIDs)) {
+        emit containersChanged();
+        emit containersBatchChanged(changedIDs);
+    }
     return matchingContainers;
 }
 
@@ -728,9 +2017,15 @@ qsizetype ContainerMap::countContainersByAddedTime(const QString &condition, dou
         return count;
     }
 
+    if (m_snapshot) {
+        return m_snapshot->reader.countByTime(
+            ContainerSnapshotReader::AddedTime,
+            toComparison(normalizedCondition), referenceTime);
+    }
+
     if (m_useDatabase) {
         // Query the database for containers by addedTime
-        QSqlQuery query(m_db);
+        QSqlQuery query(connectionUtil());
         QString queryString;
 
         // Prepare query string based on condition
@@ -823,9 +2118,15 @@ QVector<Container *> ContainerMap::getContainersByLeavingTime(const QString &con
         return result;
     }
 
+    if (m_snapshot) {
+        return snapshotContainers(m_snapshot->reader.findByTime(
+            ContainerSnapshotReader::LeavingTime,
+            toComparison(normalizedCondition), referenceTime));
+    }
+
     if (m_useDatabase) {
         // If using a database, query based on leavingTime
-        QSqlQuery query(m_db);
+        QSqlQuery query(connectionUtil());
         QString queryString;
 
         // Prepare query string based on condition
@@ -925,9 +2226,15 @@ qsizetype ContainerMap::countContainersByLeavingTime(const QString &condition,
         return count;
     }
 
+    if (m_snapshot) {
+        return m_snapshot->reader.countByTime(
+            ContainerSnapshotReader::LeavingTime,
+            toComparison(normalizedCondition), referenceTime);
+    }
+
     if (m_useDatabase) {
         // If using a database, query based on leavingTime
-        QSqlQuery query(m_db);
+        QSqlQuery query(connectionUtil());
         QString queryString;
 
         // Prepare query string based on condition
@@ -1022,9 +2329,16 @@ QVector<Container *> ContainerMap::dequeueContainersByLeavingTime(const QString
         return matchingContainers;
     }
 
+    if (rejectSnapshotWrite("dequeueContainersByLeavingTime")) {
+        return matchingContainers;
+    }
+
+    // Report all dequeued containers as a single change
+    beginBatchUtil();
+
     if (m_useDatabase) {
         // Retrieve containers from the database based on leavingTime
-        QSqlQuery query(m_db);
+        QSqlQuery query(connectionUtil());
         QString queryString;
 
         // Prepare query string based on condition
@@ -1099,6 +2413,7 @@ QVector<Container *> ContainerMap::dequeueContainersByLeavingTime(const QString
 
                 if (conditionMet) {
                     matchingContainers.append(container);
+                    notifyContainersChanged(it.key());
                     it = m_containers.erase(it);
                 } else {
                     ++it;
@@ -1109,7 +2424,11 @@ QVector<Container *> ContainerMap::dequeueContainersByLeavingTime(const QString
         }
     }
 
-    emit containersChanged();
+    QStringList changedIDs;
+    if (endBatchUtil(changedIDs)) {
+        emit containersChanged();
+        emit containersBatchChanged(changedIDs);
+    }
     return matchingContainers;
 }
 
@@ -1120,10 +2439,15 @@ QVector<Container *> ContainerMap::
     QMutexLocker locker(&m_mutex); // Ensure thread safety
     QVector<Container*> result;
 
+    if (m_snapshot) {
+        return snapshotContainers(
+            m_snapshot->reader.findByDestination(destination));
+    }
+
     if (m_useDatabase) {
         // If using a database, query for containers with the
         // specified next destination
-        QSqlQuery query(m_db);
+        QSqlQuery query(connectionUtil());
         query.prepare(
             QStringLiteral("SELECT container_id FROM NextDestinations "
                       "WHERE destination = :destination"));
@@ -1163,9 +2487,16 @@ ContainerMap::dequeueContainersByNextDestination(const QString &destination)
     QMutexLocker locker(&m_mutex); // Ensure thread safety
     QVector<Container*> matchingContainers;
 
+    if (rejectSnapshotWrite("dequeueContainersByNextDestination")) {
+        return matchingContainers;
+    }
+
+    // Report all dequeued containers as a single change
+    beginBatchUtil();
+
     if (m_useDatabase) {
         // Retrieve containers from the database
-        QSqlQuery query(m_db);
+        QSqlQuery query(connectionUtil());
         query.prepare(QStringLiteral(
             "SELECT id FROM Containers WHERE id IN ("
             "SELECT container_id FROM NextDestinations WHERE "
@@ -1194,6 +2525,7 @@ ContainerMap::dequeueContainersByNextDestination(const QString &destination)
             if (container->getContainerNextDestinations().
                 contains(destination)) {
                 matchingContainers.append(container);
+                notifyContainersChanged(it.key());
                 it = m_containers.erase(it);
             } else {
                 ++it;
@@ -1201,216 +2533,1079 @@ ContainerMap::dequeueContainersByNextDestination(const QString &destination)
         }
     }
 
-    emit containersChanged();
-    return matchingContainers;
+    QStringList changedIDs;
+    if (endBatchUtil(changedIDs)) {
+        emit containersChanged();
+        emit containersBatchChanged(changedIDs);
+    }
+    return matchingContainers;
+}
+
+qsizetype
+ContainerMap::countContainersByNextDestination(const QString &destination)
+{
+    QMutexLocker locker(&m_mutex); // Ensure thread safety
+    qsizetype count = 0;
+
+    if (m_snapshot) {
+        return m_snapshot->reader.findByDestination(destination).size();
+    }
+
+    if (m_useDatabase) {
+        // Count containers in the database
+        QSqlQuery query(connectionUtil());
+        query.prepare(QStringLiteral(
+            "SELECT COUNT(*) FROM Containers WHERE id IN ("
+            "SELECT container_id FROM NextDestinations WHERE "
+            "destination = :destination)"));
+        query.bindValue(QStringLiteral(":destination"), destination);
+
+        if (query.exec()) {
+            if (query.next()) {
+                count = query.value(0).toInt();
+            }
+        } else {
+            emit databaseErrorOccurred(
+                QStringLiteral("Failed to count containers by next "
+                               "destination."));
+            qDebug() << "Failed to count containers by next destination:"
+                     << query.lastError().text();
+        }
+    } else {
+        // Count containers in the in-memory map
+        for (auto it = m_containers.begin(); it != m_containers.end(); ++it) {
+            Container* container = it.value();
+            if (container && container->getContainerNextDestinations().
+                             contains(destination)) {
+                ++count;
+            }
+        }
+    }
+
+    return count;
+}
+
+QVector<Container *>
+ContainerMap::loadContainersFromJsonStream(QIODevice *device)
+{
+    QVector<Container*> containers;
+
+    if (!device || !device->isReadable()) {
+        qWarning() << "Failed to load containers: device is not readable";
+        return containers;
+    }
+    std::unique_ptr<CompressedBlockReader> decompressor;
+    QIODevice *source = openPlainSource(device, decompressor);
+    if (!source) {
+        return containers;
+    }
+
+    ContainerJsonStreamReader reader(source);
+    QByteArray element;
+    while (reader.readNext(element)) {
+        Container *container =
+            createContainerFromJson(element, reader.elementIndex());
+        if (container) {
+            containers.append(container);
+        }
+    }
+
+    if (reader.hasError()) {
+        qWarning() << "Failed to load containers:" << reader.errorString();
+    }
+    return containers;
+}
+
+QVector<Container *>
+ContainerMap::loadContainersFromJson(const QJsonObject &json)
+{
+    QVector<Container*> containers;
+
+    // Check if the JSON contains a "containers" array
+    if (!json.contains(QStringLiteral("containers")) ||
+        !json[QStringLiteral("containers")].isArray()) {
+        qWarning() << "Failed to load containers: 'containers' key missing "
+                      "or not an array";
+        return containers;
+    }
+
+    QJsonArray containersArray = json[QStringLiteral("containers")].toArray();
+
+    // Iterate over each container in the array
+    for (const QJsonValue &containerValue : containersArray) {
+        if (!containerValue.isObject()) {
+            qWarning() << "Skipping invalid container entry "
+                          "(not a JSON object)";
+            continue;
+        }
+
+        QJsonObject containerObj = containerValue.toObject();
+
+        try {
+            // Create a new Container from the JSON object
+            Container *container = new Container(containerObj, nullptr);
+            containers.append(container);
+        } catch (const std::invalid_argument &e) {
+            qWarning() << "Invalid container data:" << e.what();
+        } catch (const std::exception &e) {
+            qWarning() << "Error creating container:" << e.what();
+        }
+    }
+
+    return containers;
+}
+
+
+void ContainerMap::deepCopy(const ContainerMap &other)
+{
+    m_useDatabase = other.m_useDatabase;
+
+    if (m_useDatabase) {
+        // Initialize QCoreApplication if needed
+        initializeQtCoreIfNeeded();
+
+        // Copy database reference
+        m_db = other.m_db;
+        m_dbThread = other.m_dbThread;
+        // Copy cached containers
+        for (auto &id : other.m_cache.keys()) {
+            Container* originalContainer = other.m_cache.object(id);
+            // The copy constructor copies destinations and history too
+            Container* containerCopy = new Container(*originalContainer);
+            m_cache.insert(id, containerCopy);
+        }
+    } else {
+        for (auto it = other.m_containers.cbegin();
+             it != other.m_containers.cend(); ++it) {
+            Container* originalContainer = it.value();
+            // The copy constructor copies destinations and history too
+            Container* containerCopy = new Container(*originalContainer);
+            m_containers.insert(it.key(), containerCopy);
+        }
+    }
+
+    // A snapshot-backed map shares the file, not the materialized objects
+    if (other.m_snapshot) {
+        openSnapshotUtil(other.m_snapshot->path);
+    }
+}
+
+// Serialization
+QDataStream &operator<<(QDataStream &out, const ContainerMap &containerMap)
+{
+    QMutexLocker locker(&containerMap.m_mutex);
+
+    out << static_cast<qint64>(containerMap.m_containers.size());
+    for (auto it = containerMap.m_containers.cbegin();
+         it != containerMap.m_containers.cend(); ++it) {
+        out << it.key() << *it.value();
+    }
+    return out;
+}
+
+// Deserialization
+QDataStream &operator>>(QDataStream &in, ContainerMap &containerMap)
+{
+    QMutexLocker locker(&containerMap.m_mutex);
+
+    // The count is written as 64 bits; it used to be read back as int
+    qint64 size = 0;
+    in >> size;
+    for (qint64 i = 0; i < size && in.status() == QDataStream::Ok; ++i) {
+        QString id;
+        Container *container = new Container();
+        in >> id >> *container;
+        if (in.status() != QDataStream::Ok) {
+            delete container;
+            break;
+        }
+        containerMap.addContainerUtil(id, container,
+                                      container->getContainerAddedTime(),
+                                      container->getContainerLeavingTime());
+    }
+    return in;
+}
+
+// Convert to QVariant
+QVariant ContainerMap::toVariant() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QVariantMap variantMap;
+    for (auto it = m_containers.cbegin(); it != m_containers.cend(); ++it) {
+        variantMap.insert(it.key(), QVariant::fromValue(*it.value()));
+    }
+    return variantMap;
+}
+
+// Convert from QVariant
+ContainerMap ContainerMap::fromVariant(const QVariant &variant)
+{
+    ContainerMap containerMap;
+    QVariantMap variantMap = variant.toMap();
+    for (auto it = variantMap.cbegin(); it != variantMap.cend(); ++it) {
+        Container *container = new Container();
+        *container = it.value().value<Container>();
+        containerMap.addContainerUtil(it.key(), container);
+    }
+    return containerMap;
+}
+
+// Helper function to open SQLite database
+bool ContainerMap::openDatabase(const QString &dbLocation)
+{
+    QMutexLocker locker(&m_mutex); // Ensure thread safety
+
+    QByteArray byteArray = QByteArray::number(reinterpret_cast<quintptr>(this), 16); // Convert to hex string
+    QByteArray hash = QCryptographicHash::hash(byteArray, QCryptographicHash::Md5); // Use MD5 or SHA-1 for short hash
+    QString connectionName =
+        QStringLiteral("conn_%1").arg(
+        QString::fromLatin1(hash.toHex().constData()).left(8)); // Use only a part of the hash
+    m_db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"),
+                                     connectionName);
+    m_db.setDatabaseName(dbLocation);
+    m_dbThread = QThread::currentThread();
+
+    if (!m_db.open()) {
+        qDebug() << "Database Error: " << m_db.lastError().text();
+        emit databaseErrorOccurred(QStringLiteral("Database Error: ") +
+                                   m_db.lastError().text());
+        QSqlDatabase::removeDatabase(connectionName); // Ensure to remove the connection if it fails
+        return false;
+    }
+
+    // Check if the database file exists. If it doesn't, create it.
+    QFile dbFile(dbLocation);
+    if (!dbFile.exists()) {
+        qDebug() << "Database file does not exist. Creating new database.";
+        // Creating new database and tables
+        createTables();
+    }
+
+    return true;
+}
+
+qsizetype ContainerMap::compactMovementHistory(qsizetype keepLast)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (rejectSnapshotWrite("compactMovementHistory")) {
+        return 0;
+    }
+
+    keepLast = qMax<qsizetype>(keepLast, 0);
+
+    auto trimHistory = [keepLast](Container *container) -> qsizetype {
+        const QVector<QString> &history =
+            container->getContainerMovementHistory();
+        qsizetype dropped = history.size() - keepLast;
+        if (dropped <= 0) {
+            return 0;
+        }
+        container->setContainerMovementHistory(history.mid(dropped));
+        return dropped;
+    };
+
+    if (!m_useDatabase) {
+        qsizetype dropped = 0;
+        for (Container *container : std::as_const(m_containers)) {
+            dropped += trimHistory(container);
+        }
+        return dropped;
+    }
+
+    if (!connectionUtil().transaction()) {
+        qWarning() << "Failed to start transaction for history compaction:"
+                   << connectionUtil().lastError().text();
+        emit databaseErrorOccurred(
+            QStringLiteral("Failed to compact movement history."));
+        return 0;
+    }
+
+    // Rank each container's entries from newest to oldest; everything
+    // past keepLast moves to the archive in its original order
+    const QString rankedHistory = QStringLiteral(
+        "SELECT rowid AS rid, container_id, history, "
+        "ROW_NUMBER() OVER (PARTITION BY container_id "
+        "ORDER BY rowid DESC) AS recency FROM MovementHistory");
+
+    QSqlQuery archiveQuery(connectionUtil());
+    archiveQuery.prepare(
+        QStringLiteral("INSERT INTO MovementHistoryArchive "
+                       "(container_id, history) "
+                       "SELECT container_id, history FROM (%1) "
+                       "WHERE recency > :keep ORDER BY rid").arg(rankedHistory));
+    archiveQuery.bindValue(QStringLiteral(":keep"), keepLast);
+    bool success = archiveQuery.exec();
+    qsizetype archived = success ? archiveQuery.numRowsAffected() : 0;
+
+    if (success) {
+        QSqlQuery deleteQuery(connectionUtil());
+        deleteQuery.prepare(
+            QStringLiteral("DELETE FROM MovementHistory WHERE rowid IN "
+                           "(SELECT rid FROM (%1) WHERE recency > :keep)")
+                .arg(rankedHistory));
+        deleteQuery.bindValue(QStringLiteral(":keep"), keepLast);
+        success = deleteQuery.exec();
+    }
+
+    if (success) {
+        success = connectionUtil().commit();
+    }
+
+    if (success) {
+        // Trim the cached containers only once the archive is stored, so
+        // a later save does not write the compacted entries back
+        for (const QString &id : m_cache.keys()) {
+            if (Container *container = std::as_const(m_cache).object(id)) {
+                trimHistory(container);
+            }
+        }
+        return archived;
+    }
+
+    connectionUtil().rollback();
+    qWarning() << "Failed to compact movement history:"
+             << connectionUtil().lastError().text();
+    emit databaseErrorOccurred(
+        QStringLiteral("Failed to compact movement history."));
+    return 0;
+}
+
+QVector<QString> ContainerMap::getArchivedMovementHistory(
+    const QString &id) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QVector<QString> history;
+    if (!m_useDatabase) {
+        return history;
+    }
+
+    QSqlQuery query(connectionUtil());
+    query.prepare(QStringLiteral("SELECT history FROM MovementHistoryArchive "
+                                 "WHERE container_id = :id ORDER BY rowid"));
+    query.bindValue(QStringLiteral(":id"), id);
+    if (!query.exec()) {
+        emit databaseErrorOccurred(
+            QStringLiteral("Failed to load archived movement history."));
+        return history;
+    }
+    while (query.next()) {
+        history.append(query.value(0).toString());
+    }
+    return history;
+}
+
+bool ContainerMap::saveSnapshot(const QString &path,
+                                Compression::Codec codec) const
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open snapshot file for writing:" << path
+                   << file.errorString();
+        return false;
+    }
+    if (!saveSnapshot(&file, codec)) {
+        file.cancelWriting();
+        return false;
+    }
+    if (!file.commit()) {
+        qWarning() << "Failed to write snapshot file:" << path
+                   << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool ContainerMap::saveSnapshot(QIODevice *device,
+                                Compression::Codec codec) const
+{
+    if (codec != Compression::NoCompression) {
+        return writeMaybeCompressed(device, codec, [this](QIODevice *target) {
+            return saveSnapshot(target, Compression::NoCompression);
+        });
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    if (m_snapshot) {
+        // The mapped file already is a snapshot of the map
+        const qint64 size = m_snapshot->size;
+        if (!device || device->write(reinterpret_cast<const char *>(
+                                         m_snapshot->data), size) != size) {
+            qWarning() << "Failed to write snapshot";
+            return false;
+        }
+        return true;
+    }
+
+    ContainerSnapshotWriter writer;
+    if (!forEachContainerUtil([&writer](const Container &container) {
+            writer.addContainer(container);
+        })) {
+        return false;
+    }
+    return writer.write(device);
+}
+
+bool ContainerMap::saveArrow(const QString &path) const
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open Arrow file for writing:" << path
+                   << file.errorString();
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        ContainerArrowWriter writer;
+        if (!forEachContainerUtil([&writer](const Container &container) {
+                writer.addContainer(container);
+            }) ||
+            !writer.write(&file)) {
+            file.cancelWriting();
+            return false;
+        }
+    }
+
+    if (!file.commit()) {
+        qWarning() << "Failed to write Arrow file:" << path
+                   << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool ContainerMap::loadArrow(const QString &path)
+{
+    ContainerArrowReader reader;
+    if (!reader.open(path)) {
+        return false;
+    }
+    return replaceContents(reader.containerCount(),
+                           [&reader](qsizetype index) {
+                               return reader.createContainer(index);
+                           });
+}
+
+bool ContainerMap::forEachContainerUtil(
+    const std::function<void(const Container &)> &visit) const
+{
+    if (m_snapshot) {
+        const qsizetype count = m_snapshot->reader.containerCount();
+        for (qsizetype i = 0; i < count; ++i) {
+            std::unique_ptr<Container> container(
+                m_snapshot->reader.createContainer(i));
+            visit(*container);
+        }
+        return true;
+    }
+
+    if (!m_useDatabase) {
+        for (const Container *container : m_containers) {
+            if (container) {
+                visit(*container);
+            }
+        }
+        return true;
+    }
+
+    // Stream the containers from the database one at a time
+    QSqlQuery query(connectionUtil());
+    query.setForwardOnly(true);
+    if (!query.exec(QStringLiteral("SELECT id, size, currentLocation, "
+                                   "addedTime, leavingTime FROM Containers"))) {
+        emit databaseErrorOccurred(
+            QStringLiteral("Failed to query containers for export."));
+        return false;
+    }
+    while (query.next()) {
+        const QString id = query.value(0).toString();
+        if (const Container *cached = m_cache.object(id)) {
+            visit(*cached);
+            continue;
+        }
+
+        Container container;
+        container.setContainerID(id);
+        container.setContainerSize(
+            static_cast<Container::ContainerSize>(query.value(1).toInt()));
+        container.setContainerCurrentLocation(query.value(2).toString());
+        container.setContainerAddedTime(
+            query.value(3).isNull() ? std::nan("") : query.value(3).toDouble());
+        container.setContainerLeavingTime(
+            query.value(4).isNull() ? std::nan("") : query.value(4).toDouble());
+        loadAdditionalContainerData(container);
+        visit(container);
+    }
+    return true;
+}
+
+void ContainerMap::markCheckpoint()
+{
+    QMutexLocker locker(&m_mutex);
+    markCheckpointUtil();
+}
+
+void ContainerMap::markCheckpointUtil()
+{
+    m_checkpointRevisions.clear();
+    m_hasCheckpoint = true;
+    if (m_useDatabase || m_snapshot) {
+        return;
+    }
+    m_checkpointRevisions.reserve(m_containers.size());
+    for (auto it = m_containers.cbegin(); it != m_containers.cend(); ++it) {
+        m_checkpointRevisions.insert(it.key(), it.value()->revision());
+    }
+}
+
+bool ContainerMap::hasCheckpoint() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hasCheckpoint;
+}
+
+bool ContainerMap::saveDeltaSnapshot(const QString &path,
+                                     Compression::Codec codec)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open snapshot file for writing:" << path
+                   << file.errorString();
+        return false;
+    }
+    if (!saveDeltaSnapshot(&file, codec)) {
+        file.cancelWriting();
+        return false;
+    }
+    if (!file.commit()) {
+        qWarning() << "Failed to write snapshot file:" << path
+                   << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool ContainerMap::saveDeltaSnapshot(QIODevice *device,
+                                     Compression::Codec codec)
+{
+    if (codec != Compression::NoCompression) {
+        return writeMaybeCompressed(device, codec, [this](QIODevice *target) {
+            return saveDeltaSnapshot(target, Compression::NoCompression);
+        });
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    if (m_useDatabase || m_snapshot) {
+        qWarning() << "Delta snapshots require in-memory storage";
+        return false;
+    }
+    if (!m_hasCheckpoint) {
+        qWarning() << "Cannot write delta snapshot: no checkpoint recorded";
+        return false;
+    }
+
+    ContainerSnapshotWriter writer;
+    writer.setDelta(true);
+
+    // Added containers have no checkpoint revision, modified ones a stale one
+    for (auto it = m_containers.cbegin(); it != m_containers.cend(); ++it) {
+        auto checkpoint = m_checkpointRevisions.constFind(it.key());
+        if (checkpoint == m_checkpointRevisions.cend() ||
+            checkpoint.value() != it.value()->revision()) {
+            writer.addContainer(*it.value());
+        }
+    }
+    for (auto it = m_checkpointRevisions.cbegin();
+         it != m_checkpointRevisions.cend(); ++it) {
+        if (!m_containers.contains(it.key())) {
+            writer.addRemovedContainer(it.key());
+        }
+    }
+
+    if (!writer.write(device)) {
+        return false;
+    }
+    markCheckpointUtil();
+    return true;
+}
+
+bool ContainerMap::applyDeltaSnapshot(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to open snapshot file:" << path
+                   << file.errorString();
+        return false;
+    }
+
+    // Map the file when possible to avoid copying it into memory
+    if (uchar *data = file.map(0, file.size())) {
+        bool applied = applyDeltaSnapshotData(data, file.size());
+        file.unmap(data);
+        return applied;
+    }
+    return applyDeltaSnapshot(&file);
+}
+
+bool ContainerMap::applyDeltaSnapshot(QIODevice *device)
+{
+    if (!device || !device->isReadable()) {
+        qWarning() << "Cannot load snapshot: device is not readable";
+        return false;
+    }
+    const QByteArray data = device->readAll();
+    return applyDeltaSnapshotData(
+        reinterpret_cast<const uchar *>(data.constData()), data.size());
+}
+
+bool ContainerMap::applyDeltaSnapshotData(const uchar *data, qint64 size)
+{
+    QByteArray inflated;
+    if (!inflateIfCompressed(data, size, inflated)) {
+        return false;
+    }
+
+    ContainerSnapshotReader reader;
+    if (!reader.open(data, size)) {
+        return false;
+    }
+    if (!reader.isDelta()) {
+        qWarning() << "Cannot apply snapshot: not a delta snapshot";
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    if (rejectSnapshotWrite("applyDeltaSnapshot")) {
+        return false;
+    }
+
+    if (m_useDatabase && !connectionUtil().transaction()) {
+        qWarning() << "Failed to start transaction for snapshot:"
+                   << connectionUtil().lastError().text();
+        emit databaseErrorOccurred(
+            QStringLiteral("Failed to store snapshot in database."));
+        return false;
+    }
+
+    beginBatchUtil();
+
+    bool stored = true;
+    const QStringList removed = reader.removedContainers();
+    for (qsizetype i = 0; i < removed.size() && stored; ++i) {
+        stored = removeContainer(removed[i]);
+    }
+
+    // addContainerUtil() upserts: the row is replaced in place and the
+    // object it supersedes is released
+    const qsizetype count = reader.containerCount();
+    for (qsizetype i = 0; i < count && stored; ++i) {
+        Container *container = reader.createContainer(i);
+        stored = addContainerUtil(container->getContainerID(), container,
+                                  container->getContainerAddedTime(),
+                                  container->getContainerLeavingTime());
+    }
+    if (m_useDatabase) {
+        if (stored && !connectionUtil().commit()) {
+            qWarning() << "Failed to commit snapshot to database:"
+                       << connectionUtil().lastError().text();
+            stored = false;
+        }
+        if (!stored) {
+            // The cache may hold containers the rollback discards
+            connectionUtil().rollback();
+            m_cache.clear(!m_isRunningThroughPython);
+            emit databaseErrorOccurred(
+                QStringLiteral("Failed to store snapshot in database."));
+        }
+    }
+    if (stored) {
+        markCheckpointUtil();
+    }
+
+    QStringList changedIDs;
+    if (endBatchUtil(changedIDs)) {
+        locker.unlock();
+        emit containersChanged();
+        emit containersBatchChanged(changedIDs);
+    }
+    return stored;
 }
 
-qsizetype
-ContainerMap::countContainersByNextDestination(const QString &destination)
+bool ContainerMap::loadSnapshotChain(const QString &basePath,
+                                     const QStringList &deltaPaths)
 {
-    QMutexLocker locker(&m_mutex); // Ensure thread safety
-    qsizetype count = 0;
-
-    if (m_useDatabase) {
-        // Count containers in the database
-        QSqlQuery query(m_db);
-        query.prepare(QStringLiteral(
-            "SELECT COUNT(*) FROM Containers WHERE id IN ("
-            "SELECT container_id FROM NextDestinations WHERE "
-            "destination = :destination)"));
-        query.bindValue(QStringLiteral(":destination"), destination);
+    // Report the whole replay as a single change
+    ChangeBatch batch(this);
 
-        if (query.exec()) {
-            if (query.next()) {
-                count = query.value(0).toInt();
-            }
-        } else {
-            emit databaseErrorOccurred(
-                QStringLiteral("Failed to count containers by next "
-                               "destination."));
-            qDebug() << "Failed to count containers by next destination:"
-                     << query.lastError().text();
-        }
-    } else {
-        // Count containers in the in-memory map
-        for (auto it = m_containers.begin(); it != m_containers.end(); ++it) {
-            Container* container = it.value();
-            if (container && container->getContainerNextDestinations().
-                             contains(destination)) {
-                ++count;
-            }
+    if (!loadSnapshot(basePath)) {
+        return false;
+    }
+    for (const QString &deltaPath : deltaPaths) {
+        if (!applyDeltaSnapshot(deltaPath)) {
+            qWarning() << "Stopped replaying snapshots at" << deltaPath;
+            return false;
         }
     }
-
-    return count;
+    return true;
 }
 
-QVector<Container *>
-ContainerMap::loadContainersFromJson(const QJsonObject &json)
+bool ContainerMap::compactSnapshotChain(const QString &basePath,
+                                        const QStringList &deltaPaths,
+                                        const QString &outputPath)
 {
-    QVector<Container*> containers;
+    ContainerMap map;
+    if (!map.loadSnapshotChain(basePath, deltaPaths)) {
+        return false;
+    }
+    return map.saveSnapshot(outputPath);
+}
 
-    // Check if the JSON contains a "containers" array
-    if (!json.contains(QStringLiteral("containers")) ||
-        !json[QStringLiteral("containers")].isArray()) {
-        qWarning() << "Failed to load containers: 'containers' key missing "
-                      "or not an array";
-        return containers;
+bool ContainerMap::loadSnapshot(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to open snapshot file:" << path
+                   << file.errorString();
+        return false;
     }
 
-    QJsonArray containersArray = json[QStringLiteral("containers")].toArray();
+    // Map the file when possible to avoid copying it into memory
+    if (uchar *data = file.map(0, file.size())) {
+        bool loaded = loadSnapshotData(data, file.size());
+        file.unmap(data);
+        return loaded;
+    }
+    return loadSnapshot(&file);
+}
 
-    // Iterate over each container in the array
-    for (const QJsonValue &containerValue : containersArray) {
-        if (!containerValue.isObject()) {
-            qWarning() << "Skipping invalid container entry "
-                          "(not a JSON object)";
-            continue;
-        }
+bool ContainerMap::loadSnapshot(QIODevice *device)
+{
+    if (!device || !device->isReadable()) {
+        qWarning() << "Cannot load snapshot: device is not readable";
+        return false;
+    }
+    const QByteArray data = device->readAll();
+    return loadSnapshotData(reinterpret_cast<const uchar *>(data.constData()),
+                            data.size());
+}
 
-        QJsonObject containerObj = containerValue.toObject();
+bool ContainerMap::openSnapshot(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
 
-        try {
-            // Create a new Container from the JSON object
-            Container *container = new Container(containerObj, nullptr);
-            containers.append(container);
-        } catch (const std::invalid_argument &e) {
-            qWarning() << "Invalid container data:" << e.what();
-        } catch (const std::exception &e) {
-            qWarning() << "Error creating container:" << e.what();
-        }
+    if (!openSnapshotUtil(path)) {
+        return false;
     }
-
-    return containers;
+    notifyContainersChanged(QStringList());
+    return true;
 }
 
-
-void ContainerMap::deepCopy(const ContainerMap &other)
+bool ContainerMap::openSnapshotUtil(const QString &path)
 {
-    m_useDatabase = other.m_useDatabase;
+    auto backend = std::make_unique<SnapshotBackend>();
+    backend->path = path;
+    backend->file.setFileName(path);
+    if (!backend->file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to open snapshot file:" << path
+                   << backend->file.errorString();
+        return false;
+    }
+    backend->mapped = backend->file.map(0, backend->file.size());
+    if (!backend->mapped) {
+        qWarning() << "Failed to map snapshot file:" << path
+                   << backend->file.errorString();
+        return false;
+    }
+    backend->data = backend->mapped;
+    backend->size = backend->file.size();
 
-    if (m_useDatabase) {
-        // Initialize QCoreApplication if needed
-        initializeQtCoreIfNeeded();
+    // Compressed snapshots are served from their inflated copy instead
+    if (!inflateIfCompressed(backend->data, backend->size,
+                             backend->inflated)) {
+        return false;
+    }
+    if (!backend->inflated.isEmpty()) {
+        backend->file.unmap(backend->mapped);
+        backend->mapped = nullptr;
+    }
 
-        // Copy database reference
-        m_db = other.m_db;
-        // Copy cached containers
-        for (auto &id : other.m_cache.keys()) {
-            Container* originalContainer = other.m_cache.object(id);
-            Container* containerCopy = new Container(*originalContainer);
+    if (!backend->reader.open(backend->data, backend->size)) {
+        return false;
+    }
+    if (backend->reader.isDelta()) {
+        qWarning() << "Cannot open snapshot: delta snapshots must be "
+                      "applied on top of a full snapshot";
+        return false;
+    }
+
+    // Release the current contents; the database itself is kept
+    clearUtil(false, false);
+    m_snapshot = std::move(backend);
+    return true;
+}
 
-            // Ensure to copy next destinations and movement history
-            containerCopy->setContainerNextDestinations(
-                originalContainer->getContainerNextDestinations());
-            containerCopy->setContainerMovementHistory(
-                originalContainer->getContainerMovementHistory());
+void ContainerMap::closeSnapshot()
+{
+    QMutexLocker locker(&m_mutex);
 
+    if (!m_snapshot) {
+        return;
+    }
+    closeSnapshotUtil();
+    notifyContainersChanged(QStringList());
+}
 
-            m_cache.insert(id, containerCopy);
-        }
-    } else {
-        for (auto it = other.m_containers.cbegin();
-             it != other.m_containers.cend(); ++it) {
-            Container* originalContainer = it.value();
-            Container* containerCopy = new Container(*originalContainer);
+void ContainerMap::closeSnapshotUtil()
+{
+    if (!m_snapshot) {
+        return;
+    }
+    if (!m_isRunningThroughPython) {  // Python handles the pointers not us
+        qDeleteAll(m_snapshot->materialized);
+    }
+    if (m_snapshot->mapped) {
+        m_snapshot->file.unmap(m_snapshot->mapped);
+    }
+    m_snapshot.reset();
+}
 
-            // Ensure to copy next destinations and movement history
-            containerCopy->setContainerNextDestinations(
-                originalContainer->getContainerNextDestinations());
-            containerCopy->setContainerMovementHistory(
-                originalContainer->getContainerMovementHistory());
+bool ContainerMap::isSnapshotBacked() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_snapshot != nullptr;
+}
 
-            m_containers.insert(it.key(), containerCopy);
+Container *ContainerMap::snapshotContainer(qsizetype index)
+{
+    Container *&container = m_snapshot->materialized[index];
+    if (!container) {
+        container = m_snapshot->reader.createContainer(index);
+        if (container) {
+            adoptContainerUtil(container);
         }
     }
+    return container;
 }
 
-// Serialization
-QDataStream &operator<<(QDataStream &out, const ContainerMap &containerMap)
+QSqlDatabase ContainerMap::connectionUtil() const
 {
-    QMutexLocker locker(&containerMap.m_mutex);
+    QThread *current = QThread::currentThread();
+    const QString databaseName = m_db.databaseName();
+    if (current == m_dbThread || databaseName.isEmpty() ||
+        databaseName == QStringLiteral(":memory:")) {
+        return m_db;
+    }
 
-    out << containerMap.m_containers.size();
-    for (auto it = containerMap.m_containers.cbegin();
-         it != containerMap.m_containers.cend(); ++it) {
-        out << it.key() << *it.value();
+    if (!m_threadConnections) {
+        m_threadConnections = std::make_shared<ThreadConnections>();
     }
-    return out;
+    std::shared_ptr<ThreadConnections> connections = m_threadConnections;
+    QMutexLocker locker(&connections->mutex);
+    auto it = connections->connections.constFind(current);
+    if (it != connections->connections.cend()) {
+        return *it;
+    }
+
+    // Unique per clone: a later map may reuse this map's address, and so
+    // its connection name, while this clone's thread is still running
+    static std::atomic<quint64> cloneSerial{0};
+    const QString cloneName =
+        QStringLiteral("%1_%2_%3").arg(m_db.connectionName())
+            .arg(reinterpret_cast<quintptr>(current), 0, 16)
+            .arg(cloneSerial.fetch_add(1, std::memory_order_relaxed));
+    QSqlDatabase clone = QSqlDatabase::cloneDatabase(m_db, cloneName);
+    if (!clone.open()) {
+        qWarning() << "Failed to open database connection for worker thread:"
+                   << clone.lastError().text();
+        clone = QSqlDatabase();
+        QSqlDatabase::removeDatabase(cloneName);
+        return m_db;
+    }
+    connections->connections.insert(current, clone);
+
+    // Pool threads come and go; the finishing thread closes its own
+    // clone. The handler holds the shared state rather than the map, so
+    // it still runs when the map was destroyed first.
+    connect(current, &QThread::finished, current, [connections, current]() {
+        QMutexLocker locker(&connections->mutex);
+        QSqlDatabase finished = connections->connections.take(current);
+        const QString name = finished.connectionName();
+        finished.close();
+        finished = QSqlDatabase();
+        if (!name.isEmpty()) {
+            QSqlDatabase::removeDatabase(name);
+        }
+    }, Qt::DirectConnection);
+    return clone;
 }
 
-// Deserialization
-QDataStream &operator>>(QDataStream &in, ContainerMap &containerMap)
+void ContainerMap::adoptContainerUtil(Container *container) const
 {
-    QMutexLocker locker(&containerMap.m_mutex);
+    // Only the owning thread may move an object
+    if (container->thread() == QThread::currentThread() &&
+        container->thread() != thread()) {
+        container->moveToThread(thread());
+    }
+}
 
-    int size;
-    in >> size;
-    for (int i = 0; i < size; ++i) {
-        QString id;
-        Container *container = new Container();
-        in >> id >> *container;
-        containerMap.addContainerUtil(id, container);
+QVector<Container *>
+ContainerMap::snapshotContainers(const QVector<qsizetype> &indexes)
+{
+    QVector<Container *> result;
+    result.reserve(indexes.size());
+    for (qsizetype index : indexes) {
+        result.append(snapshotContainer(index));
     }
-    return in;
+    return result;
 }
 
-// Convert to QVariant
-QVariant ContainerMap::toVariant() const
+bool ContainerMap::rejectSnapshotWrite(const char *operation) const
+{
+    if (!m_snapshot) {
+        return false;
+    }
+    qWarning() << operation << "is not supported while the map is served "
+                               "from a read-only snapshot";
+    return true;
+}
+
+bool ContainerMap::addContainersBulk(const QVector<Container *> &containers,
+                                     double addingTime, double leavingTime,
+                                     bool keepContainerTimes)
 {
+    if (containers.isEmpty()) {
+        return true;
+    }
+
     QMutexLocker locker(&m_mutex);
 
-    QVariantMap variantMap;
-    for (auto it = m_containers.cbegin(); it != m_containers.cend(); ++it) {
-        variantMap.insert(it.key(), QVariant::fromValue(*it.value()));
+    if (m_useDatabase && !connectionUtil().transaction()) {
+        qWarning() << "Failed to start transaction for containers:"
+                   << connectionUtil().lastError().text();
+        emit databaseErrorOccurred(
+            QStringLiteral("Failed to store containers in database."));
+        // The containers were built for this merge and never reached it
+        qDeleteAll(containers);
+        return false;
     }
-    return variantMap;
+
+    beginBatchUtil();
+
+    bool stored = true;
+    qsizetype added = 0;
+    for (; added < containers.size() && stored; ++added) {
+        Container *container = containers[added];
+        if (keepContainerTimes) {
+            addingTime = container->getContainerAddedTime();
+            leavingTime = container->getContainerLeavingTime();
+        }
+        stored = addContainerUtil(container->getContainerID(), container,
+                                  addingTime, leavingTime);
+    }
+    if (m_useDatabase) {
+        if (stored && !connectionUtil().commit()) {
+            qWarning() << "Failed to commit containers to database:"
+                       << connectionUtil().lastError().text();
+            stored = false;
+        }
+        if (!stored) {
+            // The cache may hold containers the rollback discards
+            connectionUtil().rollback();
+            m_cache.clear(!m_isRunningThroughPython);
+            emit databaseErrorOccurred(
+                QStringLiteral("Failed to store containers in database."));
+        }
+    }
+    if (!stored) {
+        qDeleteAll(containers.cbegin() + added, containers.cend());
+    }
+
+    QStringList changedIDs;
+    if (endBatchUtil(changedIDs)) {
+        locker.unlock();
+        emit containersChanged();
+        emit containersBatchChanged(changedIDs);
+    }
+    return stored;
 }
 
-// Convert from QVariant
-ContainerMap ContainerMap::fromVariant(const QVariant &variant)
+bool ContainerMap::loadSnapshotData(const uchar *data, qint64 size)
 {
-    ContainerMap containerMap;
-    QVariantMap variantMap = variant.toMap();
-    for (auto it = variantMap.cbegin(); it != variantMap.cend(); ++it) {
-        Container *container = new Container();
-        *container = it.value().value<Container>();
-        containerMap.addContainerUtil(it.key(), container);
+    QByteArray inflated;
+    if (!inflateIfCompressed(data, size, inflated)) {
+        return false;
     }
-    return containerMap;
+
+    ContainerSnapshotReader reader;
+    if (!reader.open(data, size)) {
+        return false;
+    }
+    if (reader.isDelta()) {
+        qWarning() << "Cannot load snapshot: delta snapshots must be "
+                      "applied on top of a full snapshot";
+        return false;
+    }
+
+    return replaceContents(reader.containerCount(),
+                           [&reader](qsizetype index) {
+                               return reader.createContainer(index);
+                           });
 }
 
-// Helper function to open SQLite database
-bool ContainerMap::openDatabase(const QString &dbLocation)
+bool ContainerMap::replaceContents(
+    qsizetype count, const std::function<Container *(qsizetype)> &create)
 {
-    QMutexLocker locker(&m_mutex); // Ensure thread safety
-
-    QByteArray byteArray = QByteArray::number(reinterpret_cast<quintptr>(this), 16); // Convert to hex string
-    QByteArray hash = QCryptographicHash::hash(byteArray, QCryptographicHash::Md5); // Use MD5 or SHA-1 for short hash
-    QString connectionName =
-        QStringLiteral("conn_%1").arg(
-        QString::fromLatin1(hash.toHex().constData()).left(8)); // Use only a part of the hash
-    m_db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"),
-                                     connectionName);
-    m_db.setDatabaseName(dbLocation);
+    QMutexLocker locker(&m_mutex);
 
-    if (!m_db.open()) {
-        qDebug() << "Database Error: " << m_db.lastError().text();
-        emit databaseErrorOccurred(QStringLiteral("Database Error: ") +
-                                   m_db.lastError().text());
-        QSqlDatabase::removeDatabase(connectionName); // Ensure to remove the connection if it fails
+    if (m_useDatabase && !connectionUtil().transaction()) {
+        qWarning() << "Failed to start transaction for loaded containers:"
+                   << connectionUtil().lastError().text();
+        emit databaseErrorOccurred(
+            QStringLiteral("Failed to store loaded containers in database."));
         return false;
     }
 
-    // Check if the database file exists. If it doesn't, create it.
-    QFile dbFile(dbLocation);
-    if (!dbFile.exists()) {
-        qDebug() << "Database file does not exist. Creating new database.";
-        // Creating new database and tables
-        createTables();
+    beginBatchUtil();
+    clearUtil(true, true);
+
+    bool stored = true;
+    for (qsizetype i = 0; i < count && stored; ++i) {
+        Container *container = create(i);
+        stored = addContainerUtil(container->getContainerID(), container,
+                                  container->getContainerAddedTime(),
+                                  container->getContainerLeavingTime());
+    }
+    if (m_useDatabase) {
+        if (stored && !connectionUtil().commit()) {
+            qWarning() << "Failed to commit loaded containers to database:"
+                       << connectionUtil().lastError().text();
+            stored = false;
+        }
+        if (!stored) {
+            // Restore the previous rows; the cache only held the new ones
+            connectionUtil().rollback();
+            m_cache.clear(!m_isRunningThroughPython);
+            emit databaseErrorOccurred(QStringLiteral(
+                "Failed to store loaded containers in database."));
+        }
+    }
+    if (stored) {
+        markCheckpointUtil();
     }
 
-    return true;
+    QStringList changedIDs;
+    if (endBatchUtil(changedIDs)) {
+        locker.unlock();
+        emit containersChanged();
+        emit containersBatchChanged(changedIDs);
+    }
+    return stored;
 }
 
 // Helper function to create necessary tables in SQLite
@@ -1418,7 +3613,7 @@ void ContainerMap::createTables()
 {
     QMutexLocker locker(&m_mutex); // Ensure thread safety
 
-    QSqlQuery query(m_db);
+    QSqlQuery query(connectionUtil());
     query.exec(QStringLiteral(
         "CREATE TABLE IF NOT EXISTS Containers ("
         "id TEXT PRIMARY KEY, "
@@ -1439,6 +3634,16 @@ void ContainerMap::createTables()
         "history TEXT, "
         "FOREIGN KEY(container_id) REFERENCES Containers(id));"));
 
+    query.exec(QStringLiteral(
+        "CREATE TABLE IF NOT EXISTS MovementHistoryArchive ("
+        "container_id TEXT, "
+        "history TEXT, "
+        "FOREIGN KEY(container_id) REFERENCES Containers(id));"));
+
+    query.exec(QStringLiteral(
+        "CREATE INDEX IF NOT EXISTS idx_history_archive_container "
+        "ON MovementHistoryArchive(container_id);"));
+
     query.exec(QStringLiteral(
         "CREATE TABLE IF NOT EXISTS Packages ("
         "id TEXT PRIMARY KEY, "
@@ -1458,7 +3663,7 @@ void ContainerMap::createTables()
 // Helper function to load container from database
 void ContainerMap::loadContainerFromDB(const QString &id)
 {
-    QSqlQuery query(m_db);
+    QSqlQuery query(connectionUtil());
     query.prepare(QStringLiteral(
         "SELECT size, currentLocation, addedTime, leavingTime FROM Containers "
         "WHERE id = :id"));
@@ -1488,18 +3693,15 @@ void ContainerMap::loadContainerFromDB(const QString &id)
         bool loadSuccessful = true;
 
         // Load packages
-        QSqlQuery packageQuery(m_db);
+        QSqlQuery packageQuery(connectionUtil());
         packageQuery.prepare(QStringLiteral("SELECT id FROM Packages "
                                             "WHERE container_id = :id"));
         packageQuery.bindValue(QStringLiteral(":id"), id);
         if (packageQuery.exec()) {
-            QVector<Package*> packages;
             while (packageQuery.next()) {
-                Package* package = new Package();
-                package->setPackageID(packageQuery.value(0).toString());
-                packages.append(package);
+                container->addPackage(
+                    PackageData{packageQuery.value(0).toString()});
             }
-            container->setPackages(packages);
         } else {
             loadSuccessful = false;
             qDebug() << "Failed to load packages for container:"
@@ -1507,7 +3709,7 @@ void ContainerMap::loadContainerFromDB(const QString &id)
         }
 
         // Load custom variables
-        QSqlQuery customVarQuery(m_db);
+        QSqlQuery customVarQuery(connectionUtil());
         customVarQuery.prepare(QStringLiteral("SELECT hauler_type, key, "
                                               "value FROM CustomVariables "
                                               "WHERE container_id = :id"));
@@ -1530,7 +3732,7 @@ void ContainerMap::loadContainerFromDB(const QString &id)
         }
 
         // Load next destinations
-        QSqlQuery nextDestQuery(m_db);
+        QSqlQuery nextDestQuery(connectionUtil());
         nextDestQuery.prepare(QStringLiteral("SELECT destination FROM "
                                              "NextDestinations WHERE "
                                              "container_id = :id"));
@@ -1540,7 +3742,7 @@ void ContainerMap::loadContainerFromDB(const QString &id)
             while (nextDestQuery.next()) {
                 destinations.append(nextDestQuery.value(0).toString());
             }
-            container->setContainerNextDestinations(destinations);
+            container->setContainerNextDestinations(std::move(destinations));
         } else {
             loadSuccessful = false;
             qDebug() << "Failed to load next destinations for container:"
@@ -1548,7 +3750,7 @@ void ContainerMap::loadContainerFromDB(const QString &id)
         }
 
         // Load movement history
-        QSqlQuery historyQuery(m_db);
+        QSqlQuery historyQuery(connectionUtil());
         historyQuery.prepare(QStringLiteral("SELECT history FROM "
                                             "MovementHistory WHERE "
                                             "container_id = :id"));
@@ -1558,7 +3760,7 @@ void ContainerMap::loadContainerFromDB(const QString &id)
             while (historyQuery.next()) {
                 histories.append(historyQuery.value(0).toString());
             }
-            container->setContainerMovementHistory(histories);
+            container->setContainerMovementHistory(std::move(histories));
         } else {
             loadSuccessful = false;
             qDebug() << "Failed to load movement history for container:"
@@ -1567,6 +3769,7 @@ void ContainerMap::loadContainerFromDB(const QString &id)
 
         if (loadSuccessful) {
             // Proceed to insert container if all sub-loads are successful
+            adoptContainerUtil(container);
             m_cache.insert(id, container);
         } else {
             emit databaseErrorOccurred(QStringLiteral("Failed to load complete "
@@ -1585,11 +3788,11 @@ void ContainerMap::loadContainerFromDB(const QString &id)
 
 
 // Helper function to save container to database
-void ContainerMap::saveContainerToDB(const Container &container)
+bool ContainerMap::saveContainerToDB(const Container &container)
 {
     QSqlDatabase::database().transaction(); // Start transaction
 
-    QSqlQuery query(m_db);
+    QSqlQuery query(connectionUtil());
     query.prepare(
         QStringLiteral("REPLACE INTO Containers (id, size, currentLocation, "
                        "addedTime, leavingTime) "
@@ -1617,14 +3820,30 @@ void ContainerMap::saveContainerToDB(const Container &container)
 
     bool allSuccessful = query.exec();
 
+    // Remove packages and custom variables the container no longer has;
+    // REPLACE alone would leave them behind
+    QSqlQuery deletePackagesQuery(connectionUtil());
+    deletePackagesQuery.prepare(
+        QStringLiteral("DELETE FROM Packages WHERE container_id = :id"));
+    deletePackagesQuery.bindValue(QStringLiteral(":id"),
+                                  container.getContainerID());
+    allSuccessful = allSuccessful && deletePackagesQuery.exec();
+
+    QSqlQuery deleteCustomVarsQuery(connectionUtil());
+    deleteCustomVarsQuery.prepare(
+        QStringLiteral("DELETE FROM CustomVariables WHERE container_id = :id"));
+    deleteCustomVarsQuery.bindValue(QStringLiteral(":id"),
+                                    container.getContainerID());
+    allSuccessful = allSuccessful && deleteCustomVarsQuery.exec();
+
     // Save packages
-    for (auto package : container.getPackages()) {
+    for (const PackageData &package : container.packagesView()) {
         if (!allSuccessful) break; // Stop if there's already a failure
-        QSqlQuery packageQuery(m_db);
+        QSqlQuery packageQuery(connectionUtil());
         packageQuery.prepare(
             QStringLiteral("REPLACE INTO Packages (id, container_id) "
                            "VALUES (:id, :container_id)"));
-        packageQuery.bindValue(QStringLiteral(":id"), package->packageID());
+        packageQuery.bindValue(QStringLiteral(":id"), package.packageID);
         packageQuery.bindValue(QStringLiteral(":container_id"),
                                container.getContainerID());
 
@@ -1632,30 +3851,29 @@ void ContainerMap::saveContainerToDB(const Container &container)
     }
 
     // Save custom variables
-    for (auto it = container.getCustomVariables().constBegin();
-         it != container.getCustomVariables().constEnd(); ++it) {
-        for (auto varIt = it.value().constBegin();
-             varIt != it.value().constEnd(); ++varIt) {
-            QSqlQuery customVarQuery(m_db);
-            customVarQuery.prepare(
-                QStringLiteral("REPLACE INTO CustomVariables "
-                               "(hauler_type, container_id, key, value) "
-                               "VALUES (:hauler_type, "
-                               ":container_id, :key, :value)"));
+    QSqlQuery customVarQuery(connectionUtil());
+    customVarQuery.prepare(
+        QStringLiteral("REPLACE INTO CustomVariables "
+                       "(hauler_type, container_id, key, value) "
+                       "VALUES (:hauler_type, "
+                       ":container_id, :key, :value)"));
+    container.forEachCustomVariable(
+        [&](Container::HaulerType hauler, const QString &key,
+            const QVariant &value) {
+            if (!allSuccessful) return;
             customVarQuery.bindValue(QStringLiteral(":hauler_type"),
-                                     static_cast<int>(it.key()));
+                                     static_cast<int>(hauler));
             customVarQuery.bindValue(QStringLiteral(":container_id"),
                                      container.getContainerID());
-            customVarQuery.bindValue(QStringLiteral(":key"), varIt.key());
-            customVarQuery.bindValue(QStringLiteral(":value"), varIt.value());
+            customVarQuery.bindValue(QStringLiteral(":key"), key);
+            customVarQuery.bindValue(QStringLiteral(":value"), value);
 
             allSuccessful = allSuccessful && customVarQuery.exec();
-        }
-    }
+        });
 
     // Save next destinations
     // First, remove existing destinations to avoid duplicates
-    QSqlQuery deleteDestinationsQuery(m_db);
+    QSqlQuery deleteDestinationsQuery(connectionUtil());
     deleteDestinationsQuery.prepare(
         QStringLiteral("DELETE FROM NextDestinations "
                        "WHERE container_id = :id"));
@@ -1667,7 +3885,7 @@ void ContainerMap::saveContainerToDB(const Container &container)
 
     for (const auto &destination : container.getContainerNextDestinations()) {
         if (!allSuccessful) break;
-        QSqlQuery nextDestQuery(m_db);
+        QSqlQuery nextDestQuery(connectionUtil());
         nextDestQuery.prepare(QStringLiteral("INSERT INTO NextDestinations "
                                              "(container_id, destination) "
                                              "VALUES (:id, :destination)"));
@@ -1679,7 +3897,7 @@ void ContainerMap::saveContainerToDB(const Container &container)
 
     // Save movement history
     // First, remove existing history to avoid duplicates
-    QSqlQuery deleteHistoryQuery(m_db);
+    QSqlQuery deleteHistoryQuery(connectionUtil());
     deleteHistoryQuery.prepare(
         QStringLiteral("DELETE FROM MovementHistory WHERE "
                                "container_id = :id"));
@@ -1690,7 +3908,7 @@ void ContainerMap::saveContainerToDB(const Container &container)
 
     for (const auto &history : container.getContainerMovementHistory()) {
         if (!allSuccessful) break;
-        QSqlQuery historyQuery(m_db);
+        QSqlQuery historyQuery(connectionUtil());
         historyQuery.prepare(QStringLiteral("INSERT INTO MovementHistory "
                                             "(container_id, history) "
                                             "VALUES (:id, :history)"));
@@ -1709,73 +3927,95 @@ void ContainerMap::saveContainerToDB(const Container &container)
             QStringLiteral("Failed to save container "
                            "and related data to database."));
     }
+    return allSuccessful;
 }
 
 // Helper function to remove container from database
-void ContainerMap::removeContainerFromDB(const QString &id)
+bool ContainerMap::removeContainerFromDB(const QString &id)
 {
-    QSqlQuery query(m_db);
+    bool removed = true;
+
+    QSqlQuery query(connectionUtil());
     query.prepare(QStringLiteral("DELETE FROM Containers WHERE id = :id"));
     query.bindValue(QStringLiteral(":id"), id);
 
     if (!query.exec()) {
+        removed = false;
         emit databaseErrorOccurred(
             QStringLiteral("Failed to remove container from database."));
     }
 
-    QSqlQuery packageQuery(m_db);
+    QSqlQuery packageQuery(connectionUtil());
     packageQuery.prepare(QStringLiteral("DELETE FROM Packages WHERE "
                                         "container_id = :id"));
     packageQuery.bindValue(QStringLiteral(":id"), id);
 
     if (!packageQuery.exec()) {
+        removed = false;
         emit databaseErrorOccurred(
             QStringLiteral("Failed to remove packages from database."));
     }
 
-    QSqlQuery customVarQuery(m_db);
+    QSqlQuery customVarQuery(connectionUtil());
     customVarQuery.prepare(QStringLiteral("DELETE FROM CustomVariables "
                                           "WHERE container_id = :id"));
     customVarQuery.bindValue(QStringLiteral(":id"), id);
 
     if (!customVarQuery.exec()) {
+        removed = false;
         emit databaseErrorOccurred(QStringLiteral("Failed to remove custom "
                                                   "variables from database."));
     }
 
     // Remove next destinations associated with the container
-    QSqlQuery nextDestQuery(m_db);
+    QSqlQuery nextDestQuery(connectionUtil());
     nextDestQuery.prepare(QStringLiteral("DELETE FROM NextDestinations WHERE "
                                          "container_id = :id"));
     nextDestQuery.bindValue(QStringLiteral(":id"), id);
 
     if (!nextDestQuery.exec()) {
+        removed = false;
         emit databaseErrorOccurred(
             QStringLiteral("Failed to remove next destinations "
                            "from database."));
     }
 
     // Remove movement history associated with the container
-    QSqlQuery historyQuery(m_db);
+    QSqlQuery historyQuery(connectionUtil());
     historyQuery.prepare(QStringLiteral("DELETE FROM MovementHistory WHERE "
                          "container_id = :id"));
     historyQuery.bindValue(QStringLiteral(":id"), id);
 
     if (!historyQuery.exec()) {
+        removed = false;
         emit databaseErrorOccurred(QStringLiteral("Failed to remove movement "
                                                  "history from database."));
     }
+
+    QSqlQuery archiveQuery(connectionUtil());
+    archiveQuery.prepare(QStringLiteral("DELETE FROM MovementHistoryArchive "
+                                        "WHERE container_id = :id"));
+    archiveQuery.bindValue(QStringLiteral(":id"), id);
+
+    if (!archiveQuery.exec()) {
+        removed = false;
+        emit databaseErrorOccurred(QStringLiteral("Failed to remove archived "
+                                                 "movement history from "
+                                                 "database."));
+    }
+    return removed;
 }
 
 // Helper function to clear the database
 void ContainerMap::clearDatabase()
 {
-    QSqlQuery query(m_db);
+    QSqlQuery query(connectionUtil());
     query.exec(QStringLiteral("DELETE FROM Containers"));
     query.exec(QStringLiteral("DELETE FROM Packages"));
     query.exec(QStringLiteral("DELETE FROM CustomVariables"));
     query.exec(QStringLiteral("DELETE FROM NextDestinations"));
     query.exec(QStringLiteral("DELETE FROM MovementHistory"));
+    query.exec(QStringLiteral("DELETE FROM MovementHistoryArchive"));
 }
 
 }
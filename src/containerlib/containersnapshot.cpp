@@ -0,0 +1,818 @@
+#include "containerLib/containersnapshot.h"
+#include <QDataStream>
+#include <QDebug>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace ContainerCore {
+
+namespace {
+
+/** Section alignment inside the file */
+constexpr qint64 SectionAlignment = 8;
+
+qint64 alignedSize(qint64 size)
+{
+    return (size + SectionAlignment - 1) & ~(SectionAlignment - 1);
+}
+
+quint64 doubleBits(double value)
+{
+    return std::bit_cast<quint64>(value);
+}
+
+double bitsToDouble(quint64 bits)
+{
+    return std::bit_cast<double>(bits);
+}
+
+template <typename T>
+QByteArray rawBytes(const QVector<T> &values)
+{
+    return QByteArray(reinterpret_cast<const char *>(values.constData()),
+                      values.size() * qsizetype(sizeof(T)));
+}
+
+} // namespace
+
+ContainerSnapshotWriter::ContainerSnapshotWriter() = default;
+
+quint32 ContainerSnapshotWriter::intern(const QString &value)
+{
+    auto it = m_stringIndexes.constFind(value);
+    if (it != m_stringIndexes.constEnd()) {
+        return it.value();
+    }
+    quint32 index = static_cast<quint32>(m_strings.size());
+    m_strings.append(value);
+    m_stringIndexes.insert(value, index);
+    return index;
+}
+
+void ContainerSnapshotWriter::addContainer(const Container &container)
+{
+    Snapshot::ContainerRecord record{};
+    record.id = intern(container.getContainerID());
+    record.currentLocation = intern(container.getContainerCurrentLocation());
+    record.addedTime = doubleBits(container.getContainerAddedTime());
+    record.leavingTime = doubleBits(container.getContainerLeavingTime());
+    record.size = static_cast<qint32>(container.getContainerSize());
+
+    record.destinationsBegin = static_cast<quint32>(m_destinations.size());
+    for (const QString &destination :
+         container.getContainerNextDestinations()) {
+        m_destinations.append(quint32_le(intern(destination)));
+    }
+    record.destinationsCount =
+        static_cast<quint32>(m_destinations.size()) - record.destinationsBegin;
+
+    record.historyBegin = static_cast<quint32>(m_history.size());
+    for (const QString &location : container.getContainerMovementHistory()) {
+        m_history.append(quint32_le(intern(location)));
+    }
+    record.historyCount =
+        static_cast<quint32>(m_history.size()) - record.historyBegin;
+
+    record.packagesBegin = static_cast<quint32>(m_packages.size());
+    for (const PackageData &package : container.packagesView()) {
+        m_packages.append(quint32_le(intern(package.packageID)));
+    }
+    record.packagesCount =
+        static_cast<quint32>(m_packages.size()) - record.packagesBegin;
+
+    record.customBegin = static_cast<quint32>(m_customVariables.size());
+    container.forEachCustomVariable(
+        [this](Container::HaulerType hauler, const QString &key,
+               const QVariant &value) {
+            Snapshot::CustomVariableRecord variable{};
+            variable.hauler = static_cast<quint32>(hauler);
+            variable.key = intern(key);
+
+            switch (value.typeId()) {
+            case QMetaType::UnknownType:
+                variable.type = Snapshot::NullValue;
+                break;
+            case QMetaType::Bool:
+                variable.type = Snapshot::BoolValue;
+                variable.payload = value.toBool() ? 1 : 0;
+                break;
+            case QMetaType::Int:
+            case QMetaType::UInt:
+            case QMetaType::LongLong:
+            case QMetaType::Short:
+            case QMetaType::UShort:
+                variable.type = Snapshot::IntValue;
+                variable.payload = static_cast<quint64>(value.toLongLong());
+                break;
+            case QMetaType::Double:
+            case QMetaType::Float:
+                variable.type = Snapshot::DoubleValue;
+                variable.payload = doubleBits(value.toDouble());
+                break;
+            case QMetaType::QString:
+                variable.type = Snapshot::StringValue;
+                variable.payload = intern(value.toString());
+                break;
+            default: {
+                // Anything else keeps its exact type through QDataStream
+                QByteArray encoded;
+                QDataStream stream(&encoded, QIODevice::WriteOnly);
+                stream << value;
+                variable.type = Snapshot::VariantValue;
+                variable.payload = static_cast<quint64>(m_variantData.size());
+                variable.aux = static_cast<quint32>(encoded.size());
+                m_variantData.append(encoded);
+                break;
+            }
+            }
+            m_customVariables.append(variable);
+        });
+    record.customCount =
+        static_cast<quint32>(m_customVariables.size()) - record.customBegin;
+
+    m_records.append(record);
+}
+
+qsizetype ContainerSnapshotWriter::containerCount() const
+{
+    return m_records.size();
+}
+
+void ContainerSnapshotWriter::setDelta(bool delta)
+{
+    m_delta = delta;
+}
+
+void ContainerSnapshotWriter::addRemovedContainer(const QString &id)
+{
+    m_removed.append(quint32_le(intern(id)));
+}
+
+bool ContainerSnapshotWriter::write(QIODevice *device)
+{
+    if (!device || !device->isWritable()) {
+        qWarning() << "Cannot write snapshot: device is not writable";
+        return false;
+    }
+
+    QVector<QByteArray> utf8;
+    utf8.reserve(m_strings.size());
+    for (const QString &value : std::as_const(m_strings)) {
+        utf8.append(value.toUtf8());
+    }
+
+    // Records are sorted by ID so readers can binary search them
+    std::sort(m_records.begin(), m_records.end(),
+              [&utf8](const Snapshot::ContainerRecord &a,
+                      const Snapshot::ContainerRecord &b) {
+                  return utf8[a.id] < utf8[b.id];
+              });
+
+    // Time indexes leave out unset (NaN) times
+    auto timeIndex = [this](quint64_le Snapshot::ContainerRecord::*field) {
+        QVector<quint32_le> index;
+        for (qsizetype i = 0; i < m_records.size(); ++i) {
+            if (!std::isnan(bitsToDouble(m_records[i].*field))) {
+                index.append(quint32_le(static_cast<quint32>(i)));
+            }
+        }
+        std::stable_sort(index.begin(), index.end(),
+                         [this, field](quint32 a, quint32 b) {
+                             return bitsToDouble(m_records[a].*field) <
+                                    bitsToDouble(m_records[b].*field);
+                         });
+        return index;
+    };
+    const QVector<quint32_le> addedIndex =
+        timeIndex(&Snapshot::ContainerRecord::addedTime);
+    const QVector<quint32_le> leavingIndex =
+        timeIndex(&Snapshot::ContainerRecord::leavingTime);
+
+    QVector<Snapshot::DestinationIndexEntry> destinationIndex;
+    destinationIndex.reserve(m_destinations.size());
+    for (qsizetype i = 0; i < m_records.size(); ++i) {
+        const Snapshot::ContainerRecord &record = m_records[i];
+        for (quint32 d = 0; d < record.destinationsCount; ++d) {
+            Snapshot::DestinationIndexEntry entry;
+            entry.destination = m_destinations[record.destinationsBegin + d];
+            entry.record = static_cast<quint32>(i);
+            destinationIndex.append(entry);
+        }
+    }
+    std::stable_sort(destinationIndex.begin(), destinationIndex.end(),
+                     [&utf8](const Snapshot::DestinationIndexEntry &a,
+                             const Snapshot::DestinationIndexEntry &b) {
+                         return utf8[a.destination] < utf8[b.destination];
+                     });
+
+    // Build the string table
+    QByteArray stringTable;
+    {
+        QByteArray bytes;
+        QVector<quint64_le> offsets;
+        offsets.reserve(utf8.size() + 1);
+        for (const QByteArray &value : std::as_const(utf8)) {
+            offsets.append(quint64_le(static_cast<quint64>(bytes.size())));
+            bytes.append(value);
+        }
+        offsets.append(quint64_le(static_cast<quint64>(bytes.size())));
+
+        quint64_le count(static_cast<quint64>(m_strings.size()));
+        stringTable.append(reinterpret_cast<const char *>(&count),
+                           sizeof(count));
+        stringTable.append(rawBytes(offsets));
+        stringTable.append(bytes);
+    }
+
+    QVector<std::pair<Snapshot::SectionType, QByteArray>> sections = {
+        {Snapshot::StringTable, stringTable},
+        {Snapshot::Containers, rawBytes(m_records)},
+        {Snapshot::Destinations, rawBytes(m_destinations)},
+        {Snapshot::MovementHistory, rawBytes(m_history)},
+        {Snapshot::Packages, rawBytes(m_packages)},
+        {Snapshot::CustomVariables, rawBytes(m_customVariables)},
+        {Snapshot::VariantData, m_variantData},
+        {Snapshot::AddedTimeIndex, rawBytes(addedIndex)},
+        {Snapshot::LeavingTimeIndex, rawBytes(leavingIndex)},
+        {Snapshot::DestinationIndex, rawBytes(destinationIndex)}
+    };
+    if (m_delta) {
+        sections.append({Snapshot::RemovedContainers, rawBytes(m_removed)});
+    }
+
+    // Lay out the sections after the header, then the section table
+    QVector<Snapshot::SectionEntry> table;
+    qint64 offset = sizeof(Snapshot::FileHeader);
+    for (const auto &section : sections) {
+        Snapshot::SectionEntry entry{};
+        entry.type = section.first;
+        entry.offset = static_cast<quint64>(offset);
+        entry.size = static_cast<quint64>(section.second.size());
+        table.append(entry);
+        offset += alignedSize(section.second.size());
+    }
+
+    Snapshot::FileHeader header{};
+    std::memcpy(header.magic, Snapshot::Magic, sizeof(header.magic));
+    header.version = Snapshot::FormatVersion;
+    header.flags = m_delta ? quint32(Snapshot::DeltaSnapshot) : 0u;
+    header.containerCount = static_cast<quint64>(m_records.size());
+    header.sectionTableOffset = static_cast<quint64>(offset);
+    header.sectionCount = static_cast<quint32>(table.size());
+
+    auto writeBytes = [device](const char *data, qint64 size) {
+        return device->write(data, size) == size;
+    };
+    static const char padding[SectionAlignment] = {};
+
+    bool ok = writeBytes(reinterpret_cast<const char *>(&header),
+                         sizeof(header));
+    for (const auto &section : sections) {
+        if (!ok) break;
+        const qint64 size = section.second.size();
+        ok = writeBytes(section.second.constData(), size) &&
+             writeBytes(padding, alignedSize(size) - size);
+    }
+    ok = ok && writeBytes(reinterpret_cast<const char *>(table.constData()),
+                          table.size() * qint64(sizeof(Snapshot::SectionEntry)));
+
+    if (!ok) {
+        qWarning() << "Failed to write snapshot:" << device->errorString();
+    }
+    return ok;
+}
+
+ContainerSnapshotReader::ContainerSnapshotReader() = default;
+
+bool ContainerSnapshotReader::open(const uchar *data, qint64 size)
+{
+    m_data = nullptr;
+    m_size = 0;
+
+    if (!data || size < qint64(sizeof(Snapshot::FileHeader))) {
+        qWarning() << "Invalid snapshot: file is too small";
+        return false;
+    }
+    if (reinterpret_cast<quintptr>(data) % alignof(quint64) != 0) {
+        qWarning() << "Invalid snapshot: buffer is not 8-byte aligned";
+        return false;
+    }
+
+    const auto *header = reinterpret_cast<const Snapshot::FileHeader *>(data);
+    if (std::memcmp(header->magic, Snapshot::Magic, sizeof(header->magic))) {
+        qWarning() << "Invalid snapshot: bad magic";
+        return false;
+    }
+    if (header->version > Snapshot::FormatVersion) {
+        qWarning() << "Unsupported snapshot version" << quint32(header->version);
+        return false;
+    }
+
+    const quint64 tableOffset = header->sectionTableOffset;
+    const quint64 tableSize =
+        quint64(header->sectionCount) * sizeof(Snapshot::SectionEntry);
+    if (tableOffset > quint64(size) || tableSize > quint64(size) - tableOffset ||
+        tableOffset % SectionAlignment != 0) {
+        qWarning() << "Invalid snapshot: section table out of range";
+        return false;
+    }
+
+    m_data = data;
+    m_size = size;
+    m_flags = header->flags;
+    m_sections =
+        reinterpret_cast<const Snapshot::SectionEntry *>(data + tableOffset);
+    m_sectionCount = header->sectionCount;
+
+    for (quint32 i = 0; i < m_sectionCount; ++i) {
+        const quint64 offset = m_sections[i].offset;
+        const quint64 length = m_sections[i].size;
+        if (offset > quint64(size) || length > quint64(size) - offset ||
+            offset % SectionAlignment != 0) {
+            qWarning() << "Invalid snapshot: section" << i << "out of range";
+            m_data = nullptr;
+            return false;
+        }
+    }
+
+    // String table
+    qint64 length = 0;
+    const uchar *strings = section(Snapshot::StringTable, &length);
+    if (!strings || length < qint64(sizeof(quint64_le))) {
+        qWarning() << "Invalid snapshot: missing string table";
+        m_data = nullptr;
+        return false;
+    }
+    const quint64 stringCount = *reinterpret_cast<const quint64_le *>(strings);
+    if (stringCount >= quint64(length) / sizeof(quint64_le)) {
+        qWarning() << "Invalid snapshot: corrupt string table";
+        m_data = nullptr;
+        return false;
+    }
+    m_stringCount = qint64(stringCount);
+    const qint64 offsetsSize = (m_stringCount + 1) * qint64(sizeof(quint64_le));
+    if (qint64(sizeof(quint64_le)) + offsetsSize > length) {
+        qWarning() << "Invalid snapshot: corrupt string table";
+        m_data = nullptr;
+        return false;
+    }
+    m_stringOffsets =
+        reinterpret_cast<const quint64_le *>(strings + sizeof(quint64_le));
+    m_stringBytes = reinterpret_cast<const char *>(
+        strings + sizeof(quint64_le) + offsetsSize);
+    m_stringBytesSize = length - qint64(sizeof(quint64_le)) - offsetsSize;
+
+    // Fixed-width arrays
+    auto array = [this](quint32 type, qint64 elementSize, qint64 &count) {
+        qint64 bytes = 0;
+        const uchar *sectionData = section(type, &bytes);
+        count = sectionData ? bytes / elementSize : 0;
+        return sectionData;
+    };
+    m_records = reinterpret_cast<const Snapshot::ContainerRecord *>(
+        array(Snapshot::Containers, sizeof(Snapshot::ContainerRecord),
+              m_recordCount));
+    m_destinations = reinterpret_cast<const quint32_le *>(
+        array(Snapshot::Destinations, sizeof(quint32_le), m_destinationCount));
+    m_history = reinterpret_cast<const quint32_le *>(
+        array(Snapshot::MovementHistory, sizeof(quint32_le), m_historyCount));
+    m_packages = reinterpret_cast<const quint32_le *>(
+        array(Snapshot::Packages, sizeof(quint32_le), m_packageCount));
+    m_customVariables =
+        reinterpret_cast<const Snapshot::CustomVariableRecord *>(
+            array(Snapshot::CustomVariables,
+                  sizeof(Snapshot::CustomVariableRecord),
+                  m_customVariableCount));
+    m_variantData = section(Snapshot::VariantData, &m_variantDataSize);
+
+    if (m_recordCount != qint64(header->containerCount)) {
+        qWarning() << "Invalid snapshot: container count mismatch";
+        m_data = nullptr;
+        return false;
+    }
+    if (!openIndexes()) {
+        m_data = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool ContainerSnapshotReader::openIndexes()
+{
+    qint64 bytes = 0;
+    m_addedTimeIndex = reinterpret_cast<const quint32_le *>(
+        section(Snapshot::AddedTimeIndex, &bytes));
+    m_addedTimeIndexSize = bytes / qint64(sizeof(quint32_le));
+    m_leavingTimeIndex = reinterpret_cast<const quint32_le *>(
+        section(Snapshot::LeavingTimeIndex, &bytes));
+    m_leavingTimeIndexSize = bytes / qint64(sizeof(quint32_le));
+    m_destinationIndex =
+        reinterpret_cast<const Snapshot::DestinationIndexEntry *>(
+            section(Snapshot::DestinationIndex, &bytes));
+    m_destinationIndexSize =
+        bytes / qint64(sizeof(Snapshot::DestinationIndexEntry));
+    m_removed = reinterpret_cast<const quint32_le *>(
+        section(Snapshot::RemovedContainers, &bytes));
+    m_removedCount = bytes / qint64(sizeof(quint32_le));
+
+    // Check once here so the queries can use the entries unchecked
+    for (qint64 i = 0; i < m_addedTimeIndexSize; ++i) {
+        if (m_addedTimeIndex[i] >= quint64(m_recordCount)) {
+            qWarning() << "Invalid snapshot: added time index out of range";
+            return false;
+        }
+    }
+    for (qint64 i = 0; i < m_leavingTimeIndexSize; ++i) {
+        if (m_leavingTimeIndex[i] >= quint64(m_recordCount)) {
+            qWarning() << "Invalid snapshot: leaving time index out of range";
+            return false;
+        }
+    }
+    for (qint64 i = 0; i < m_destinationIndexSize; ++i) {
+        if (m_destinationIndex[i].record >= quint64(m_recordCount) ||
+            m_destinationIndex[i].destination >= quint64(m_stringCount)) {
+            qWarning() << "Invalid snapshot: destination index out of range";
+            return false;
+        }
+    }
+    for (qint64 i = 0; i < m_removedCount; ++i) {
+        if (m_removed[i] >= quint64(m_stringCount)) {
+            qWarning() << "Invalid snapshot: removed container out of range";
+            return false;
+        }
+    }
+    return true;
+}
+
+qsizetype ContainerSnapshotReader::containerCount() const
+{
+    return m_data ? m_recordCount : 0;
+}
+
+bool ContainerSnapshotReader::isDelta() const
+{
+    return m_data && (m_flags & Snapshot::DeltaSnapshot);
+}
+
+QStringList ContainerSnapshotReader::removedContainers() const
+{
+    QStringList ids;
+    if (!m_data) {
+        return ids;
+    }
+    ids.reserve(m_removedCount);
+    for (qint64 i = 0; i < m_removedCount; ++i) {
+        ids.append(string(m_removed[i]));
+    }
+    return ids;
+}
+
+const Snapshot::ContainerRecord &
+ContainerSnapshotReader::record(qsizetype index) const
+{
+    return m_records[index];
+}
+
+const uchar *ContainerSnapshotReader::section(quint32 type,
+                                              qint64 *size) const
+{
+    if (m_data) {
+        for (quint32 i = 0; i < m_sectionCount; ++i) {
+            if (m_sections[i].type == type) {
+                if (size) {
+                    *size = qint64(m_sections[i].size);
+                }
+                return m_data + quint64(m_sections[i].offset);
+            }
+        }
+    }
+    if (size) {
+        *size = 0;
+    }
+    return nullptr;
+}
+
+QString ContainerSnapshotReader::string(quint32 index) const
+{
+    return QString::fromUtf8(stringView(index));
+}
+
+QByteArrayView ContainerSnapshotReader::stringView(quint32 index) const
+{
+    if (qint64(index) >= m_stringCount) {
+        return QByteArrayView();
+    }
+    const quint64 begin = m_stringOffsets[index];
+    const quint64 end = m_stringOffsets[index + 1];
+    if (begin > end || end > quint64(m_stringBytesSize)) {
+        return QByteArrayView();
+    }
+    return QByteArrayView(m_stringBytes + begin, qsizetype(end - begin));
+}
+
+qsizetype ContainerSnapshotReader::findContainer(const QString &id) const
+{
+    if (!m_data) {
+        return -1;
+    }
+    const QByteArray key = id.toUtf8();
+    const auto *begin = m_records;
+    const auto *end = m_records + m_recordCount;
+    const auto *it = std::lower_bound(
+        begin, end, key,
+        [this](const Snapshot::ContainerRecord &record,
+               const QByteArray &value) {
+            return stringView(record.id) < QByteArrayView(value);
+        });
+    if (it != end && stringView(it->id) == QByteArrayView(key)) {
+        return it - begin;
+    }
+    return -1;
+}
+
+qsizetype ContainerSnapshotReader::upperBound(const QString &id) const
+{
+    if (!m_data) {
+        return 0;
+    }
+    const QByteArray key = id.toUtf8();
+    const auto *begin = m_records;
+    const auto *end = m_records + m_recordCount;
+    const auto *it = std::upper_bound(
+        begin, end, key,
+        [this](const QByteArray &value,
+               const Snapshot::ContainerRecord &record) {
+            return QByteArrayView(value) < stringView(record.id);
+        });
+    return it - begin;
+}
+
+double ContainerSnapshotReader::recordTime(qsizetype index,
+                                           TimeField field) const
+{
+    const Snapshot::ContainerRecord &rec = m_records[index];
+    return bitsToDouble(field == AddedTime ? rec.addedTime : rec.leavingTime);
+}
+
+bool ContainerSnapshotReader::matches(double time, Comparison comparison,
+                                      double referenceTime)
+{
+    switch (comparison) {
+    case Greater:      return time > referenceTime;
+    case GreaterEqual: return time >= referenceTime;
+    case Less:         return time < referenceTime;
+    case LessEqual:    return time <= referenceTime;
+    case Equal:        return time == referenceTime;
+    case NotEqual:     return time != referenceTime;
+    }
+    return false;
+}
+
+bool ContainerSnapshotReader::timeRange(TimeField field, double referenceTime,
+                                        qint64 &lower, qint64 &upper,
+                                        const quint32_le *&index,
+                                        qint64 &indexSize) const
+{
+    if (field == AddedTime) {
+        index = m_addedTimeIndex;
+        indexSize = m_addedTimeIndexSize;
+    } else {
+        index = m_leavingTimeIndex;
+        indexSize = m_leavingTimeIndexSize;
+    }
+    if (!index) {
+        return false;
+    }
+
+    auto timeAt = [this, field](quint32 record) {
+        return recordTime(record, field);
+    };
+    const quint32_le *first = index;
+    const quint32_le *last = index + indexSize;
+    lower = std::lower_bound(first, last, referenceTime,
+                             [&](quint32 record, double value) {
+                                 return timeAt(record) < value;
+                             }) - first;
+    upper = std::upper_bound(first, last, referenceTime,
+                             [&](double value, quint32 record) {
+                                 return value < timeAt(record);
+                             }) - first;
+    return true;
+}
+
+QVector<qsizetype> ContainerSnapshotReader::findByTime(
+    TimeField field, Comparison comparison, double referenceTime) const
+{
+    QVector<qsizetype> result;
+    if (!m_data) {
+        return result;
+    }
+
+    qint64 lower = 0, upper = 0, indexSize = 0;
+    const quint32_le *index = nullptr;
+    if (comparison == NotEqual || std::isnan(referenceTime) ||
+        !timeRange(field, referenceTime, lower, upper, index, indexSize)) {
+        // NotEqual also matches unset times, which are not indexed
+        for (qint64 i = 0; i < m_recordCount; ++i) {
+            if (matches(recordTime(i, field), comparison, referenceTime)) {
+                result.append(i);
+            }
+        }
+        return result;
+    }
+
+    qint64 from = 0, to = 0;
+    switch (comparison) {
+    case Greater:      from = upper; to = indexSize; break;
+    case GreaterEqual: from = lower; to = indexSize; break;
+    case Less:         from = 0;     to = lower;     break;
+    case LessEqual:    from = 0;     to = upper;     break;
+    case Equal:        from = lower; to = upper;     break;
+    case NotEqual:     break;
+    }
+    result.reserve(to - from);
+    for (qint64 i = from; i < to; ++i) {
+        result.append(qsizetype(quint32(index[i])));
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+qsizetype ContainerSnapshotReader::countByTime(
+    TimeField field, Comparison comparison, double referenceTime) const
+{
+    if (!m_data) {
+        return 0;
+    }
+
+    qint64 lower = 0, upper = 0, indexSize = 0;
+    const quint32_le *index = nullptr;
+    if (std::isnan(referenceTime) ||
+        !timeRange(field, referenceTime, lower, upper, index, indexSize)) {
+        qsizetype count = 0;
+        for (qint64 i = 0; i < m_recordCount; ++i) {
+            if (matches(recordTime(i, field), comparison, referenceTime)) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    switch (comparison) {
+    case Greater:      return indexSize - upper;
+    case GreaterEqual: return indexSize - lower;
+    case Less:         return lower;
+    case LessEqual:    return upper;
+    case Equal:        return upper - lower;
+    case NotEqual:     return m_recordCount - (upper - lower);
+    }
+    return 0;
+}
+
+QVector<qsizetype> ContainerSnapshotReader::findByDestination(
+    const QString &destination) const
+{
+    QVector<qsizetype> result;
+    if (!m_data) {
+        return result;
+    }
+    const QByteArray key = destination.toUtf8();
+
+    const Snapshot::DestinationIndexEntry *entries = m_destinationIndex;
+    if (!entries) {
+        // No index: scan the destination arrays
+        for (qint64 i = 0; i < m_recordCount; ++i) {
+            const Snapshot::ContainerRecord &rec = m_records[i];
+            if (!m_destinations || !sliceInRange(rec.destinationsBegin,
+                                                 rec.destinationsCount,
+                                                 m_destinationCount)) {
+                continue;
+            }
+            for (quint32 d = 0; d < rec.destinationsCount; ++d) {
+                if (stringView(m_destinations[rec.destinationsBegin + d]) ==
+                    QByteArrayView(key)) {
+                    result.append(i);
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    const auto *first = entries;
+    const auto *last = entries + m_destinationIndexSize;
+    const auto *it = std::lower_bound(
+        first, last, key,
+        [this](const Snapshot::DestinationIndexEntry &entry,
+               const QByteArray &value) {
+            return stringView(entry.destination) < QByteArrayView(value);
+        });
+    for (; it != last && stringView(it->destination) == QByteArrayView(key);
+         ++it) {
+        result.append(qsizetype(quint32(it->record)));
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+bool ContainerSnapshotReader::sliceInRange(quint32 begin, quint32 count,
+                                           qint64 length)
+{
+    return qint64(begin) + qint64(count) <= length;
+}
+
+QVariant ContainerSnapshotReader::customValue(
+    const Snapshot::CustomVariableRecord &record) const
+{
+    const quint64 payload = record.payload;
+    switch (quint32(record.type)) {
+    case Snapshot::BoolValue:
+        return QVariant(payload != 0);
+    case Snapshot::IntValue:
+        return QVariant(static_cast<qlonglong>(payload));
+    case Snapshot::DoubleValue:
+        return QVariant(bitsToDouble(payload));
+    case Snapshot::StringValue:
+        return QVariant(string(static_cast<quint32>(payload)));
+    case Snapshot::VariantValue: {
+        if (payload > quint64(m_variantDataSize) ||
+            quint64(record.aux) > quint64(m_variantDataSize) - payload) {
+            qWarning() << "Invalid snapshot: variant payload out of range";
+            return QVariant();
+        }
+        QByteArray encoded = QByteArray::fromRawData(
+            reinterpret_cast<const char *>(m_variantData + payload),
+            qsizetype(record.aux));
+        QDataStream stream(encoded);
+        QVariant value;
+        stream >> value;
+        return value;
+    }
+    default:
+        return QVariant();
+    }
+}
+
+Container *ContainerSnapshotReader::createContainer(qsizetype index) const
+{
+    const Snapshot::ContainerRecord &rec = m_records[index];
+
+    Container *container = new Container();
+    container->setContainerID(string(rec.id));
+    container->setContainerSize(
+        static_cast<Container::ContainerSize>(qint32(rec.size)));
+    container->setContainerAddedTime(bitsToDouble(rec.addedTime));
+    container->setContainerLeavingTime(bitsToDouble(rec.leavingTime));
+
+    // Setting the location first lets the stored history and destinations
+    // overwrite the bookkeeping setContainerCurrentLocation() does
+    container->setContainerCurrentLocation(string(rec.currentLocation));
+
+    auto strings = [this](const quint32_le *array, qint64 length,
+                          quint32 begin, quint32 count) {
+        QVector<QString> values;
+        if (!array || !sliceInRange(begin, count, length)) {
+            if (count > 0) {
+                qWarning() << "Invalid snapshot: child array out of range";
+            }
+            return values;
+        }
+        values.reserve(count);
+        for (quint32 i = 0; i < count; ++i) {
+            values.append(string(array[begin + i]));
+        }
+        return values;
+    };
+
+    container->setContainerNextDestinations(
+        strings(m_destinations, m_destinationCount,
+                rec.destinationsBegin, rec.destinationsCount));
+    container->setContainerMovementHistory(
+        strings(m_history, m_historyCount,
+                rec.historyBegin, rec.historyCount));
+
+    for (const QString &packageID :
+         strings(m_packages, m_packageCount,
+                 rec.packagesBegin, rec.packagesCount)) {
+        container->addPackage(PackageData{packageID});
+    }
+
+    if (m_customVariables &&
+        sliceInRange(rec.customBegin, rec.customCount,
+                     m_customVariableCount)) {
+        for (quint32 i = 0; i < rec.customCount; ++i) {
+            const Snapshot::CustomVariableRecord &variable =
+                m_customVariables[rec.customBegin + i];
+            container->addCustomVariable(
+                static_cast<Container::HaulerType>(quint32(variable.hauler)),
+                string(variable.key), customValue(variable));
+        }
+    }
+
+    return container;
+}
+
+}
@@ -1,5 +1,7 @@
 #include "containerLib/package.h"
+#include "containerLib/containercbor.h"
 #include <QDebug>
+#include <QtEndian>
 
 namespace ContainerCore {
 
@@ -21,6 +23,12 @@ Package::Package(const QJsonObject &json, QObject *parent)
     m_packageID = json[QStringLiteral("packageID")].toString();
 }
 
+Package::Package(const PackageData &data, QObject *parent)
+    : QObject(parent), m_packageID(data.packageID)
+{
+
+}
+
 // Copy constructor
 Package::Package(const Package &other)
     : QObject(other.parent())
@@ -56,19 +64,121 @@ QJsonObject Package::toJson() const
     return jsonObject;
 }
 
+PackageData Package::toData() const
+{
+    return PackageData{m_packageID};
+}
+
+QCborMap Package::toCbor() const
+{
+    QCborMap cborMap;
+    cborMap.insert(QLatin1String("packageID"), m_packageID);
+    return cborMap;
+}
+
+Package *Package::fromCbor(const QCborMap &cbor, QObject *parent)
+{
+    return new Package(cbor.value(QLatin1String("packageID")).toString(),
+                       parent);
+}
+
+void Package::writeCbor(QCborStreamWriter &writer) const
+{
+    writeCbor(writer, PackageData{m_packageID});
+}
+
+bool Package::readCbor(QCborStreamReader &reader)
+{
+    PackageData data;
+    if (!readCbor(reader, data)) {
+        return false;
+    }
+    setPackageID(data.packageID);
+    return true;
+}
+
+void Package::writeCbor(QCborStreamWriter &writer, const PackageData &package)
+{
+    writer.startMap(1);
+    writer.append(QLatin1String("packageID"));
+    writer.append(package.packageID);
+    writer.endMap();
+}
+
+bool Package::readCbor(QCborStreamReader &reader, PackageData &package)
+{
+    if (!reader.isMap()) {
+        reader.next(); // Skip the value so callers can move on
+        return false;
+    }
+    if (!reader.enterContainer()) {
+        return false;
+    }
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        if (Cbor::readString(reader) == QLatin1String("packageID")) {
+            package.packageID = Cbor::readString(reader);
+        } else {
+            reader.next(); // Skip unknown members
+        }
+    }
+    return reader.leaveContainer();
+}
+
 ContainerCore::Package* Package::copy() const {
     Package* newPackage = new Package();
     newPackage->setPackageID(m_packageID);
     return newPackage;
 }
 
+namespace DataStream {
+
+void writeHeader(QDataStream &out, quint32 magic)
+{
+    out << magic << FormatVersion;
+}
+
+quint16 readHeader(QDataStream &in, quint32 magic)
+{
+    // Legacy records start with a string length; look without consuming
+    QIODevice *device = in.device();
+    if (!device) {
+        return 0;
+    }
+    const QByteArray prefix = device->peek(sizeof(quint32));
+    if (prefix.size() < qsizetype(sizeof(quint32))) {
+        return 0;
+    }
+    const quint32 value = in.byteOrder() == QDataStream::BigEndian
+                              ? qFromBigEndian<quint32>(prefix.constData())
+                              : qFromLittleEndian<quint32>(prefix.constData());
+    if (value != magic) {
+        return 0;
+    }
+
+    quint32 storedMagic = 0;
+    quint16 version = 0;
+    in >> storedMagic >> version;
+    if (version == 0 || version > FormatVersion) {
+        qWarning() << "Unsupported stream format version:" << version;
+        in.setStatus(QDataStream::ReadCorruptData);
+    }
+    return version;
+}
+
+} // namespace DataStream
+
 QDataStream &operator<<(QDataStream &out, const Package &package) {
+    DataStream::writeHeader(out, DataStream::PackageMagic);
     out << package.m_packageID;
     return out;
 }
 
 QDataStream &operator>>(QDataStream &in, Package &package) {
-    in >> package.m_packageID;
+    // Both formats continue with the ID
+    DataStream::readHeader(in, DataStream::PackageMagic);
+    if (in.status() == QDataStream::Ok) {
+        in >> package.m_packageID;
+    }
     return in;
 }
 
@@ -1,9 +1,16 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 #include "containerext.h"
 #include "containermapext.h"
 #include "packageext.h"
+#include <QSysInfo>
+#include <QThreadPool>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <type_traits>
 
 namespace py = pybind11;
 
@@ -45,124 +52,946 @@ py::object QJsonValueToPyObject(const QJsonValue& value) {
     }
 }
 
+// Keys of the container and package dictionaries, interned once. The
+// objects are never released so they do not outlive the interpreter.
+struct DictKeys {
+    py::str containers;
+    py::str containerID;
+    py::str containerSize;
+    py::str containerCurrentLocation;
+    py::str addedTime;
+    py::str leavingTime;
+    py::str containerNextDestinations;
+    py::str containerMovementHistory;
+    py::str packages;
+    py::str packageID;
+    py::str customVariables;
+};
+
+py::str internedKey(const char *key) {
+    PyObject *interned = PyUnicode_InternFromString(key);
+    if (!interned) {
+        throw py::error_already_set();
+    }
+    return py::reinterpret_steal<py::str>(interned);
+}
+
+const DictKeys &dictKeys() {
+    static const DictKeys *keys = new DictKeys{
+        internedKey("containers"),
+        internedKey("containerID"),
+        internedKey("containerSize"),
+        internedKey("containerCurrentLocation"),
+        internedKey("addedTime"),
+        internedKey("leavingTime"),
+        internedKey("containerNextDestinations"),
+        internedKey("containerMovementHistory"),
+        internedKey("packages"),
+        internedKey("packageID"),
+        internedKey("customVariables")};
+    return *keys;
+}
+
+void setDictItem(py::dict &dict, py::handle key, const py::object &value) {
+    if (PyDict_SetItem(dict.ptr(), key.ptr(), value.ptr()) != 0) {
+        throw py::error_already_set();
+    }
+}
+
+// Borrowed value for a key, or a null handle if the key is missing
+py::handle dictItem(const py::dict &dict, py::handle key) {
+    return py::handle(PyDict_GetItem(dict.ptr(), key.ptr()));
+}
+
+// Decodes the UTF-16 data directly instead of going through std::string
+py::str QStringToPyStr(const QString &value) {
+    int byteOrder = QSysInfo::ByteOrder == QSysInfo::LittleEndian ? -1 : 1;
+    PyObject *str = PyUnicode_DecodeUTF16(
+        reinterpret_cast<const char *>(value.utf16()),
+        Py_ssize_t(value.size()) * 2, nullptr, &byteOrder);
+    if (!str) {
+        throw py::error_already_set();
+    }
+    return py::reinterpret_steal<py::str>(str);
+}
+
+QString PyToQString(py::handle value) {
+    if (!PyUnicode_Check(value.ptr())) {
+        return QString::fromStdString(py::str(value).cast<std::string>());
+    }
+    Py_ssize_t size = 0;
+    const char *data = PyUnicode_AsUTF8AndSize(value.ptr(), &size);
+    if (!data) {
+        throw py::error_already_set();
+    }
+    return QString::fromUtf8(data, qsizetype(size));
+}
+
+py::object TimeToPyObject(double time) {
+    if (std::isnan(time)) {
+        return py::none();
+    }
+    return py::float_(time);
+}
+
+py::list QStringVectorToPyList(const QVector<QString> &values) {
+    py::list list(values.size());
+    for (qsizetype i = 0; i < values.size(); ++i) {
+        list[i] = QStringToPyStr(values[i]);
+    }
+    return list;
+}
+
+py::object QVariantToPyObject(const QVariant &value) {
+    switch (value.typeId()) {
+    case QMetaType::Bool:
+        return py::bool_(value.toBool());
+    case QMetaType::Int:
+    case QMetaType::LongLong:
+        return py::int_(value.toLongLong());
+    case QMetaType::UInt:
+    case QMetaType::ULongLong:
+        return py::int_(value.toULongLong());
+    case QMetaType::Float:
+    case QMetaType::Double:
+        return TimeToPyObject(value.toDouble());
+    case QMetaType::QString:
+        return QStringToPyStr(value.toString());
+    case QMetaType::UnknownType:
+    case QMetaType::Nullptr:
+        return py::none();
+    default:
+        return QJsonValueToPyObject(QJsonValue::fromVariant(value));
+    }
+}
+
+py::dict PackageDataToPyDict(const ContainerCore::PackageData &package) {
+    py::dict dict;
+    setDictItem(dict, dictKeys().packageID, QStringToPyStr(package.packageID));
+    return dict;
+}
+
+// Builds the dictionary of Container::toJson() straight from the fields.
+// Integers stay integers instead of passing through JSON doubles.
+py::dict ContainerToPyDict(const ContainerCore::Container &container) {
+    const DictKeys &keys = dictKeys();
+    py::dict dict;
+    setDictItem(dict, keys.containerID, QStringToPyStr(container.getContainerID()));
+    setDictItem(dict, keys.containerSize, py::int_(int(container.getContainerSize())));
+    setDictItem(dict, keys.containerCurrentLocation,
+                QStringToPyStr(container.getContainerCurrentLocation()));
+    setDictItem(dict, keys.addedTime, TimeToPyObject(container.getContainerAddedTime()));
+    setDictItem(dict, keys.leavingTime, TimeToPyObject(container.getContainerLeavingTime()));
+    setDictItem(dict, keys.containerNextDestinations,
+                QStringVectorToPyList(container.getContainerNextDestinations()));
+    setDictItem(dict, keys.containerMovementHistory,
+                QStringVectorToPyList(container.getContainerMovementHistory()));
+
+    const auto packages = container.packagesView();
+    py::list packageList(packages.size());
+    for (std::size_t i = 0; i < packages.size(); ++i) {
+        packageList[i] = PackageDataToPyDict(packages[i]);
+    }
+    setDictItem(dict, keys.packages, packageList);
+
+    // Hauler keys are strings, as in the JSON form
+    py::dict customVariables;
+    container.forEachCustomVariable(
+        [&customVariables](ContainerCore::Container::HaulerType hauler,
+                           const QString &key, const QVariant &value) {
+            py::str haulerKey(std::to_string(int(hauler)));
+            py::handle existing = PyDict_GetItem(customVariables.ptr(), haulerKey.ptr());
+            py::dict variables = existing
+                ? py::reinterpret_borrow<py::dict>(existing)
+                : py::dict();
+            if (!existing) {
+                setDictItem(customVariables, haulerKey, variables);
+            }
+            setDictItem(variables, QStringToPyStr(key), QVariantToPyObject(value));
+        });
+    setDictItem(dict, keys.customVariables, customVariables);
+    return dict;
+}
+
 py::dict PackageExtToPyDict(const PackageExt& pkg) {
-    QJsonObject json = pkg.toJson();  // Assuming this returns QJsonObject
-    return QJsonObjectToPyDict(json);
+    py::dict dict;
+    setDictItem(dict, dictKeys().packageID, py::str(pkg.packageID()));
+    return dict;
 }
 
 py::dict ContainerExtToPyDict(const ContainerExt& container) {
-    QJsonObject json = container.toJson();  // Assuming this returns QJsonObject
-    return QJsonObjectToPyDict(json);
+    const ContainerCore::Container *base = container.getBaseContainer();
+    return base ? ContainerToPyDict(*base) : py::dict();
 }
 
 py::dict ContainerMapExtToPyDict(const ContainerMapExt& map) {
-    QJsonObject json = map.toJson();  // Assuming this returns QJsonObject
-    return QJsonObjectToPyDict(json);
+    if (map.isDatabaseBacked()) {
+        // Only the database location is exported
+        QJsonObject json;
+        {
+            py::gil_scoped_release release;
+            json = map.toJson();
+        }
+        return QJsonObjectToPyDict(json);
+    }
+
+    // The dictionaries are Python objects, so the GIL stays held
+    py::list containers;
+    map.forEachContainer([&containers](const ContainerCore::Container &container) {
+        containers.append(ContainerToPyDict(container));
+    });
+    py::dict dict;
+    setDictItem(dict, dictKeys().containers, containers);
+    return dict;
 }
 
-// Helper function to convert Python dict to QJsonObject
-QJsonObject PyDictToQJsonObject(const py::dict &pyDict) {
-    QJsonObject jsonObj;
-    for (auto item : pyDict) {
-        QString key = QString::fromStdString(py::str(item.first).cast<std::string>());
-        py::object value = py::reinterpret_borrow<py::object>(item.second);
+// NumPy's bool scalar is neither a bool nor an index
+bool IsNumpyBool(PyObject *object) {
+    const char *name = Py_TYPE(object)->tp_name;
+    return std::strcmp(name, "numpy.bool_") == 0 ||
+           std::strcmp(name, "numpy.bool") == 0;
+}
 
-        // Handle None/null values
-        if (value.is_none()) {
-            jsonObj[key] = QJsonValue::Null;
-            continue;
+QVariant PyToQVariant(py::handle value) {
+    PyObject *object = value.ptr();
+    if (object == Py_None) {
+        return QVariant::fromValue(nullptr);
+    }
+    if (PyBool_Check(object)) {
+        return QVariant(object == Py_True);
+    }
+    if (PyLong_Check(object)) {
+        int overflow = 0;
+        const long long integer = PyLong_AsLongLongAndOverflow(object, &overflow);
+        if (!overflow) {
+            return QVariant(qlonglong(integer));
+        }
+        return QVariant(PyLong_AsDouble(object));
+    }
+    if (PyFloat_Check(object)) {
+        const double number = PyFloat_AS_DOUBLE(object);
+        if (std::isnan(number)) {
+            return QVariant::fromValue(nullptr);
+        }
+        return QVariant(number);
+    }
+    if (PyUnicode_Check(object)) {
+        return PyToQString(value);
+    }
+    if (PyDict_Check(object)) {
+        QVariantMap map;
+        for (auto item : py::reinterpret_borrow<py::dict>(value)) {
+            map.insert(PyToQString(item.first), PyToQVariant(item.second));
+        }
+        return map;
+    }
+    if (PyList_Check(object) || PyTuple_Check(object)) {
+        QVariantList list;
+        for (py::handle item : value) {
+            list.append(PyToQVariant(item));
+        }
+        return list;
+    }
+    if (IsNumpyBool(object)) {
+        return QVariant(PyObject_IsTrue(object) == 1);
+    }
+    PyTypeObject *type = Py_TYPE(object);
+    if (PyIndex_Check(object)) {
+        // NumPy integer scalars
+        py::object index = py::reinterpret_steal<py::object>(PyNumber_Index(object));
+        if (index) {
+            return PyToQVariant(index);
+        }
+        PyErr_Clear();
+    } else if (type->tp_as_number && type->tp_as_number->nb_float) {
+        // numpy.float32 and other objects with __float__
+        const double number = PyFloat_AsDouble(object);
+        if (!(number == -1.0 && PyErr_Occurred())) {
+            return std::isnan(number) ? QVariant::fromValue(nullptr)
+                                      : QVariant(number);
         }
+        PyErr_Clear();
+    }
+    qWarning() << "Unsupported custom variable type:"
+               << Py_TYPE(object)->tp_name;
+    return QVariant::fromValue(nullptr);
+}
 
-        // Special handling for customVariables which has numeric keys
-        if (key == "customVariables" && py::isinstance<py::dict>(value)) {
-            QJsonObject customVarsObj;
-            py::dict customVarsDict = value.cast<py::dict>();
+// Same rules as the JSON constructor: None, "NaN" and anything that is
+// not a number, or too large for a double, become NaN
+double PyToTime(py::handle value) {
+    PyObject *object = value.ptr();
+    PyNumberMethods *number = Py_TYPE(object)->tp_as_number;
+    // The nb_float check takes NumPy scalars
+    if (PyFloat_Check(object) || PyLong_Check(object) ||
+        (number && number->nb_float)) {
+        const double time = PyFloat_AsDouble(object);
+        if (time == -1.0 && PyErr_Occurred()) {
+            PyErr_Clear();
+            return std::nan("");
+        }
+        return time;
+    }
+    if (PyUnicode_Check(object)) {
+        bool ok = false;
+        const double time = PyToQString(value).toDouble(&ok);
+        return ok ? time : std::nan("");
+    }
+    return std::nan("");
+}
 
-            for (auto haulerItem : customVarsDict) {
-                // Convert hauler type (which could be int or string) to string key
-                QString haulerKey;
-                py::object haulerKey_obj = py::reinterpret_borrow<py::object>(haulerItem.first);
+QVector<QString> PyToQStringVector(py::handle value) {
+    QVector<QString> values;
+    if (!PyList_Check(value.ptr()) && !PyTuple_Check(value.ptr())) {
+        return values;
+    }
+    values.reserve(qsizetype(PySequence_Size(value.ptr())));
+    for (py::handle item : value) {
+        if (PyUnicode_Check(item.ptr())) {
+            values.append(PyToQString(item));
+        }
+    }
+    return values;
+}
 
-                if (py::isinstance<py::int_>(haulerKey_obj)) {
-                    haulerKey = QString::number(haulerKey_obj.cast<int>());
-                } else {
-                    haulerKey = QString::fromStdString(py::str(haulerKey_obj).cast<std::string>());
-                }
+// Converts any sequence (list, tuple, NumPy array, Arrow array) to
+// strings; None becomes an empty string and other items that are not str
+// are converted with str()
+QStringList PySequenceToQStringList(py::handle value, const char *name) {
+    py::object source = py::reinterpret_borrow<py::object>(value);
+    if (!PyList_Check(value.ptr()) && !PyTuple_Check(value.ptr()) &&
+        py::hasattr(source, "to_pylist")) {
+        // Arrow arrays iterate as Arrow scalars; ask for Python objects
+        source = source.attr("to_pylist")();
+    }
+    py::object sequence = py::reinterpret_steal<py::object>(
+        PySequence_Fast(source.ptr(), name));
+    if (!sequence) {
+        throw py::error_already_set();
+    }
+    const Py_ssize_t size = PySequence_Fast_GET_SIZE(sequence.ptr());
+    PyObject **items = PySequence_Fast_ITEMS(sequence.ptr());
+    QStringList values;
+    values.reserve(qsizetype(size));
+    for (Py_ssize_t i = 0; i < size; ++i) {
+        if (PyUnicode_Check(items[i])) {
+            values.append(PyToQString(items[i]));
+        } else if (items[i] == Py_None) {
+            values.append(QString());
+        } else {
+            values.append(PyToQString(py::str(items[i])));
+        }
+    }
+    return values;
+}
 
-                // Handle the variables for this hauler
-                py::object haulerValue = py::reinterpret_borrow<py::object>(haulerItem.second);
-                if (py::isinstance<py::dict>(haulerValue)) {
-                    customVarsObj[haulerKey] = PyDictToQJsonObject(haulerValue.cast<py::dict>());
-                }
+// Copies a numeric column into a QVector; anything NumPy can convert
+// (arrays, lists, Arrow arrays, pandas Series) is accepted. None gives an
+// empty column
+template <typename T>
+QVector<T> PyToNumericColumn(const py::object &value, const char *name) {
+    if (value.is_none()) {
+        return QVector<T>();
+    }
+    auto array = py::array_t<T, py::array::c_style | py::array::forcecast>::ensure(value);
+    if (!array || array.ndim() != 1) {
+        throw py::type_error(std::string(name) + " must be a one-dimensional array of numbers");
+    }
+    const T *data = array.data();
+    return QVector<T>(data, data + array.size());
+}
+
+// Copies a one-dimensional NumPy array into variants
+template <typename T, typename Convert>
+QVariantList NumpyToQVariantList(const py::array &array, Convert convert) {
+    auto typed = py::array_t<T, py::array::c_style | py::array::forcecast>::ensure(array);
+    if (!typed || typed.ndim() != 1) {
+        throw py::value_error("Expected a one-dimensional array of values");
+    }
+    const T *data = typed.data();
+    const qsizetype size = qsizetype(typed.size());
+    QVariantList values;
+    values.reserve(size);
+    for (qsizetype i = 0; i < size; ++i) {
+        values.append(convert(data[i]));
+    }
+    return values;
+}
+
+// Converts custom variable values; float, integer and boolean NumPy
+// arrays are read straight from their buffer, anything else goes through
+// PyToQVariant() item by item
+QVariantList PyToQVariantList(py::handle value) {
+    if (py::isinstance<py::array>(value)) {
+        auto array = py::reinterpret_borrow<py::array>(value);
+        switch (array.dtype().kind()) {
+        case 'f':
+            // NaN means "no value", as in PyToQVariant()
+            return NumpyToQVariantList<double>(array, [](double number) {
+                return std::isnan(number) ? QVariant::fromValue(nullptr)
+                                          : QVariant(number);
+            });
+        case 'i':
+            return NumpyToQVariantList<std::int64_t>(array, [](std::int64_t number) {
+                return QVariant(qlonglong(number));
+            });
+        case 'u':
+            return NumpyToQVariantList<std::uint64_t>(array, [](std::uint64_t number) {
+                return QVariant(qulonglong(number));
+            });
+        case 'b':
+            return NumpyToQVariantList<bool>(array, [](bool flag) {
+                return QVariant(flag);
+            });
+        default:
+            break;
+        }
+    }
+
+    py::object sequence = py::reinterpret_steal<py::object>(
+        PySequence_Fast(value.ptr(), "values must be a sequence"));
+    if (!sequence) {
+        throw py::error_already_set();
+    }
+    const Py_ssize_t size = PySequence_Fast_GET_SIZE(sequence.ptr());
+    PyObject **items = PySequence_Fast_ITEMS(sequence.ptr());
+    QVariantList values;
+    values.reserve(qsizetype(size));
+    for (Py_ssize_t i = 0; i < size; ++i) {
+        values.append(PyToQVariant(items[i]));
+    }
+    return values;
+}
+
+// Builds a Container straight from a dictionary shaped like
+// Container::toJson(); throws std::invalid_argument like the JSON
+// constructor does
+ContainerCore::Container *PyDictToContainer(const py::dict &dict) {
+    using ContainerCore::Container;
+    const DictKeys &keys = dictKeys();
+
+    py::handle id = dictItem(dict, keys.containerID);
+    if (!id || !PyUnicode_Check(id.ptr())) {
+        throw std::invalid_argument("Invalid or missing 'containerID'");
+    }
+
+    py::handle sizeValue = dictItem(dict, keys.containerSize);
+    if (!sizeValue) {
+        throw std::invalid_argument("Missing 'containerSize'");
+    }
+    int size = 0;
+    if (PyLong_Check(sizeValue.ptr()) || PyFloat_Check(sizeValue.ptr())) {
+        const double number = PyFloat_AsDouble(sizeValue.ptr());
+        if (number == -1.0 && PyErr_Occurred()) {
+            PyErr_Clear();
+            throw std::invalid_argument("'containerSize' is out of range");
+        }
+        size = int(number);
+    } else if (PyUnicode_Check(sizeValue.ptr())) {
+        size = PyToQString(sizeValue).toInt();
+    } else {
+        throw std::invalid_argument("'containerSize' must be "
+                                    "a number or string");
+    }
+
+    py::handle addedTime = dictItem(dict, keys.addedTime);
+    if (!addedTime) {
+        throw std::invalid_argument("Missing 'addedTime'");
+    }
+
+    auto container = std::make_unique<Container>(
+        PyToQString(id), static_cast<Container::ContainerSize>(size));
+    Container::ChangeBatch batch(container.get());
+
+    py::handle location = dictItem(dict, keys.containerCurrentLocation);
+    if (location && PyUnicode_Check(location.ptr())) {
+        container->setContainerCurrentLocation(PyToQString(location));
+    } else if (!location || location.is_none()) {
+        container->setContainerCurrentLocation(QStringLiteral("Unknown"));
+    }
+
+    container->setContainerAddedTime(PyToTime(addedTime));
+    if (py::handle leavingTime = dictItem(dict, keys.leavingTime)) {
+        container->setContainerLeavingTime(PyToTime(leavingTime));
+    } else {
+        container->setContainerLeavingTime(std::nan(""));
+    }
+
+    if (py::handle destinations = dictItem(dict, keys.containerNextDestinations)) {
+        container->setContainerNextDestinations(PyToQStringVector(destinations));
+    }
+    if (py::handle history = dictItem(dict, keys.containerMovementHistory)) {
+        container->setContainerMovementHistory(PyToQStringVector(history));
+    }
+
+    py::handle packages = dictItem(dict, keys.packages);
+    if (packages && (PyList_Check(packages.ptr()) || PyTuple_Check(packages.ptr()))) {
+        for (py::handle package : packages) {
+            if (!PyDict_Check(package.ptr())) {
+                continue;
             }
-            jsonObj[key] = customVarsObj;
-            continue;
+            py::handle packageID = dictItem(
+                py::reinterpret_borrow<py::dict>(package), keys.packageID);
+            container->addPackage(ContainerCore::PackageData{
+                packageID && PyUnicode_Check(packageID.ptr())
+                    ? PyToQString(packageID) : QString()});
         }
+    }
 
-        // Handle primitive types and nested objects properly
-        if (py::isinstance<py::bool_>(value)) {
-            jsonObj[key] = value.cast<bool>();
-        } else if (py::isinstance<py::int_>(value)) {
-            jsonObj[key] = value.cast<int>();
-        } else if (py::isinstance<py::float_>(value)) {
-            // Special handling for NaN values
-            double doubleVal = value.cast<double>();
-            if (std::isnan(doubleVal)) {
-                jsonObj[key] = QJsonValue::Null;
-            } else {
-                jsonObj[key] = doubleVal;
+    py::handle customVariables = dictItem(dict, keys.customVariables);
+    if (customVariables && PyDict_Check(customVariables.ptr())) {
+        for (auto haulerItem : py::reinterpret_borrow<py::dict>(customVariables)) {
+            if (!PyDict_Check(haulerItem.second.ptr())) {
+                continue;
+            }
+            const int hauler = PyLong_Check(haulerItem.first.ptr())
+                ? int(PyLong_AsLong(haulerItem.first.ptr()))
+                : PyToQString(haulerItem.first).toInt();
+            for (auto variable : py::reinterpret_borrow<py::dict>(haulerItem.second)) {
+                container->addCustomVariable(
+                    static_cast<Container::HaulerType>(hauler),
+                    PyToQString(variable.first), PyToQVariant(variable.second));
             }
-        } else if (py::isinstance<py::str>(value)) {
-            QString strVal = QString::fromStdString(value.cast<std::string>());
-            // Check if the string is "NaN" and handle appropriately
-            if (strVal.compare(QLatin1String("NaN"), Qt::CaseInsensitive) == 0) {
-                jsonObj[key] = QJsonValue::Null;
+        }
+    }
+
+    return container.release();
+}
+
+// Converts the "containers" list of a map dictionary. Invalid items are
+// skipped with the warnings ContainerMap::addContainers() prints.
+QVector<ContainerCore::Container *> PyDictToContainers(const py::dict &dict) {
+    QVector<ContainerCore::Container *> containers;
+    py::handle items = dictItem(dict, dictKeys().containers);
+    if (!items || !PyList_Check(items.ptr())) {
+        qWarning() << "Failed to add containers: 'containers' "
+                      "key missing or not an array";
+        return containers;
+    }
+
+    containers.reserve(qsizetype(PyList_GET_SIZE(items.ptr())));
+    for (py::handle item : items) {
+        if (!PyDict_Check(item.ptr())) {
+            qWarning() << "Failed to add container: item is not a JSON object";
+            continue;
+        }
+        try {
+            containers.append(PyDictToContainer(py::reinterpret_borrow<py::dict>(item)));
+        } catch (const std::invalid_argument &e) {
+            py::handle id = dictItem(py::reinterpret_borrow<py::dict>(item),
+                                     dictKeys().containerID);
+            qWarning() << "Failed to add container with ID: "
+                       << (id ? PyToQString(id) : QString())
+                       << ". Error: " << e.what();
+        }
+    }
+    return containers;
+}
+
+// Converts the arguments of from_columns; called with the GIL held
+std::pair<ContainerCore::ContainerMap::Columns, QVector<QString>> PyToColumns(
+    const py::object &ids, const py::object &sizes, const py::object &addedTimes,
+    const py::object &leavingTimes, const py::object &locations) {
+    ContainerCore::ContainerMap::Columns columns;
+    columns.ids = PySequenceToQStringList(ids, "ids must be a sequence");
+    columns.sizes = PyToNumericColumn<qint32>(sizes, "sizes");
+    columns.addedTimes = PyToNumericColumn<double>(addedTimes, "added_times");
+    columns.leavingTimes = PyToNumericColumn<double>(leavingTimes, "leaving_times");
+    QVector<QString> qtLocations;
+    if (!locations.is_none()) {
+        qtLocations = PySequenceToQStringList(locations, "locations must be a sequence");
+    }
+    return {std::move(columns), std::move(qtLocations)};
+}
+
+// Gathers the columns with the GIL released; called with the GIL held
+ContainerCore::ContainerMap::Columns columnsWithoutGil(const ContainerMapExt &map) {
+    py::gil_scoped_release release;
+    return map.columns();
+}
+
+// Copies the contents of a bytes object; QByteArray needs its own buffer
+QByteArray PyBytesToQByteArray(const py::bytes &state) {
+    char *data = nullptr;
+    Py_ssize_t size = 0;
+    if (PyBytes_AsStringAndSize(state.ptr(), &data, &size) != 0) {
+        throw py::error_already_set();
+    }
+    return QByteArray(data, qsizetype(size));
+}
+
+// Same reduction that pickle protocol 2 derives from __getstate__: the
+// object is created without __init__ and restored by __setstate__
+py::tuple PickleReduce(const py::object &self) {
+    return py::make_tuple(py::module_::import("copyreg").attr("__newobj__"),
+                          py::make_tuple(py::type::of(self)),
+                          self.attr("__getstate__")());
+}
+
+// Restores a map pickled as a binary snapshot; the result always uses
+// in-memory storage
+ContainerMapExt *ContainerMapFromBytes(const QByteArray &state) {
+    auto map = std::make_unique<ContainerMapExt>();
+    bool loaded = false;
+    {
+        py::gil_scoped_release release;
+        loaded = map->loadBytes(state);
+    }
+    if (!loaded) {
+        throw std::invalid_argument("Invalid ContainerMap state");
+    }
+    return map.release();
+}
+
+// Hands a column over to NumPy without copying it again; the array keeps
+// the vector alive through a capsule
+template <typename T>
+py::array_t<T> QVectorToNumpy(QVector<T> &&values) {
+    auto *owner = new QVector<T>(std::move(values));
+    py::capsule release(owner, [](void *p) {
+        delete static_cast<QVector<T> *>(p);
+    });
+    return py::array_t<T>(owner->size(), owner->constData(), release);
+}
+
+// Container IDs as a NumPy object array of str
+py::array QStringVectorToNumpy(const QVector<QString> &values) {
+    return py::module_::import("numpy").attr("array")(
+        QStringVectorToPyList(values), py::arg("dtype") = "object");
+}
+
+QJsonObject PyDictToQJsonObject(PyObject *dict);
+QJsonArray PySequenceToQJsonArray(PyObject *sequence, const QString &key);
+
+// Python ints become 64-bit JSON integers; larger ones fall back to double
+QJsonValue PyLongToQJsonValue(PyObject *object) {
+    int overflow = 0;
+    const long long integer = PyLong_AsLongLongAndOverflow(object, &overflow);
+    if (overflow) {
+        return QJsonValue(PyLong_AsDouble(object));
+    }
+    return QJsonValue(qint64(integer));
+}
+
+QJsonValue DoubleToQJsonValue(double number) {
+    if (std::isnan(number)) {
+        return QJsonValue(QJsonValue::Null);
+    }
+    return QJsonValue(number);
+}
+
+// Converts one value. The exact built-in types are matched on the type
+// pointer first; subclasses, NumPy scalars and other numbers go through
+// the slower checks below
+QJsonValue PyToQJsonValue(PyObject *object, const QString &key) {
+    PyTypeObject *type = Py_TYPE(object);
+    if (object == Py_None) {
+        return QJsonValue(QJsonValue::Null);
+    } else if (type == &PyBool_Type) {
+        return QJsonValue(object == Py_True);
+    } else if (type == &PyLong_Type) {
+        return PyLongToQJsonValue(object);
+    } else if (type == &PyFloat_Type) {
+        return DoubleToQJsonValue(PyFloat_AS_DOUBLE(object));
+    } else if (type == &PyUnicode_Type) {
+        return QJsonValue(PyToQString(object));
+    } else if (type == &PyDict_Type) {
+        return PyDictToQJsonObject(object);
+    } else if (type == &PyList_Type || type == &PyTuple_Type) {
+        return PySequenceToQJsonArray(object, key);
+    }
+
+    if (PyLong_Check(object)) {
+        return PyLongToQJsonValue(object);
+    } else if (PyFloat_Check(object)) {
+        // Includes numpy.float64
+        return DoubleToQJsonValue(PyFloat_AsDouble(object));
+    } else if (PyUnicode_Check(object)) {
+        return QJsonValue(PyToQString(object));
+    } else if (PyDict_Check(object)) {
+        return PyDictToQJsonObject(object);
+    } else if (PyList_Check(object) || PyTuple_Check(object)) {
+        return PySequenceToQJsonArray(object, key);
+    } else if (IsNumpyBool(object)) {
+        return QJsonValue(PyObject_IsTrue(object) == 1);
+    } else if (PyIndex_Check(object)) {
+        // NumPy integer scalars
+        py::object index = py::reinterpret_steal<py::object>(PyNumber_Index(object));
+        if (index) {
+            return PyLongToQJsonValue(index.ptr());
+        }
+        PyErr_Clear();
+    } else if (type->tp_as_number && type->tp_as_number->nb_float) {
+        // numpy.float32 and other objects with __float__
+        const double number = PyFloat_AsDouble(object);
+        if (!(number == -1.0 && PyErr_Occurred())) {
+            return DoubleToQJsonValue(number);
+        }
+        PyErr_Clear();
+    }
+
+    qWarning() << "Unsupported data type" << type->tp_name << "for key:" << key;
+    return QJsonValue(QJsonValue::Null);
+}
+
+QJsonArray PySequenceToQJsonArray(PyObject *sequence, const QString &key) {
+    const Py_ssize_t size = PySequence_Fast_GET_SIZE(sequence);
+    PyObject **items = PySequence_Fast_ITEMS(sequence);
+    QJsonArray jsonArray;
+    for (Py_ssize_t i = 0; i < size; ++i) {
+        jsonArray.append(PyToQJsonValue(items[i], key));
+    }
+    return jsonArray;
+}
+
+// Keys are usually str; other keys, such as the integer hauler types of
+// customVariables, are converted with str()
+QString PyKeyToQString(PyObject *key) {
+    if (PyUnicode_Check(key)) {
+        return PyToQString(key);
+    }
+    return PyToQString(py::str(key));
+}
+
+QJsonObject PyDictToQJsonObject(PyObject *dict) {
+    const QString customVariablesKey = QStringLiteral("customVariables");
+    QJsonObject jsonObj;
+    PyObject *pyKey = nullptr;
+    PyObject *pyValue = nullptr;
+    Py_ssize_t position = 0;
+    while (PyDict_Next(dict, &position, &pyKey, &pyValue)) {
+        const QString key = PyKeyToQString(pyKey);
+
+        // String values spelling NaN mean "no value" here, as in the JSON
+        // constructors
+        if (PyUnicode_Check(pyValue)) {
+            const QString text = PyToQString(pyValue);
+            if (text.compare(QLatin1String("NaN"), Qt::CaseInsensitive) == 0) {
+                jsonObj.insert(key, QJsonValue::Null);
             } else {
-                jsonObj[key] = strVal;
+                jsonObj.insert(key, text);
             }
-        } else if (py::isinstance<py::list>(value)) {
-            QJsonArray jsonArray;
-            for (py::handle item : value) {
-                py::object item_obj = py::reinterpret_borrow<py::object>(item);
-
-                // Handle None/null in arrays
-                if (item_obj.is_none()) {
-                    jsonArray.append(QJsonValue::Null);
-                    continue;
-                }
+            continue;
+        }
 
-                if (py::isinstance<py::str>(item_obj)) {
-                    jsonArray.append(QString::fromStdString(item_obj.cast<std::string>()));
-                } else if (py::isinstance<py::int_>(item_obj)) {
-                    jsonArray.append(item_obj.cast<int>());
-                } else if (py::isinstance<py::float_>(item_obj)) {
-                    double doubleVal = item_obj.cast<double>();
-                    if (std::isnan(doubleVal)) {
-                        jsonArray.append(QJsonValue::Null);
-                    } else {
-                        jsonArray.append(doubleVal);
-                    }
-                } else if (py::isinstance<py::bool_>(item_obj)) {
-                    jsonArray.append(item_obj.cast<bool>());
-                } else if (py::isinstance<py::dict>(item_obj)) {
-                    // If the list contains a dictionary, convert it to a QJsonObject
-                    jsonArray.append(PyDictToQJsonObject(item_obj.cast<py::dict>()));
-                } else {
-                    qWarning() << "Unsupported data type in list for key:" << key;
-                    jsonArray.append(QJsonValue::Null);
+        // Hauler types map to dictionaries of variables; anything else is
+        // dropped
+        if (key == customVariablesKey && PyDict_Check(pyValue)) {
+            QJsonObject customVarsObj;
+            PyObject *hauler = nullptr;
+            PyObject *variables = nullptr;
+            Py_ssize_t haulerPosition = 0;
+            while (PyDict_Next(pyValue, &haulerPosition, &hauler, &variables)) {
+                if (PyDict_Check(variables)) {
+                    customVarsObj.insert(PyKeyToQString(hauler), PyDictToQJsonObject(variables));
                 }
             }
-            jsonObj[key] = jsonArray;
-        } else if (py::isinstance<py::dict>(value)) {
-            jsonObj[key] = PyDictToQJsonObject(value.cast<py::dict>());
-        } else {
-            qWarning() << "Unsupported data type for key:" << key;
-            jsonObj[key] = QJsonValue::Null;  // Use null for unsupported types
+            jsonObj.insert(key, customVarsObj);
+            continue;
         }
+
+        jsonObj.insert(key, PyToQJsonValue(pyValue, key));
     }
     return jsonObj;
 }
 
+// Helper function to convert Python dict to QJsonObject
+QJsonObject PyDictToQJsonObject(const py::dict &pyDict) {
+    return PyDictToQJsonObject(pyDict.ptr());
+}
+
+// Walks a ContainerMap in ID order, fetching one page at a time so that
+// database-backed maps are never loaded as a whole
+class ContainerMapIterator
+{
+public:
+    enum Kind {
+        Keys,
+        Values,
+        Items
+    };
+
+    // Small enough to stay within the map's container cache
+    static constexpr std::size_t PageSize = 128;
+
+    ContainerMapIterator(py::object owner, Kind kind,
+                         const ContainerCore::ContainerMap::PageFilter &filter = {})
+        : mOwner(std::move(owner)),
+          mMap(mOwner.cast<ContainerMapExt &>()),
+          mKind(kind),
+          mFilter(filter)
+    {}
+
+    py::object next() {
+        if (mPosition == pageSize()) {
+            fetch();
+            if (mPosition == pageSize()) {
+                throw py::stop_iteration();
+            }
+        }
+
+        const std::size_t index = mPosition++;
+        if (mKind == Keys) {
+            return py::str(mIDs[index]);
+        }
+        if (mKind == Values) {
+            return mContainers[index];
+        }
+        return py::make_tuple(py::str(mIDs[index]), mContainers[index]);
+    }
+
+private:
+    std::size_t pageSize() const {
+        return mIDs.size();
+    }
+
+    void fetch() {
+        if (mExhausted) {
+            return;
+        }
+        mPosition = 0;
+        std::vector<ContainerExt *> containers;
+        {
+            py::gil_scoped_release release;
+            if (mKind == Keys) {
+                mIDs = mMap.getContainerIDsPage(mLastID, PageSize);
+            } else {
+                containers = mMap.getContainersPage(mLastID, PageSize, mFilter);
+                mIDs.clear();
+                mIDs.reserve(containers.size());
+                for (ContainerExt *container : containers) {
+                    mIDs.push_back(container->getContainerID());
+                }
+            }
+            if (!mIDs.empty()) {
+                mLastID = mIDs.back();
+            }
+        }
+        // Python owns the wrappers, so a page is freed once the caller
+        // drops its containers and the walk runs in constant memory
+        mContainers.clear();
+        mContainers.reserve(containers.size());
+        for (ContainerExt *container : containers) {
+            mContainers.push_back(py::cast(container, py::return_value_policy::take_ownership));
+        }
+        // Only an empty page ends the walk, so IDs added past the
+        // current position are still visited
+        mExhausted = pageSize() == 0;
+    }
+
+    py::object mOwner;
+    ContainerMapExt &mMap;
+    Kind mKind;
+    ContainerCore::ContainerMap::PageFilter mFilter;
+    std::string mLastID;
+    std::vector<std::string> mIDs;
+    std::vector<py::object> mContainers;
+    std::size_t mPosition = 0;
+    bool mExhausted = false;
+};
+
+ContainerCore::ContainerMap::PageFilter TimePageFilter(
+    ContainerCore::ContainerMap::PageFilter::Field field,
+    const std::string &condition, double referenceTime) {
+    ContainerCore::ContainerMap::PageFilter filter;
+    filter.field = field;
+    filter.condition = QString::fromStdString(condition);
+    filter.referenceTime = referenceTime;
+    return filter;
+}
+
+// Worker pool for the *_async methods. Never destroyed: a task may drop
+// the last reference to a map, and a pool cannot wait for itself
+QThreadPool &AsyncPool() {
+    static QThreadPool *pool = new QThreadPool();
+    return *pool;
+}
+
+// Python state of one async call; only touched with the GIL held
+struct AsyncCall {
+    py::object owner;
+    py::object args;
+    py::object loop;
+    py::object future;
+};
+
+// Runs work(map) on the async pool and returns an asyncio future. The
+// result is converted and set on the event loop's thread through
+// call_soon_threadsafe; a C++ exception becomes a RuntimeError. Must be
+// called from a running event loop. args keeps Python inputs alive while
+// the work runs. If the future was cancelled meanwhile, the converted
+// result is passed to cancelled(result, owner), e.g. to undo a dequeue.
+template <typename Work, typename Convert, typename Cancelled = std::nullptr_t>
+py::object RunAsync(const py::object &owner, Work work, Convert convert,
+                    const py::object &args = py::none(),
+                    Cancelled cancelled = nullptr) {
+    ContainerMapExt *map = owner.cast<ContainerMapExt *>();
+    py::object loop = py::module_::import("asyncio").attr("get_running_loop")();
+    py::object future = loop.attr("create_future")();
+    auto *call = new AsyncCall{owner, args, loop, future};
+
+    AsyncPool().start([call, map, work, convert, cancelled]() {
+        using Result = decltype(work(*map));
+        auto result = std::make_shared<std::optional<Result>>();
+        std::string error;
+        try {
+            result->emplace(work(*map));
+        } catch (const std::exception &e) {
+            error = e.what();
+        }
+
+        py::gil_scoped_acquire acquire;
+        std::unique_ptr<AsyncCall> state(call);
+        try {
+            py::cpp_function resolve(
+                [owner = state->owner, future = state->future, result, error, convert,
+                 cancelled]() {
+                    // Skip futures cancelled while the work was running,
+                    // still converting so that handed-over wrappers are freed
+                    if (future.attr("done")().cast<bool>()) {
+                        if (error.empty()) {
+                            py::object value = convert(std::move(**result), owner);
+                            if constexpr (!std::is_same_v<Cancelled, std::nullptr_t>) {
+                                cancelled(value, owner);
+                            }
+                        }
+                        return;
+                    }
+                    if (!error.empty()) {
+                        future.attr("set_exception")(
+                            py::reinterpret_borrow<py::object>(PyExc_RuntimeError)(error));
+                        return;
+                    }
+                    future.attr("set_result")(convert(std::move(**result), owner));
+                });
+            state->loop.attr("call_soon_threadsafe")(resolve);
+        } catch (py::error_already_set &e) {
+            // The loop was closed before the work finished
+            e.discard_as_unraisable("ContainerMap async call");
+        }
+    });
+    return future;
+}
+
+// Converts query results; Python owns the wrappers
+py::object ContainersToPy(std::vector<ContainerExt *> &&containers, const py::object &) {
+    return py::cast(std::move(containers), py::return_value_policy::take_ownership);
+}
+
+// Puts the containers of a cancelled dequeue back into the map
+void RestoreDequeued(const py::object &containers, const py::object &owner) {
+    auto items = containers.cast<std::vector<ContainerExt *>>();
+    ContainerMapExt &map = owner.cast<ContainerMapExt &>();
+    py::gil_scoped_release release;
+    map.restoreContainers(items);
+}
+
+// Converts plain results such as counts and success flags
+template <typename T>
+py::object ValueToPy(T &&value, const py::object &) {
+    return py::cast(std::forward<T>(value));
+}
+
 PYBIND11_MODULE(ContainerPy, m) {
     m.doc() = "Pybind11 plugin for Container library";
 
@@ -192,7 +1021,7 @@ PYBIND11_MODULE(ContainerPy, m) {
              py::arg("size"),
              "Constructor that initializes a Container with a specified size.")
         .def(py::init([](const py::dict &pyDict) {
-                 return ContainerExt(PyDictToQJsonObject(pyDict));
+                 return new ContainerExt(PyDictToContainer(pyDict));
              }), py::arg("json_dict"),
              "Constructor that initializes a Package from a Python dictionary.")
         .def("get_container_id", &ContainerExt::getContainerID)
@@ -254,7 +1083,21 @@ PYBIND11_MODULE(ContainerPy, m) {
         .def("to_json", [](ContainerExt &self) {
                 return ContainerExtToPyDict(self);
             }, "Extract Container information to a Python dictionary")
-        .def("copy", &ContainerExt::copy, py::return_value_policy::reference);
+        .def("copy", &ContainerExt::copy, py::return_value_policy::reference)
+        .def(py::pickle(
+            [](const ContainerExt &self) {
+                const QByteArray state = self.toBytes();
+                if (state.isEmpty()) {
+                    // A wrapper whose container is gone has no state
+                    throw std::runtime_error("Failed to serialize the Container");
+                }
+                return py::bytes(state.constData(), state.size());
+            },
+            [](const py::bytes &state) {
+                return new ContainerExt(ContainerExt::fromBytes(PyBytesToQByteArray(state)));
+            }))
+        .def("__reduce__", &PickleReduce,
+             "Reduce to the class and the binary state for pickle and copy.");
 
 
     // Binding the ContainerSize enum
@@ -281,11 +1124,17 @@ PYBIND11_MODULE(ContainerPy, m) {
         .value("NoHauler", ContainerExt::HaulerType::noHauler)
         .export_values();
 
+    py::class_<ContainerMapIterator>(m, "ContainerMapIterator")
+        .def("__iter__", [](ContainerMapIterator &self) -> ContainerMapIterator & {
+                return self;
+            })
+        .def("__next__", &ContainerMapIterator::next);
+
     py::class_<ContainerMapExt>(m, "ContainerMap")
         .def(py::init<>())
         .def(py::init<const std::string &>())
         .def(py::init([](const py::dict &pyDict) {
-                 return ContainerMapExt(PyDictToQJsonObject(pyDict));
+                 return new ContainerMapExt(PyDictToQJsonObject(pyDict));
              }), py::arg("json_dict"),
              "Constructor that initializes a Package from a Python dictionary.")
         .def("add_container",
@@ -306,7 +1155,8 @@ PYBIND11_MODULE(ContainerPy, m) {
                 }
 
                 self.addContainer(container, mAT, mLT);
-            }, py::arg("container"), py::arg("addingTime") = std::nan(""), py::arg("leavingTime") = std::nan(""))
+            }, py::arg("container"), py::arg("addingTime") = std::nan(""), py::arg("leavingTime") = std::nan(""),
+            py::call_guard<py::gil_scoped_release>())
         .def("add_containers",
             [](ContainerMapExt &self, const std::vector<ContainerExt*> &containers, double addingTime, double leavingTime) {
                 // Check if addingTime is NaN and pass it to the C++ function accordingly
@@ -324,11 +1174,12 @@ PYBIND11_MODULE(ContainerPy, m) {
                     mLT = leavingTime;
                 }
                 self.addContainers(containers, mAT, mLT);
-            }, py::arg("containers"), py::arg("addingTime") = std::nan(""), py::arg("leavingTime") = std::nan(""))
+            }, py::arg("containers"), py::arg("addingTime") = std::nan(""), py::arg("leavingTime") = std::nan(""),
+            py::call_guard<py::gil_scoped_release>())
         .def("add_containers_from_dict",
             [](ContainerMapExt &self, const py::dict &pyDict, double addingTime, double leavingTime) {
-                // Convert the Python dictionary to a QJsonObject
-                QJsonObject jsonObj = PyDictToQJsonObject(pyDict);
+                // Build the containers straight from the dictionaries
+                QVector<ContainerCore::Container *> containers = PyDictToContainers(pyDict);
                 double mAT = 0;
                 double mLT = 0;
                 if (std::isnan(addingTime)) {
@@ -342,42 +1193,305 @@ PYBIND11_MODULE(ContainerPy, m) {
                 } else {
                     mLT = leavingTime;
                 }
-                self.addContainers(jsonObj, mAT, mLT);
+                // The dictionary is converted; the rest is pure C++
+                py::gil_scoped_release release;
+                self.addContainers(containers, mAT, mLT);
             }, py::arg("json_dict"), py::arg("addingTime") = std::nan(""), py::arg("leavingTime") = std::nan(""),
             "Add multiple containers to the ContainerMap from a JSON-like Python dictionary.")
-        .def("remove_container_by_id", &ContainerMapExt::removeContainerByID)
-        .def("get_all_containers", &ContainerMapExt::getAllContainers, py::return_value_policy::reference)
-        .def("get_container_by_id", &ContainerMapExt::getContainerByID, py::return_value_policy::reference)
-        .def("get_latest_containers", &ContainerMapExt::getLatestContainers, py::return_value_policy::reference)
-        .def("size", &ContainerMapExt::size, py::return_value_policy::copy)
+        .def_static("from_columns",
+            [](const py::object &ids, const py::object &sizes, const py::object &addedTimes,
+               const py::object &leavingTimes, const py::object &locations) {
+                auto input = PyToColumns(ids, sizes, addedTimes, leavingTimes, locations);
+                auto map = std::make_unique<ContainerMapExt>();
+                {
+                    py::gil_scoped_release release;
+                    map->addContainersFromColumns(input.first, input.second);
+                }
+                return map.release();
+            }, py::arg("ids"), py::arg("sizes") = py::none(), py::arg("added_times") = py::none(),
+            py::arg("leaving_times") = py::none(), py::arg("locations") = py::none(),
+            py::return_value_policy::take_ownership,
+            "Create an in-memory ContainerMap from columns (NumPy arrays, Arrow arrays or lists), one row per container.")
+        .def("add_containers_from_columns",
+            [](ContainerMapExt &self, const py::object &ids, const py::object &sizes,
+               const py::object &addedTimes, const py::object &leavingTimes, const py::object &locations) {
+                auto input = PyToColumns(ids, sizes, addedTimes, leavingTimes, locations);
+                py::gil_scoped_release release;
+                return self.addContainersFromColumns(input.first, input.second);
+            }, py::arg("ids"), py::arg("sizes") = py::none(), py::arg("added_times") = py::none(),
+            py::arg("leaving_times") = py::none(), py::arg("locations") = py::none(),
+            "Add containers built from columns, one row per container; returns the number added.")
+        .def("remove_container_by_id", &ContainerMapExt::removeContainerByID,
+             py::call_guard<py::gil_scoped_release>())
+        .def("set_containers_current_location",
+            [](ContainerMapExt &self, const py::object &ids, const py::object &locations) {
+                const QStringList qtIDs = PySequenceToQStringList(ids, "ids must be a sequence");
+                const QStringList qtLocations = PySequenceToQStringList(locations, "locations must be a sequence");
+                py::gil_scoped_release release;
+                return self.setContainersCurrentLocation(qtIDs, qtLocations);
+            }, py::arg("ids"), py::arg("locations"),
+            "Set the current location of many containers in one call; returns the number updated.")
+        .def("add_containers_destination",
+            [](ContainerMapExt &self, const py::object &ids, const py::object &destinations) {
+                const QStringList qtIDs = PySequenceToQStringList(ids, "ids must be a sequence");
+                const QStringList qtDestinations = PySequenceToQStringList(destinations, "destinations must be a sequence");
+                py::gil_scoped_release release;
+                return self.addContainersDestination(qtIDs, qtDestinations);
+            }, py::arg("ids"), py::arg("destinations"),
+            "Append a next destination to many containers in one call; returns the number updated.")
+        .def("add_containers_custom_variable",
+            [](ContainerMapExt &self, const py::object &ids, int hauler,
+               const std::string &key, const py::object &values) {
+                const QStringList qtIDs = PySequenceToQStringList(ids, "ids must be a sequence");
+                const QVariantList qtValues = PyToQVariantList(values);
+                const QString qtKey = QString::fromStdString(key);
+                py::gil_scoped_release release;
+                return self.addContainersCustomVariable(
+                    qtIDs, static_cast<ContainerCore::Container::HaulerType>(hauler), qtKey, qtValues);
+            }, py::arg("ids"), py::arg("hauler"), py::arg("key"), py::arg("values"),
+            "Set a custom variable on many containers in one call; returns the number updated.")
+        .def("get_all_containers", &ContainerMapExt::getAllContainers, py::return_value_policy::take_ownership,
+             py::call_guard<py::gil_scoped_release>())
+        .def("get_container_by_id", &ContainerMapExt::getContainerByID, py::return_value_policy::take_ownership,
+             py::keep_alive<0, 1>(), py::call_guard<py::gil_scoped_release>())
+        .def("get_latest_containers", &ContainerMapExt::getLatestContainers, py::return_value_policy::take_ownership,
+             py::call_guard<py::gil_scoped_release>())
+        .def("size", &ContainerMapExt::size, py::return_value_policy::copy,
+             py::call_guard<py::gil_scoped_release>())
+        .def("__len__", &ContainerMapExt::size,
+             py::call_guard<py::gil_scoped_release>())
+        .def("__contains__", &ContainerMapExt::containsContainer, py::arg("id"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("__getitem__", [](ContainerMapExt &self, const std::string &id) {
+                ContainerExt *container = nullptr;
+                {
+                    py::gil_scoped_release release;
+                    container = self.getContainerByID(id);
+                }
+                if (!container) {
+                    throw py::key_error(id);
+                }
+                return container;
+            }, py::arg("id"), py::return_value_policy::take_ownership, py::keep_alive<0, 1>())
+        .def("__iter__", [](py::object self) {
+                return new ContainerMapIterator(std::move(self), ContainerMapIterator::Keys);
+            }, py::return_value_policy::take_ownership,
+            "Iterate over the container IDs in ascending order, one page at a time.")
+        .def("keys", [](py::object self) {
+                return new ContainerMapIterator(std::move(self), ContainerMapIterator::Keys);
+            }, py::return_value_policy::take_ownership,
+            "Iterate lazily over the container IDs in ascending order.")
+        .def("values", [](py::object self) {
+                return new ContainerMapIterator(std::move(self), ContainerMapIterator::Values);
+            }, py::return_value_policy::take_ownership,
+            "Iterate lazily over the containers in ID order.")
+        .def("items", [](py::object self) {
+                return new ContainerMapIterator(std::move(self), ContainerMapIterator::Items);
+            }, py::return_value_policy::take_ownership,
+            "Iterate lazily over (id, container) pairs in ID order.")
+        .def("iter_containers_by_added_time",
+             [](py::object self, const std::string &condition, double referenceTime) {
+                return new ContainerMapIterator(
+                    std::move(self), ContainerMapIterator::Values,
+                    TimePageFilter(ContainerCore::ContainerMap::PageFilter::AddedTime,
+                                   condition, referenceTime));
+             }, py::arg("condition"), py::arg("referenceTime"),
+             py::return_value_policy::take_ownership,
+             "Lazy variant of get_containers_by_added_time, in ID order.")
+        .def("iter_containers_by_leaving_time",
+             [](py::object self, const std::string &condition, double referenceTime) {
+                return new ContainerMapIterator(
+                    std::move(self), ContainerMapIterator::Values,
+                    TimePageFilter(ContainerCore::ContainerMap::PageFilter::LeavingTime,
+                                   condition, referenceTime));
+             }, py::arg("condition"), py::arg("referenceTime"),
+             py::return_value_policy::take_ownership,
+             "Lazy variant of get_containers_by_leaving_time, in ID order.")
+        .def("iter_containers_by_next_destination",
+             [](py::object self, const std::string &destination) {
+                ContainerCore::ContainerMap::PageFilter filter;
+                filter.field = ContainerCore::ContainerMap::PageFilter::NextDestination;
+                filter.destination = QString::fromStdString(destination);
+                return new ContainerMapIterator(std::move(self), ContainerMapIterator::Values, filter);
+             }, py::arg("destination"),
+             py::return_value_policy::take_ownership,
+             "Lazy variant of get_containers_by_next_destination, in ID order.")
+        .def("added_times", [](const ContainerMapExt &self) {
+                return QVectorToNumpy(std::move(columnsWithoutGil(self).addedTimes));
+            }, "Return the added times of all containers as a float64 NumPy array (NaN if unset).")
+        .def("leaving_times", [](const ContainerMapExt &self) {
+                return QVectorToNumpy(std::move(columnsWithoutGil(self).leavingTimes));
+            }, "Return the leaving times of all containers as a float64 NumPy array (NaN if unset).")
+        .def("sizes", [](const ContainerMapExt &self) {
+                return QVectorToNumpy(std::move(columnsWithoutGil(self).sizes));
+            }, "Return the ContainerSize values of all containers as an int32 NumPy array.")
+        .def("ids", [](const ContainerMapExt &self) {
+                return QStringVectorToNumpy(columnsWithoutGil(self).ids);
+            }, "Return the IDs of all containers as a NumPy object array.")
+        .def("columns", [](const ContainerMapExt &self) {
+                auto columns = columnsWithoutGil(self);
+                py::dict result;
+                result["ids"] = QStringVectorToNumpy(columns.ids);
+                result["sizes"] = QVectorToNumpy(std::move(columns.sizes));
+                result["added_times"] = QVectorToNumpy(std::move(columns.addedTimes));
+                result["leaving_times"] = QVectorToNumpy(std::move(columns.leavingTimes));
+                return result;
+            }, "Return ids, sizes, added_times and leaving_times as NumPy arrays gathered in one pass.")
         .def("get_containers_by_added_time",
              &ContainerMapExt::getContainersByAddedTime,
-             py::arg("condition"), py::arg("referenceTime"), py::return_value_policy::reference)
+             py::arg("condition"), py::arg("referenceTime"), py::return_value_policy::take_ownership,
+             py::call_guard<py::gil_scoped_release>())
         .def("dequeue_containers_by_added_time", &ContainerMapExt::dequeueContainersByAddedTime,
-             py::arg("condition"), py::arg("referenceTime"), py::return_value_policy::reference)
+             py::arg("condition"), py::arg("referenceTime"), py::return_value_policy::take_ownership,
+             py::call_guard<py::gil_scoped_release>())
         .def("count_containers_by_added_time", &ContainerMapExt::countContainersByAddedTime,
-             py::arg("condition"), py::arg("referenceTime"))
+             py::arg("condition"), py::arg("referenceTime"),
+             py::call_guard<py::gil_scoped_release>())
         .def("get_containers_by_leaving_time",
              &ContainerMapExt::getContainersByLeavingTime,
-             py::arg("condition"), py::arg("referenceTime"), py::return_value_policy::reference)
+             py::arg("condition"), py::arg("referenceTime"), py::return_value_policy::take_ownership,
+             py::call_guard<py::gil_scoped_release>())
         .def("dequeue_containers_by_leaving_time", &ContainerMapExt::dequeueContainersByLeavingTime,
-             py::arg("condition"), py::arg("referenceTime"), py::return_value_policy::reference)
+             py::arg("condition"), py::arg("referenceTime"), py::return_value_policy::take_ownership,
+             py::call_guard<py::gil_scoped_release>())
         .def("count_containers_by_leaving_time", &ContainerMapExt::countContainersByLeavingTime,
-             py::arg("condition"), py::arg("referenceTime"))
-        .def("get_containers_by_next_destination", &ContainerMapExt::getContainersByNextDestination, py::return_value_policy::reference)
-        .def("dequeue_containers_by_next_destination", &ContainerMapExt::dequeueContainerByNextDestination, py::return_value_policy::reference)
-        .def("count_containers_by_next_destination", &ContainerMapExt::countContainersByNextDestination)
+             py::arg("condition"), py::arg("referenceTime"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("get_containers_by_next_destination", &ContainerMapExt::getContainersByNextDestination, py::return_value_policy::take_ownership,
+             py::call_guard<py::gil_scoped_release>())
+        .def("dequeue_containers_by_next_destination", &ContainerMapExt::dequeueContainerByNextDestination, py::return_value_policy::take_ownership,
+             py::call_guard<py::gil_scoped_release>())
+        .def("count_containers_by_next_destination", &ContainerMapExt::countContainersByNextDestination,
+             py::call_guard<py::gil_scoped_release>())
         .def("to_json", [](ContainerMapExt &self) {
                 return ContainerMapExtToPyDict(self);
             }, "Extract ContainerMap information to a Python dictionary")
-        .def("clear", &ContainerMapExt::clear)
+        .def("clear", &ContainerMapExt::clear,
+             py::call_guard<py::gil_scoped_release>())
+        .def("save_snapshot", &ContainerMapExt::saveSnapshot, py::arg("path"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Write all containers to a binary snapshot file; returns False on failure.")
+        .def("load_snapshot", &ContainerMapExt::loadSnapshot, py::arg("path"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Replace the contents with a binary snapshot file; returns False on failure.")
+        // Awaitable variants; the work runs on a C++ thread pool
+        .def("get_containers_by_added_time_async",
+             [](const py::object &self, const std::string &condition, double referenceTime) {
+                return RunAsync(self, [condition, referenceTime](ContainerMapExt &map) {
+                    return map.getContainersByAddedTime(condition, referenceTime);
+                }, &ContainersToPy);
+             }, py::arg("condition"), py::arg("referenceTime"))
+        .def("dequeue_containers_by_added_time_async",
+             [](const py::object &self, const std::string &condition, double referenceTime) {
+                return RunAsync(self, [condition, referenceTime](ContainerMapExt &map) {
+                    return map.dequeueContainersByAddedTime(condition, referenceTime);
+                }, &ContainersToPy, py::none(), &RestoreDequeued);
+             }, py::arg("condition"), py::arg("referenceTime"))
+        .def("count_containers_by_added_time_async",
+             [](const py::object &self, const std::string &condition, double referenceTime) {
+                return RunAsync(self, [condition, referenceTime](ContainerMapExt &map) {
+                    return map.countContainersByAddedTime(condition, referenceTime);
+                }, &ValueToPy<std::size_t>);
+             }, py::arg("condition"), py::arg("referenceTime"))
+        .def("get_containers_by_leaving_time_async",
+             [](const py::object &self, const std::string &condition, double referenceTime) {
+                return RunAsync(self, [condition, referenceTime](ContainerMapExt &map) {
+                    return map.getContainersByLeavingTime(condition, referenceTime);
+                }, &ContainersToPy);
+             }, py::arg("condition"), py::arg("referenceTime"))
+        .def("dequeue_containers_by_leaving_time_async",
+             [](const py::object &self, const std::string &condition, double referenceTime) {
+                return RunAsync(self, [condition, referenceTime](ContainerMapExt &map) {
+                    return map.dequeueContainersByLeavingTime(condition, referenceTime);
+                }, &ContainersToPy, py::none(), &RestoreDequeued);
+             }, py::arg("condition"), py::arg("referenceTime"))
+        .def("count_containers_by_leaving_time_async",
+             [](const py::object &self, const std::string &condition, double referenceTime) {
+                return RunAsync(self, [condition, referenceTime](ContainerMapExt &map) {
+                    return map.countContainersByLeavingTime(condition, referenceTime);
+                }, &ValueToPy<std::size_t>);
+             }, py::arg("condition"), py::arg("referenceTime"))
+        .def("get_containers_by_next_destination_async",
+             [](const py::object &self, const std::string &destination) {
+                return RunAsync(self, [destination](ContainerMapExt &map) {
+                    return map.getContainersByNextDestination(destination);
+                }, &ContainersToPy);
+             }, py::arg("destination"))
+        .def("dequeue_containers_by_next_destination_async",
+             [](const py::object &self, const std::string &destination) {
+                return RunAsync(self, [destination](ContainerMapExt &map) {
+                    return map.dequeueContainerByNextDestination(destination);
+                }, &ContainersToPy, py::none(), &RestoreDequeued);
+             }, py::arg("destination"))
+        .def("count_containers_by_next_destination_async",
+             [](const py::object &self, const std::string &destination) {
+                return RunAsync(self, [destination](ContainerMapExt &map) {
+                    return map.countContainersByNextDestination(destination);
+                }, &ValueToPy<std::size_t>);
+             }, py::arg("destination"))
+        .def("add_containers_async",
+             [](const py::object &self, const py::list &containers, double addingTime, double leavingTime) {
+                // The list keeps the Python-owned containers alive meanwhile
+                auto items = containers.cast<std::vector<ContainerExt *>>();
+                return RunAsync(self, [items, addingTime, leavingTime](ContainerMapExt &map) {
+                    map.addContainers(items, addingTime, leavingTime);
+                    return items.size();
+                }, &ValueToPy<std::size_t>, containers);
+             }, py::arg("containers"), py::arg("addingTime") = std::nan(""), py::arg("leavingTime") = std::nan(""))
+        .def("add_containers_from_dict_async",
+             [](const py::object &self, const py::dict &pyDict, double addingTime, double leavingTime) {
+                QVector<ContainerCore::Container *> containers = PyDictToContainers(pyDict);
+                return RunAsync(self, [containers, addingTime, leavingTime](ContainerMapExt &map) {
+                    map.addContainers(containers, addingTime, leavingTime);
+                    return std::size_t(containers.size());
+                }, &ValueToPy<std::size_t>);
+             }, py::arg("json_dict"), py::arg("addingTime") = std::nan(""), py::arg("leavingTime") = std::nan(""))
+        .def("add_containers_from_columns_async",
+             [](const py::object &self, const py::object &ids, const py::object &sizes,
+                const py::object &addedTimes, const py::object &leavingTimes, const py::object &locations) {
+                auto input = PyToColumns(ids, sizes, addedTimes, leavingTimes, locations);
+                return RunAsync(self, [input](ContainerMapExt &map) {
+                    return map.addContainersFromColumns(input.first, input.second);
+                }, &ValueToPy<std::size_t>);
+             }, py::arg("ids"), py::arg("sizes") = py::none(), py::arg("added_times") = py::none(),
+             py::arg("leaving_times") = py::none(), py::arg("locations") = py::none())
+        .def("save_snapshot_async",
+             [](const py::object &self, const std::string &path) {
+                return RunAsync(self, [path](ContainerMapExt &map) {
+                    return map.saveSnapshot(path);
+                }, &ValueToPy<bool>);
+             }, py::arg("path"))
+        .def("load_snapshot_async",
+             [](const py::object &self, const std::string &path) {
+                return RunAsync(self, [path](ContainerMapExt &map) {
+                    return map.loadSnapshot(path);
+                }, &ValueToPy<bool>);
+             }, py::arg("path"))
+        .def(py::pickle(
+            [](const ContainerMapExt &self) {
+                QByteArray state;
+                {
+                    py::gil_scoped_release release;
+                    state = self.toBytes();
+                }
+                if (state.isEmpty()) {
+                    throw std::runtime_error("Failed to serialize the ContainerMap");
+                }
+                return py::bytes(state.constData(), state.size());
+            },
+            [](const py::bytes &state) {
+                return ContainerMapFromBytes(PyBytesToQByteArray(state));
+            }))
+        .def("__reduce__", &PickleReduce,
+             "Reduce to the class and the binary state for pickle and copy.")
         .def_static("load_containers_from_json",
                     [](const py::dict &pyDict) {
                         QJsonObject jsonObj = PyDictToQJsonObject(pyDict);
+                        py::gil_scoped_release release;
                         return ContainerMapExt::loadContainersFromJson(jsonObj);
                     },
                     py::arg("json_dict"),
-                    py::return_value_policy::reference,
+                    py::return_value_policy::take_ownership,
                     "Load containers from a JSON dictionary and return them as a list of Container objects"
                     );
 
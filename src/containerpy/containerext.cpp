@@ -2,6 +2,9 @@
 #include "containerLib/container.h"
 #include "containerLib/package.h"
 #include "packageext.h"
+#include <QDataStream>
+#include <memory>
+#include <stdexcept>
 
 ContainerExt::ContainerExt(const std::string &id, ContainerSize size)
 {
@@ -14,48 +17,115 @@ ContainerExt::ContainerExt(const QJsonObject &json)
 }
 
 ContainerExt::~ContainerExt() {
+    // Untrack first so the map does not react to our own delete
+    releaseFromMap();
     cleanup();
 }
 
 ContainerExt::ContainerExt(const ContainerExt &other)
 {
-    mContainer = new ContainerCore::Container(*other.mContainer);
+    mContainer = new ContainerCore::Container(*other.container());
 }
 
-ContainerExt::ContainerExt(ContainerCore::Container *other)
+ContainerExt::ContainerExt(ContainerCore::Container *other, bool ownsContainer)
+    : mOwnsContainer(ownsContainer)
 {
     mContainer = other;
 }
 
 ContainerExt& ContainerExt::operator=(const ContainerExt &other) {
     if (this != &other) {
+        // The copy is ours, so the map no longer tracks this wrapper
+        releaseFromMap();
         cleanup();
-        mContainer = new ContainerCore::Container(*other.mContainer);
+        mContainer = new ContainerCore::Container(*other.container());
+        mOwnsContainer = true;
     }
     return *this;
 }
 
 void ContainerExt::cleanup() {
-    if (mContainer) {
+    if (mContainer && mOwnsContainer) {
         delete mContainer;
-        mContainer = nullptr;
     }
+    mContainer = nullptr;
+}
+
+bool ContainerExt::ownsContainer() const
+{
+    return mOwnsContainer;
+}
+
+void ContainerExt::setOwnsContainer(bool owns)
+{
+    mOwnsContainer = owns;
+}
+
+void ContainerExt::detach()
+{
+    mContainer = nullptr;
+    mOwnsContainer = false;
+}
+
+void ContainerExt::attach(ContainerCore::Container *container)
+{
+    mContainer = container;
+    mOwnsContainer = false;
+}
+
+bool ContainerExt::isAttached() const
+{
+    return mContainer != nullptr;
+}
+
+void ContainerExt::setMapHooks(std::function<void()> reattach,
+                               std::function<void(ContainerExt *)> released)
+{
+    mReattach = std::move(reattach);
+    mReleased = std::move(released);
+}
+
+void ContainerExt::clearMapHooks()
+{
+    mReattach = nullptr;
+    mReleased = nullptr;
+}
+
+void ContainerExt::releaseFromMap()
+{
+    // The map clears the hooks while it runs, so call a local copy
+    std::function<void(ContainerExt *)> released;
+    released.swap(mReleased);
+    mReattach = nullptr;
+    if (released) {
+        released(this);
+    }
+}
+
+ContainerCore::Container *ContainerExt::container() const
+{
+    if (!mContainer && mReattach) {
+        // A copy, as the map may clear the hooks while this runs
+        const std::function<void()> reattach = mReattach;
+        reattach();
+    }
+    return mContainer;
 }
 
 std::string ContainerExt::getContainerID() const {
-    return mContainer ? mContainer->getContainerID().toStdString() : "";
+    return container() ? container()->getContainerID().toStdString() : "";
 }
 
 void ContainerExt::setContainerID(const std::string &id) {
-    if (mContainer) {
-        mContainer->setContainerID(QString::fromStdString(id));
+    if (container()) {
+        container()->setContainerID(QString::fromStdString(id));
     }
 }
 
 double ContainerExt::getContainerAddedTime() const
 {
-    if (mContainer) {
-        return mContainer->getContainerAddedTime();
+    if (container()) {
+        return container()->getContainerAddedTime();
     }
 
     return std::nan("containerNotDefined");
@@ -63,15 +133,15 @@ double ContainerExt::getContainerAddedTime() const
 
 void ContainerExt::setContainerAddedTime(double &time)
 {
-    if (mContainer) {
-        mContainer->setContainerAddedTime(time);
+    if (container()) {
+        container()->setContainerAddedTime(time);
     }
 }
 
 double ContainerExt::getContainerLeavingTime() const
 {
-    if (mContainer) {
-        return mContainer->getContainerLeavingTime();
+    if (container()) {
+        return container()->getContainerLeavingTime();
     }
 
     return std::nan("containerNotDefined");
@@ -79,48 +149,48 @@ double ContainerExt::getContainerLeavingTime() const
 
 void ContainerExt::setContainerLeavingTime(double &time)
 {
-    if (mContainer) {
-        mContainer->setContainerLeavingTime(time);
+    if (container()) {
+        container()->setContainerLeavingTime(time);
     }
 }
 
 ContainerExt::ContainerSize ContainerExt::getContainerSize() const
 {
-    return static_cast<ContainerExt::ContainerSize>(mContainer->getContainerSize());
+    return static_cast<ContainerExt::ContainerSize>(container()->getContainerSize());
 }
 
 void ContainerExt::setContainerSize(ContainerSize size)
 {
-    mContainer->setContainerSize(static_cast<ContainerCore::Container::ContainerSize>(size));
+    container()->setContainerSize(static_cast<ContainerCore::Container::ContainerSize>(size));
 }
 
 std::vector<PackageExt*> ContainerExt::getPackages() const {
     std::vector<PackageExt*> stdPackages;
-    if (mContainer) {
-        QVector<ContainerCore::Package*> qtPackages = mContainer->getPackages();
-        for (ContainerCore::Package* package : qtPackages) {
-            PackageExt* ext = new PackageExt(*package);
-            if (ext) {
-                stdPackages.push_back(ext);
-            }
+    if (container()) {
+        stdPackages.reserve(container()->packageCount());
+        for (const ContainerCore::PackageData &package :
+             container()->packagesView()) {
+            stdPackages.push_back(
+                new PackageExt(new ContainerCore::Package(package)));
         }
     }
     return stdPackages;
 }
 
 void ContainerExt::setPackages(const std::vector<PackageExt*>& stdPackages) {
-    if (mContainer) {
+    if (container()) {
         QVector<ContainerCore::Package*> qtPackages;
         for (PackageExt* ext : stdPackages) {
             qtPackages.append(ext->getBasePackage());
         }
-        mContainer->setPackages(qtPackages);
+        container()->setPackages(qtPackages);
     }
 }
 
 void ContainerExt::addPackage(PackageExt* package) {
-    if (mContainer && package) {
-        mContainer->addPackage(package->getBasePackage());
+    if (container() && package) {
+        // The container stores a copy; the Python object keeps its package
+        container()->addPackage(package->getBasePackage()->toData());
     }
 }
 
@@ -128,7 +198,7 @@ void ContainerExt::addCustomVariable(HaulerType hauler, const std::string &key,
                                   const std::string &value) {
     QString qKey = QString::fromStdString(key);
     QVariant qValue = QString::fromStdString(value);
-    mContainer->addCustomVariable(static_cast<ContainerCore::Container::HaulerType>(hauler), qKey, qValue);
+    container()->addCustomVariable(static_cast<ContainerCore::Container::HaulerType>(hauler), qKey, qValue);
 }
 
 
@@ -136,21 +206,21 @@ void ContainerExt::addCustomVariable(HaulerType hauler, const std::string &key,
                                   int value) {
     QString qKey = QString::fromStdString(key);
     QVariant qValue = value;  // Automatically constructs a QVariant from int
-    mContainer->addCustomVariable(static_cast<ContainerCore::Container::HaulerType>(hauler), qKey, qValue);
+    container()->addCustomVariable(static_cast<ContainerCore::Container::HaulerType>(hauler), qKey, qValue);
 }
 
 void ContainerExt::addCustomVariable(HaulerType hauler, const std::string &key,
                                   double value) {
     QString qKey = QString::fromStdString(key);
     QVariant qValue = value;  // Automatically constructs a QVariant from double
-    mContainer->addCustomVariable(static_cast<ContainerCore::Container::HaulerType>(hauler), qKey, qValue);
+    container()->addCustomVariable(static_cast<ContainerCore::Container::HaulerType>(hauler), qKey, qValue);
 }
 
 // Method to remove a custom variable using std::string
 void ContainerExt::removeCustomVariable(HaulerType hauler,
                                      const std::string &key) {
     QString qKey = QString::fromStdString(key);
-    mContainer->removeCustomVariable(static_cast<ContainerCore::Container::HaulerType>(hauler), qKey);
+    container()->removeCustomVariable(static_cast<ContainerCore::Container::HaulerType>(hauler), qKey);
 }
 
 // Method to get a custom variable's value using std::string
@@ -158,7 +228,7 @@ std::string ContainerExt::getCustomVariable(HaulerType hauler,
                                             const std::string &key) const {
     QString qKey = QString::fromStdString(key);
     QVariant qValue =
-        mContainer->getCustomVariable(
+        container()->getCustomVariable(
             static_cast<ContainerCore::Container::HaulerType>(hauler), qKey);
 
     if (qValue.isNull() || !qValue.isValid()) {
@@ -233,17 +303,19 @@ std::string ContainerExt::getCustomVariable(HaulerType hauler,
 
 std::string ContainerExt::getContainerCurrentLocation() const
 {
-    return mContainer->getContainerCurrentLocation().toStdString();
+    return container()->getContainerCurrentLocation().toStdString();
 }
 
 void ContainerExt::setContainerCurrentLocation(const std::string &location) {
-    mContainer->setContainerCurrentLocation(QString::fromStdString(location));
+    container()->setContainerCurrentLocation(QString::fromStdString(location));
 }
 
 std::vector<std::string> ContainerExt::getContainerNextDestinations() const
 {
+    const QVector<QString> &values = container()->getContainerNextDestinations();
     std::vector<std::string> results;
-    for (auto &e : mContainer->getContainerNextDestinations()) {
+    results.reserve(values.size());
+    for (const auto &e : values) {
         results.push_back(e.toStdString());
     }
     return results;
@@ -256,20 +328,22 @@ void ContainerExt::setContainerNextDestinations(
     for (auto& e : destinations) {
         values.push_back(QString::fromStdString(e));
     }
-    mContainer->setContainerNextDestinations(values);
+    container()->setContainerNextDestinations(std::move(values));
 }
 
 void ContainerExt::addDestination(const std::string &destination) {
-    mContainer->addDestination(QString::fromStdString(destination));
+    container()->addDestination(QString::fromStdString(destination));
 }
 
 bool ContainerExt::removeDestination(const std::string &destination) {
-    return mContainer->removeDestination(QString::fromStdString(destination));
+    return container()->removeDestination(QString::fromStdString(destination));
 }
 
 std::vector<std::string> ContainerExt::getContainerMovementHistory() const {
+    const QVector<QString> &values = container()->getContainerMovementHistory();
     std::vector<std::string> results;
-    for (auto &e : mContainer->getContainerMovementHistory()) {
+    results.reserve(values.size());
+    for (const auto &e : values) {
         results.push_back(e.toStdString());
     }
     return results;
@@ -282,27 +356,55 @@ void ContainerExt::setContainerMovementHistory(
     for (auto& e : history) {
         values.push_back(QString::fromStdString(e));
     }
-    mContainer->setContainerMovementHistory(values);
+    container()->setContainerMovementHistory(std::move(values));
 }
 void ContainerExt::addMovementHistory(const std::string &history) {
-    mContainer->addMovementHistory(QString::fromStdString(history));
+    container()->addMovementHistory(QString::fromStdString(history));
 }
 
 bool ContainerExt::removeMovementHistory(const std::string &history) {
-    return mContainer->removeMovementHistory(QString::fromStdString(history));
+    return container()->removeMovementHistory(QString::fromStdString(history));
 }
 
 QJsonObject ContainerExt::toJson() const
 {
-    return mContainer->toJson();
+    return container()->toJson();
 }
 
 ContainerCore::Container *ContainerExt::copy()
 {
-    return mContainer->copy();
+    return container()->copy();
 }
 
 ContainerCore::Container *ContainerExt::getBaseContainer()
 {
-    return mContainer;
+    return container();
+}
+
+const ContainerCore::Container *ContainerExt::getBaseContainer() const
+{
+    return container();
+}
+
+QByteArray ContainerExt::toBytes() const
+{
+    QByteArray data;
+    if (ContainerCore::Container *base = container()) {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << *base;
+    }
+    return data;
+}
+
+ContainerCore::Container *ContainerExt::fromBytes(const QByteArray &data)
+{
+    auto container = std::make_unique<ContainerCore::Container>();
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_6_0);
+    in >> *container;
+    if (in.status() != QDataStream::Ok) {
+        throw std::invalid_argument("Invalid container state");
+    }
+    return container.release();
 }
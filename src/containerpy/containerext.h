@@ -3,6 +3,7 @@
 
 #include "containerLib/container.h"
 #include "packageext.h"
+#include <functional>
 
 class ContainerExt
 {
@@ -36,7 +37,8 @@ public:
 
     // Copy Constructor and Assignment Operator
     ContainerExt(const ContainerExt &other);
-    ContainerExt(ContainerCore::Container *other);
+    // Wraps an existing container; deletes it on destruction if ownsContainer
+    ContainerExt(ContainerCore::Container *other, bool ownsContainer = true);
     ContainerExt& operator=(const ContainerExt &other);
 
     std::string getContainerID() const;
@@ -76,12 +78,43 @@ public:
 
     QJsonObject toJson() const;
 
+    // Binary state for pickling, in the versioned QDataStream format
+    QByteArray toBytes() const;
+    static ContainerCore::Container *fromBytes(const QByteArray &data);
+
     ContainerCore::Container *copy();
 
     ContainerCore::Container *getBaseContainer();
+    const ContainerCore::Container *getBaseContainer() const;
+
+    bool ownsContainer() const;
+    void setOwnsContainer(bool owns);
+
+    // Drops the pointer to a container that was deleted elsewhere
+    void detach();
+
+    // Points a detached wrapper at a container it does not own
+    void attach(ContainerCore::Container *container);
+    bool isAttached() const;
+
+    // Set by a ContainerMapExt that tracks this wrapper: reattach looks the
+    // container up again after the map released it (e.g. on cache
+    // eviction), released lets the map forget the wrapper when it is freed
+    void setMapHooks(std::function<void()> reattach,
+                     std::function<void(ContainerExt *)> released);
+    void clearMapHooks();
 
 private:
     ContainerCore::Container *mContainer;
+    bool mOwnsContainer = true;
+    std::function<void()> mReattach;
+    std::function<void(ContainerExt *)> mReleased;
+
+    // Returns the wrapped container, reattaching a detached map wrapper
+    ContainerCore::Container *container() const;
+
+    // Tells the tracking map, if any, that this wrapper goes away
+    void releaseFromMap();
 
     // Helper method to clean up mContainer
     void cleanup();
@@ -1,4 +1,5 @@
 #include "containermapext.h"
+#include <QBuffer>
 
 ContainerMapExt::ContainerMapExt()
     : mContainerMap{nullptr}
@@ -6,6 +7,22 @@ ContainerMapExt::ContainerMapExt()
         mContainerMap.setIsRunningThroughPython(true);
 }
 
+ContainerMapExt::~ContainerMapExt()
+{
+    // Stop tracking before the map releases its containers. Wrappers that
+    // outlive the map keep only containers they own.
+    QMutexLocker locker(&mWrapperMutex);
+    for (auto it = mWrappers.begin(); it != mWrappers.end(); ++it) {
+        QObject::disconnect(it->destroyed);
+        it->wrapper->clearMapHooks();
+        if (!it->wrapper->ownsContainer()) {
+            it->wrapper->detach();
+        }
+    }
+    mWrappers.clear();
+    mWrapperIDs.clear();
+}
+
 ContainerMapExt::ContainerMapExt(const std::string &dbLocation)
     : mContainerMap(QString::fromStdString(dbLocation))
 {
@@ -21,14 +38,17 @@ ContainerMapExt::ContainerMapExt(const QJsonObject &json)
 void ContainerMapExt::addContainer(ContainerExt *container, double addingTime, double leavingTime)
 {
     if (container) {
+        registerWrapper(container);
         mContainerMap.addContainer(QString::fromStdString(container->getContainerID()), container->getBaseContainer(), addingTime, leavingTime);
     }
 }
 
 void ContainerMapExt::addContainers(const std::vector<ContainerExt *> &containers, double addingTime, double leavingTime)
 {
+    ContainerCore::ContainerMap::ChangeBatch batch(&mContainerMap);
     for (auto& c : containers) {
         if (c) {
+            registerWrapper(c);
             mContainerMap.addContainer(QString::fromStdString(c->getContainerID()), c->getBaseContainer(), addingTime, leavingTime);
         }
     }
@@ -39,6 +59,17 @@ void ContainerMapExt::addContainers(const QJsonObject &json, double addingTime,
     mContainerMap.addContainers(json, addingTime, leavingTime);
 }
 
+void ContainerMapExt::addContainers(const QVector<ContainerCore::Container *> &containers, double addingTime, double leavingTime)
+{
+    mContainerMap.addContainers(containers, addingTime, leavingTime);
+}
+
+std::size_t ContainerMapExt::addContainersFromColumns(const ContainerCore::ContainerMap::Columns &columns,
+                                                      const QVector<QString> &locations)
+{
+    return std::size_t(mContainerMap.addContainersFromColumns(columns, locations));
+}
+
 std::vector<ContainerExt*> ContainerMapExt::getContainersByAddedTime(const std::string &condition, double referenceTime) {
     auto results = mContainerMap.getContainersByAddedTime(QString::fromStdString(condition), referenceTime);
 
@@ -49,7 +80,7 @@ std::vector<ContainerExt *> ContainerMapExt::dequeueContainersByAddedTime(const
 {
     auto results = mContainerMap.dequeueContainersByAddedTime(QString::fromStdString(condition), referenceTime);
 
-    return convertQVecContainerToSTDVecContainerExt(results);
+    return takeQVecContainerToSTDVecContainerExt(results);
 }
 
 std::size_t ContainerMapExt::countContainersByAddedTime(const std::string &condition, double referenceTime) {
@@ -67,7 +98,7 @@ std::vector<ContainerExt *> ContainerMapExt::dequeueContainersByLeavingTime(cons
 {
     auto results = mContainerMap.dequeueContainersByLeavingTime(QString::fromStdString(condition), referenceTime);
 
-    return convertQVecContainerToSTDVecContainerExt(results);
+    return takeQVecContainerToSTDVecContainerExt(results);
 }
 
 std::size_t ContainerMapExt::countContainersByLeavingTime(const std::string &condition, double referenceTime) {
@@ -92,6 +123,47 @@ std::vector<ContainerExt *> ContainerMapExt::getAllContainers()
     return convertQVecContainerToSTDVecContainerExt(qtMapVec);
 }
 
+bool ContainerMapExt::containsContainer(const std::string &id) const
+{
+    return mContainerMap.containsContainer(QString::fromStdString(id));
+}
+
+std::size_t ContainerMapExt::setContainersCurrentLocation(const QStringList &ids, const QStringList &locations)
+{
+    return std::size_t(mContainerMap.setContainersCurrentLocation(ids, locations));
+}
+
+std::size_t ContainerMapExt::addContainersDestination(const QStringList &ids, const QStringList &destinations)
+{
+    return std::size_t(mContainerMap.addContainersDestination(ids, destinations));
+}
+
+std::size_t ContainerMapExt::addContainersCustomVariable(const QStringList &ids,
+                                                         ContainerCore::Container::HaulerType hauler,
+                                                         const QString &key, const QVariantList &values)
+{
+    return std::size_t(mContainerMap.addContainersCustomVariable(ids, hauler, key, values));
+}
+
+std::vector<std::string> ContainerMapExt::getContainerIDsPage(const std::string &afterID, std::size_t limit) const
+{
+    const QStringList ids = mContainerMap.getContainerIDsPage(QString::fromStdString(afterID), qsizetype(limit));
+    std::vector<std::string> output;
+    output.reserve(ids.size());
+    for (const QString &id : ids) {
+        output.push_back(id.toStdString());
+    }
+    return output;
+}
+
+std::vector<ContainerExt *> ContainerMapExt::getContainersPage(const std::string &afterID, std::size_t limit,
+                                                               const ContainerCore::ContainerMap::PageFilter &filter)
+{
+    auto results = mContainerMap.getContainersPage(QString::fromStdString(afterID), qsizetype(limit), filter);
+
+    return convertQVecContainerToSTDVecContainerExt(results);
+}
+
 std::vector<ContainerExt *> ContainerMapExt::getLatestContainers() {
     QMap<QString, ContainerCore::Container*> qtMap = mContainerMap.getLatestContainers();
     auto qtMapVec = qtMap.values();
@@ -103,6 +175,21 @@ std::size_t ContainerMapExt::size() const
     return mContainerMap.size();
 }
 
+ContainerCore::ContainerMap::Columns ContainerMapExt::columns() const
+{
+    return mContainerMap.columns();
+}
+
+bool ContainerMapExt::forEachContainer(const std::function<void(const ContainerCore::Container &)> &visit) const
+{
+    return mContainerMap.forEachContainer(visit);
+}
+
+bool ContainerMapExt::isDatabaseBacked() const
+{
+    return mContainerMap.isDatabaseBacked();
+}
+
 std::vector<ContainerExt*> ContainerMapExt::getContainersByNextDestination(const std::string &destination)
 {
     auto results = mContainerMap.getContainersByNextDestination(QString::fromStdString(destination));
@@ -114,14 +201,36 @@ std::vector<ContainerExt*> ContainerMapExt::dequeueContainerByNextDestination(co
 {
     auto results = mContainerMap.dequeueContainersByNextDestination(QString::fromStdString(destination));
 
-    return convertQVecContainerToSTDVecContainerExt(results);
+    return takeQVecContainerToSTDVecContainerExt(results);
+}
+
+void ContainerMapExt::restoreContainers(const std::vector<ContainerExt *> &containers)
+{
+    ContainerCore::ContainerMap::ChangeBatch batch(&mContainerMap);
+    for (ContainerExt *wrapper : containers) {
+        ContainerCore::Container *base = wrapper ? wrapper->getBaseContainer() : nullptr;
+        if (!base) {
+            continue;
+        }
+        wrapper->setOwnsContainer(false);
+        registerWrapper(wrapper);
+        mContainerMap.addContainer(base->getContainerID(), base,
+                                   base->getContainerAddedTime(),
+                                   base->getContainerLeavingTime());
+    }
 }
 
 std::vector<ContainerExt *> ContainerMapExt::loadContainersFromJson(const QJsonObject &json)
 {
     auto results = ContainerCore::ContainerMap::loadContainersFromJson(json);
 
-    return convertQVecContainerToSTDVecContainerExt(results);
+    // Not part of any map yet; each wrapper owns its container
+    std::vector<ContainerExt*> output;
+    output.reserve(results.size());
+    for (ContainerCore::Container *container : results) {
+        output.push_back(new ContainerExt(container));
+    }
+    return output;
 }
 
 std::size_t ContainerMapExt::countContainersByNextDestination(const std::string &destination) {
@@ -133,14 +242,166 @@ QJsonObject ContainerMapExt::toJson() const
     return mContainerMap.toJson();
 }
 
-// Helper method to safely cast ContainerCore::Container* to ContainerExt*
 ContainerExt* ContainerMapExt::toContainerExt(ContainerCore::Container* base)
 {
-    return new ContainerExt(base);
+    if (!base) {
+        return nullptr;
+    }
+
+    const QString id = base->getContainerID();
+    QMutexLocker locker(&mWrapperMutex);
+    auto it = mWrappers.constFind(id);
+    if (it != mWrappers.cend()) {
+        ContainerExt *wrapper = it->wrapper;
+        if (it->container == base) {
+            return wrapper;
+        }
+        if (!wrapper->isAttached()) {
+            // The container was reloaded after the map released it
+            wrapper->attach(base);
+            bindUtil(id, base, wrapper);
+            return wrapper;
+        }
+        // The wrapper holds a container this ID no longer refers to
+        untrackUtil(wrapper);
+    }
+
+    ContainerExt *wrapper = new ContainerExt(base, false);
+    bindUtil(id, base, wrapper);
+    return wrapper;
+}
+
+ContainerExt* ContainerMapExt::takeContainerExt(ContainerCore::Container* base)
+{
+    if (!base) {
+        return nullptr;
+    }
+
+    {
+        QMutexLocker locker(&mWrapperMutex);
+        auto it = mWrappers.constFind(base->getContainerID());
+        if (it != mWrappers.cend() &&
+            (it->container == base || !it->wrapper->isAttached())) {
+            ContainerExt *wrapper = it->wrapper;
+            untrackUtil(wrapper);
+            wrapper->attach(base);
+            wrapper->setOwnsContainer(true);
+            return wrapper;
+        }
+    }
+    return new ContainerExt(base, true);
+}
+
+void ContainerMapExt::registerWrapper(ContainerExt *wrapper)
+{
+    ContainerCore::Container *base = wrapper->getBaseContainer();
+    if (!base) {
+        return;
+    }
+
+    const QString id = base->getContainerID();
+    QMutexLocker locker(&mWrapperMutex);
+    auto it = mWrappers.constFind(id);
+    if (it != mWrappers.cend()) {
+        if (it->wrapper == wrapper && it->container == base) {
+            return;
+        }
+        if (it->wrapper != wrapper) {
+            untrackUtil(it->wrapper);
+        }
+    }
+    bindUtil(id, base, wrapper);
+}
+
+void ContainerMapExt::bindUtil(const QString &id, ContainerCore::Container *base, ContainerExt *wrapper)
+{
+    auto idIt = mWrapperIDs.constFind(wrapper);
+    const bool tracked = idIt != mWrapperIDs.cend();
+    if (tracked && idIt.value() != id) {
+        // The container was renamed; drop the entry under the old ID
+        auto it = mWrappers.find(idIt.value());
+        if (it != mWrappers.end() && it->wrapper == wrapper) {
+            QObject::disconnect(it->destroyed);
+            mWrappers.erase(it);
+        }
+    }
+
+    WrapperEntry &entry = mWrappers[id];
+    QObject::disconnect(entry.destroyed);
+    entry.wrapper = wrapper;
+    entry.container = base;
+    // Runs synchronously in the deleting thread
+    entry.destroyed = QObject::connect(base, &QObject::destroyed, &mContainerMap, [this, id, base]() {
+        containerDestroyed(id, base);
+    }, Qt::DirectConnection);
+
+    mWrapperIDs.insert(wrapper, id);
+    if (!tracked) {
+        wrapper->setMapHooks([this, wrapper]() { reattach(wrapper); },
+                             [this](ContainerExt *released) {
+                                 QMutexLocker locker(&mWrapperMutex);
+                                 untrackUtil(released);
+                             });
+    }
+}
+
+void ContainerMapExt::untrackUtil(ContainerExt *wrapper)
+{
+    auto idIt = mWrapperIDs.find(wrapper);
+    if (idIt == mWrapperIDs.end()) {
+        return;
+    }
+    auto it = mWrappers.find(idIt.value());
+    if (it != mWrappers.end() && it->wrapper == wrapper) {
+        QObject::disconnect(it->destroyed);
+        mWrappers.erase(it);
+    }
+    mWrapperIDs.erase(idIt);
+    wrapper->clearMapHooks();
+}
+
+void ContainerMapExt::containerDestroyed(const QString &id, ContainerCore::Container *base)
+{
+    QMutexLocker locker(&mWrapperMutex);
+    auto it = mWrappers.find(id);
+    if (it == mWrappers.end() || it->container != base) {
+        return;
+    }
+    // A wrapper deleting its own container is untracked first, so this is
+    // the map releasing it; the wrapper stays registered under its ID
+    it->container = nullptr;
+    it->wrapper->detach();
+}
+
+void ContainerMapExt::reattach(ContainerExt *wrapper)
+{
+    QString id;
+    {
+        QMutexLocker locker(&mWrapperMutex);
+        auto idIt = mWrapperIDs.constFind(wrapper);
+        if (idIt == mWrapperIDs.cend()) {
+            return;
+        }
+        id = idIt.value();
+    }
+
+    // Not under mWrapperMutex: loading may evict and delete containers
+    ContainerCore::Container *base = mContainerMap.getContainerByID(id);
+    if (!base) {
+        return;
+    }
+
+    QMutexLocker locker(&mWrapperMutex);
+    auto it = mWrappers.constFind(id);
+    if (it != mWrappers.cend() && it->wrapper == wrapper && !wrapper->isAttached()) {
+        wrapper->attach(base);
+        bindUtil(id, base, wrapper);
+    }
 }
 
-std::vector<ContainerExt*> ContainerMapExt::convertQVecContainerToSTDVecContainerExt(QVector<ContainerCore::Container*> original) {
+std::vector<ContainerExt*> ContainerMapExt::convertQVecContainerToSTDVecContainerExt(const QVector<ContainerCore::Container*> &original) {
     std::vector<ContainerExt*> output;
+    output.reserve(original.size());
 
     for (auto& r : original) {
         ContainerExt* value = toContainerExt(r);
@@ -152,7 +413,21 @@ std::vector<ContainerExt*> ContainerMapExt::convertQVecContainerToSTDVecContaine
     return output;
 }
 
-std::map<std::string, ContainerExt *> ContainerMapExt::convertQMapToSTDMapContainerExt(QMap<QString, ContainerCore::Container*> original) {
+std::vector<ContainerExt*> ContainerMapExt::takeQVecContainerToSTDVecContainerExt(const QVector<ContainerCore::Container*> &original) {
+    std::vector<ContainerExt*> output;
+    output.reserve(original.size());
+
+    for (auto& r : original) {
+        ContainerExt* value = takeContainerExt(r);
+        if (value) {
+            output.push_back(value);
+        }
+    }
+
+    return output;
+}
+
+std::map<std::string, ContainerExt *> ContainerMapExt::convertQMapToSTDMapContainerExt(const QMap<QString, ContainerCore::Container*> &original) {
     std::map<std::string, ContainerExt*> stdMap;
 
     for (auto it = original.begin(); it != original.end(); ++it) {
@@ -169,3 +444,32 @@ std::map<std::string, ContainerExt *> ContainerMapExt::convertQMapToSTDMapContai
 void ContainerMapExt::clear() {
     mContainerMap.clear();
 }
+
+bool ContainerMapExt::saveSnapshot(const std::string &path) const
+{
+    return mContainerMap.saveSnapshot(QString::fromStdString(path));
+}
+
+bool ContainerMapExt::loadSnapshot(const std::string &path)
+{
+    return mContainerMap.loadSnapshot(QString::fromStdString(path));
+}
+
+QByteArray ContainerMapExt::toBytes() const
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    if (!mContainerMap.saveSnapshot(&buffer)) {
+        return QByteArray();
+    }
+    return data;
+}
+
+bool ContainerMapExt::loadBytes(const QByteArray &data)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    return mContainerMap.loadSnapshot(&buffer);
+}
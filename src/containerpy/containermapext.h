@@ -3,19 +3,30 @@
 
 #include "containerext.h"
 #include "containerLib/containermap.h"
+#include <QHash>
+#include <QMutex>
+#include <vector>
 
 class ContainerMapExt
 {
 public:
     explicit ContainerMapExt();
+    ~ContainerMapExt();
 
     ContainerMapExt(const std::string &dbLocation);
     ContainerMapExt(const QJsonObject &json);
 
+    // Wrappers are shared with Python and cannot follow a copy
+    ContainerMapExt(const ContainerMapExt &) = delete;
+    ContainerMapExt &operator=(const ContainerMapExt &) = delete;
+
     void addContainer(ContainerExt* container, double addingTime, double leavingTime);
 
     void addContainers(const std::vector<ContainerExt*> &containers, double addingTime, double leavingTime);
     void addContainers(const QJsonObject &json, double addingTime, double leavingTime);
+    void addContainers(const QVector<ContainerCore::Container*> &containers, double addingTime, double leavingTime);
+    std::size_t addContainersFromColumns(const ContainerCore::ContainerMap::Columns &columns,
+                                         const QVector<QString> &locations);
 
     ContainerExt* getContainerByID(const std::string &id);
 
@@ -23,10 +34,29 @@ public:
 
     std::vector<ContainerExt *> getAllContainers();
 
+    bool containsContainer(const std::string &id) const;
+
+    // Batch updates over parallel sequences; return the number updated
+    std::size_t setContainersCurrentLocation(const QStringList &ids, const QStringList &locations);
+    std::size_t addContainersDestination(const QStringList &ids, const QStringList &destinations);
+    std::size_t addContainersCustomVariable(const QStringList &ids, ContainerCore::Container::HaulerType hauler,
+                                            const QString &key, const QVariantList &values);
+
+    std::vector<std::string> getContainerIDsPage(const std::string &afterID, std::size_t limit) const;
+
+    std::vector<ContainerExt *> getContainersPage(const std::string &afterID, std::size_t limit,
+                                                  const ContainerCore::ContainerMap::PageFilter &filter);
+
     std::vector<ContainerExt *> getLatestContainers();
 
     std::size_t size() const;
 
+    ContainerCore::ContainerMap::Columns columns() const;
+
+    bool forEachContainer(const std::function<void(const ContainerCore::Container &)> &visit) const;
+
+    bool isDatabaseBacked() const;
+
     std::vector<ContainerExt*> getContainersByAddedTime(const std::string &condition, double referenceTime);
 
     std::vector<ContainerExt*> dequeueContainersByAddedTime(const std::string &condition, double referenceTime);
@@ -43,6 +73,10 @@ public:
 
     std::vector<ContainerExt*> dequeueContainerByNextDestination(const std::string &destination);
 
+    // Puts dequeued containers back, each with its own times; the map
+    // holds them again and the wrappers go back to tracking them
+    void restoreContainers(const std::vector<ContainerExt*> &containers);
+
     static std::vector<ContainerExt*> loadContainersFromJson(const QJsonObject &json);
 
     std::size_t countContainersByNextDestination(const std::string &destination);
@@ -51,14 +85,56 @@ public:
 
     void clear();
 
+    bool saveSnapshot(const std::string &path) const;
+    bool loadSnapshot(const std::string &path);
+
+    // Binary state for pickling: a snapshot of all containers
+    QByteArray toBytes() const;
+    bool loadBytes(const QByteArray &data);
+
 private:
+    // One wrapper per container ID, so repeated queries hand Python the
+    // same object. The registry only tracks wrappers: Python owns them and
+    // untracks a wrapper when it frees it. When the map deletes a
+    // container (e.g. on cache eviction) its wrapper is detached and looks
+    // the ID up again on next use. Declared before mContainerMap so the
+    // registry outlives it.
+    struct WrapperEntry {
+        ContainerExt *wrapper = nullptr;
+        ContainerCore::Container *container = nullptr;
+        QMetaObject::Connection destroyed;
+    };
+    QHash<QString, WrapperEntry> mWrappers;
+    QHash<ContainerExt*, QString> mWrapperIDs;
+    mutable QMutex mWrapperMutex;
+
     ContainerCore::ContainerMap mContainerMap;
 
-    // Helper method to safely cast ContainerCore::Container* to ContainerExt*
-    static ContainerExt* toContainerExt(ContainerCore::Container* base);
+    // Returns the tracked wrapper for a container, creating it if needed
+    ContainerExt* toContainerExt(ContainerCore::Container* base);
+
+    // Returns a wrapper that owns a container the map handed over
+    ContainerExt* takeContainerExt(ContainerCore::Container* base);
+
+    // Tracks a wrapper created in Python for its container
+    void registerWrapper(ContainerExt* wrapper);
+
+    // Points the registry entry for id at wrapper and base; mWrapperMutex
+    // must be held
+    void bindUtil(const QString &id, ContainerCore::Container *base, ContainerExt *wrapper);
+
+    // Forgets a wrapper; mWrapperMutex must be held
+    void untrackUtil(ContainerExt *wrapper);
+
+    // Detaches the wrapper of a container the map deleted
+    void containerDestroyed(const QString &id, ContainerCore::Container *base);
+
+    // Looks a detached wrapper's container up again
+    void reattach(ContainerExt *wrapper);
 
-    static std::vector<ContainerExt*> convertQVecContainerToSTDVecContainerExt(QVector<ContainerCore::Container*> original);
-    static std::map<std::string, ContainerExt *> convertQMapToSTDMapContainerExt(QMap<QString, ContainerCore::Container*> original);
+    std::vector<ContainerExt*> convertQVecContainerToSTDVecContainerExt(const QVector<ContainerCore::Container*> &original);
+    std::vector<ContainerExt*> takeQVecContainerToSTDVecContainerExt(const QVector<ContainerCore::Container*> &original);
+    std::map<std::string, ContainerExt *> convertQMapToSTDMapContainerExt(const QMap<QString, ContainerCore::Container*> &original);
 };
 
 #endif // CONTAINERMAPEXT_H
@@ -0,0 +1,434 @@
+#include <QtTest>
+#include "containerLib/container.h"
+#include "containerLib/containerarrow.h"
+#include "containerLib/containermap.h"
+#include "containerLib/package.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace ContainerCore;
+
+namespace {
+
+/** Number of operator new calls made by the process so far */
+std::atomic<qint64> allocationCount{0};
+
+} // namespace
+
+// Count heap allocations so benchmarks can report them; Qt's containers
+// allocate through malloc and are not included
+void *operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+// Benchmarks for the Container accessors and setters
+class BenchContainer : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    // Custom variables
+    void benchGetCustomVariables();
+    void benchForEachCustomVariable();
+
+    // Packages
+    void benchSetPackagesCopy();
+    void benchSetPackagesAdopt();
+    void benchSetPackagesAllocations_data();
+    void benchSetPackagesAllocations();
+
+    // Destinations
+    void benchSetDestinationsCopy();
+    void benchSetDestinationsMove();
+    void benchDestinationScan();
+
+    // Export
+    void benchToJsonDocument();
+    void benchWriteJson();
+    void benchSaveArrow();
+    void benchToCborDocument();
+    void benchWriteCbor();
+
+    // Loading
+    void benchLoadJson();
+    void benchLoadJsonStream();
+    void benchLoadCborStream();
+    void benchReadDataStream();
+    void benchLoadJsonParallel_data();
+    void benchLoadJsonParallel();
+    void benchLoadSnapshot();
+    void benchLoadCompressedSnapshot_data();
+    void benchLoadCompressedSnapshot();
+
+private:
+    Container m_container{"BENCH001", Container::twentyFT};
+
+    /** Fills a map with containers for the load benchmarks */
+    static void populate(ContainerMap &map, int count);
+};
+
+void BenchContainer::initTestCase() {
+    for (int i = 0; i < 16; ++i) {
+        m_container.addCustomVariable(Container::truck,
+                                      QStringLiteral("var%1").arg(i), i);
+    }
+}
+
+// Builds the merged map on every call
+void BenchContainer::benchGetCustomVariables() {
+    double sum = 0;
+    QBENCHMARK {
+        const QMap<Container::HaulerType, QVariantMap> variables =
+            m_container.getCustomVariables();
+        for (const QVariantMap &haulerVariables : variables) {
+            for (const QVariant &value : haulerVariables) {
+                sum += value.toDouble();
+            }
+        }
+    }
+    QVERIFY(sum > 0);
+}
+
+// Visits the stored variables in place
+void BenchContainer::benchForEachCustomVariable() {
+    double sum = 0;
+    QBENCHMARK {
+        m_container.forEachCustomVariable(
+            [&sum](Container::HaulerType, const QString &,
+                   const QVariant &value) {
+                sum += value.toDouble();
+            });
+    }
+    QVERIFY(sum > 0);
+}
+
+// Copies the package data; the caller deletes its objects
+void BenchContainer::benchSetPackagesCopy() {
+    Container container("BENCH002", Container::twentyFT);
+    QBENCHMARK {
+        QVector<Package*> packages;
+        for (int i = 0; i < 32; ++i) {
+            packages.append(new Package(QStringLiteral("PKG%1").arg(i)));
+        }
+        container.setPackages(packages);
+        qDeleteAll(packages);
+        QCOMPARE(container.packageCount(), 32);
+    }
+}
+
+// Hands the objects to the container, which deletes them
+void BenchContainer::benchSetPackagesAdopt() {
+    Container container("BENCH002", Container::twentyFT);
+    QBENCHMARK {
+        QVector<Package*> packages;
+        for (int i = 0; i < 32; ++i) {
+            packages.append(new Package(QStringLiteral("PKG%1").arg(i)));
+        }
+        container.adoptPackages(std::move(packages));
+        QCOMPARE(container.packageCount(), 32);
+    }
+}
+
+void BenchContainer::benchSetPackagesAllocations_data() {
+    QTest::addColumn<QString>("mode");
+    QTest::addRow("copy") << QStringLiteral("copy");
+    QTest::addRow("adopt") << QStringLiteral("adopt");
+    QTest::addRow("values") << QStringLiteral("values");
+}
+
+// Reports the operator new calls per replacement of 32 packages
+void BenchContainer::benchSetPackagesAllocations() {
+    QFETCH(QString, mode);
+    Container container("BENCH002", Container::twentyFT);
+    constexpr int iterations = 1000;
+    const qint64 before = allocationCount.load(std::memory_order_relaxed);
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        if (mode == QLatin1String("values")) {
+            QVector<PackageData> packages;
+            for (int i = 0; i < 32; ++i) {
+                packages.append(PackageData{QStringLiteral("PKG%1").arg(i)});
+            }
+            container.setPackages(packages);
+        } else {
+            QVector<Package*> packages;
+            for (int i = 0; i < 32; ++i) {
+                packages.append(new Package(QStringLiteral("PKG%1").arg(i)));
+            }
+            if (mode == QLatin1String("adopt")) {
+                container.adoptPackages(std::move(packages));
+            } else {
+                container.setPackages(packages);
+                qDeleteAll(packages);
+            }
+        }
+    }
+    const qint64 allocations =
+        allocationCount.load(std::memory_order_relaxed) - before;
+    QCOMPARE(container.packageCount(), 32);
+    QTest::setBenchmarkResult(qreal(allocations) / iterations, QTest::Events);
+}
+
+// A shared copy detaches on the next modification
+void BenchContainer::benchSetDestinationsCopy() {
+    Container container("BENCH003", Container::twentyFT);
+    QBENCHMARK {
+        QVector<QString> destinations(64, QStringLiteral("Port"));
+        destinations.last() = QStringLiteral("Last");
+        container.setContainerNextDestinations(destinations);
+        container.addDestination(QStringLiteral("Extra"));
+    }
+}
+
+// A moved vector is owned by the container and modified in place
+void BenchContainer::benchSetDestinationsMove() {
+    Container container("BENCH003", Container::twentyFT);
+    QBENCHMARK {
+        QVector<QString> destinations(64, QStringLiteral("Port"));
+        destinations.last() = QStringLiteral("Last");
+        container.setContainerNextDestinations(std::move(destinations));
+        container.addDestination(QStringLiteral("Extra"));
+    }
+}
+
+// In-memory destination query over many containers
+void BenchContainer::benchDestinationScan() {
+    ContainerMap map;
+    for (int i = 0; i < 10000; ++i) {
+        Container *container =
+            new Container(QStringLiteral("C%1").arg(i), Container::twentyFT);
+        container->addDestination(QStringLiteral("Port %1").arg(i % 10));
+        map.addContainer(container->getContainerID(), container);
+    }
+    qsizetype matches = 0;
+    QBENCHMARK {
+        matches = map.countContainersByNextDestination(QStringLiteral("Port 3"));
+    }
+    QCOMPARE(matches, 1000);
+}
+
+void BenchContainer::populate(ContainerMap &map, int count) {
+    ContainerMap::ChangeBatch batch(&map);
+    for (int i = 0; i < count; ++i) {
+        Container *container = new Container();
+        container->setContainerID(QStringLiteral("C%1").arg(i));
+        container->setContainerCurrentLocation(
+            QStringLiteral("Yard %1").arg(i % 50));
+        container->addDestination(QStringLiteral("Port %1").arg(i % 10));
+        container->addPackage(PackageData{QStringLiteral("P%1").arg(i)});
+        container->addCustomVariable(Container::truck,
+                                     QStringLiteral("weight"), i);
+        map.addContainer(container->getContainerID(), container, i);
+    }
+}
+
+// Builds the whole DOM before serializing it
+void BenchContainer::benchToJsonDocument() {
+    ContainerMap source;
+    populate(source, 100000);
+    QBENCHMARK {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        buffer.write(
+            QJsonDocument(source.toJson()).toJson(QJsonDocument::Compact));
+        QVERIFY(buffer.size() > 0);
+    }
+}
+
+// Writes the same document one container at a time
+void BenchContainer::benchWriteJson() {
+    ContainerMap source;
+    populate(source, 100000);
+    QBENCHMARK {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(source.writeJson(&buffer));
+        QVERIFY(buffer.size() > 0);
+    }
+}
+
+// Writes the Feather file analysts load instead of the JSON export
+void BenchContainer::benchSaveArrow() {
+    if (!ContainerArrowWriter::isAvailable()) {
+        QSKIP("Built without Arrow support");
+    }
+    ContainerMap source;
+    populate(source, 100000);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("bench.feather");
+    QBENCHMARK {
+        QVERIFY(source.saveArrow(path));
+    }
+}
+
+// CBOR counterpart of benchToJsonDocument()
+void BenchContainer::benchToCborDocument() {
+    ContainerMap source;
+    populate(source, 100000);
+    QBENCHMARK {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        buffer.write(source.toCbor().toCborValue().toCbor());
+        QVERIFY(buffer.size() > 0);
+    }
+}
+
+// CBOR counterpart of benchWriteJson()
+void BenchContainer::benchWriteCbor() {
+    ContainerMap source;
+    populate(source, 100000);
+    QBENCHMARK {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(source.writeCbor(&buffer));
+        QVERIFY(buffer.size() > 0);
+    }
+}
+
+// Parses a JSON document through the DOM constructor
+void BenchContainer::benchLoadJson() {
+    ContainerMap source;
+    populate(source, 100000);
+    const QByteArray json = QJsonDocument(source.toJson()).toJson();
+    QBENCHMARK {
+        ContainerMap map(QJsonDocument::fromJson(json).object());
+        QCOMPARE(map.size(), 100000);
+    }
+}
+
+// Parses the same document one container at a time
+void BenchContainer::benchLoadJsonStream() {
+    ContainerMap source;
+    populate(source, 100000);
+    QByteArray json = QJsonDocument(source.toJson()).toJson();
+    QBuffer buffer(&json);
+    buffer.open(QIODevice::ReadOnly);
+    QBENCHMARK {
+        buffer.seek(0);
+        ContainerMap map;
+        QVERIFY(map.addContainersFromJsonStream(&buffer));
+        QCOMPARE(map.size(), 100000);
+    }
+}
+
+// CBOR counterpart of benchLoadJsonStream()
+void BenchContainer::benchLoadCborStream() {
+    ContainerMap source;
+    populate(source, 100000);
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    QVERIFY(source.writeCbor(&buffer));
+    QBENCHMARK {
+        buffer.seek(0);
+        ContainerMap map;
+        QVERIFY(map.addContainersFromCborStream(&buffer));
+        QCOMPARE(map.size(), 100000);
+    }
+}
+
+// Decodes QDataStream records into one recycled container
+void BenchContainer::benchReadDataStream() {
+    ContainerMap source;
+    populate(source, 100000);
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        for (Container *container : source.getAllContainers()) {
+            out << *container;
+        }
+    }
+    Container recycled;
+    QBENCHMARK {
+        QDataStream in(data);
+        while (!in.atEnd()) {
+            in >> recycled;
+        }
+        QCOMPARE(in.status(), QDataStream::Ok);
+    }
+}
+
+void BenchContainer::benchLoadJsonParallel_data() {
+    QTest::addColumn<int>("threads");
+    for (int threads : {1, 2, 4, 8, 16, 32}) {
+        QTest::addRow("%d threads", threads) << threads;
+    }
+}
+
+// Parses the same document on a thread pool of increasing size
+void BenchContainer::benchLoadJsonParallel() {
+    QFETCH(int, threads);
+    ContainerMap source;
+    populate(source, 100000);
+    QByteArray json = QJsonDocument(source.toJson()).toJson();
+    QBuffer buffer(&json);
+    buffer.open(QIODevice::ReadOnly);
+    QBENCHMARK {
+        buffer.seek(0);
+        ContainerMap map;
+        QVERIFY(map.addContainersParallel(&buffer, std::nan("notDefined"),
+                                          std::nan("notDefined"), threads));
+        QCOMPARE(map.size(), 100000);
+    }
+}
+
+// Loads the same containers from a binary snapshot
+void BenchContainer::benchLoadSnapshot() {
+    ContainerMap source;
+    populate(source, 100000);
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    QVERIFY(source.saveSnapshot(&buffer));
+    QBENCHMARK {
+        buffer.seek(0);
+        ContainerMap map;
+        QVERIFY(map.loadSnapshot(&buffer));
+        QCOMPARE(map.size(), 100000);
+    }
+}
+
+void BenchContainer::benchLoadCompressedSnapshot_data() {
+    QTest::addColumn<int>("codec");
+    QTest::addRow("zlib") << int(Compression::Zlib);
+    if (Compression::isCodecAvailable(Compression::Zstd)) {
+        QTest::addRow("zstd") << int(Compression::Zstd);
+    }
+    if (Compression::isCodecAvailable(Compression::Lz4)) {
+        QTest::addRow("lz4") << int(Compression::Lz4);
+    }
+}
+
+// Loads a block-compressed snapshot; blocks are inflated in parallel
+void BenchContainer::benchLoadCompressedSnapshot() {
+    QFETCH(int, codec);
+    ContainerMap source;
+    populate(source, 100000);
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    QVERIFY(source.saveSnapshot(&buffer, Compression::Codec(codec)));
+    QBENCHMARK {
+        buffer.seek(0);
+        ContainerMap map;
+        QVERIFY(map.loadSnapshot(&buffer));
+        QCOMPARE(map.size(), 100000);
+    }
+}
+
+QTEST_MAIN(BenchContainer)
+#include "bench_container.moc"
@@ -1,6 +1,8 @@
 #include <QtTest>
 #include "containerLib/container.h"
+#include "containerLib/containerarrow.h"
 #include "containerLib/containermap.h"
+#include "containerLib/containersnapshot.h"
 #include "containerLib/package.h"
 
 using namespace ContainerCore;
@@ -22,14 +24,35 @@ private slots:
     // Container tests
     void testContainerInitialization();
     void testCustomVariables();
+    void testCustomVariableSchema();
+    void testCustomVariableSlotFallback();
+    void testPackages();
     void testCurrentLocation();
     void testNextDestinations();
     void testMovementHistory();
+    void testMovementHistoryPolicy();
     void testJsonSerialization();
+    void testDataStreamSerialization();
+    void testChangeBatch();
 
     // ContainerMap tests
     void testContainerMapOperations();
     void testContainerMapJsonSerialization();
+    void testContainerMapBatch();
+    void testContainerMapSnapshot();
+    void testContainerMapSnapshotBacked();
+    void testContainerMapJsonStream();
+    void testContainerMapParallelIngest();
+    void testWriteJson();
+    void testDeltaSnapshots();
+    void testCompressedSnapshots();
+    void testArrowExport();
+    void testCborSerialization();
+    void testContainerMapColumns();
+    void testContainerMapPaging();
+    void testContainerMapBatchUpdates();
+    void testContainerMapFromColumns();
+    void testDatabaseFromWorkerThread();
 };
 
 void TestContainer::initTestCase() {
@@ -92,6 +115,141 @@ void TestContainer::testCustomVariables() {
                  .contains("weight"));
 }
 
+// Test schema-registered custom variable slots
+void TestContainer::testCustomVariableSchema() {
+    const int slot = Container::registerCustomVariable(
+        Container::HaulerType::train, "axleLoad", QMetaType::Double);
+    QVERIFY(slot >= 0);
+    QCOMPARE(Container::registerCustomVariable(
+                 Container::HaulerType::train, "axleLoad", QMetaType::Double),
+             slot);
+    QCOMPARE(Container::customVariableSlotIndex(
+                 Container::HaulerType::train, "axleLoad"), slot);
+    QCOMPARE(Container::registerCustomVariable(
+                 Container::HaulerType::train, "bad", QMetaType::QPoint), -1);
+
+    Container container("TEST001", Container::twentyFT);
+    container.setCustomVariableSlot(slot, 12.5);
+    QCOMPARE(std::get<double>(container.customVariableSlot(slot)), 12.5);
+    QCOMPARE(container.getCustomVariable(
+                 Container::HaulerType::train, "axleLoad").toDouble(), 12.5);
+
+    // The QVariant API routes registered keys into the slot
+    container.addCustomVariable(Container::HaulerType::train, "axleLoad", 20);
+    QCOMPARE(std::get<double>(container.customVariableSlot(slot)), 20.0);
+    QVERIFY(container.getCustomVariablesForHauler(
+                         Container::HaulerType::train).contains("axleLoad"));
+
+    // Slots survive JSON round trips and copies
+    Container fromJson(container.toJson());
+    QCOMPARE(std::get<double>(fromJson.customVariableSlot(slot)), 20.0);
+    Container copied(container);
+    QCOMPARE(std::get<double>(copied.customVariableSlot(slot)), 20.0);
+
+    container.removeCustomVariable(Container::HaulerType::train, "axleLoad");
+    QVERIFY(std::holds_alternative<std::monostate>(
+        container.customVariableSlot(slot)));
+
+    // Keep the process-wide schema clean for the other tests
+    QVERIFY(Container::unregisterCustomVariable(
+        Container::HaulerType::train, "axleLoad"));
+    QCOMPARE(Container::customVariableSlotIndex(
+                 Container::HaulerType::train, "axleLoad"), -1);
+    QVERIFY(!Container::unregisterCustomVariable(
+        Container::HaulerType::train, "axleLoad"));
+}
+
+// Test values that do not fit a registered slot's type
+void TestContainer::testCustomVariableSlotFallback() {
+    const Container::HaulerType hauler = Container::HaulerType::waterTransport;
+    const int slot =
+        Container::registerCustomVariable(hauler, "draught", QMetaType::Double);
+    QVERIFY(slot >= 0);
+
+    Container container("TEST001", Container::twentyFT);
+    container.addCustomVariable(hauler, "draught", 7.5);
+    QCOMPARE(std::get<double>(container.customVariableSlot(slot)), 7.5);
+
+    // A string cannot live in a double slot, so it falls back to the map
+    // and the old slot value must not shadow it
+    container.addCustomVariable(hauler, "draught", QString("deep"));
+    QVERIFY(std::holds_alternative<std::monostate>(
+        container.customVariableSlot(slot)));
+    QCOMPARE(container.getCustomVariable(hauler, "draught").toString(),
+             QString("deep"));
+    QCOMPARE(container.getCustomVariablesForHauler(hauler)
+                 .value("draught").toString(),
+             QString("deep"));
+
+    // The slot accessor rejects values of the wrong type
+    QTest::ignoreMessage(
+        QtWarningMsg,
+        "Value does not match the type of custom variable \"draught\"");
+    container.setCustomVariableSlot(slot, QString("shallow"));
+    QVERIFY(std::holds_alternative<std::monostate>(
+        container.customVariableSlot(slot)));
+
+    // A matching value moves the key back into its slot
+    container.addCustomVariable(hauler, "draught", 8.0);
+    QCOMPARE(std::get<double>(container.customVariableSlot(slot)), 8.0);
+    QCOMPARE(container.getCustomVariable(hauler, "draught").toDouble(), 8.0);
+
+    // Unknown keys do not retire another key's slot
+    QVERIFY(!Container::unregisterCustomVariable(hauler, "keel"));
+    QCOMPARE(Container::customVariableSlotIndex(hauler, "draught"), slot);
+
+    // A retired slot keeps reporting its value until the key is written
+    QVERIFY(Container::unregisterCustomVariable(hauler, "draught"));
+    QCOMPARE(container.getCustomVariable(hauler, "draught").toDouble(), 8.0);
+    QCOMPARE(container.getCustomVariablesForHauler(hauler)
+                 .value("draught").toDouble(), 8.0);
+    Container copied(container);
+    QCOMPARE(copied.getCustomVariable(hauler, "draught").toDouble(), 8.0);
+
+    container.addCustomVariable(hauler, "draught", 9.0);
+    QVERIFY(std::holds_alternative<std::monostate>(
+        container.customVariableSlot(slot)));
+    QCOMPARE(container.getCustomVariable(hauler, "draught").toDouble(), 9.0);
+    container.removeCustomVariable(hauler, "draught");
+    QVERIFY(!container.getCustomVariable(hauler, "draught").isValid());
+}
+
+// Test package storage in a Container
+void TestContainer::testPackages() {
+    Container container("TEST001", Container::twentyFT);
+    container.addDestination("Port B");
+
+    container.addPackage(PackageData{"PKG001"});
+    Package added("PKG002");
+    container.addPackage(&added);
+    QCOMPARE(container.packageCount(), 2);
+    QCOMPARE(container.packagesView()[1].packageID, QString("PKG002"));
+
+    // The caller keeps its object and the container keeps its copy
+    added.setPackageID("PKG005");
+    QCOMPARE(container.packagesView()[1].packageID, QString("PKG002"));
+
+    QVector<PackageData> packages = container.getPackages();
+    QCOMPARE(packages.size(), 2);
+    QCOMPARE(packages[0].packageID, QString("PKG001"));
+    QCOMPARE(container.getPackages(), packages);
+
+    Package replacement("PKG003");
+    const QVector<Package*> replacements = {&replacement};
+    container.setPackages(replacements);
+    QCOMPARE(container.packageCount(), 1);
+    QCOMPARE(container.packagesView()[0].packageID, QString("PKG003"));
+
+    // adoptPackages() takes ownership of the objects
+    container.adoptPackages(QVector<Package*>{new Package("PKG004")});
+    QCOMPARE(container.packagesView()[0].packageID, QString("PKG004"));
+
+    container.setPackages(QVector<PackageData>{{"PKG006"}, {"PKG007"}});
+    QCOMPARE(container.packageCount(), 2);
+    QCOMPARE(container.getPackages().constLast().packageID, QString("PKG007"));
+    QCOMPARE(container.getContainerNextDestinations().size(), 1);
+}
+
 // Test current location in a Container
 void TestContainer::testCurrentLocation()
 {
@@ -128,6 +286,56 @@ void TestContainer::testMovementHistory() {
     QCOMPARE(container.getContainerMovementHistory().size(), 0);
 }
 
+// Test bounded and hashed movement history
+void TestContainer::testMovementHistoryPolicy() {
+    Container container("TEST001", Container::twentyFT);
+    container.setMovementHistoryPolicy({3, true});
+
+    container.addMovementHistory("A");
+    container.addMovementHistory("B");
+    container.addMovementHistory("B");
+    container.addMovementHistory("C");
+    container.addMovementHistory("D");
+    QCOMPARE(container.getContainerMovementHistory(),
+             QVector<QString>({"B", "C", "D"}));
+    QVERIFY(!container.hasMovementHistory("A"));
+    QVERIFY(container.hasMovementHistory("D"));
+
+    // An evicted location can be recorded again
+    container.setContainerCurrentLocation("A");
+    QCOMPARE(container.getContainerMovementHistory(),
+             QVector<QString>({"C", "D", "A"}));
+
+    QVERIFY(container.removeMovementHistory("C"));
+    QVERIFY(!container.hasMovementHistory("C"));
+
+    // Tightening the bound trims the oldest entries
+    container.setMovementHistoryPolicy({1, false});
+    QCOMPARE(container.getContainerMovementHistory(),
+             QVector<QString>({"A"}));
+
+    // Loading keeps repeated visits, and the index counts them
+    Container revisited("TEST003", Container::twentyFT);
+    revisited.setContainerMovementHistory({"A", "B", "A"});
+    Container loaded(revisited.toJson());
+    QCOMPARE(loaded.getContainerMovementHistory(),
+             QVector<QString>({"A", "B", "A"}));
+    loaded.setMovementHistoryPolicy({0, true});
+    QVERIFY(loaded.removeMovementHistory("A"));
+    QVERIFY(loaded.hasMovementHistory("A"));
+    QVERIFY(loaded.removeMovementHistory("A"));
+    QVERIFY(!loaded.hasMovementHistory("A"));
+    QVERIFY(!loaded.removeMovementHistory("A"));
+
+    ContainerMap map;
+    Container *mapped = new Container("TEST002", Container::twentyFT);
+    mapped->setContainerMovementHistory({"X", "Y", "Z"});
+    map.addContainer("TEST002", mapped);
+    QCOMPARE(map.compactMovementHistory(1), 2);
+    QCOMPARE(map.getContainerByID("TEST002")->getContainerMovementHistory(),
+             QVector<QString>({"Z"}));
+}
+
 // Test JSON serialization in a Container
 void TestContainer::testJsonSerialization() {
     Container container("TEST001", Container::twentyFT);
@@ -144,6 +352,133 @@ void TestContainer::testJsonSerialization() {
     QCOMPARE(destinations[0].toString(), QString("Port B"));
 }
 
+// Test batched change notifications in a Container
+void TestContainer::testChangeBatch() {
+    Container container("TEST001", Container::twentyFT);
+    QSignalSpy locationSpy(&container,
+                           &Container::containerCurrentLocationChanged);
+    QSignalSpy historySpy(&container,
+                          &Container::containerMovementHistoryChanged);
+    QSignalSpy summarySpy(&container, &Container::containerChanged);
+
+    {
+        Container::ChangeBatch batch(&container);
+        container.setContainerCurrentLocation("Warehouse A");
+        container.setContainerCurrentLocation("Warehouse B");
+        container.addDestination("Port C");
+        QVERIFY(container.isBatchingChanges());
+        QCOMPARE(locationSpy.count(), 0);
+    }
+
+    QVERIFY(!container.isBatchingChanges());
+    QCOMPARE(locationSpy.count(), 1);
+    QCOMPARE(historySpy.count(), 1);
+    QCOMPARE(summarySpy.count(), 1);
+    Container::ChangeFlags changes =
+        summarySpy.at(0).at(0).value<Container::ChangeFlags>();
+    QVERIFY(changes.testFlag(Container::CurrentLocationChange));
+    QVERIFY(changes.testFlag(Container::MovementHistoryChange));
+    QVERIFY(changes.testFlag(Container::NextDestinationsChange));
+    QVERIFY(!changes.testFlag(Container::PackagesChange));
+}
+
+// Test QDataStream serialization of Container and Package
+void TestContainer::testDataStreamSerialization() {
+    Container container("DS001", Container::fourtyFT);
+    container.setContainerAddedTime(5.0);
+    container.setContainerLeavingTime(25.0);
+    container.setMovementHistoryPolicy({3, true});
+    container.setContainerCurrentLocation("Yard");
+    container.addDestination("Port A");
+    container.addPackage(PackageData{"PKG001"});
+    container.addPackage(PackageData{"PKG002"});
+    container.addCustomVariable(Container::truck, "weight", 1.5);
+
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out << container << container;
+    }
+
+    // Both records decode into the same recycled container
+    Container recycled("OLD", Container::twentyFT);
+    recycled.addDestination("Somewhere");
+    QSignalSpy idSpy(&recycled, &Container::containerIDChanged);
+    QDataStream in(data);
+    for (int i = 0; i < 2; ++i) {
+        in >> recycled;
+        QCOMPARE(in.status(), QDataStream::Ok);
+        QCOMPARE(recycled.toJson(), container.toJson());
+    }
+    QCOMPARE(recycled.getContainerLeavingTime(), 25.0);
+    QVERIFY(recycled.movementHistoryPolicy() ==
+            container.movementHistoryPolicy());
+    QCOMPARE(idSpy.count(), 0);
+
+    // Copies keep the times as well
+    Container copy(container);
+    QCOMPARE(copy.getContainerAddedTime(), 5.0);
+    QCOMPARE(copy.getContainerLeavingTime(), 25.0);
+
+    // Records written before the format was versioned still load
+    QByteArray legacy;
+    {
+        QDataStream out(&legacy, QIODevice::WriteOnly);
+        QVariantMap variables;
+        variables.insert("weight", 2.0);
+        out << QString("LEGACY") << int(Container::twentyFT)
+            << QString("Dock") << QVector<QString>{"Port B"}
+            << QVector<QString>{"Dock"};
+        out << qint64(1) << QString("PKG009");
+        out << qint64(1) << int(Container::truck) << variables;
+        out << QString("PKG010");
+    }
+    QDataStream legacyIn(legacy);
+    Container legacyContainer;
+    legacyIn >> legacyContainer;
+    QCOMPARE(legacyIn.status(), QDataStream::Ok);
+    QCOMPARE(legacyContainer.getContainerID(), QString("LEGACY"));
+    QCOMPARE(legacyContainer.getContainerNextDestinations(),
+             QVector<QString>{"Port B"});
+    QCOMPARE(legacyContainer.packagesView().size(), size_t(1));
+    QCOMPARE(legacyContainer.getCustomVariable(Container::truck, "weight")
+                 .toDouble(), 2.0);
+    QVERIFY(std::isnan(legacyContainer.getContainerAddedTime()));
+    Package legacyPackage;
+    legacyIn >> legacyPackage;
+    QCOMPARE(legacyPackage.packageID(), QString("PKG010"));
+
+    // A legacy record resets the policy of a recycled container
+    QDataStream legacyRecycledIn(legacy);
+    legacyRecycledIn >> recycled;
+    QCOMPARE(legacyRecycledIn.status(), QDataStream::Ok);
+    QVERIFY(recycled.movementHistoryPolicy() ==
+            Container::defaultMovementHistoryPolicy());
+
+    Package package("PKG003");
+    QByteArray packageData;
+    {
+        QDataStream out(&packageData, QIODevice::WriteOnly);
+        out << package;
+    }
+    Package packageCopy;
+    QDataStream packageIn(packageData);
+    packageIn >> packageCopy;
+    QCOMPARE(packageCopy.packageID(), QString("PKG003"));
+
+    // Newer format versions are rejected
+    QByteArray future;
+    {
+        QDataStream out(&future, QIODevice::WriteOnly);
+        out << DataStream::ContainerMagic
+            << quint16(DataStream::FormatVersion + 1);
+    }
+    QDataStream futureIn(future);
+    Container futureContainer;
+    futureIn >> futureContainer;
+    QCOMPARE(futureIn.status(), QDataStream::ReadCorruptData);
+}
+
 // Test ContainerMap operations
 void TestContainer::testContainerMapOperations() {
     ContainerMap map;
@@ -174,6 +509,675 @@ void TestContainer::testContainerMapJsonSerialization() {
     QCOMPARE(loadedContainers[0]->getContainerID(), QString("TEST001"));
 }
 
+// Test batched change notifications in a ContainerMap
+void TestContainer::testContainerMapBatch() {
+    ContainerMap map;
+    QSignalSpy changedSpy(&map, &ContainerMap::containersChanged);
+    QSignalSpy batchSpy(&map, &ContainerMap::containersBatchChanged);
+
+    map.beginBatch();
+    for (int i = 0; i < 10; ++i) {
+        QString id = QStringLiteral("TEST%1").arg(i);
+        map.addContainer(id, new Container(id, Container::twentyFT));
+    }
+    map.removeContainerByID("TEST0");
+    QCOMPARE(changedSpy.count(), 0);
+    map.endBatch();
+
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(batchSpy.count(), 1);
+    QStringList changedIDs = batchSpy.at(0).at(0).toStringList();
+    QCOMPARE(changedIDs.size(), 10);
+    QVERIFY(changedIDs.contains("TEST0"));
+    QCOMPARE(map.size(), 9);
+
+    // Unbatched changes keep emitting per operation
+    map.removeContainerByID("TEST1");
+    QCOMPARE(changedSpy.count(), 2);
+    QCOMPARE(batchSpy.count(), 1);
+}
+
 // Main function to run tests
+// Test binary snapshot round trip
+void TestContainer::testContainerMapSnapshot() {
+    ContainerMap map;
+    Container *container = new Container("SNAP001", Container::fourtyFT);
+    container->setContainerCurrentLocation("Yard 1");
+    container->addDestination("Port B");
+    container->addPackage(PackageData{"PKG001"});
+    container->addCustomVariable(Container::truck, "weight", 500);
+    container->addCustomVariable(Container::truck, "label", "fragile");
+    container->setContainerLeavingTime(42.5);
+    map.addContainer("SNAP001", container, 10.0);
+    map.addContainer("SNAP000",
+                     new Container("SNAP000", Container::twentyFT), 5.0);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    QVERIFY(map.saveSnapshot(&buffer));
+
+    ContainerMap loaded;
+    buffer.seek(0);
+    QVERIFY(loaded.loadSnapshot(&buffer));
+    QCOMPARE(loaded.size(), 2);
+
+    Container *copy = loaded.getContainerByID("SNAP001");
+    QVERIFY(copy);
+    QCOMPARE(copy->getContainerSize(), Container::fourtyFT);
+    QCOMPARE(copy->getContainerCurrentLocation(), QString("Yard 1"));
+    QCOMPARE(copy->getContainerNextDestinations(),
+             QVector<QString>({"Port B"}));
+    QCOMPARE(copy->getContainerMovementHistory(),
+             QVector<QString>({"Yard 1"}));
+    QCOMPARE(copy->packagesView()[0].packageID, QString("PKG001"));
+    QCOMPARE(copy->getCustomVariable(Container::truck, "weight").toInt(), 500);
+    QCOMPARE(copy->getCustomVariable(Container::truck, "label").toString(),
+             QString("fragile"));
+    QCOMPARE(copy->getContainerAddedTime(), 10.0);
+    QCOMPARE(copy->getContainerLeavingTime(), 42.5);
+
+    // Corrupt data is rejected and leaves the map untouched
+    QBuffer garbage;
+    garbage.setData("not a snapshot");
+    garbage.open(QIODevice::ReadOnly);
+    QVERIFY(!loaded.loadSnapshot(&garbage));
+    QCOMPARE(loaded.size(), 2);
+}
+
+// Test serving a map directly from a mapped snapshot file
+void TestContainer::testContainerMapSnapshotBacked() {
+    ContainerMap map;
+    for (int i = 0; i < 10; ++i) {
+        const QString id = QString("MAP%1").arg(i, 3, 10, QChar('0'));
+        Container *container = new Container(id, Container::twentyFT);
+        container->addDestination(i % 2 ? "Port A" : "Port B");
+        map.addContainer(id, container, double(i));
+    }
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("map.snap");
+    QVERIFY(map.saveSnapshot(path));
+
+    ContainerMap mapped;
+    QVERIFY(mapped.openSnapshot(path));
+    QVERIFY(mapped.isSnapshotBacked());
+    QCOMPARE(mapped.size(), 10);
+
+    Container *container = mapped.getContainerByID("MAP007");
+    QVERIFY(container);
+    QCOMPARE(container->getContainerAddedTime(), 7.0);
+    QCOMPARE(mapped.getContainerByID("MAP007"), container);
+    QVERIFY(!mapped.getContainerByID("MISSING"));
+
+    QCOMPARE(mapped.countContainersByAddedTime(">=", 5.0), 5);
+    QCOMPARE(mapped.countContainersByAddedTime("!=", 5.0), 9);
+    QVector<Container *> early = mapped.getContainersByAddedTime("<", 2.0);
+    QCOMPARE(early.size(), 2);
+    QCOMPARE(early[0]->getContainerID(), QString("MAP000"));
+    QCOMPARE(mapped.countContainersByNextDestination("Port A"), 5);
+    QCOMPARE(mapped.getContainersByNextDestination("Port C").size(), 0);
+
+    // Writes are rejected while the snapshot is open
+    mapped.removeContainerByID("MAP007");
+    QCOMPARE(mapped.size(), 10);
+    QVERIFY(mapped.dequeueContainersByNextDestination("Port A").isEmpty());
+
+    mapped.closeSnapshot();
+    QVERIFY(!mapped.isSnapshotBacked());
+    QCOMPARE(mapped.size(), 0);
+}
+
+// Test incremental JSON ingest
+void TestContainer::testContainerMapJsonStream() {
+    QByteArray json = R"({
+        "databaseInfo": {"note": "brackets ] and } in \"strings\""},
+        "containers": [
+            {"containerID": "JS001", "containerSize": 0,
+             "containerCurrentLocation": "Yard [1]"},
+            42,
+            {"containerID": "JS002", "containerSize": 1},
+            {"containerID": "JS003", broken}
+        ]
+    })";
+    QBuffer buffer(&json);
+    buffer.open(QIODevice::ReadOnly);
+
+    ContainerMap map;
+    QSignalSpy spy(&map, &ContainerMap::containersChanged);
+    QTest::ignoreMessage(QtWarningMsg,
+                         "Failed to add container: item is not a JSON object");
+    QTest::ignoreMessage(QtWarningMsg,
+                         QRegularExpression("item 3 is not valid JSON"));
+    QVERIFY(map.addContainersFromJsonStream(&buffer, 1.0));
+    QCOMPARE(map.size(), 2);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(map.getContainerByID("JS001")->getContainerCurrentLocation(),
+             QString("Yard [1]"));
+    QCOMPARE(map.getContainerByID("JS002")->getContainerAddedTime(), 1.0);
+
+    // A truncated document keeps the records read before the error
+    QByteArray truncated = R"({"containers": [{"containerID": "JS004",
+        "containerSize": 0}, {"containerID": )";
+    QBuffer truncatedBuffer(&truncated);
+    truncatedBuffer.open(QIODevice::ReadOnly);
+    QTest::ignoreMessage(QtWarningMsg,
+                         QRegularExpression("Failed to add containers"));
+    QVERIFY(!map.addContainersFromJsonStream(&truncatedBuffer));
+    QCOMPARE(map.size(), 3);
+}
+
+// Test parallel construction from a DOM and from a stream
+void TestContainer::testContainerMapParallelIngest() {
+    QJsonArray containers;
+    for (int i = 0; i < 2000; ++i) {
+        QJsonObject container;
+        container["containerID"] = QString("PAR%1").arg(i);
+        container["containerSize"] = 0;
+        containers.append(container);
+    }
+    containers.append(42);
+    QJsonObject json;
+    json["containers"] = containers;
+
+    ContainerMap domMap;
+    QSignalSpy spy(&domMap, &ContainerMap::containersChanged);
+    QTest::ignoreMessage(QtWarningMsg,
+                         "Failed to add container: item is not a JSON object");
+    domMap.addContainersParallel(json, 3.0, std::nan("notDefined"), 4);
+    QCOMPARE(domMap.size(), 2000);
+    QCOMPARE(spy.count(), 1);
+    Container *container = domMap.getContainerByID("PAR1999");
+    QVERIFY(container);
+    QCOMPARE(container->thread(), domMap.thread());
+    QCOMPARE(container->getContainerAddedTime(), 3.0);
+
+    QByteArray data = QJsonDocument(json).toJson();
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    ContainerMap streamMap;
+    QTest::ignoreMessage(QtWarningMsg,
+                         "Failed to add container: item is not a JSON object");
+    QVERIFY(streamMap.addContainersParallel(&buffer, std::nan("notDefined"),
+                                            std::nan("notDefined"), 4));
+    QCOMPARE(streamMap.size(), 2000);
+    QVERIFY(streamMap.getContainerByID("PAR0"));
+}
+
+// Test that streamed JSON matches the DOM serialization
+void TestContainer::testWriteJson() {
+    Container *container = new Container("WJ001", Container::twentyFT);
+    container->setContainerCurrentLocation("Yard \"A\"\n");
+    container->addDestination("Port B");
+    container->addPackage(PackageData{"PKG001"});
+    container->addCustomVariable(Container::truck, "weight", 500);
+    container->addCustomVariable(Container::truck, "ratio", 0.25);
+    container->addCustomVariable(Container::truck, "missing",
+                                 std::nan("notDefined"));
+    container->addCustomVariable(Container::train, "label", "fragile");
+
+    QBuffer containerBuffer;
+    containerBuffer.open(QIODevice::WriteOnly);
+    QVERIFY(container->writeJson(&containerBuffer));
+    QCOMPARE(containerBuffer.data(), QJsonDocument(container->toJson())
+                                         .toJson(QJsonDocument::Compact));
+
+    ContainerMap map;
+    map.addContainer("WJ001", container, 12.5);
+    map.addContainer("WJ002", new Container("WJ002", Container::fourtyFT));
+
+    QBuffer mapBuffer;
+    mapBuffer.open(QIODevice::WriteOnly);
+    QVERIFY(map.writeJson(&mapBuffer));
+    QCOMPARE(mapBuffer.data(), QJsonDocument(map.toJson())
+                                   .toJson(QJsonDocument::Compact));
+}
+
+// Test checkpoints, delta snapshots and chain compaction
+void TestContainer::testDeltaSnapshots() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString basePath = dir.filePath("base.snap");
+    const QString firstDelta = dir.filePath("delta1.snap");
+    const QString secondDelta = dir.filePath("delta2.snap");
+
+    ContainerMap map;
+    for (int i = 0; i < 3; ++i) {
+        const QString id = QString("DELTA%1").arg(i);
+        map.addContainer(id, new Container(id, Container::twentyFT), i);
+    }
+    QVERIFY(!map.hasCheckpoint());
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("no checkpoint"));
+    QVERIFY(!map.saveDeltaSnapshot(firstDelta));
+    QVERIFY(map.saveSnapshot(basePath));
+    map.markCheckpoint();
+
+    map.getContainerByID("DELTA0")->setContainerCurrentLocation("Gate 4");
+    map.removeContainerByID("DELTA1");
+    map.addContainer("DELTA3", new Container("DELTA3", Container::fourtyFT));
+    QVERIFY(map.saveDeltaSnapshot(firstDelta));
+
+    map.getContainerByID("DELTA2")->addDestination("Port C");
+    QVERIFY(map.saveDeltaSnapshot(secondDelta));
+
+    // Only the container touched after the first delta is written again
+    QFile file(secondDelta);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray deltaBytes = file.readAll();
+    ContainerSnapshotReader reader;
+    QVERIFY(reader.open(reinterpret_cast<const uchar *>(deltaBytes.constData()),
+                        deltaBytes.size()));
+    QVERIFY(reader.isDelta());
+    QCOMPARE(reader.containerCount(), 1);
+    QVERIFY(reader.removedContainers().isEmpty());
+
+    ContainerMap replayed;
+    QVERIFY(replayed.loadSnapshotChain(basePath, {firstDelta, secondDelta}));
+    QCOMPARE(replayed.toJson(), map.toJson());
+    QVERIFY(!replayed.getContainerByID("DELTA1"));
+
+    const QString compactPath = dir.filePath("compact.snap");
+    QVERIFY(ContainerMap::compactSnapshotChain(
+        basePath, {firstDelta, secondDelta}, compactPath));
+    ContainerMap compacted;
+    QVERIFY(compacted.loadSnapshot(compactPath));
+    QCOMPARE(compacted.toJson(), map.toJson());
+
+    QTest::ignoreMessage(QtWarningMsg,
+                         QRegularExpression("delta snapshots must be applied"));
+    QVERIFY(!compacted.loadSnapshot(firstDelta));
+}
+
+// Test block-compressed snapshots and JSON exports
+void TestContainer::testCompressedSnapshots() {
+    // Small blocks so the data spans several of them
+    QByteArray plain;
+    for (int i = 0; i < 1000; ++i) {
+        plain.append(QByteArray::number(i)).append(" Port ");
+    }
+    QBuffer compressedBuffer;
+    compressedBuffer.open(QIODevice::ReadWrite);
+    {
+        CompressedBlockWriter writer(&compressedBuffer, Compression::Zlib, 256);
+        QCOMPARE(writer.write(plain), qint64(plain.size()));
+        writer.close();
+        QVERIFY(!writer.hasError());
+    }
+    QVERIFY(Compression::isCompressed(compressedBuffer.data()));
+    CompressedBlockReader reader(&compressedBuffer);
+    QVERIFY(reader.open(QIODevice::ReadOnly));
+    QVERIFY(reader.blockCount() > 1);
+    QCOMPARE(reader.readBlock(1), plain.mid(256, 256));
+    QByteArray inflated;
+    QVERIFY(Compression::decompress(
+        reinterpret_cast<const uchar *>(compressedBuffer.data().constData()),
+        compressedBuffer.size(), inflated, 2));
+    QCOMPARE(inflated, plain);
+
+    ContainerMap map;
+    for (int i = 0; i < 100; ++i) {
+        const QString id = QString("ZIP%1").arg(i);
+        Container *container = new Container(id, Container::twentyFT);
+        container->addDestination("Port A");
+        map.addContainer(id, container, i);
+    }
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("map.snapz");
+    QVERIFY(map.saveSnapshot(path, Compression::bestAvailableCodec()));
+
+    ContainerMap loaded;
+    QVERIFY(loaded.loadSnapshot(path));
+    QCOMPARE(loaded.toJson(), map.toJson());
+
+    ContainerMap mapped;
+    QVERIFY(mapped.openSnapshot(path));
+    QCOMPARE(mapped.countContainersByNextDestination("Port A"), 100);
+
+    QBuffer jsonBuffer;
+    jsonBuffer.open(QIODevice::ReadWrite);
+    QVERIFY(map.writeJson(&jsonBuffer, Compression::Zlib));
+    jsonBuffer.seek(0);
+    ContainerMap fromJson;
+    QVERIFY(fromJson.addContainersFromJsonStream(&jsonBuffer));
+    QCOMPARE(fromJson.size(), 100);
+}
+
+void TestContainer::testArrowExport() {
+    ContainerMap map;
+    for (int i = 0; i < 50; ++i) {
+        const QString id = QString("ARW%1").arg(i);
+        Container *container = new Container(id, Container::fourtyFT);
+        container->setContainerCurrentLocation("Yard");
+        container->addDestination("Port A");
+        container->addDestination("Port B");
+        container->addPackage(PackageData{QString("PKG%1").arg(i)});
+        map.addContainer(id, container, i);
+    }
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("map.feather");
+
+    if (!ContainerArrowWriter::isAvailable()) {
+        QVERIFY(!map.saveArrow(path));
+        QSKIP("Built without Arrow support");
+    }
+
+    QVERIFY(map.saveArrow(path));
+
+    ContainerArrowReader reader;
+    QVERIFY(reader.open(path));
+    QCOMPARE(reader.containerCount(), qsizetype(50));
+    std::unique_ptr<Container> first(reader.createContainer(0));
+    QVERIFY(std::isnan(first->getContainerLeavingTime()));
+
+    ContainerMap loaded;
+    QVERIFY(loaded.loadArrow(path));
+    QCOMPARE(loaded.toJson(), map.toJson());
+    QVERIFY(!loaded.loadArrow(dir.filePath("missing.feather")));
+    QCOMPARE(loaded.size(), 50);
+}
+
+void TestContainer::testCborSerialization() {
+    Package package("PKG001");
+    std::unique_ptr<Package> packageCopy(Package::fromCbor(package.toCbor()));
+    QCOMPARE(packageCopy->packageID(), QString("PKG001"));
+
+    Container container("CBOR001", Container::fourtyFT);
+    container.setContainerAddedTime(12.5);
+    container.setContainerLeavingTime(std::nan(""));
+    container.setContainerCurrentLocation("Yard");
+    container.addDestination("Port A");
+    container.addPackage(PackageData{"PKG001"});
+    container.addCustomVariable(Container::truck, "weight", 1.5);
+    container.addCustomVariable(Container::train, "missing",
+                                std::nan(""));
+
+    // NaN survives without the null round trip JSON needs
+    std::unique_ptr<Container> copy(Container::fromCbor(container.toCbor()));
+    QVERIFY(copy);
+    QCOMPARE(copy->toJson(), container.toJson());
+    QVERIFY(std::isnan(copy->getContainerLeavingTime()));
+    QVERIFY(std::isnan(
+        copy->getCustomVariable(Container::train, "missing").toDouble()));
+    QVERIFY(!Container::fromCbor(QCborMap()));
+
+    // The streaming writer matches the DOM encoding byte for byte
+    QByteArray streamed;
+    {
+        QCborStreamWriter writer(&streamed);
+        container.writeCbor(writer);
+    }
+    QCOMPARE(streamed, container.toCbor().toCborValue().toCbor());
+
+    // Reading into a used container replaces all of its data
+    Container recycled("OLD", Container::twentyFT);
+    recycled.addDestination("Somewhere");
+    QCborStreamReader reader(streamed);
+    QVERIFY(recycled.readCbor(reader));
+    QCOMPARE(recycled.toJson(), container.toJson());
+
+    ContainerMap map;
+    for (int i = 0; i < 20; ++i) {
+        const QString id = QString("CBM%1").arg(i);
+        Container *item = new Container(id, Container::twentyFT);
+        item->addDestination("Port B");
+        map.addContainer(id, item);
+    }
+
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    QVERIFY(map.writeCbor(&buffer, Compression::Zlib));
+    buffer.seek(0);
+    ContainerMap streamedMap;
+    QVERIFY(streamedMap.addContainersFromCborStream(&buffer));
+    QCOMPARE(streamedMap.toJson(), map.toJson());
+
+    ContainerMap domMap;
+    domMap.addContainers(map.toCbor());
+    QCOMPARE(domMap.toJson(), map.toJson());
+
+    QBuffer garbage;
+    garbage.setData("not cbor");
+    garbage.open(QIODevice::ReadOnly);
+    QVERIFY(!domMap.addContainersFromCborStream(&garbage));
+
+    // A malformed element is skipped and the rest is still read
+    QCborArray mixed;
+    mixed.append(Container("GOOD1", Container::twentyFT).toCbor());
+    mixed.append(42);
+    mixed.append(Container("GOOD2", Container::twentyFT).toCbor());
+    QCborMap mixedDocument;
+    mixedDocument.insert(QLatin1String("containers"), mixed);
+    QBuffer mixedBuffer;
+    mixedBuffer.setData(mixedDocument.toCborValue().toCbor());
+    mixedBuffer.open(QIODevice::ReadOnly);
+    ContainerMap mixedMap;
+    QVERIFY(mixedMap.addContainersFromCborStream(&mixedBuffer));
+    QCOMPARE(mixedMap.size(), qsizetype(2));
+    QVERIFY(mixedMap.containsContainer("GOOD2"));
+}
+
+void TestContainer::testContainerMapColumns() {
+    ContainerMap map;
+    for (int i = 0; i < 20; ++i) {
+        const QString id = QString("COL%1").arg(i, 2, 10, QChar('0'));
+        Container *container = new Container(id, Container::tenFT);
+        container->setContainerLeavingTime(i % 2 ? 100.0 + i : std::nan(""));
+        map.addContainer(id, container, i);
+    }
+
+    const ContainerMap::Columns columns = map.columns();
+    QCOMPARE(columns.ids.size(), qsizetype(20));
+    QCOMPARE(columns.sizes.size(), qsizetype(20));
+    QCOMPARE(columns.addedTimes.size(), qsizetype(20));
+    QCOMPARE(columns.leavingTimes.size(), qsizetype(20));
+    QCOMPARE(columns.ids[3], QString("COL03"));
+    QCOMPARE(columns.sizes[3], qint32(Container::tenFT));
+    QCOMPARE(columns.addedTimes[3], 3.0);
+    QCOMPARE(columns.leavingTimes[3], 103.0);
+    QVERIFY(std::isnan(columns.leavingTimes[4]));
+
+    // A snapshot-backed map answers from the records
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("columns.snap");
+    QVERIFY(map.saveSnapshot(path));
+    ContainerMap mapped;
+    QVERIFY(mapped.openSnapshot(path));
+    const ContainerMap::Columns mappedColumns = mapped.columns();
+    QCOMPARE(mappedColumns.ids, columns.ids);
+    QCOMPARE(mappedColumns.sizes, columns.sizes);
+    QCOMPARE(mappedColumns.addedTimes, columns.addedTimes);
+    QCOMPARE(mappedColumns.leavingTimes[3], 103.0);
+    QVERIFY(std::isnan(mappedColumns.leavingTimes[4]));
+}
+
+void TestContainer::testContainerMapPaging() {
+    ContainerMap map;
+    for (int i = 0; i < 10; ++i) {
+        const QString id = QString("PG%1").arg(i);
+        Container *container = new Container(id, Container::twentyFT);
+        if (i % 3 == 0) {
+            container->addDestination("Port A");
+        }
+        map.addContainer(id, container, i);
+    }
+
+    QVERIFY(map.containsContainer("PG4"));
+    QVERIFY(!map.containsContainer("PG42"));
+
+    // Walk the IDs three at a time
+    QStringList ids;
+    QString last;
+    for (QStringList page = map.getContainerIDsPage(last, 3); !page.isEmpty();
+         page = map.getContainerIDsPage(last, 3)) {
+        QVERIFY(page.size() <= 3);
+        ids += page;
+        last = page.last();
+    }
+    QCOMPARE(ids.size(), 10);
+    QCOMPARE(ids, map.getAllContainers().keys());
+
+    ContainerMap::PageFilter byTime;
+    byTime.field = ContainerMap::PageFilter::AddedTime;
+    byTime.condition = ">=";
+    byTime.referenceTime = 5.0;
+    QVector<Container *> page = map.getContainersPage("PG6", 10, byTime);
+    QCOMPARE(page.size(), 3);
+    QCOMPARE(page.first()->getContainerID(), QString("PG7"));
+
+    ContainerMap::PageFilter byDestination;
+    byDestination.field = ContainerMap::PageFilter::NextDestination;
+    byDestination.destination = "Port A";
+    page = map.getContainersPage(QString(), 2, byDestination);
+    QCOMPARE(page.size(), 2);
+    QCOMPARE(page.last()->getContainerID(), QString("PG3"));
+
+    // A snapshot-backed map pages the same way
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("paging.snap");
+    QVERIFY(map.saveSnapshot(path));
+    ContainerMap mapped;
+    QVERIFY(mapped.openSnapshot(path));
+    QVERIFY(mapped.containsContainer("PG4"));
+    QCOMPARE(mapped.getContainerIDsPage("PG2", 3),
+             QStringList({"PG3", "PG4", "PG5"}));
+    QCOMPARE(mapped.getContainersPage("PG6", 10, byTime).size(), 3);
+    page = mapped.getContainersPage("PG3", 10, byDestination);
+    QCOMPARE(page.size(), 2);
+    QCOMPARE(page.first()->getContainerID(), QString("PG6"));
+}
+
+void TestContainer::testContainerMapBatchUpdates() {
+    ContainerMap map;
+    for (int i = 0; i < 4; ++i) {
+        const QString id = QString("BU%1").arg(i);
+        map.addContainer(id, new Container(id, Container::twentyFT), i);
+    }
+
+    QSignalSpy batchSpy(&map, &ContainerMap::containersBatchChanged);
+    const QStringList ids({"BU0", "BU2", "BU9"});
+    QCOMPARE(map.setContainersCurrentLocation(ids, {"Yard", "Gate", "Nowhere"}),
+             qsizetype(2));
+    QCOMPARE(batchSpy.count(), 1);
+    QStringList changed = batchSpy.first().first().toStringList();
+    changed.sort();
+    QCOMPARE(changed, QStringList({"BU0", "BU2"}));
+    QCOMPARE(map.getContainerByID("BU2")->getContainerCurrentLocation(),
+             QString("Gate"));
+
+    QCOMPARE(map.addContainersDestination(ids, {"Port A", "Port B", "Port C"}),
+             qsizetype(2));
+    QCOMPARE(map.getContainerByID("BU0")->getContainerNextDestinations(),
+             QVector<QString>({"Port A"}));
+
+    QCOMPARE(map.addContainersCustomVariable(
+                 ids, Container::truck, "weight", {1.5, 2.5, 3.5}),
+             qsizetype(2));
+    QCOMPARE(map.getContainerByID("BU2")->getCustomVariable(
+                 Container::truck, "weight").toDouble(), 2.5);
+
+    // Mismatched lengths change nothing
+    QCOMPARE(map.setContainersCurrentLocation(ids, {"Yard"}), qsizetype(0));
+    QCOMPARE(map.getContainerByID("BU0")->getContainerCurrentLocation(),
+             QString("Yard"));
+    QCOMPARE(batchSpy.count(), 3);
+}
+
+void TestContainer::testContainerMapFromColumns() {
+    ContainerMap::Columns columns;
+    for (int i = 0; i < 1500; ++i) {
+        columns.ids.append(QString("FC%1").arg(i));
+        columns.sizes.append(i % 11);
+        columns.addedTimes.append(i);
+        columns.leavingTimes.append(i + 10.0);
+    }
+    // Skipped rows: no ID, an unknown size and a repeated ID
+    columns.ids[3].clear();
+    columns.sizes[7] = 42;
+    columns.ids[9] = QString("FC8");
+    QVector<QString> locations(columns.ids.size(), QString("Yard"));
+
+    ContainerMap map;
+    QSignalSpy batchSpy(&map, &ContainerMap::containersBatchChanged);
+    QCOMPARE(map.addContainersFromColumns(columns, locations, 2), qsizetype(1497));
+    QCOMPARE(map.size(), qsizetype(1497));
+    QCOMPARE(batchSpy.count(), 1);
+
+    Container *container = map.getContainerByID("FC1200");
+    QVERIFY(container);
+    QCOMPARE(container->getContainerSize(), Container::ContainerSize(1200 % 11));
+    QCOMPARE(container->getContainerAddedTime(), 1200.0);
+    QCOMPARE(container->getContainerLeavingTime(), 1210.0);
+    QCOMPARE(container->getContainerCurrentLocation(), QString("Yard"));
+    QCOMPARE(container->getContainerMovementHistory(), QVector<QString>{"Yard"});
+    QCOMPARE(container->thread(), map.thread());
+    QVERIFY(!map.containsContainer("FC7"));
+    QCOMPARE(map.getContainerByID("FC8")->getContainerAddedTime(), 8.0);
+
+    // Optional columns may be left empty, but not be shorter than ids
+    ContainerMap::Columns idsOnly;
+    idsOnly.ids = {"X1", "X2"};
+    ContainerMap other;
+    QCOMPARE(other.addContainersFromColumns(idsOnly), qsizetype(2));
+    QVERIFY(std::isnan(other.getContainerByID("X1")->getContainerAddedTime()));
+    idsOnly.sizes = {0};
+    QCOMPARE(other.addContainersFromColumns(idsOnly), qsizetype(0));
+}
+
+void TestContainer::testDatabaseFromWorkerThread() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("worker.db");
+    {
+        ContainerMap writer(path);
+        for (int i = 0; i < 5; ++i) {
+            const QString id = QString("WT%1").arg(i);
+            writer.addContainer(id, new Container(id, Container::twentyFT), i);
+        }
+    }
+
+    // Worker threads get their own connection and hand the containers
+    // they load over to the map's thread
+    ContainerMap map(path);
+    qsizetype count = 0;
+    QThread *loadedThread = nullptr;
+    std::unique_ptr<QThread> worker(QThread::create([&]() {
+        count = map.countContainersByAddedTime(">=", 2);
+        Container *container = map.getContainerByID("WT3");
+        loadedThread = container ? container->thread() : nullptr;
+    }));
+    worker->start();
+    QVERIFY(worker->wait(10000));
+    QCOMPARE(count, qsizetype(3));
+    QCOMPARE(loadedThread, map.thread());
+    QCOMPARE(map.size(), qsizetype(5));
+
+    // A map destroyed while its worker thread still runs leaves the clone
+    // to that thread, which closes it when it finishes
+    QStringList connections = QSqlDatabase::connectionNames();
+    connections.sort();
+    auto shortLived = std::make_unique<ContainerMap>(path);
+    QSemaphore queried;
+    QSemaphore mapGone;
+    std::unique_ptr<QThread> lingering(QThread::create([&]() {
+        shortLived->countContainersByAddedTime(">=", 0);
+        queried.release();
+        mapGone.acquire();
+    }));
+    lingering->start();
+    queried.acquire();
+    shortLived.reset();
+    mapGone.release();
+    QVERIFY(lingering->wait(10000));
+    QStringList remaining = QSqlDatabase::connectionNames();
+    remaining.sort();
+    QCOMPARE(remaining, connections);
+}
+
 QTEST_MAIN(TestContainer)
 #include "test_container.moc"
@@ -0,0 +1,65 @@
+"""
+Benchmark for building a ContainerMap from columns.
+
+Compares ContainerMap.from_columns() on NumPy arrays (and on Arrow arrays
+when pyarrow is installed) with constructing Container objects row by row
+in Python.
+
+Usage:
+    python tests/python/bench_columns.py [--containers N] [--repeat R]
+"""
+
+import argparse
+
+import numpy as np
+
+import ContainerPy
+
+from bench_common import report
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--containers", type=int, default=1000000)
+    parser.add_argument("--repeat", type=int, default=3)
+    args = parser.parse_args()
+
+    n = args.containers
+    ids = np.array([f"C{i}" for i in range(n)], dtype=object)
+    sizes = (np.arange(n) % 11).astype(np.int32)
+    added = np.arange(n, dtype=np.float64)
+    leaving = added + 24.0
+    locations = np.array(["Yard"] * n, dtype=object)
+
+    def row_by_row():
+        container_map = ContainerPy.ContainerMap()
+        # Python owns these containers; keep them alive with the map
+        containers = []
+        for i in range(n):
+            container = ContainerPy.Container(ids[i], ContainerPy.ContainerSize(int(sizes[i])))
+            container.set_container_current_location(locations[i])
+            container_map.add_container(container, added[i], leaving[i])
+            containers.append(container)
+        return container_map, containers
+
+    timings = [
+        ("from_columns (NumPy)",
+         lambda: ContainerPy.ContainerMap.from_columns(ids, sizes, added, leaving, locations)),
+        ("row by row (Python)", row_by_row),
+    ]
+
+    try:
+        import pyarrow as pa
+    except ImportError:
+        pa = None
+    if pa is not None:
+        arrow = [pa.array(ids.tolist()), pa.array(sizes), pa.array(added),
+                 pa.array(leaving), pa.array(locations.tolist())]
+        timings.insert(1, ("from_columns (Arrow)",
+                           lambda: ContainerPy.ContainerMap.from_columns(*arrow)))
+
+    report(n, args.repeat, timings)
+
+
+if __name__ == "__main__":
+    main()
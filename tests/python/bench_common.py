@@ -0,0 +1,43 @@
+"""
+Helpers shared by the ContainerPy benchmarks in this directory.
+
+The benchmarks import this module by name, so run them as scripts from
+any directory; Python puts tests/python on the path.
+"""
+
+import time
+
+
+def make_record(i, prefix="C"):
+    """Returns a container dictionary in the to_json() layout."""
+    return {
+        "containerID": f"{prefix}{i}",
+        "containerSize": i % 11,
+        "containerCurrentLocation": "Yard",
+        "addedTime": float(i),
+        "leavingTime": None,
+        "containerNextDestinations": ["Port A", "Port B"],
+        "containerMovementHistory": ["Gate", "Yard"],
+        "packages": [{"packageID": f"P{i}-{k}"} for k in range(3)],
+        "customVariables": {"0": {"weight": 12.5, "owner": "ACME"}},
+    }
+
+
+def best_of(repeat, fn):
+    """Returns the fastest of repeat calls to fn, in seconds."""
+    best = float("inf")
+    for _ in range(repeat):
+        start = time.perf_counter()
+        fn()
+        best = min(best, time.perf_counter() - start)
+    return best
+
+
+def report(count, repeat, timings):
+    """Times each (name, fn) pair and prints one line per pair."""
+    width = max(len(name) for name, _ in timings) + 2
+    print(f"{count} containers, best of {repeat}")
+    for name, fn in timings:
+        elapsed = best_of(repeat, fn)
+        rate = count / elapsed if elapsed else float("inf")
+        print(f"{name:<{width}} {elapsed * 1000:>10.1f} ms {rate:>12.0f} containers/s")
@@ -0,0 +1,51 @@
+"""
+Benchmark for the conversions between containers and Python dicts.
+
+Measures Container.to_json(), ContainerMap.to_json(), Container(dict) and
+ContainerMap.add_containers_from_dict(). Run it against two builds of
+ContainerPy to compare them; the JSON baseline column converts the same
+data with the json module for reference.
+
+Usage:
+    python tests/python/bench_dict.py [--containers N] [--repeat R]
+"""
+
+import argparse
+import json
+
+import ContainerPy
+
+from bench_common import make_record, report
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--containers", type=int, default=50000)
+    parser.add_argument("--repeat", type=int, default=5)
+    args = parser.parse_args()
+
+    records = [make_record(i) for i in range(args.containers)]
+    payload = {"containers": records}
+    encoded = json.dumps(payload)
+
+    container_map = ContainerPy.ContainerMap()
+    container_map.add_containers_from_dict(payload)
+    containers = container_map.get_all_containers()
+
+    def ingest():
+        target = ContainerPy.ContainerMap()
+        target.add_containers_from_dict(payload)
+
+    timings = [
+        ("Container(dict)", lambda: [ContainerPy.Container(r) for r in records]),
+        ("Container.to_json()", lambda: [c.to_json() for c in containers]),
+        ("ContainerMap.add_containers_from_dict()", ingest),
+        ("ContainerMap.to_json()", container_map.to_json),
+        ("json.loads (baseline)", lambda: json.loads(encoded)),
+    ]
+
+    report(args.containers, args.repeat, timings)
+
+
+if __name__ == "__main__":
+    main()
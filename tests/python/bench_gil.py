@@ -0,0 +1,83 @@
+"""
+Multithreaded benchmark for the GIL release in the ContainerMap bindings.
+
+Each worker thread owns a ContainerMap and repeatedly bulk-adds containers
+from a dictionary, runs time queries and serializes the map with to_json.
+While the workers run, the main thread counts how often a pure-Python
+loop gets scheduled. With the GIL released around the C++ work the
+ticker keeps running and the workers overlap, so the wall time grows
+much less than linearly with the thread count.
+
+Usage:
+    python tests/python/bench_gil.py [--containers N] [--rounds R] [--threads T ...]
+"""
+
+import argparse
+import threading
+import time
+
+import ContainerPy
+
+
+def make_payload(count, prefix):
+    return {
+        "containers": [
+            {
+                "containerID": f"{prefix}-{i}",
+                "containerSize": i % 11,
+                "containerCurrentLocation": "Yard",
+                "containerNextDestinations": ["Port A", "Port B"],
+                "containerMovementHistory": [],
+                "packages": [{"packageID": f"{prefix}-PKG-{i}"}],
+                "customVariables": {},
+            }
+            for i in range(count)
+        ]
+    }
+
+
+def worker(payload, rounds):
+    container_map = ContainerPy.ContainerMap()
+    for round_index in range(rounds):
+        container_map.clear()
+        container_map.add_containers_from_dict(payload, float(round_index))
+        container_map.count_containers_by_added_time(">=", 0.0)
+        container_map.get_containers_by_next_destination("Port A")
+        container_map.to_json()
+
+
+def run(thread_count, containers, rounds):
+    payloads = [make_payload(containers, f"T{t}") for t in range(thread_count)]
+    threads = [
+        threading.Thread(target=worker, args=(payloads[t], rounds))
+        for t in range(thread_count)
+    ]
+
+    ticks = 0
+    start = time.perf_counter()
+    for thread in threads:
+        thread.start()
+    while any(thread.is_alive() for thread in threads):
+        ticks += 1
+        time.sleep(0)
+    for thread in threads:
+        thread.join()
+    return time.perf_counter() - start, ticks
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--containers", type=int, default=20000)
+    parser.add_argument("--rounds", type=int, default=5)
+    parser.add_argument("--threads", type=int, nargs="+", default=[1, 2, 4, 8])
+    args = parser.parse_args()
+
+    print(f"{'threads':>8} {'wall [s]':>10} {'per thread [s]':>15} {'main ticks':>11}")
+    for thread_count in args.threads:
+        elapsed, ticks = run(thread_count, args.containers, args.rounds)
+        print(f"{thread_count:>8} {elapsed:>10.3f} "
+              f"{elapsed / thread_count:>15.3f} {ticks:>11}")
+
+
+if __name__ == "__main__":
+    main()
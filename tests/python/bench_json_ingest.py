@@ -0,0 +1,62 @@
+"""
+Benchmark for ingesting containers through the JSON conversion path.
+
+ContainerMap(json_dict) and ContainerMap.load_containers_from_json()
+convert the dictionary to a QJsonObject first. The records mix 64-bit
+integers, floats, NumPy scalars and nested custom variables, so the run
+also checks that 64-bit values survive the conversion. Run it against two
+builds of ContainerPy to compare them.
+
+Usage:
+    python tests/python/bench_json_ingest.py [--containers N] [--repeat R]
+"""
+
+import argparse
+
+import numpy as np
+
+import ContainerPy
+
+import bench_common
+
+SERIAL_BASE = 2**40
+
+
+def make_record(i):
+    record = bench_common.make_record(i, "J")
+    record.update({
+        "addedTime": 1_700_000_000 + i,
+        "leavingTime": np.float64(1_700_086_400 + i),
+        "customVariables": {
+            0: {"serial": SERIAL_BASE + i, "weight": np.float32(12.5),
+                "axles": np.int64(3), "hazmat": np.bool_(i % 2)},
+        },
+    })
+    return record
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--containers", type=int, default=50000)
+    parser.add_argument("--repeat", type=int, default=5)
+    args = parser.parse_args()
+
+    payload = {"containers": [make_record(i) for i in range(args.containers)]}
+
+    containers = ContainerPy.ContainerMap.load_containers_from_json(payload)
+    last = containers[-1]
+    expected = str(SERIAL_BASE + args.containers - 1)
+    serial = last.get_custom_variable(0, "serial")
+    assert serial == expected, f"64-bit value lost: {serial} != {expected}"
+
+    timings = [
+        ("ContainerMap(json_dict)", lambda: ContainerPy.ContainerMap(payload)),
+        ("load_containers_from_json()",
+         lambda: ContainerPy.ContainerMap.load_containers_from_json(payload)),
+    ]
+
+    bench_common.report(args.containers, args.repeat, timings)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,94 @@
+"""
+Checks the awaitable ContainerMap API.
+
+Queries run on a C++ thread pool and resolve an asyncio future. A dequeue
+whose future is cancelled after the work ran must put its containers back
+into the map instead of dropping them.
+
+Usage:
+    python tests/python/test_async.py [--containers N]
+"""
+
+import argparse
+import asyncio
+import time
+
+import ContainerPy
+
+TIMEOUT = 10.0
+
+
+def make_map(count):
+    container_map = ContainerPy.ContainerMap()
+    container_map.add_containers_from_dict({
+        "containers": [
+            {
+                "containerID": f"A{i:05d}",
+                "containerSize": i % 11,
+                "containerCurrentLocation": "Yard",
+                "containerNextDestinations": ["Port A"],
+                "containerMovementHistory": [],
+                "packages": [],
+                "customVariables": {},
+            }
+            for i in range(count)
+        ]
+    }, 5.0)
+    return container_map
+
+
+async def check_query(count):
+    container_map = make_map(count)
+
+    containers = await container_map.get_containers_by_added_time_async(">=", 0.0)
+    assert sorted(c.get_container_id() for c in containers) == sorted(container_map.keys())
+    assert await container_map.count_containers_by_added_time_async(">=", 0.0) == count
+
+    dequeued = await container_map.dequeue_containers_by_next_destination_async("Port A")
+    assert len(dequeued) == count
+    assert len(container_map) == 0
+
+
+async def check_cancelled_dequeue(count):
+    container_map = make_map(count)
+    ids = sorted(container_map.keys())
+
+    future = container_map.dequeue_containers_by_added_time_async(">=", 0.0)
+
+    # Block the loop until the work has run, so the result is already
+    # queued for the loop when the future gets cancelled
+    deadline = time.monotonic() + TIMEOUT
+    while len(container_map) != 0:
+        assert time.monotonic() < deadline, "dequeue did not run"
+        time.sleep(0.001)
+    assert future.cancel()
+
+    while len(container_map) != count:
+        assert time.monotonic() < deadline, "dequeued containers were not put back"
+        await asyncio.sleep(0.001)
+
+    assert sorted(container_map.keys()) == ids
+    for container_id in ids:
+        assert container_map[container_id].get_container_added_time() == 5.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--containers", type=int, default=500)
+    args = parser.parse_args()
+
+    for test in (check_query, check_cancelled_dequeue):
+        asyncio.run(test(args.containers))
+        print(f"{test.__name__}: ok")
+
+
+def test_query():
+    asyncio.run(check_query(500))
+
+
+def test_cancelled_dequeue():
+    asyncio.run(check_cancelled_dequeue(500))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,104 @@
+"""
+Checks lazy iteration over a database-backed ContainerMap past its cache.
+
+The map keeps only 200 containers in memory, so walking more than that
+evicts the containers handed out earlier. Items must stay usable after
+eviction, a lookup by ID must keep returning the same Python object, and
+the wrappers must be freed once Python drops them.
+
+Usage:
+    python tests/python/test_map_iteration.py [--containers N]
+"""
+
+import argparse
+import gc
+import os
+import tempfile
+import weakref
+
+import ContainerPy
+
+CACHE_SIZE = 200
+
+
+def make_payload(count):
+    return {
+        "containers": [
+            {
+                "containerID": f"C{i:06d}",
+                "containerSize": i % 11,
+                "containerCurrentLocation": f"Yard {i}",
+                "containerNextDestinations": ["Port A"],
+                "containerMovementHistory": [],
+                "packages": [],
+                "customVariables": {},
+            }
+            for i in range(count)
+        ]
+    }
+
+
+def make_map(directory, count):
+    container_map = ContainerPy.ContainerMap(os.path.join(directory, "containers.db"))
+    container_map.add_containers_from_dict(make_payload(count), 1.0)
+    return container_map
+
+
+def test_items_survive_eviction(count=3 * CACHE_SIZE):
+    with tempfile.TemporaryDirectory() as directory:
+        container_map = make_map(directory, count)
+
+        items = list(container_map.items())
+        assert len(items) == count
+        for index, (container_id, container) in enumerate(items):
+            assert container_id == f"C{index:06d}"
+            assert container.get_container_id() == container_id
+            assert container.get_container_current_location() == f"Yard {index}"
+
+        del items, container_map
+        gc.collect()
+
+
+def test_lookup_returns_same_object(count=3 * CACHE_SIZE):
+    with tempfile.TemporaryDirectory() as directory:
+        container_map = make_map(directory, count)
+
+        assert container_map["C000000"] is container_map["C000000"]
+
+        first = container_map["C000000"]
+        for index in range(1, count):
+            container_map[f"C{index:06d}"]
+        assert container_map["C000000"] is first
+        assert first.get_container_id() == "C000000"
+
+        del first, container_map
+        gc.collect()
+
+
+def test_values_are_freed(count=3 * CACHE_SIZE):
+    with tempfile.TemporaryDirectory() as directory:
+        container_map = make_map(directory, count)
+
+        references = [weakref.ref(container) for container in container_map.values()]
+        assert len(references) == count
+        gc.collect()
+        assert all(reference() is None for reference in references)
+
+        del container_map
+        gc.collect()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--containers", type=int, default=3 * CACHE_SIZE)
+    args = parser.parse_args()
+
+    for test in (test_items_survive_eviction,
+                 test_lookup_returns_same_object,
+                 test_values_are_freed):
+        test(args.containers)
+        print(f"{test.__name__}: ok")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,105 @@
+"""
+Checks pickling and copying of Container and ContainerMap.
+
+Both types reduce to a binary state that __setstate__ restores; copy and
+deepcopy go through the same reduction. Corrupt state raises ValueError.
+
+Usage:
+    python tests/python/test_pickle.py
+"""
+
+import copy
+import math
+import pickle
+
+import ContainerPy
+
+
+def make_container(container_id="P001"):
+    container = ContainerPy.Container(container_id, ContainerPy.FourtyFT)
+    container.add_package(ContainerPy.Package("PKG-1"))
+    container.add_package(ContainerPy.Package("PKG-2"))
+    container.add_custom_variable(ContainerPy.Truck, "plate", "AB-123")
+    container.add_custom_variable(ContainerPy.Train, "wagon", 7)
+    container.add_custom_variable(ContainerPy.WaterTransport, "draught", 8.5)
+    container.set_container_added_time(12.5)
+    container.set_container_leaving_time(40.0)
+    container.set_container_current_location("Yard")
+    container.add_container_destination("Port A")
+    return container
+
+
+def assert_same_container(restored, original):
+    assert restored is not original
+    assert restored.get_container_id() == original.get_container_id()
+    assert restored.get_container_size() == original.get_container_size()
+    assert restored.get_container_added_time() == original.get_container_added_time()
+    assert restored.get_container_leaving_time() == original.get_container_leaving_time()
+    assert (restored.get_container_current_location()
+            == original.get_container_current_location())
+    assert (restored.get_container_next_destinations()
+            == original.get_container_next_destinations())
+    assert ([package.get_package_id() for package in restored.get_packages()]
+            == [package.get_package_id() for package in original.get_packages()])
+    assert restored.get_custom_variable(ContainerPy.Truck, "plate") == "AB-123"
+    assert restored.get_custom_variable(ContainerPy.Train, "wagon") == "7"
+    assert float(restored.get_custom_variable(ContainerPy.WaterTransport, "draught")) == 8.5
+
+
+def test_container_round_trip():
+    container = make_container()
+    for protocol in range(2, pickle.HIGHEST_PROTOCOL + 1):
+        assert_same_container(pickle.loads(pickle.dumps(container, protocol)), container)
+    assert_same_container(copy.copy(container), container)
+    assert_same_container(copy.deepcopy(container), container)
+
+
+def test_container_map_round_trip():
+    # The Python objects own their containers, so keep them alive
+    containers = [make_container(f"P{i:03d}") for i in range(5)]
+    empty = ContainerPy.Container("EMPTY", ContainerPy.TwentyFT)
+    container_map = ContainerPy.ContainerMap()
+    container_map.add_containers(containers, 3.0)
+    container_map.add_container(empty, 4.0, math.nan)
+
+    for restored in (pickle.loads(pickle.dumps(container_map)),
+                     copy.deepcopy(container_map)):
+        assert restored is not container_map
+        assert len(restored) == len(container_map)
+        assert sorted(restored.keys()) == sorted(container_map.keys())
+        for container_id in container_map.keys():
+            if container_id != "EMPTY":
+                assert_same_container(restored[container_id], container_map[container_id])
+        assert restored["EMPTY"].get_container_added_time() == 4.0
+        assert math.isnan(restored["EMPTY"].get_container_leaving_time())
+
+
+def expect_value_error(cls, state):
+    instance = cls.__new__(cls)
+    try:
+        instance.__setstate__(state)
+    except ValueError:
+        return
+    raise AssertionError(f"{cls.__name__} accepted corrupt state")
+
+
+def test_corrupt_state():
+    expect_value_error(ContainerPy.Container, b"not a container")
+    expect_value_error(ContainerPy.Container, b"")
+    expect_value_error(ContainerPy.ContainerMap, b"not a map")
+
+    # A truncated but otherwise valid state is rejected as well
+    state = make_container().__getstate__()
+    expect_value_error(ContainerPy.Container, state[:len(state) // 2])
+
+
+def main():
+    for test in (test_container_round_trip,
+                 test_container_map_round_trip,
+                 test_corrupt_state):
+        test()
+        print(f"{test.__name__}: ok")
+
+
+if __name__ == "__main__":
+    main()